@@ -0,0 +1,44 @@
+/* extension/pg_hexedit--0.1.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION pg_hexedit" to load this file. \quit
+
+--
+-- pg_hexedit_tags()
+--
+CREATE FUNCTION pg_hexedit_tags(relation regclass,
+    first_block int8 DEFAULT 0,
+    last_block int8 DEFAULT NULL,
+    fork text DEFAULT 'main',
+    OUT blkno int8,
+    OUT start_offset int4,
+    OUT end_offset int4,
+    OUT tag text,
+    OUT font_colour text,
+    OUT note_colour text)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_hexedit_tags'
+LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+--
+-- pg_hexedit_pages()
+--
+CREATE FUNCTION pg_hexedit_pages(relation regclass,
+    first_block int8 DEFAULT 0,
+    last_block int8 DEFAULT NULL,
+    fork text DEFAULT 'main',
+    OUT blkno int8,
+    OUT lsn pg_lsn,
+    OUT page_type text,
+    OUT pd_lower int4,
+    OUT pd_upper int4,
+    OUT pd_special int4,
+    OUT ntags int4,
+    OUT errors text)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_hexedit_pages'
+LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+-- Pages can contain any data in the database, so only superusers may read them
+REVOKE ALL ON FUNCTION pg_hexedit_tags(regclass, int8, int8, text) FROM PUBLIC;
+REVOKE ALL ON FUNCTION pg_hexedit_pages(regclass, int8, int8, text) FROM PUBLIC;
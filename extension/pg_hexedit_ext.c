@@ -0,0 +1,411 @@
+/*
+ * pg_hexedit_ext.c - Server extension that exposes pg_hexedit tags and page
+ *                    statistics as set-returning functions.
+ *
+ * Copyright (c) 2018-2021, Crunchy Data Solutions, Inc.
+ * Copyright (c) 2011-2021, PostgreSQL Global Development Group
+ *
+ * The frontend program needs filesystem access to PGDATA, and a CHECKPOINT
+ * before the relation files on disk are current.  This extension runs the
+ * same decoding routines against pages read through the buffer manager
+ * instead, so it works on hosts where only a SQL connection is available.
+ *
+ * The decoding routines are built from ../pg_hexedit.c directly, with
+ * PG_HEXEDIT_EXTENSION defined, which compiles out option handling, the scan
+ * modes, and everything else that only the frontend program uses.  Tags are
+ * collected with the same tag visitor that --view and --html use.  Problems
+ * with pages that pg_hexedit reports on stderr are captured and returned
+ * instead.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+#include "postgres.h"
+
+#if PG_VERSION_NUM >= 120000
+#include "access/relation.h"
+#else
+#include "access/heapam.h"
+#endif
+#include "catalog/pg_class.h"
+#include "common/relpath.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "storage/bufmgr.h"
+#include "utils/builtins.h"
+#include "utils/pg_lsn.h"
+#include "utils/rel.h"
+
+PG_MODULE_MAGIC;
+
+#define PG_HEXEDIT_EXTENSION 1
+
+/*
+ * pg_hexedit.c allocates with the frontend memory routines.  Map them onto
+ * palloc() and friends.
+ */
+static inline void *
+pg_malloc(size_t size)
+{
+	return palloc(size);
+}
+
+static inline void *
+pg_malloc0(size_t size)
+{
+	return palloc0(size);
+}
+
+static inline void *
+pg_realloc(void *ptr, size_t size)
+{
+	return ptr ? repalloc(ptr, size) : palloc(size);
+}
+
+static inline char *
+pg_strdup(const char *in)
+{
+	return pstrdup(in);
+}
+
+static inline void
+pg_free(void *ptr)
+{
+	if (ptr)
+		pfree(ptr);
+}
+
+/*
+ * pg_hexedit.c reports problems with pages on stderr.  While a page is being
+ * decoded, stderr is a memory stream, so that problems can be returned to
+ * the caller.
+ */
+static FILE *pageErrors = NULL;
+
+static FILE *
+GetServerStderr(void)
+{
+	return stderr;
+}
+
+#undef stderr
+#define stderr (pageErrors ? pageErrors : GetServerStderr())
+
+#include "../pg_hexedit.c"
+
+PG_FUNCTION_INFO_V1(pg_hexedit_tags);
+PG_FUNCTION_INFO_V1(pg_hexedit_pages);
+
+/* Number of pg_hexedit_tags() output columns */
+#define HEXEDIT_TAGS_COLS		6
+
+/* Number of pg_hexedit_pages() output columns */
+#define HEXEDIT_PAGES_COLS		8
+
+/*
+ * Set up decoding state for relation.  Tuples are decoded using the
+ * relation's own tuple descriptor, just as if its attributes had been passed
+ * to pg_hexedit -D.
+ */
+static void
+SetupRelationDecoding(Relation rel)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	int			i;
+
+	blockSize = BLCKSZ;
+	segmentSize = RELSEG_SIZE * BLCKSZ;
+	blockOptions = 0;
+	exitCode = 0;
+	firstType = SPEC_SECT_ERROR_UNKNOWN;
+	fileName = RelationGetRelationName(rel);
+	buffer = (char *) palloc(BLCKSZ);
+
+	nrelatts = tupdesc->natts;
+	attlenrel = palloc(sizeof(int) * Max(nrelatts, 1));
+	attnamerel = palloc(sizeof(char *) * Max(nrelatts, 1));
+	attcolorrel = palloc(sizeof(char *) * Max(nrelatts, 1));
+	attalignrel = palloc(sizeof(char) * Max(nrelatts, 1));
+	for (i = 0; i < nrelatts; i++)
+	{
+		Form_pg_attribute att = TupleDescAttr(tupdesc, i);
+
+		attlenrel[i] = att->attlen;
+		attnamerel[i] = pstrdup(NameStr(att->attname));
+		attcolorrel[i] = GetColorFromAttrname(NameStr(att->attname));
+		attalignrel[i] = att->attalign;
+	}
+}
+
+/*
+ * Read block through shared buffers, and decode it.  Returns number of tags,
+ * and sets *tags to them.  Sets *errors to problems pg_hexedit found with the
+ * page, one per line, or NULL when there were none.  Caller should reset
+ * memory context afterwards.
+ */
+static int
+DecodeRelationBlock(Relation rel, ForkNumber forknum, BlockNumber blkno,
+					BufferAccessStrategy strategy, PageTag **tags,
+					char **errors)
+{
+	Buffer		buf;
+	char	   *errorText = NULL;
+	size_t		errorLen = 0;
+	int			ntags;
+
+	CHECK_FOR_INTERRUPTS();
+
+	buf = ReadBufferExtended(rel, forknum, blkno, RBM_NORMAL, strategy);
+	LockBuffer(buf, BUFFER_LOCK_SHARE);
+	memcpy(buffer, BufferGetPage(buf), BLCKSZ);
+	UnlockReleaseBuffer(buf);
+
+	/* Tag offsets are relative to the start of the block's segment file */
+	segmentNumber = blkno / RELSEG_SIZE;
+	segmentBlockDelta = segmentNumber * RELSEG_SIZE;
+	currentBlock = blkno - segmentBlockDelta;
+	bytesToFormat = BLCKSZ;
+
+	pageErrors = open_memstream(&errorText, &errorLen);
+	if (!pageErrors)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("could not create memory stream")));
+
+	/*
+	 * tagText is allocated in caller's memory context, which is reset after
+	 * each page, and when the query is aborted.  Neither it nor the memory
+	 * stream may outlive this call, even when decoding raises an ERROR.
+	 */
+	PG_TRY();
+	{
+		ntags = CollectPageTags(currentBlock, tags);
+	}
+	PG_CATCH();
+	{
+		fclose(pageErrors);
+		pageErrors = NULL;
+		free(errorText);
+		tagText.data = NULL;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	fclose(pageErrors);
+	pageErrors = NULL;
+	tagText.data = NULL;
+
+	*errors = NULL;
+	if (errorLen > 0)
+	{
+		StringInfoData problems;
+		char	   *line;
+		char	   *saveptr;
+
+		initStringInfo(&problems);
+		for (line = strtok_r(errorText, "\n", &saveptr); line;
+			 line = strtok_r(NULL, "\n", &saveptr))
+		{
+			/* Only errors are problems with page, not notices or tips */
+			if (strncmp(line, "pg_hexedit error: ", 18) != 0)
+				continue;
+			if (problems.len > 0)
+				appendStringInfoChar(&problems, '\n');
+			appendStringInfoString(&problems, line + 18);
+		}
+		if (problems.len > 0)
+			*errors = problems.data;
+	}
+	free(errorText);
+
+	return ntags;
+}
+
+/*
+ * Shared implementation of pg_hexedit_tags() and pg_hexedit_pages().  Reads
+ * each block in range through shared buffers, with a bulk read strategy so
+ * that scanning a large relation doesn't evict the rest of shared_buffers.
+ */
+static void
+ScanRelationBlocks(FunctionCallInfo fcinfo, bool emitTags)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext oldcontext;
+	MemoryContext pageContext;
+	Relation	rel;
+	ForkNumber	forknum = MAIN_FORKNUM;
+	BufferAccessStrategy strategy;
+	BlockNumber nblocks;
+	int64		first;
+	int64		last;
+	int64		blkno;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("must be superuser to use pg_hexedit functions")));
+
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+	MemoryContextSwitchTo(oldcontext);
+
+	if (PG_ARGISNULL(0))
+		return;
+
+	if (!PG_ARGISNULL(3))
+		forknum = forkname_to_number(text_to_cstring(PG_GETARG_TEXT_PP(3)));
+
+	rel = relation_open(PG_GETARG_OID(0), AccessShareLock);
+	if (rel->rd_rel->relkind != RELKIND_RELATION &&
+		rel->rd_rel->relkind != RELKIND_INDEX &&
+		rel->rd_rel->relkind != RELKIND_MATVIEW &&
+		rel->rd_rel->relkind != RELKIND_SEQUENCE &&
+		rel->rd_rel->relkind != RELKIND_TOASTVALUE)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cannot read pages of relation \"%s\"",
+						RelationGetRelationName(rel)),
+				 errdetail("Only tables, indexes, materialized views, sequences, and TOAST tables have pages.")));
+
+	/* Other sessions' temp tables can't be read through shared buffers */
+	if (RELATION_IS_OTHER_TEMP(rel))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot access temporary tables of other sessions")));
+
+	nblocks = RelationGetNumberOfBlocksInFork(rel, forknum);
+	first = PG_ARGISNULL(1) ? 0 : PG_GETARG_INT64(1);
+	last = PG_ARGISNULL(2) ? (int64) nblocks - 1 : PG_GETARG_INT64(2);
+	if (first < 0 || first > MaxBlockNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid block number " INT64_FORMAT, first)));
+	last = Min(last, (int64) nblocks - 1);
+
+	SetupRelationDecoding(rel);
+	strategy = GetAccessStrategy(BAS_BULKREAD);
+	pageContext = AllocSetContextCreate(CurrentMemoryContext,
+										"pg_hexedit page",
+										ALLOCSET_DEFAULT_SIZES);
+
+	for (blkno = first; blkno <= last; blkno++)
+	{
+		PageTag    *tags;
+		char	   *errors;
+		int			ntags;
+		int			i;
+
+		oldcontext = MemoryContextSwitchTo(pageContext);
+		ntags = DecodeRelationBlock(rel, forknum, (BlockNumber) blkno,
+									strategy, &tags, &errors);
+
+		if (emitTags)
+		{
+			uint32		pageStart = currentBlock * BLCKSZ;
+
+			if (errors)
+				ereport(WARNING,
+						(errmsg("pg_hexedit found problems with block " INT64_FORMAT " of relation \"%s\"",
+								blkno, RelationGetRelationName(rel)),
+						 errdetail_internal("%s", errors)));
+
+			for (i = 0; i < ntags; i++)
+			{
+				Datum		values[HEXEDIT_TAGS_COLS];
+				bool		nulls[HEXEDIT_TAGS_COLS];
+
+				memset(nulls, 0, sizeof(nulls));
+				values[0] = Int64GetDatum(blkno);
+				values[1] = Int32GetDatum(tags[i].start - pageStart);
+				values[2] = Int32GetDatum(tags[i].end - pageStart);
+				values[3] = CStringGetTextDatum(tags[i].text);
+				values[4] = CStringGetTextDatum(tags[i].fontColor);
+				values[5] = CStringGetTextDatum(tags[i].noteColor);
+				tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+			}
+		}
+		else
+		{
+			Page		page = (Page) buffer;
+			Datum		values[HEXEDIT_PAGES_COLS];
+			bool		nulls[HEXEDIT_PAGES_COLS];
+
+			memset(nulls, 0, sizeof(nulls));
+			values[0] = Int64GetDatum(blkno);
+			if (PageIsNew(page))
+			{
+				nulls[1] = true;
+				values[2] = CStringGetTextDatum("new");
+				nulls[3] = nulls[4] = nulls[5] = true;
+			}
+			else
+			{
+				values[1] = LSNGetDatum(PageGetLSN(page));
+				values[2] = CStringGetTextDatum(GetSpecialSectionString(specialType));
+				values[3] = Int32GetDatum(((PageHeader) page)->pd_lower);
+				values[4] = Int32GetDatum(((PageHeader) page)->pd_upper);
+				values[5] = Int32GetDatum(((PageHeader) page)->pd_special);
+			}
+			values[6] = Int32GetDatum(ntags);
+			if (errors)
+				values[7] = CStringGetTextDatum(errors);
+			else
+				nulls[7] = true;
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+
+		MemoryContextSwitchTo(oldcontext);
+		MemoryContextReset(pageContext);
+	}
+
+	MemoryContextDelete(pageContext);
+	FreeAccessStrategy(strategy);
+	relation_close(rel, AccessShareLock);
+}
+
+/*
+ * pg_hexedit_tags()
+ *
+ * Returns the tags that pg_hexedit would emit for each page in a range of
+ * blocks of relation fork.  Offsets are relative to the start of each page.
+ */
+Datum
+pg_hexedit_tags(PG_FUNCTION_ARGS)
+{
+	ScanRelationBlocks(fcinfo, true);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_hexedit_pages()
+ *
+ * Returns page header details, the number of tags, and any problems that
+ * pg_hexedit found, for each page in a range of blocks of relation fork.
+ * Pages whose errors column is NULL passed every check pg_hexedit makes.
+ */
+Datum
+pg_hexedit_pages(PG_FUNCTION_ARGS)
+{
+	ScanRelationBlocks(fcinfo, false);
+
+	return (Datum) 0;
+}
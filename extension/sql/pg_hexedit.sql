@@ -0,0 +1,26 @@
+CREATE EXTENSION pg_hexedit;
+
+CREATE TABLE hexedit_test (id int4, val text);
+INSERT INTO hexedit_test SELECT i, 'value ' || i FROM generate_series(1, 100) i;
+CREATE INDEX hexedit_test_idx ON hexedit_test (id);
+
+-- One line pointer tag per heap tuple
+SELECT count(*) FROM pg_hexedit_tags('hexedit_test')
+WHERE tag ~ '^\(0,\d+\) lp_len: \d+, lp_off: \d+, lp_flags: LP_NORMAL$';
+
+-- Attributes are decoded using the relation's tuple descriptor
+SELECT start_offset, end_offset, tag FROM pg_hexedit_tags('hexedit_test', 0, 0)
+WHERE tag IN ('(0,1) id', '(0,1) val - varattrib_1b', '(0,1) val')
+ORDER BY start_offset, end_offset;
+
+SELECT blkno, page_type, pd_lower, pd_special, ntags > 0 AS has_tags, errors
+FROM pg_hexedit_pages('hexedit_test');
+
+SELECT blkno, page_type, errors FROM pg_hexedit_pages('hexedit_test_idx');
+
+-- Block ranges
+SELECT DISTINCT blkno FROM pg_hexedit_tags('hexedit_test_idx', 1);
+SELECT count(*) FROM pg_hexedit_pages('hexedit_test_idx', 0, 100);
+SELECT * FROM pg_hexedit_pages('hexedit_test', -1);
+
+DROP TABLE hexedit_test;
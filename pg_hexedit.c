@@ -27,6 +27,14 @@
  * Original pg_filedump Author: Patrick Macdonald <patrickm@redhat.com>
  * pg_hexedit author:           Peter Geoghegan <pg@bowt.ie>
  */
+
+/*
+ * The server extension (see extension/) builds the decoding routines in this
+ * file into a backend module, with PG_HEXEDIT_EXTENSION defined.  It includes
+ * postgres.h itself, and leaves out everything that only makes sense in a
+ * frontend program.
+ */
+#ifndef PG_HEXEDIT_EXTENSION
 #define FRONTEND 1
 #include "postgres.h"
 #include "common/fe_memutils.h"
@@ -45,8 +53,36 @@
  * macros happen to be shared by frontend and backend code.
  */
 #define TrapMacro(condition, errorType) (true)
+#endif
 
+#ifndef PG_HEXEDIT_EXTENSION
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <time.h>
+#include <unistd.h>
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define USE_IO_URING 1
+#endif
+#endif
+#endif
+#include <curses.h>
+/* pg_hexedit's own tag colors reuse these names */
+#undef COLOR_BLACK
+#undef COLOR_WHITE
+#endif
 
 #include "access/brin_page.h"
 #include "access/brin_tuple.h"
@@ -58,10 +94,32 @@
 #include "access/itup.h"
 #include "access/nbtree.h"
 #include "access/spgist_private.h"
+#if PG_VERSION_NUM >= 140000
+#include "access/toast_compression.h"
+#endif
+#include "access/xlogrecord.h"
+#include "common/pg_lzcompress.h"
+#include "lib/stringinfo.h"
+#include "mb/pg_wchar.h"
+#include "port/pg_bswap.h"
 #include "storage/checksum.h"
+#ifndef PG_HEXEDIT_EXTENSION
 #include "storage/checksum_impl.h"
+#endif
 #include "utils/pg_crc.h"
 
+#include "pg_hexedit_plugin.h"
+
+#ifndef PG_HEXEDIT_EXTENSION
+#ifdef USE_LZ4
+#include <lz4.h>
+#include <lz4frame.h>
+#endif
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#endif
+
 #define HEXEDIT_VERSION			"0.1"
 #define SEQUENCE_MAGIC			0x1717	/* PostgreSQL defined magic number */
 #define EOF_ENCOUNTERED 		(-1)	/* Indicator for partial read */
@@ -77,6 +135,12 @@
 #define BT_OFFSET_MASK	BT_N_KEYS_OFFSET_MASK
 #endif
 
+/* Postgres 14 moved VARATT_EXTERNAL_IS_COMPRESSED() to postgres.h */
+#if PG_VERSION_NUM < 140000
+#define VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer) \
+	((toast_pointer).va_extsize < (toast_pointer).va_rawsize - VARHDRSZ)
+#endif
+
 #define COLOR_FONT_STANDARD		"#313739"
 
 #define COLOR_BLACK				"#000000"
@@ -104,30 +168,80 @@ typedef enum blockSwitches
 	BLOCK_SKIP_LEAF = 0x00000100,	/* -l: Skip leaf pages (use whole page
 									 * tag) */
 	BLOCK_SKIP_LSN = 0x00000200,	/* -x: Skip pages before LSN */
-	BLOCK_DECODE = 0x00000400	/* -D: Decode tuple attributes */
+	BLOCK_DECODE = 0x00000400,	/* -D: Decode tuple attributes */
+	BLOCK_TOAST = 0x00000800,	/* -T: Resolve external TOAST pointers */
+	BLOCK_COLUMN_STATS = 0x00001000,	/* --column-stats: Print column
+										 * statistics instead of tags */
+	BLOCK_JOBS = 0x00002000,	/* -j: Worker threads for tagless modes */
+	BLOCK_SALVAGE = 0x00004000,	/* --salvage: Write tuples as COPY BINARY */
+	BLOCK_VISIBLE_ONLY = 0x00008000,	/* --visible-only: Only salvage tuples
+										 * that hint bits show are visible */
+	BLOCK_CHECK_UTF8 = 0x00010000,	/* --check-utf8: Only tag attributes
+									 * that are invalid UTF-8 */
+	BLOCK_LSN_HEATMAP = 0x00020000,	/* --lsn-heatmap: Print page LSN
+									 * heatmap instead of tags */
+	BLOCK_FPW_ESTIMATE = 0x00040000,	/* --fpw-estimate: Print full-page
+										 * write estimate instead of tags */
+	BLOCK_SHARD = 0x00080000,	/* --shard-blocks: Write tags to one file
+								 * per block range */
+	BLOCK_SERVE = 0x00100000,	/* --serve: Answer tag requests on Unix
+								 * socket */
+	BLOCK_VIEW = 0x00200000,	/* --view: Interactive terminal viewer */
+	BLOCK_HTML = 0x00400000,	/* --html: Write static HTML report */
+	BLOCK_DIRECT_IO = 0x00800000,	/* --direct-io: Read relation file
+									 * without caching it */
+	BLOCK_METRICS = 0x01000000,	/* --metrics: Write Prometheus metrics
+								 * instead of tags */
+	BLOCK_CHECK = 0x02000000,	/* --check: List page anomalies, and only
+								 * tag anomalous pages */
+	BLOCK_FIX_CHECKSUMS = 0x04000000,	/* --fix-checksums: Rewrite incorrect
+										 * checksums instead of tags */
+	BLOCK_APPLY = 0x08000000,	/* --apply: Apply patch file to relation
+								 * file instead of emitting tags */
+	BLOCK_INJECT = 0x10000000	/* --inject: Write randomly corrupted
+								 * copies of relation file instead of tags */
 } blockSwitches;
 
+/*
+ * Modes that scan blocks using worker threads (see -j).  Only one may be
+ * used at a time.
+ */
+#define BLOCK_SCAN_MODES	(BLOCK_COLUMN_STATS | BLOCK_SALVAGE | \
+							 BLOCK_CHECK_UTF8 | BLOCK_LSN_HEATMAP | \
+							 BLOCK_FPW_ESTIMATE | BLOCK_METRICS | \
+							 BLOCK_CHECK | BLOCK_FIX_CHECKSUMS)
+
 typedef enum segmentSwitches
 {
 	SEGMENT_SIZE_FORCED = 0x00000001,	/* -s: Segment size forced */
 	SEGMENT_NUMBER_FORCED = 0x00000002	/* -n: Segment number forced */
 } segmentSwitches;
 
+/*
+ * Variables that describe the XML document currently being emitted are
+ * thread-local, so that each --shard-blocks worker thread can emit its own
+ * document
+ */
+
+#ifndef PG_HEXEDIT_EXTENSION
+
 /* -R[start]:Block range start */
-static int	blockStart = -1;
+static __thread int blockStart = -1;
 
 /* -R[end]:Block range end */
-static int	blockEnd = -1;
+static __thread int blockEnd = -1;
+
+#endif							/* PG_HEXEDIT_EXTENSION */
 
 /* -x:Skip pages whose LSN is before point */
 static XLogRecPtr afterThreshold = InvalidXLogRecPtr;
-static XLogRecPtr minPageLSN = (XLogRecPtr) PG_UINT64_MAX;
-static XLogRecPtr maxPageLSN = InvalidXLogRecPtr;
-static BlockNumber minPageLSNBlock = InvalidBlockNumber;
-static BlockNumber maxPageLSNBlock = InvalidBlockNumber;
-static BlockNumber maxBlockNumber = 0;
-static uint32	nblockstagged = 0;
-static uint32	nblocksskipped = 0;
+static __thread XLogRecPtr minPageLSN = (XLogRecPtr) PG_UINT64_MAX;
+static __thread XLogRecPtr maxPageLSN = InvalidXLogRecPtr;
+static __thread BlockNumber minPageLSNBlock = InvalidBlockNumber;
+static __thread BlockNumber maxPageLSNBlock = InvalidBlockNumber;
+static __thread BlockNumber maxBlockNumber = 0;
+static __thread uint32 nblockstagged = 0;
+static __thread uint32 nblocksskipped = 0;
 
 /* Possible value types for the Special Section */
 typedef enum specialSectionTypes
@@ -141,14 +255,325 @@ typedef enum specialSectionTypes
 	SPEC_SECT_INDEX_SPGIST,		/* SP - GIST index info in special section */
 	SPEC_SECT_INDEX_BRIN,		/* BRIN index info in special section */
 	SPEC_SECT_ERROR_UNKNOWN,	/* Unknown error */
-	SPEC_SECT_ERROR_BOUNDARY	/* Boundary error */
+	SPEC_SECT_ERROR_BOUNDARY,	/* Boundary error */
+	SPEC_SECT_PLUGIN			/* First --plugin access method (each one
+								 * has its own type) */
 } specialSectionTypes;
 
+/* --plugin: Access methods that plugins decode, indexed by type */
+#define MAX_PLUGIN_AMS			32
+#define IsPluginType(type) \
+	((type) >= SPEC_SECT_PLUGIN && (type) < SPEC_SECT_PLUGIN + npluginAms)
+#define GetPluginAm(type)		(pluginAms[(type) - SPEC_SECT_PLUGIN])
+#define PluginLacksMetapage(type) \
+	(IsPluginType(type) && GetPluginAm(type)->emitMetapage == NULL)
+
+static const HexeditPluginAm *pluginAms[MAX_PLUGIN_AMS];
+static char *pluginTypeNames[MAX_PLUGIN_AMS];
+static int	npluginAms = 0;
+
 /* Special section type that was encountered first */
-static unsigned int firstType = SPEC_SECT_ERROR_UNKNOWN;
+static __thread unsigned int firstType = SPEC_SECT_ERROR_UNKNOWN;
 
 /* Current block special section type */
-static unsigned int specialType = SPEC_SECT_NONE;
+static __thread unsigned int specialType = SPEC_SECT_NONE;
+
+/* Special area of sequence pages (sequence_magic in sequence.c) */
+typedef struct SequenceMagic
+{
+	uint32		magic;
+} SequenceMagic;
+
+/*
+ * How a metapage or special area field's tag describes the field's value, in
+ * addition to naming the field
+ */
+typedef enum fieldDecoders
+{
+	FIELD_PLAIN,				/* Field name alone */
+	FIELD_FLAGS,				/* Names of flag bits that are set */
+	FIELD_ENUM					/* Name of field's value */
+} fieldDecoders;
+
+/* Name of flag bit (or value) that a field decoder recognizes */
+typedef struct FieldFlag
+{
+	const char *name;
+	uint32		value;
+} FieldFlag;
+
+typedef struct StructDesc StructDesc;
+
+/*
+ * Descriptor of metapage or special area struct field.  A field's tag covers
+ * everything up to the next field's offset (or the end of its struct), so
+ * alignment padding is tagged along with the field that comes before it.
+ * Arrays of structs are tagged element by element, using elem's fields.
+ */
+typedef struct FieldDesc
+{
+	const char *name;
+	uint32		offset;			/* Offset within struct */
+	uint32		size;			/* sizeof() field, excluding padding */
+	const char *color;
+	fieldDecoders decoder;
+	const FieldFlag *flags;		/* Names used by decoder */
+	int			nflags;
+	const StructDesc *elem;		/* Struct of array elements, or NULL */
+	int			nelems;
+} FieldDesc;
+
+/* Descriptor of metapage or special area struct */
+struct StructDesc
+{
+	const FieldDesc *fields;
+	int			nfields;
+	uint32		size;			/* sizeof() struct */
+};
+
+#define FieldSize(type, member)	sizeof(((type *) 0)->member)
+#define FIELD(type, member, color) \
+	{#member, offsetof(type, member), FieldSize(type, member), color, \
+	 FIELD_PLAIN, NULL, 0, NULL, 0}
+#define FIELD_AS(type, member, name, color) \
+	{name, offsetof(type, member), FieldSize(type, member), color, \
+	 FIELD_PLAIN, NULL, 0, NULL, 0}
+#define DECODED_FIELD(type, member, name, color, decoder, flags) \
+	{name, offsetof(type, member), FieldSize(type, member), color, \
+	 decoder, flags, lengthof(flags), NULL, 0}
+#define ARRAY_FIELD(type, member, elemDesc, nelems) \
+	{#member, offsetof(type, member), FieldSize(type, member), NULL, \
+	 FIELD_PLAIN, NULL, 0, &elemDesc, nelems}
+#define STRUCT_DESC(type, fields)	{fields, lengthof(fields), sizeof(type)}
+
+/*
+ * Fail to compile when a descriptor doesn't end with the last field of its
+ * struct, which is where new versions of Postgres usually add fields
+ */
+#define StaticAssertLastField(type, member) \
+	StaticAssertStmt(offsetof(type, member) + FieldSize(type, member) + \
+					 MAXIMUM_ALIGNOF > sizeof(type), \
+					 "descriptor of " #type " lacks last field")
+
+/* Metapage field descriptors */
+static const FieldDesc btreeMetaFields[] = {
+	FIELD(BTMetaPageData, btm_magic, COLOR_PINK),
+	FIELD(BTMetaPageData, btm_version, COLOR_PINK),
+	FIELD(BTMetaPageData, btm_root, COLOR_PINK),
+	FIELD(BTMetaPageData, btm_level, COLOR_PINK),
+	FIELD(BTMetaPageData, btm_fastroot, COLOR_PINK),
+	FIELD(BTMetaPageData, btm_fastlevel, COLOR_PINK),
+
+	/*
+	 * These fields are only actually active when btm_version >= 3 (which is
+	 * v11's standard BTREE_VERSION)
+	 */
+#if PG_VERSION_NUM < 140000
+	FIELD(BTMetaPageData, btm_oldest_btpo_xact, COLOR_PINK),
+#else
+	FIELD(BTMetaPageData, btm_last_cleanup_num_delpages, COLOR_PINK),
+#endif
+	FIELD(BTMetaPageData, btm_last_cleanup_num_heap_tuples, COLOR_PINK),
+#if PG_VERSION_NUM >= 130000
+	/* New metapage field added in Postgres 13: */
+	FIELD(BTMetaPageData, btm_allequalimage, COLOR_PINK)
+#endif
+};
+
+static const FieldDesc hashMetaFields[] = {
+	FIELD(HashMetaPageData, hashm_magic, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_version, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_ntuples, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_ffactor, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_bsize, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_bmsize, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_bmshift, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_maxbucket, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_highmask, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_lowmask, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_ovflpoint, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_firstfree, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_nmaps, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_procid, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_spares, COLOR_PINK),
+	FIELD(HashMetaPageData, hashm_mapp, COLOR_PINK)
+};
+
+static const FieldDesc ginMetaFields[] = {
+	FIELD(GinMetaPageData, head, COLOR_PINK),
+	FIELD(GinMetaPageData, tail, COLOR_PINK),
+	FIELD(GinMetaPageData, tailFreeSize, COLOR_PINK),
+	FIELD(GinMetaPageData, nPendingPages, COLOR_PINK),
+	FIELD(GinMetaPageData, nPendingHeapTuples, COLOR_PINK),
+	FIELD(GinMetaPageData, nTotalPages, COLOR_PINK),
+	FIELD(GinMetaPageData, nEntryPages, COLOR_PINK),
+	FIELD(GinMetaPageData, nDataPages, COLOR_PINK),
+	FIELD(GinMetaPageData, nEntries, COLOR_PINK),
+	FIELD(GinMetaPageData, ginVersion, COLOR_PINK)
+};
+
+static const FieldDesc spgistLastUsedPageFields[] = {
+	FIELD_AS(SpGistLastUsedPage, blkno, "lastUsedPages.blkno", COLOR_PINK),
+	FIELD_AS(SpGistLastUsedPage, freeSpace, "lastUsedPages.freeSpace", COLOR_PINK)
+};
+
+static const StructDesc spgistLastUsedPageDesc =
+STRUCT_DESC(SpGistLastUsedPage, spgistLastUsedPageFields);
+
+static const FieldDesc spgistMetaFields[] = {
+	FIELD(SpGistMetaPageData, magicNumber, COLOR_PINK),
+	ARRAY_FIELD(SpGistMetaPageData, lastUsedPages.cachedPage,
+				spgistLastUsedPageDesc, SPGIST_CACHED_PAGES)
+};
+
+static const FieldDesc brinMetaFields[] = {
+	FIELD(BrinMetaPageData, brinMagic, COLOR_PINK),
+	FIELD(BrinMetaPageData, brinVersion, COLOR_PINK),
+	FIELD(BrinMetaPageData, pagesPerRange, COLOR_PINK),
+	FIELD(BrinMetaPageData, lastRevmapPage, COLOR_PINK)
+};
+
+static const StructDesc btreeMetaDesc = STRUCT_DESC(BTMetaPageData, btreeMetaFields);
+static const StructDesc hashMetaDesc = STRUCT_DESC(HashMetaPageData, hashMetaFields);
+static const StructDesc ginMetaDesc = STRUCT_DESC(GinMetaPageData, ginMetaFields);
+static const StructDesc spgistMetaDesc = STRUCT_DESC(SpGistMetaPageData, spgistMetaFields);
+static const StructDesc brinMetaDesc = STRUCT_DESC(BrinMetaPageData, brinMetaFields);
+
+/* Special area flags, and special area field descriptors */
+static const FieldFlag btreeFlags[] = {
+	{"BTP_LEAF", BTP_LEAF},
+	{"BTP_ROOT", BTP_ROOT},
+	{"BTP_DELETED", BTP_DELETED},
+	{"BTP_META", BTP_META},
+	{"BTP_HALF_DEAD", BTP_HALF_DEAD},
+	{"BTP_SPLIT_END", BTP_SPLIT_END},
+	{"BTP_HAS_GARBAGE", BTP_HAS_GARBAGE},
+	{"BTP_INCOMPLETE_SPLIT", BTP_INCOMPLETE_SPLIT}
+};
+
+static const FieldFlag hashFlags[] = {
+	{"LH_OVERFLOW_PAGE", LH_OVERFLOW_PAGE},
+	{"LH_BUCKET_PAGE", LH_BUCKET_PAGE},
+	{"LH_BITMAP_PAGE", LH_BITMAP_PAGE},
+	{"LH_META_PAGE", LH_META_PAGE},
+	{"LH_BUCKET_BEING_POPULATED", LH_BUCKET_BEING_POPULATED},
+	{"LH_BUCKET_BEING_SPLIT", LH_BUCKET_BEING_SPLIT},
+	{"LH_BUCKET_NEEDS_SPLIT_CLEANUP", LH_BUCKET_NEEDS_SPLIT_CLEANUP},
+	{"LH_PAGE_HAS_DEAD_TUPLES", LH_PAGE_HAS_DEAD_TUPLES}
+};
+
+static const FieldFlag gistFlags[] = {
+	{"F_LEAF", F_LEAF},
+	{"F_DELETED", F_DELETED},
+	{"F_TUPLES_DELETED", F_TUPLES_DELETED},
+	{"F_FOLLOW_RIGHT", F_FOLLOW_RIGHT},
+	{"F_HAS_GARBAGE", F_HAS_GARBAGE}
+};
+
+static const FieldFlag ginFlags[] = {
+	{"GIN_DATA", GIN_DATA},
+	{"GIN_LEAF", GIN_LEAF},
+	{"GIN_DELETED", GIN_DELETED},
+	{"GIN_META", GIN_META},
+	{"GIN_LIST", GIN_LIST},
+	{"GIN_LIST_FULLROW", GIN_LIST_FULLROW},
+	{"GIN_INCOMPLETE_SPLIT", GIN_INCOMPLETE_SPLIT},
+	{"GIN_COMPRESSED", GIN_COMPRESSED}
+};
+
+static const FieldFlag spgistFlags[] = {
+	{"SPGIST_META", SPGIST_META},
+	{"SPGIST_DELETED", SPGIST_DELETED},
+	{"SPGIST_LEAF", SPGIST_LEAF},
+	{"SPGIST_NULLS", SPGIST_NULLS}
+};
+
+static const FieldFlag brinFlags[] = {
+	{"BRIN_EVACUATE_PAGE", BRIN_EVACUATE_PAGE}
+};
+
+static const FieldFlag brinPageTypes[] = {
+	{"BRIN_PAGETYPE_META", BRIN_PAGETYPE_META},
+	{"BRIN_PAGETYPE_REVMAP", BRIN_PAGETYPE_REVMAP},
+	{"BRIN_PAGETYPE_REGULAR", BRIN_PAGETYPE_REGULAR}
+};
+
+static const FieldDesc sequenceSpecialFields[] = {
+	FIELD(SequenceMagic, magic, COLOR_GREEN_BRIGHT)
+};
+
+static const FieldDesc btreeSpecialFields[] = {
+	FIELD(BTPageOpaqueData, btpo_prev, COLOR_GREEN_BRIGHT),
+	FIELD(BTPageOpaqueData, btpo_next, COLOR_GREEN_BRIGHT),
+	/* btpo union simply became btpo_level on Postgres 14 */
+#if PG_VERSION_NUM >= 140000
+	FIELD(BTPageOpaqueData, btpo_level, COLOR_GREEN_BRIGHT),
+#else
+
+	/*
+	 * XXX: Call btpo.level btpo_level on older versions, just to keep test
+	 * results consistent across Postgres versions
+	 */
+	FIELD_AS(BTPageOpaqueData, btpo, "btpo_level", COLOR_GREEN_BRIGHT),
+#endif
+	DECODED_FIELD(BTPageOpaqueData, btpo_flags, "btpo_flags",
+				  COLOR_GREEN_BRIGHT, FIELD_FLAGS, btreeFlags),
+	FIELD(BTPageOpaqueData, btpo_cycleid, COLOR_GREEN_BRIGHT)
+};
+
+static const FieldDesc hashSpecialFields[] = {
+	FIELD(HashPageOpaqueData, hasho_prevblkno, COLOR_GREEN_BRIGHT),
+	FIELD(HashPageOpaqueData, hasho_nextblkno, COLOR_GREEN_BRIGHT),
+	FIELD(HashPageOpaqueData, hasho_bucket, COLOR_GREEN_BRIGHT),
+	DECODED_FIELD(HashPageOpaqueData, hasho_flag, "hasho_flag",
+				  COLOR_GREEN_BRIGHT, FIELD_FLAGS, hashFlags),
+	FIELD(HashPageOpaqueData, hasho_page_id, COLOR_GREEN_BRIGHT)
+};
+
+static const FieldDesc gistSpecialFields[] = {
+	FIELD(GISTPageOpaqueData, nsn, COLOR_GREEN_BRIGHT),
+	FIELD(GISTPageOpaqueData, rightlink, COLOR_GREEN_BRIGHT),
+	DECODED_FIELD(GISTPageOpaqueData, flags, "flags", COLOR_GREEN_BRIGHT,
+				  FIELD_FLAGS, gistFlags),
+	FIELD(GISTPageOpaqueData, gist_page_id, COLOR_GREEN_BRIGHT)
+};
+
+static const FieldDesc ginSpecialFields[] = {
+	FIELD(GinPageOpaqueData, rightlink, COLOR_GREEN_BRIGHT),
+	FIELD(GinPageOpaqueData, maxoff, COLOR_GREEN_BRIGHT),
+	DECODED_FIELD(GinPageOpaqueData, flags, "flags", COLOR_GREEN_BRIGHT,
+				  FIELD_FLAGS, ginFlags)
+};
+
+static const FieldDesc spgistSpecialFields[] = {
+	DECODED_FIELD(SpGistPageOpaqueData, flags, "flags", COLOR_GREEN_BRIGHT,
+				  FIELD_FLAGS, spgistFlags),
+	FIELD(SpGistPageOpaqueData, nRedirection, COLOR_GREEN_BRIGHT),
+	FIELD(SpGistPageOpaqueData, nPlaceholder, COLOR_GREEN_BRIGHT),
+	FIELD(SpGistPageOpaqueData, spgist_page_id, COLOR_GREEN_BRIGHT)
+};
+
+/*
+ * BRIN's flags and page type are the last two elements of its special area
+ * vector.  Details of array subscription are taken from BrinPageFlags() and
+ * BrinPageType() macros.
+ */
+static const FieldDesc brinSpecialFields[] = {
+	DECODED_FIELD(BrinSpecialSpace, vector[MAXALIGN(1) / sizeof(uint16) - 2],
+				  "BrinPageFlags()", COLOR_GREEN_BRIGHT, FIELD_FLAGS,
+				  brinFlags),
+	DECODED_FIELD(BrinSpecialSpace, vector[MAXALIGN(1) / sizeof(uint16) - 1],
+				  "BrinPageType()", COLOR_GREEN_BRIGHT, FIELD_ENUM,
+				  brinPageTypes)
+};
+
+static const StructDesc sequenceSpecialDesc = STRUCT_DESC(SequenceMagic, sequenceSpecialFields);
+static const StructDesc btreeSpecialDesc = STRUCT_DESC(BTPageOpaqueData, btreeSpecialFields);
+static const StructDesc hashSpecialDesc = STRUCT_DESC(HashPageOpaqueData, hashSpecialFields);
+static const StructDesc gistSpecialDesc = STRUCT_DESC(GISTPageOpaqueData, gistSpecialFields);
+static const StructDesc ginSpecialDesc = STRUCT_DESC(GinPageOpaqueData, ginSpecialFields);
+static const StructDesc spgistSpecialDesc = STRUCT_DESC(SpGistPageOpaqueData, spgistSpecialFields);
+static const StructDesc brinSpecialDesc = STRUCT_DESC(BrinSpecialSpace, brinSpecialFields);
 
 /*
  * Possible return codes from option validation routine.
@@ -180,26 +605,30 @@ typedef enum optionReturnCodes
  * Global variables for ease of use mostly
  */
 
+#ifndef PG_HEXEDIT_EXTENSION
 /* Segment-related options */
 static unsigned int segmentOptions = 0;
+#endif
 
 /*	Options for Block formatting operations */
 static unsigned int blockOptions = 0;
 
+#ifndef PG_HEXEDIT_EXTENSION
 /* File to dump or format */
-static FILE *fp = NULL;
+static __thread FILE *fp = NULL;
+#endif
 
 /* File name for display */
 static char *fileName = NULL;
 
 /* Cache for current block */
-static char *buffer = NULL;
+static __thread char *buffer = NULL;
 
 /* Current block size */
 static unsigned int blockSize = 0;
 
 /* Current block in file */
-static unsigned int currentBlock = 0;
+static __thread unsigned int currentBlock = 0;
 
 /* Segment size in bytes */
 static unsigned int segmentSize = RELSEG_SIZE * BLCKSZ;
@@ -211,16 +640,16 @@ static unsigned int segmentBlockDelta = 0;
 static unsigned int segmentNumber = 0;
 
 /* Current wxHexEditor output tag number */
-static unsigned int tagNumber = 0;
+static __thread unsigned int tagNumber = 0;
 
 /* Offset of current block (in bytes) */
-static unsigned int pageOffset = 0;
+static __thread unsigned int pageOffset = 0;
 
 /* Number of bytes to format */
-static unsigned int bytesToFormat = 0;
+static __thread unsigned int bytesToFormat = 0;
 
 /* Block version number */
-static unsigned int blockVersion = 0;
+static __thread unsigned int blockVersion = 0;
 
 /* Number of attributes (used when decoding) */
 static int	nrelatts = 0;
@@ -237,6 +666,1136 @@ static char **attcolorrel = NULL;
 /* attalign catalog metadata for relation (used when decoding) */
 static char *attalignrel = NULL;
 
+/* Attribute of tuple, as located by LocateAttribute() */
+typedef struct AttributeSpan
+{
+	bool		isnull;
+	int			off;			/* Offset within tuple data area */
+	int			len;			/* Bytes used, including any varlena header
+								 * and cstring terminator */
+	int			hdrlen;			/* Bytes of varlena header, or 0 */
+	unsigned char *ptr;			/* Start of attribute */
+} AttributeSpan;
+
+/* Output stream for wxHexEditor XML tags */
+static __thread FILE *xmlOut = NULL;
+
+/*
+ * Consumer of the tags that decoding a page produces.  Decoding routines never
+ * write tags themselves.  They pass each tag to the current visitor, which
+ * writes wxHexEditor XML to xmlOut by default.  --view and --html see exactly
+ * the same tags from the same decoding pass, without any XML being written.
+ * Scan modes that don't need tags (such as --metrics and --check) walk pages
+ * with a PageVisitor instead.
+ */
+typedef struct TagVisitor
+{
+	/*
+	 * Called for each tag.  start and end are file offsets of the first and
+	 * last byte covered by the tag.  Colors are "#RRGGBB" strings.
+	 */
+	void		(*onTag) (uint32 start, uint32 end, const char *text,
+						  const char *fontColor, const char *noteColor);
+} TagVisitor;
+
+/* Text of tag being built, reused for every tag */
+static __thread StringInfoData tagText;
+
+#ifndef PG_HEXEDIT_EXTENSION
+
+/* -T: TOAST relation file that external TOAST pointers are resolved against */
+static FILE *toastFp = NULL;
+
+/* File name of -T TOAST relation file */
+static char *toastFileName = NULL;
+
+/* Relation-relative block offset to beginning of -T TOAST file */
+static unsigned int toastSegmentBlockDelta = 0;
+
+/*
+ * Chunk found in -T TOAST relation file.  The chunk index is an array of
+ * these, sorted by (chunk_id, chunk_seq) while external TOAST pointers are
+ * resolved.
+ */
+typedef struct ToastChunk
+{
+	Oid			chunkId;		/* chunk_id column */
+	int32		chunkSeq;		/* chunk_seq column */
+	BlockNumber blkno;			/* TOAST file block */
+	OffsetNumber offset;		/* TOAST tuple offset number */
+	uint32		itemLen;		/* lp_len of TOAST tuple */
+	uint32		dataOff;		/* TOAST file offset of chunk_data payload */
+	uint32		dataLen;		/* chunk_data payload size */
+	bool		duplicate;		/* chunk_seq already seen for chunk_id? */
+	int			refAttnum;		/* Referencing attribute, or -1 */
+	BlockNumber refBlkno;		/* Referencing heap TID block */
+	OffsetNumber refOffset;		/* Referencing heap TID offset */
+} ToastChunk;
+
+/* -T TOAST chunk index */
+static ToastChunk *toastChunks = NULL;
+static int	ntoastchunks = 0;
+
+/* Per-attribute external TOAST accounting for relation (used with -T) */
+typedef struct ToastAttStats
+{
+	uint64		nexternal;		/* Number of external on-disk pointers */
+	uint64		nbroken;		/* Pointers with missing/duplicate chunks */
+	uint64		rawBytes;		/* Sum of va_rawsize */
+	uint64		extBytes;		/* Sum of external (possibly compressed) size */
+	uint64		toastBytes;		/* TOAST relation space used by chunks */
+} ToastAttStats;
+
+static ToastAttStats *toaststatsrel = NULL;
+
+/* -j: Number of worker threads used by modes that do not emit tags */
+static int	numWorkers = 1;
+
+/*
+ * Shared state for parallel block scans.  Workers claim batches of blocks
+ * from scanNextBlock while holding scanLock.
+ */
+#define SCAN_BATCH_BLOCKS		64
+static pthread_mutex_t scanLock = PTHREAD_MUTEX_INITIALIZER;
+static BlockNumber scanNextBlock = 0;
+static BlockNumber scanLastBlock = 0;
+
+/*
+ * --direct-io: Relation file reader that bypasses the OS page cache, so that
+ * scanning a large relation on a production host doesn't push the database's
+ * working set out of memory.  Blocks are read DIRECT_IO_READ_SIZE bytes at a
+ * time into an aligned buffer, using O_DIRECT.  When the file system doesn't
+ * support O_DIRECT, the same reads are buffered, and the OS is asked to drop
+ * each read from its cache once we've moved past it.
+ */
+#ifdef O_DIRECT
+#define PG_HEXEDIT_O_DIRECT		O_DIRECT
+#else
+#define PG_HEXEDIT_O_DIRECT		0
+#endif
+#define DIRECT_IO_ALIGN			4096
+#define DIRECT_IO_READ_SIZE		(1024 * 1024)
+
+typedef struct BlockReader
+{
+	int			fd;				/* Descriptor of file being read */
+	bool		direct;			/* fd is using O_DIRECT? */
+	off_t		fileSize;		/* Size of file when it was opened */
+	char	   *unaligned;		/* Allocation that buf points into */
+	char	   *buf;			/* DIRECT_IO_ALIGN aligned read buffer */
+	off_t		bufStart;		/* File offset of first byte in buf */
+	size_t		bufLen;			/* Number of bytes in buf */
+} BlockReader;
+
+static pthread_once_t directIoNoticeOnce = PTHREAD_ONCE_INIT;
+
+/*
+ * --queue-depth: Read-ahead pipeline that keeps up to depth block reads in
+ * flight, and hands completed blocks back in block order.  Block b is always
+ * read into slot b % depth, so a block can only be read once the block depth
+ * blocks before it has been handed back.  Reads are issued through io_uring
+ * where the kernel allows it, and by a pool of depth reader threads that use
+ * pg_pread() otherwise.
+ */
+#define READ_AHEAD_MAX_DEPTH	256
+
+typedef struct ReadAhead
+{
+	int			fd;				/* Descriptor of file being read */
+	bool		direct;			/* fd is using O_DIRECT? */
+	int			depth;			/* Number of slots */
+	BlockNumber last;			/* Last block to read */
+	BlockNumber nextRead;		/* Next block to issue a read for */
+	BlockNumber nextDeliver;	/* Next block to hand back */
+	char	   *unaligned;		/* Allocation that slots points into */
+	char	   *slots;			/* depth blocks, DIRECT_IO_ALIGN aligned */
+	ssize_t    *results;		/* Bytes read into each slot, or -errno */
+	bool	   *ready;			/* Has slot's read completed? */
+
+	/* Reader thread pool (used when ringFd is -1) */
+	pthread_mutex_t lock;		/* Protects nextRead, nextDeliver, results,
+								 * and ready */
+	pthread_cond_t changed;		/* Signaled when a read completes, or when
+								 * a slot is freed */
+	bool		shutdown;		/* Tell reader threads to exit */
+	int			nthreads;
+	pthread_t  *threads;
+
+	/* io_uring */
+	int			ringFd;
+#ifdef USE_IO_URING
+	int			inFlight;		/* Reads submitted but not yet reaped */
+	void	   *sqRing;
+	size_t		sqRingSize;
+	void	   *cqRing;
+	size_t		cqRingSize;
+	struct io_uring_sqe *sqes;
+	size_t		sqesSize;
+	unsigned   *sqHead;
+	unsigned   *sqTail;
+	unsigned   *sqMask;
+	unsigned   *sqArray;
+	unsigned   *cqHead;
+	unsigned   *cqTail;
+	unsigned   *cqMask;
+	struct io_uring_cqe *cqes;
+	struct iovec *iovecs;		/* One per slot */
+#endif
+} ReadAhead;
+
+static int	readAheadDepth = 0; /* --queue-depth */
+static pthread_once_t readAheadNoticeOnce = PTHREAD_ONCE_INIT;
+static int	ioUringErrno = 0;	/* Why io_uring could not be set up */
+
+/*
+ * Relation file that is a member of a (possibly compressed) tar archive, such
+ * as a pg_basebackup tarball, given as archive.tar[.gz|.lz4]:path/in/archive.
+ * The member is read through a stdio stream whose data is decompressed and
+ * unpacked on the fly, without extracting anything to disk.  Offsets are
+ * relative to the start of the member, so tags stay valid against the
+ * extracted file.
+ *
+ * Seeking forward skips through the archive.  Seeking backwards means
+ * starting over from the beginning of the archive, except within the first
+ * ARCHIVE_HEAD_SIZE bytes of the member, which are kept in memory (this is
+ * what GetBlockSize()'s rewind() needs).
+ */
+#define ARCHIVE_BUF_SIZE		(256 * 1024)
+#define ARCHIVE_HEAD_SIZE		32768
+#define TAR_BLOCK_SIZE			512
+
+typedef enum archiveCompressions
+{
+	ARCHIVE_PLAIN,
+	ARCHIVE_GZIP,
+	ARCHIVE_LZ4
+} archiveCompressions;
+
+typedef struct ArchiveStream
+{
+	char	   *archiveName;	/* Path of tar archive */
+	char	   *memberName;		/* Path of relation file within archive */
+	FILE	   *archive;
+	archiveCompressions compression;
+#ifdef HAVE_LIBZ
+	z_stream	zstream;
+#endif
+#ifdef USE_LZ4
+	LZ4F_dctx  *lz4;
+#endif
+	char	   *in;				/* Data read from archive */
+	size_t		inPos;
+	size_t		inLen;
+	char	   *out;			/* Uncompressed tar stream */
+	size_t		outPos;
+	size_t		outLen;
+	uint64		memberSize;		/* Size of member, from its tar header */
+	char	   *head;			/* First bytes of member */
+	size_t		headLen;
+	uint64		streamPos;		/* Member offset of next byte in tar stream */
+	uint64		position;		/* Member offset of stdio stream */
+	bool		truncated;		/* Already reported that archive is cut
+								 * short? */
+} ArchiveStream;
+
+/* Relation file's archive, when it is read from one */
+static ArchiveStream *archiveMember = NULL;
+
+/*
+ * --max-rate and --max-iops: Token buckets that every read of relation file
+ * (or -T TOAST file) draws from before it is issued, shared by all threads.
+ * Buckets start out full, and hold at most THROTTLE_BURST_SECS worth of
+ * tokens.  A read that takes more tokens than are available leaves the
+ * bucket in debt, and the reader sleeps until the debt would be repaid, so
+ * later readers queue up behind it.
+ */
+#define THROTTLE_BURST_SECS		0.1
+
+typedef struct IoBucket
+{
+	double		rate;			/* Tokens added per second, or 0 */
+	double		tokens;			/* Tokens available (negative when in debt) */
+} IoBucket;
+
+static int	maxRate = 0;		/* --max-rate, in MB/s */
+static int	maxIops = 0;		/* --max-iops */
+static pthread_mutex_t throttleLock = PTHREAD_MUTEX_INITIALIZER;
+static IoBucket throttleBytes;
+static IoBucket throttleOps;
+static struct timespec throttleStart;	/* Time of first throttled read */
+static struct timespec throttleRefill;	/* Time buckets were last refilled */
+static uint64 throttleReadBytes = 0;	/* Bytes read under throttling */
+static uint64 throttleReads = 0;	/* Reads issued under throttling */
+static double throttleSleepSecs = 0;	/* Total time readers slept */
+
+/*
+ * --progress and --progress-fd: Periodic progress reports for long scans.
+ * Every thread that processes blocks adds to the shared counters with atomic
+ * instructions.  The clock is only checked every PROGRESS_CHECK_BLOCKS
+ * blocks, and a report is only written when PROGRESS_INTERVAL_SECS have
+ * passed since the last one.
+ */
+#define PROGRESS_CHECK_BLOCKS	64
+#define PROGRESS_INTERVAL_SECS	1.0
+
+static bool progressHuman = false;	/* --progress */
+static int	progressFd = -1;	/* --progress-fd */
+static pthread_mutex_t progressLock = PTHREAD_MUTEX_INITIALIZER;
+static struct timespec progressStart;
+static double progressNextReport = PROGRESS_INTERVAL_SECS;
+static uint64 progressTotalBlocks = 0;
+static uint64 progressBlocks = 0;	/* Blocks processed so far */
+static uint64 progressTags = 0; /* Tags emitted so far */
+static uint64 progressOutput = 0;	/* Output bytes written so far */
+
+#endif							/* PG_HEXEDIT_EXTENSION */
+
+/* Bytes of wxHexEditor XML tags written by the current thread */
+static __thread uint64 xmlTagBytes = 0;
+
+#ifndef PG_HEXEDIT_EXTENSION
+
+/* How a non-NULL attribute value is stored (used by --column-stats) */
+typedef enum columnValueKinds
+{
+	COLUMN_VALUE_NULL,			/* NULL, or beyond tuple's natts */
+	COLUMN_VALUE_PLAIN,			/* Inline, not compressed */
+	COLUMN_VALUE_COMPRESSED,	/* Inline, compressed */
+	COLUMN_VALUE_EXTERNAL		/* External on-disk TOAST pointer */
+} columnValueKinds;
+
+/* Compression method of compressed value (used by --column-stats) */
+typedef enum columnCompressionMethods
+{
+	COLUMN_COMPRESSION_NONE,
+	COLUMN_COMPRESSION_PGLZ,
+	COLUMN_COMPRESSION_LZ4
+} columnCompressionMethods;
+
+/* Per-attribute --column-stats statistics */
+typedef struct ColumnStats
+{
+	uint64		nnull;			/* NULL values */
+	uint64		nvalues;		/* Non-NULL values */
+	uint64		totalWidth;		/* Sum of stored widths of non-NULL values */
+	uint32		maxWidth;		/* Largest stored width */
+	uint64		ncompressed;	/* Inline compressed values */
+	uint64		nexternal;		/* External on-disk TOAST pointers */
+	uint64		npglz;			/* pglz compressed (inline or external) */
+	uint64		nlz4;			/* lz4 compressed (inline or external) */
+} ColumnStats;
+
+/* Per-worker --column-stats state */
+typedef struct ColumnStatsState
+{
+	uint64		nheappages;		/* Heap pages scanned */
+	uint64		nskippedpages;	/* New or non-heap pages skipped */
+	uint64		ntuples;		/* Tuples accumulated */
+	uint64		ndead;			/* Tuples skipped as hinted dead */
+	uint64		nmalformed;		/* Tuples skipped as malformed */
+	ColumnStats *cols;			/* Array of nrelatts entries */
+	uint32	   *widths;			/* Scratch space for current tuple */
+	uint8	   *kinds;			/* Scratch space for current tuple */
+	uint8	   *methods;		/* Scratch space for current tuple */
+} ColumnStatsState;
+
+/* --salvage: COPY BINARY output file, and its name */
+static FILE *salvageFp = NULL;
+static char *salvageFileName = NULL;
+
+/* --salvage-bytea: Comma separated attribute names, and per-attribute flags */
+static char *byteaAttrList = NULL;
+static bool *byteasalvagerel = NULL;
+
+/*
+ * Workers buffer COPY BINARY rows, and append them to salvageFp while holding
+ * salvageLock once SALVAGE_FLUSH_SIZE bytes have accumulated
+ */
+#define SALVAGE_FLUSH_SIZE		(1024 * 1024)
+static pthread_mutex_t salvageLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Values larger than this can't have been stored by the server, so sizes
+ * from damaged varlena headers and TOAST pointers are rejected before any
+ * allocation is made for them (same as utils/memutils.h)
+ */
+#ifndef MaxAllocSize
+#define MaxAllocSize			((Size) 0x3fffffff)
+#endif
+
+/* Per-worker --salvage state */
+typedef struct SalvageState
+{
+	uint64		nheappages;		/* Heap pages scanned */
+	uint64		nskippedpages;	/* New or non-heap pages skipped */
+	uint64		ntuples;		/* Tuples written */
+	uint64		ninvisible;		/* Tuples skipped by --visible-only */
+	uint64		ndamaged;		/* Tuples skipped as damaged */
+	StringInfoData buf;			/* Buffered COPY BINARY rows */
+	int			tupleStart;		/* Length of buf before current tuple */
+	const char *problem;		/* Why current tuple can't be salvaged */
+} SalvageState;
+
+/* --check-utf8: Comma separated attribute names, and per-attribute flags */
+static char *utf8AttrList = NULL;
+static bool *utf8checkrel = NULL;
+static int	lastUtf8Att = -1;
+
+/* --lsn-heatmap: Number of block ranges */
+static int	heatmapRanges = 0;
+
+/* --lsn-cutoff: LSN cutoffs that modified pages are listed for */
+#define MAX_LSN_CUTOFFS			16
+static XLogRecPtr lsnCutoffs[MAX_LSN_CUTOFFS];
+static int	nlsnCutoffs = 0;
+
+/* --bookmarks: File that GoToOffset lines for hottest ranges are written to */
+static char *bookmarksFileName = NULL;
+#define MAX_BOOKMARKS			10
+
+/* --fpw-estimate: Number of block ranges */
+static int	fpwRanges = 0;
+
+/* --redo: Checkpoint REDO LSNs that dirtied pages are counted for */
+static XLogRecPtr redoLsns[MAX_LSN_CUTOFFS];
+static int	nredoLsns = 0;
+
+/*
+ * --lsn-heatmap and --fpw-estimate: Page LSN of each scanned block, indexed
+ * by block number.  --fpw-estimate also records the length of each page's
+ * hole, which full-page images omit.
+ */
+static XLogRecPtr *pageLsns = NULL;
+static uint16 *pageHoles = NULL;
+
+/* --lsn-heatmap block range */
+typedef struct HeatmapRange
+{
+	BlockNumber start;			/* First file block in range */
+	BlockNumber end;			/* Last file block in range */
+	uint32		npages;			/* Pages with an LSN */
+	XLogRecPtr	minLsn;			/* Oldest page LSN in range */
+	XLogRecPtr	maxLsn;			/* Newest page LSN in range */
+	BlockNumber maxLsnBlock;	/* Block whose LSN is maxLsn */
+	double		heat;			/* Mean recency of pages, from 0.0 to 1.0 */
+} HeatmapRange;
+
+/* --metrics: Prometheus text file that metrics are written to */
+static char *metricsFileName = NULL;
+
+/* --metrics: Data directory given in place of a relation file, if any */
+static char *metricsDataDir = NULL;
+
+/* Page types that --metrics counts */
+typedef enum metricsPageTypes
+{
+	METRICS_PAGE_NEW = 0,		/* All-zeroes page */
+	METRICS_PAGE_HEAP,			/* Page without a special section */
+	METRICS_PAGE_BTREE,
+	METRICS_PAGE_HASH,
+	METRICS_PAGE_GIST,
+	METRICS_PAGE_GIN,
+	METRICS_PAGE_SPGIST,
+	METRICS_PAGE_BRIN,
+	METRICS_PAGE_SEQUENCE,
+	METRICS_PAGE_PLUGIN,		/* Access method decoded by --plugin */
+	METRICS_PAGE_UNKNOWN,		/* Special section not recognized */
+	METRICS_PAGE_INVALID,		/* Page header is invalid */
+	METRICS_PAGE_NTYPES
+} metricsPageTypes;
+
+static const char *const metricsPageTypeNames[METRICS_PAGE_NTYPES] = {
+	"new", "heap", "btree", "hash", "gist", "gin", "spgist", "brin",
+	"sequence", "plugin", "unknown", "invalid"
+};
+
+/* Per-worker (and per-relation) --metrics state */
+typedef struct MetricsState
+{
+	uint64		nblocks;		/* Blocks scanned */
+	uint64		npages[METRICS_PAGE_NTYPES];	/* Pages of each type */
+	uint64		freeBytes;		/* Space between pd_lower and pd_upper */
+	uint64		nitems;			/* Line pointers */
+	uint64		ndeadItems;		/* LP_DEAD line pointers */
+	uint64		ndeadTuples;	/* Heap tuples that hint bits show are dead */
+	uint64		nchecksumFailures;	/* Pages with incorrect checksum */
+	TransactionId oldestXid;	/* Oldest unfrozen heap XID, if any */
+	bool		invalidPage;	/* Current page's header has an anomaly? */
+	metricsPageTypes pageType;	/* Type of current page */
+} MetricsState;
+
+/* --metrics: Main fork segment file to scan */
+typedef struct MetricsFile
+{
+	char	   *path;			/* Path to open */
+	char	   *relPath;		/* Relation's label, without segment suffix */
+	unsigned int segno;			/* Segment number */
+	off_t		size;			/* Size when directory was read */
+} MetricsFile;
+
+static MetricsFile *metricsFiles = NULL;
+static int	nmetricsFiles = 0;
+static int	maxMetricsFiles = 0;
+
+/* --metrics: Relation whose segment files are aggregated */
+typedef struct MetricsRelation
+{
+	char	   *path;			/* Label, from MetricsFile.relPath */
+	MetricsState state;
+} MetricsRelation;
+
+/* --check: File that the anomaly list is written to */
+static char *checkFileName = NULL;
+
+#endif							/* PG_HEXEDIT_EXTENSION */
+
+/*
+ * Kinds of page anomaly.  Page sanity checks report these through a
+ * PageProblemCallback, and --check lists them by name.
+ */
+typedef enum checkAnomalyCodes
+{
+	CHECK_CHECKSUM = 0,
+	CHECK_PAGE_SIZE,
+	CHECK_LAYOUT_VERSION,
+	CHECK_LOWER_BEFORE_HEADER,
+	CHECK_LOWER_AFTER_UPPER,
+	CHECK_UPPER_AFTER_SPECIAL,
+	CHECK_SPECIAL_PAST_END,
+	CHECK_SPECIAL_UNKNOWN,
+	CHECK_SPECIAL_CHANGED,
+	CHECK_MAX_OFFSET,
+	CHECK_ITEM_ZERO_LENGTH,
+	CHECK_ITEM_HAS_LENGTH,
+	CHECK_ITEM_PAST_END,
+	CHECK_ITEM_OUTSIDE_TUPLES,
+	CHECK_ITEM_OVERLAP,
+	CHECK_REDIRECT_TARGET,
+	CHECK_TUPLE_TOO_SHORT,
+	CHECK_TUPLE_HOFF,
+	CHECK_TUPLE_NULL_BITMAP,
+	CHECK_INDEX_TUPLE_SIZE,
+	CHECK_NCODES
+} checkAnomalyCodes;
+
+static const char *const checkAnomalyNames[CHECK_NCODES] = {
+	"checksum_mismatch",
+	"bad_page_size",
+	"bad_layout_version",
+	"pd_lower_before_header_end",
+	"pd_lower_after_pd_upper",
+	"pd_upper_after_pd_special",
+	"pd_special_past_block_end",
+	"unknown_special_section",
+	"special_section_type_changed",
+	"bad_max_offset",
+	"lp_normal_zero_length",
+	"lp_unused_or_redirect_has_length",
+	"item_past_block_end",
+	"item_outside_tuple_space",
+	"items_overlap",
+	"bad_redirect_target",
+	"tuple_shorter_than_header",
+	"bad_t_hoff",
+	"null_bitmap_past_t_hoff",
+	"index_tuple_size_exceeds_lp_len"
+};
+
+/*
+ * Callback that page sanity checks report each anomaly through.  start and
+ * end are the page offsets of the first and last bytes that the anomaly
+ * involves, and detail gives the values involved.
+ */
+typedef void (*PageProblemCallback) (void *arg, BlockNumber blkno,
+									 OffsetNumber offset,
+									 checkAnomalyCodes code,
+									 unsigned int start, unsigned int end,
+									 const char *detail);
+
+/* Outcome of VerifyPageChecksum() */
+typedef enum pageChecksumResults
+{
+	PAGE_CHECKSUM_SKIPPED = 0,	/* New page, or zero checksum without -k */
+	PAGE_CHECKSUM_VALID,
+	PAGE_CHECKSUM_INVALID
+} pageChecksumResults;
+
+#ifndef PG_HEXEDIT_EXTENSION
+
+/*
+ * Consumer of the pages that a parallel block scan reads, and of their items,
+ * tuples, and attributes.  WalkPage() checks each of these before it is
+ * passed to the visitor, so that scan modes that don't emit tags agree with
+ * each other (and with EmitXmlPage()) about what is well-formed.  Callbacks
+ * that are NULL are skipped, and each callback is passed the worker's state
+ * as arg.
+ */
+typedef struct PageVisitor
+{
+	/*
+	 * Called for each page.  sane is false for new pages, and for pages whose
+	 * header can't be used to locate all of their contents.  Returns false to
+	 * skip the rest of the page.  Otherwise the page's items are visited
+	 * whenever its line pointer array fits on the page.
+	 */
+	bool		(*onPage) (Page page, BlockNumber blkno, bool sane, void *arg);
+
+	/*
+	 * Called for each line pointer of a page that has them.  hasStorage is
+	 * true when the item's storage is known to be on the page.  Returns false
+	 * to skip the item's tuple.
+	 */
+	bool		(*onItemId) (Page page, BlockNumber blkno, OffsetNumber offset,
+							 ItemId itemId, bool hasStorage, void *arg);
+
+	/*
+	 * Called for each heap tuple whose header is sane.  Returns the number of
+	 * leading attributes to locate and pass to onAttribute, or 0 for none.
+	 */
+	int			(*onHeapTuple) (Page page, BlockNumber blkno,
+								OffsetNumber offset, HeapTupleHeader htup,
+								unsigned int itemSize, void *arg);
+
+	/*
+	 * Called for each attribute that was located.  Returns false to stop at
+	 * attnum.
+	 */
+	bool		(*onAttribute) (BlockNumber blkno, OffsetNumber offset,
+								int attnum, const AttributeSpan *span,
+								void *arg);
+
+	/*
+	 * Called once attributes that onHeapTuple asked for have been visited.
+	 * badAttnum is the attribute that could not be located, or that
+	 * onAttribute stopped at, or -1.
+	 */
+	void		(*onHeapTupleEnd) (BlockNumber blkno, OffsetNumber offset,
+								   int badAttnum, void *arg);
+
+	/* Called for each btree, hash, GiST, and GIN index tuple */
+	void		(*onIndexTuple) (Page page, BlockNumber blkno,
+								 OffsetNumber offset, IndexTuple itup,
+								 unsigned int itemSize, void *arg);
+
+	/* Called once page's items have been visited */
+	void		(*onPageEnd) (Page page, BlockNumber blkno, void *arg);
+
+	/* Called for each anomaly found while checking the page */
+	PageProblemCallback onProblem;
+} PageVisitor;
+
+/* Parallel block scan worker */
+typedef struct ScanWorker
+{
+	pthread_t	thread;
+	int			fd;				/* Descriptor of file being scanned */
+	const PageVisitor *visitor; /* Visits each block read */
+	void	   *state;			/* Worker-private visitor state */
+} ScanWorker;
+
+/* --check anomaly */
+typedef struct CheckAnomaly
+{
+	BlockNumber blkno;			/* File block */
+	OffsetNumber offset;		/* Item, or InvalidOffsetNumber for page */
+	uint8		code;			/* checkAnomalyCodes */
+	uint16		start;			/* First byte of page to tag */
+	uint16		end;			/* Last byte of page to tag */
+	char		detail[64];		/* Values involved */
+} CheckAnomaly;
+
+/* Storage of an item, used by --check to find overlapping items */
+typedef struct CheckItemSpan
+{
+	uint16		start;
+	uint16		end;			/* One past last byte */
+	OffsetNumber offset;
+} CheckItemSpan;
+
+/* Per-worker --check state */
+typedef struct CheckState
+{
+	uint64		npages;			/* Pages scanned */
+	CheckAnomaly *anomalies;
+	int			nanomalies;
+	int			maxanomalies;
+	CheckItemSpan *spans;		/* Scratch space for current page */
+	int			nspans;
+} CheckState;
+
+/*
+ * --check: Special section type of each scanned block, indexed by block
+ * number, so that type changes can be found once all workers are done.
+ * Blocks that are new, or that weren't scanned, are CHECK_TYPE_NONE.
+ */
+#define CHECK_TYPE_NONE			0xFF
+static uint8 *checkPageTypes = NULL;
+
+/* --fsync: When --fix-checksums (or --apply) flushes its writes to disk */
+typedef enum fixChecksumsFsyncPolicies
+{
+	FIX_FSYNC_END = 0,			/* Once, after every page is fixed */
+	FIX_FSYNC_EACH,				/* After each page is fixed */
+	FIX_FSYNC_NONE				/* Leave it to the OS */
+} fixChecksumsFsyncPolicies;
+
+static fixChecksumsFsyncPolicies fixFsyncPolicy = FIX_FSYNC_END;
+static bool fixFsyncPolicySet = false;
+
+/* --fix-checksums: Writable descriptor for relation file */
+static int	fixFd = -1;
+
+/* --baseline: Snapshot of relation file from before it was edited */
+static char *baselineFileName = NULL;
+static int	baselineFd = -1;
+
+/* Checksum that --fix-checksums rewrote */
+typedef struct FixedChecksum
+{
+	BlockNumber blkno;			/* File block */
+	uint16		stored;			/* Incorrect checksum that was on page */
+	uint16		calculated;		/* Checksum that replaced it */
+} FixedChecksum;
+
+/* Per-worker --fix-checksums state */
+typedef struct FixChecksumsState
+{
+	uint64		nverified;		/* Pages whose checksum was verified */
+	uint64		nunchanged;		/* Pages skipped as same as --baseline */
+	uint64		nfailed;		/* Pages whose checksum couldn't be written */
+	FixedChecksum *fixed;
+	int			nfixed;
+	int			maxfixed;
+	char	   *baselinePage;	/* Scratch space for --baseline page */
+} FixChecksumsState;
+
+/* --apply: Patch file of field assignments */
+static char *applyFileName = NULL;
+
+/* --apply: Assignment operator of patch entry */
+typedef enum patchOperators
+{
+	PATCH_SET = 0,				/* = */
+	PATCH_OR,					/* |= */
+	PATCH_AND,					/* &= */
+	PATCH_XOR					/* ^= */
+} patchOperators;
+
+/* --apply: One field assignment from patch file */
+typedef struct PatchEntry
+{
+	int			line;			/* Line number within patch file */
+	BlockNumber blkno;			/* File block */
+	OffsetNumber offset;		/* Tuple's offset, or InvalidOffsetNumber for
+								 * page field */
+	char		field[NAMEDATALEN]; /* Name of field's tag */
+	bool		attribute;		/* field is attr[name] attribute? */
+	patchOperators op;
+	uint64		value;			/* Numeric value */
+	char	   *bytes;			/* Byte string value, or NULL if numeric */
+	int			nbytes;
+	char	   *oldValue;		/* Field before entry was applied */
+	char	   *newValue;		/* Field after entry was applied */
+} PatchEntry;
+
+/*
+ * --apply: Constant that patch file values may use instead of a number.
+ * Special area flags (such as BTP_LEAF) come from field descriptors instead.
+ */
+typedef struct PatchSymbol
+{
+	const char *name;
+	uint64		value;
+} PatchSymbol;
+
+static const PatchSymbol patchSymbols[] = {
+	/* t_infomask */
+	{"HEAP_HASNULL", HEAP_HASNULL},
+	{"HEAP_HASVARWIDTH", HEAP_HASVARWIDTH},
+	{"HEAP_HASEXTERNAL", HEAP_HASEXTERNAL},
+	{"HEAP_XMAX_KEYSHR_LOCK", HEAP_XMAX_KEYSHR_LOCK},
+	{"HEAP_COMBOCID", HEAP_COMBOCID},
+	{"HEAP_XMAX_EXCL_LOCK", HEAP_XMAX_EXCL_LOCK},
+	{"HEAP_XMAX_LOCK_ONLY", HEAP_XMAX_LOCK_ONLY},
+	{"HEAP_XMAX_SHR_LOCK", HEAP_XMAX_SHR_LOCK},
+	{"HEAP_XMIN_COMMITTED", HEAP_XMIN_COMMITTED},
+	{"HEAP_XMIN_INVALID", HEAP_XMIN_INVALID},
+	{"HEAP_XMIN_FROZEN", HEAP_XMIN_FROZEN},
+	{"HEAP_XMAX_COMMITTED", HEAP_XMAX_COMMITTED},
+	{"HEAP_XMAX_INVALID", HEAP_XMAX_INVALID},
+	{"HEAP_XMAX_IS_MULTI", HEAP_XMAX_IS_MULTI},
+	{"HEAP_UPDATED", HEAP_UPDATED},
+	{"HEAP_MOVED_OFF", HEAP_MOVED_OFF},
+	{"HEAP_MOVED_IN", HEAP_MOVED_IN},
+	/* t_infomask2 */
+	{"HEAP_NATTS_MASK", HEAP_NATTS_MASK},
+	{"HEAP_KEYS_UPDATED", HEAP_KEYS_UPDATED},
+	{"HEAP_HOT_UPDATED", HEAP_HOT_UPDATED},
+	{"HEAP_ONLY_TUPLE", HEAP_ONLY_TUPLE},
+	/* lp_flags */
+	{"LP_UNUSED", LP_UNUSED},
+	{"LP_NORMAL", LP_NORMAL},
+	{"LP_REDIRECT", LP_REDIRECT},
+	{"LP_DEAD", LP_DEAD},
+	/* pd_flags */
+	{"PD_HAS_FREE_LINES", PD_HAS_FREE_LINES},
+	{"PD_PAGE_FULL", PD_PAGE_FULL},
+	{"PD_ALL_VISIBLE", PD_ALL_VISIBLE},
+	/* Special values of transaction IDs, blocks, and offsets */
+	{"InvalidTransactionId", InvalidTransactionId},
+	{"BootstrapTransactionId", BootstrapTransactionId},
+	{"FrozenTransactionId", FrozenTransactionId},
+	{"FirstNormalTransactionId", FirstNormalTransactionId},
+	{"P_NONE", P_NONE},
+	{"InvalidBlockNumber", InvalidBlockNumber},
+	{"InvalidOffsetNumber", InvalidOffsetNumber}
+};
+
+/* --inject: Directory that corrupted copies of relation file are written to */
+static char *injectDirName = NULL;
+
+/* --inject: Classes of field that --classes can choose to corrupt */
+typedef enum injectClasses
+{
+	INJECT_LP = 0,				/* Line pointers */
+	INJECT_TUPLE,				/* Heap and index tuple headers */
+	INJECT_BTREE,				/* nbtree special area and metapage */
+	INJECT_POSTING,				/* nbtree and GIN entry tree posting lists */
+	INJECT_GIN,					/* GIN posting tree segments and items, and
+								 * GIN special area */
+	INJECT_PAGE,				/* Page header */
+	INJECT_NCLASSES
+} injectClasses;
+
+static const char *const injectClassNames[] = {
+	"lp", "tuple", "btree", "posting", "gin", "page"
+};
+
+/* --inject options, with their defaults */
+static int	injectVariants = 1;
+static int	injectCorruptions = 1;
+static uint32 injectClassMask = (1 << INJECT_NCLASSES) - 1;
+static uint64 injectSeed = 0;
+static bool injectSeedSet = false;
+static bool injectOptionSet = false;
+
+/* --session: wxHexEditor session config file that is written with tags */
+static char *sessionFileName = NULL;
+
+/* --session: Kinds of page whose first page gets a bookmark */
+typedef enum sessionPageKinds
+{
+	SESSION_PAGE_ROOT = 0,		/* Index root page */
+	SESSION_PAGE_META,			/* Index metapage */
+	SESSION_PAGE_INTERNAL,		/* Index internal page */
+	SESSION_PAGE_LEAF,			/* Index leaf page */
+	SESSION_PAGE_DELETED,		/* Deleted index page */
+	SESSION_PAGE_POSTING,		/* GIN posting tree page */
+	SESSION_PAGE_OVERFLOW,		/* Hash overflow page */
+	SESSION_PAGE_BITMAP,		/* Hash bitmap page */
+	SESSION_PAGE_REVMAP,		/* BRIN revmap page */
+	SESSION_PAGE_DATA,			/* Any other page, such as a heap page */
+	SESSION_PAGE_NKINDS
+} sessionPageKinds;
+
+/* --session: File-relative blocks that get bookmarks */
+#define MAX_SESSION_ERROR_PAGES		10
+#define MAX_SESSION_NEWEST_PAGES	5
+#define SESSION_DECILES				10
+#define MAX_SESSION_BOOKMARKS		(SESSION_PAGE_NKINDS + \
+									 MAX_SESSION_ERROR_PAGES + \
+									 MAX_SESSION_NEWEST_PAGES + \
+									 SESSION_DECILES - 1)
+static BlockNumber sessionFirstOfKind[SESSION_PAGE_NKINDS];
+static BlockNumber sessionErrorBlocks[MAX_SESSION_ERROR_PAGES];
+static int	nsessionErrorBlocks = 0;
+static BlockNumber sessionNewestBlocks[MAX_SESSION_NEWEST_PAGES];
+static XLogRecPtr sessionNewestLsns[MAX_SESSION_NEWEST_PAGES];
+static int	nsessionNewestBlocks = 0;
+
+/* --shard-blocks: Number of blocks in each shard of tags */
+static int	shardBlocks = 0;
+
+/* --shard-blocks: Block range of one tags file, and its manifest entry */
+typedef struct TagShard
+{
+	BlockNumber start;			/* First file block in shard */
+	BlockNumber end;			/* Last file block in shard */
+	char	   *fileName;		/* Shard's tags file */
+	uint32		npages;			/* Pages tagged */
+	XLogRecPtr	minLsn;			/* Oldest page LSN among tagged pages */
+	XLogRecPtr	maxLsn;			/* Newest page LSN among tagged pages */
+	unsigned int ntags;			/* Tags emitted */
+	bool		written;		/* Was tags file written? */
+} TagShard;
+
+static TagShard *tagShards = NULL;
+static int	ntagShards = 0;
+static int	nextTagShard = 0;	/* Protected by scanLock */
+
+/* --shard-blocks: Options echoed in each shard's header */
+static int	shardNumOptions = 0;
+static char **shardOptions = NULL;
+
+/* --serve: Unix socket that tag requests are answered on */
+static char *serveSocketPath = NULL;
+static volatile sig_atomic_t serveShutdown = 0;
+
+#define SERVE_MAX_CLIENTS		16	/* Concurrent client connections */
+#define SERVE_MAX_BLOCKS		1024	/* Blocks in one request */
+#define SERVE_MAX_REQUEST		256 /* Bytes in one request line */
+
+/*
+ * --serve: State of one client connection.  Client sockets are non-blocking,
+ * so responses that the client isn't ready for yet are queued in output.
+ */
+typedef struct ServeClient
+{
+	StringInfoData request;		/* Incomplete request line */
+	StringInfoData output;		/* Queued responses */
+	int			outputDone;		/* Bytes of output already written */
+} ServeClient;
+
+/*
+ * --serve and --view: Each page is only read and decoded when its tags are
+ * first needed.  Tags of recently used pages are kept in an LRU cache.
+ */
+#define TAG_CACHE_PAGES			1024
+
+/* Cached tags for one page, and its LRU list links */
+typedef struct TagCacheEntry
+{
+	BlockNumber blkno;			/* File-relative block */
+	char	   *xml;			/* Tags emitted by EmitXmlPage() */
+	size_t		len;			/* Length of xml */
+	int			prev;			/* More recently used entry, or -1 */
+	int			next;			/* Less recently used entry, or -1 */
+} TagCacheEntry;
+
+static TagCacheEntry *tagCache = NULL;
+static int	ntagCache = 0;
+static int	tagCacheLruHead = -1;	/* Most recently used entry */
+static int	tagCacheLruTail = -1;	/* Least recently used entry */
+static int *tagCacheSlots = NULL; /* Cache entry of each block, or -1 */
+static BlockNumber relationBlocks = 0; /* Blocks in file, at startup */
+static uint64 tagCacheHits = 0;
+static uint64 tagCacheMisses = 0;
+
+#endif							/* PG_HEXEDIT_EXTENSION */
+
+/* --view and --html: Tag of a page, collected by pageTagsVisitor */
+typedef struct PageTag
+{
+	uint32		start;			/* File offset of first byte */
+	uint32		end;			/* File offset of last byte */
+	char	   *text;			/* Tag text */
+	char		fontColor[8];	/* "#RRGGBB" font color */
+	char		noteColor[8];	/* "#RRGGBB" note color */
+	short		pair;			/* --view curses color pair */
+} PageTag;
+
+#ifndef PG_HEXEDIT_EXTENSION
+
+/* --view: Parsed tags of one page, and innermost tag of each of its bytes */
+typedef struct ViewerPage
+{
+	BlockNumber blkno;			/* File-relative block */
+	bool		unreadable;		/* Block couldn't be read (data is zeroes) */
+	char	   *data;			/* Contents of block */
+	int			ntags;			/* Number of tags */
+	PageTag    *tags;			/* Tags, widest first */
+	int		   *owner;			/* Innermost tag of each byte, or -1 */
+} ViewerPage;
+
+#define VIEWER_PAGES			4	/* Parsed pages, direct-mapped by block */
+#define VIEWER_STATUS_LINES		8	/* Lines below hex dump */
+#define VIEWER_MAX_PAIRS		256 /* Curses color pairs used for tags */
+
+static ViewerPage viewerPages[VIEWER_PAGES];
+static short viewerPairColors[VIEWER_MAX_PAIRS][2];
+static int	nviewerPairs = 0;
+
+/* --html: Blocks of file written to each chunk file */
+#define HTML_CHUNK_BLOCKS		16
+
+static char *htmlDirName = NULL;
+
+/* --html: index.html, before and after the report's manifest */
+static const char *htmlReportHead =
+	"<!DOCTYPE html>\n"
+	"<html>\n"
+	"<head>\n"
+	"<meta charset=\"utf-8\">\n"
+	"<title>pg_hexedit</title>\n"
+	"<style>\n"
+	"body { margin: 0; font: 13px monospace; display: flex; height: 100vh; }\n"
+	"#grid { flex: 1; overflow-y: scroll; position: relative; }\n"
+	"#rows { position: absolute; left: 0; right: 0; padding: 0 8px; }\n"
+	"#rows div { height: 16px; line-height: 16px; white-space: pre; }\n"
+	"#rows span.cursor { outline: 2px solid #000; }\n"
+	"#side { width: 40%; overflow-y: auto; border-left: 1px solid #999; padding: 8px; }\n"
+	"#side div { margin: 2px 0; padding: 2px 4px; white-space: pre-wrap; }\n"
+	"</style>\n"
+	"</head>\n"
+	"<body>\n"
+	"<div id=\"grid\"><div id=\"spacer\"></div><div id=\"rows\"></div></div>\n"
+	"<div id=\"side\">\n"
+	"<form id=\"goto\">Go to block, TID (b,o), or offset 0x...: <input id=\"target\" size=\"16\"></form>\n"
+	"<p id=\"where\"></p>\n"
+	"<div id=\"tags\"></div>\n"
+	"</div>\n"
+	"<script>\n"
+	"var M = \n";
+
+static const char *htmlReportTail =
+	";\n"
+	"var LH = 16, BPL = 16, MAXH = 8000000, MAXCHUNKS = 16;\n"
+	"var chunkBytes = M.chunkBlocks * M.blockSize;\n"
+	"var base = M.firstBlock * M.blockSize;\n"
+	"var total = (M.lastBlock - M.firstBlock + 1) * M.blockSize;\n"
+	"var nlines = Math.ceil(total / BPL);\n"
+	"var chunks = {}, loading = {}, lru = [], cursor = base;\n"
+	"var grid = document.getElementById(\"grid\");\n"
+	"var rows = document.getElementById(\"rows\");\n"
+	"document.getElementById(\"spacer\").style.height = Math.min(nlines * LH, MAXH) + \"px\";\n"
+	"function hex(n, w) { var s = n.toString(16).toUpperCase(); while (s.length < w) s = \"0\" + s; return s; }\n"
+	"function visibleLines() { return Math.max(1, Math.floor(grid.clientHeight / LH)); }\n"
+	"function maxTop() { return Math.max(0, nlines - visibleLines()); }\n"
+	"function topLine() {\n"
+	"  var range = grid.scrollHeight - grid.clientHeight;\n"
+	"  return range > 0 ? Math.round(grid.scrollTop / range * maxTop()) : 0;\n"
+	"}\n"
+	"function pgHexeditChunk(c) {\n"
+	"  var raw = atob(c.bytes), bytes = new Uint8Array(raw.length);\n"
+	"  var owner = new Int32Array(raw.length).fill(-1);\n"
+	"  for (var i = 0; i < raw.length; i++) bytes[i] = raw.charCodeAt(i);\n"
+	"  /* Tags are widest first within each block, so innermost tags win */\n"
+	"  c.tags.forEach(function(t, n) {\n"
+	"    for (var o = Math.max(t[0], c.offset); o <= t[1] && o < c.offset + raw.length; o++)\n"
+	"      owner[o - c.offset] = n;\n"
+	"  });\n"
+	"  chunks[c.chunk] = { offset: c.offset, bytes: bytes, tags: c.tags, owner: owner };\n"
+	"  delete loading[c.chunk];\n"
+	"  lru.push(c.chunk);\n"
+	"  while (lru.length > MAXCHUNKS) {\n"
+	"    var old = lru.shift();\n"
+	"    delete chunks[old];\n"
+	"    var el = document.getElementById(\"chunk\" + old);\n"
+	"    if (el) el.remove();\n"
+	"  }\n"
+	"  render();\n"
+	"}\n"
+	"function chunkOf(off) {\n"
+	"  var k = Math.floor((off - base) / chunkBytes), c = chunks[k];\n"
+	"  if (c) {\n"
+	"    lru.splice(lru.indexOf(k), 1);\n"
+	"    lru.push(k);\n"
+	"  } else if (!loading[k]) {\n"
+	"    loading[k] = true;\n"
+	"    var s = document.createElement(\"script\");\n"
+	"    s.id = \"chunk\" + k;\n"
+	"    s.src = \"chunk-\" + k + \".js\";\n"
+	"    document.body.appendChild(s);\n"
+	"  }\n"
+	"  return c;\n"
+	"}\n"
+	"function render() {\n"
+	"  var first = topLine(), n = visibleLines() + 1, html = [];\n"
+	"  rows.style.top = grid.scrollTop + \"px\";\n"
+	"  for (var l = first; l < Math.min(first + n, nlines); l++) {\n"
+	"    var off = base + l * BPL, c = chunkOf(off), line = hex(off, 8) + \" \", text = \"\";\n"
+	"    for (var i = 0; i < BPL && off + i < base + total; i++) {\n"
+	"      var o = off + i, cls = o == cursor ? ' class=\"cursor\"' : \"\";\n"
+	"      if (!c) { line += \"   \"; continue; }\n"
+	"      var b = c.bytes[o - c.offset], t = c.tags[c.owner[o - c.offset]];\n"
+	"      var style = t ? ' style=\"color:' + t[3] + ';background:' + t[4] + '\"' : \"\";\n"
+	"      line += '<span data-off=\"' + o + '\"' + cls + style + \">\" + hex(b, 2) + \"</span> \";\n"
+	"      text += b >= 32 && b < 127 ? \"&#\" + b + \";\" : \".\";\n"
+	"    }\n"
+	"    html.push(\"<div>\" + line + \" \" + text + \"</div>\");\n"
+	"  }\n"
+	"  rows.innerHTML = html.join(\"\");\n"
+	"}\n"
+	"function showTags(off) {\n"
+	"  var c = chunks[Math.floor((off - base) / chunkBytes)], blk = Math.floor(off / M.blockSize);\n"
+	"  var list = document.getElementById(\"tags\");\n"
+	"  document.getElementById(\"where\").textContent = \"file offset \" + off + \"  block \" + blk +\n"
+	"    \" (relation block \" + (blk + M.segmentBlockDelta) + \")  page offset \" + off % M.blockSize;\n"
+	"  list.innerHTML = \"\";\n"
+	"  if (!c) return;\n"
+	"  for (var n = c.tags.length - 1; n >= 0; n--) {\n"
+	"    var t = c.tags[n];\n"
+	"    if (off < t[0] || off > t[1]) continue;\n"
+	"    var d = document.createElement(\"div\");\n"
+	"    d.textContent = t[2];\n"
+	"    d.style.color = t[3];\n"
+	"    d.style.background = t[4];\n"
+	"    list.appendChild(d);\n"
+	"  }\n"
+	"}\n"
+	"function goTo(off) {\n"
+	"  off = Math.max(base, Math.min(off, base + total - 1));\n"
+	"  cursor = off;\n"
+	"  var line = Math.min(Math.floor((off - base) / BPL), maxTop());\n"
+	"  var range = grid.scrollHeight - grid.clientHeight;\n"
+	"  grid.scrollTop = maxTop() > 0 ? line / maxTop() * range : 0;\n"
+	"  render();\n"
+	"  if (chunks[Math.floor((off - base) / chunkBytes)]) showTags(off);\n"
+	"}\n"
+	"grid.addEventListener(\"scroll\", render);\n"
+	"document.addEventListener(\"keydown\", function(e) {\n"
+	"  var moves = { ArrowLeft: -1, ArrowRight: 1, ArrowUp: -BPL, ArrowDown: BPL,\n"
+	"                PageUp: -BPL * visibleLines(), PageDown: BPL * visibleLines() };\n"
+	"  if (e.target.tagName == \"INPUT\" || !(e.key in moves)) return;\n"
+	"  e.preventDefault();\n"
+	"  goTo(cursor + moves[e.key]);\n"
+	"});\n"
+	"window.addEventListener(\"resize\", render);\n"
+	"rows.addEventListener(\"click\", function(e) {\n"
+	"  var off = e.target.getAttribute(\"data-off\");\n"
+	"  if (off !== null) { cursor = +off; render(); showTags(cursor); }\n"
+	"});\n"
+	"document.getElementById(\"goto\").addEventListener(\"submit\", function(e) {\n"
+	"  var v = document.getElementById(\"target\").value.trim(), m;\n"
+	"  e.preventDefault();\n"
+	"  if ((m = v.match(/^\\(?\\s*(\\d+)\\s*,\\s*(\\d+)\\s*\\)?$/)))\n"
+	"    goTo((+m[1] - M.segmentBlockDelta) * M.blockSize + M.itemIdStart + (+m[2] - 1) * 4);\n"
+	"  else if (/^0x[0-9a-f]+$/i.test(v))\n"
+	"    goTo(parseInt(v, 16));\n"
+	"  else if (/^\\d+$/.test(v))\n"
+	"    goTo(+v * M.blockSize);\n"
+	"});\n"
+	"render();\n"
+	"</script>\n"
+	"</body>\n"
+	"</html>\n";
+
+/* Inline uncompressed attribute value that is not valid UTF-8 */
+typedef struct Utf8Problem
+{
+	BlockNumber blkno;			/* File-relative block */
+	OffsetNumber offset;		/* Tuple offset number */
+	int			attnum;			/* Zero-based attribute number */
+	uint32		relfileOff;		/* File offset of value's payload */
+	uint32		len;			/* Payload size */
+	uint32		validLen;		/* Size of valid prefix of payload */
+} Utf8Problem;
+
+/* Per-worker --check-utf8 state */
+typedef struct Utf8CheckState
+{
+	uint64		nvalues;		/* Values validated */
+	uint64		nbytes;			/* Bytes validated */
+	uint64		nunchecked;		/* Compressed or external values skipped */
+	uint64		nmalformed;		/* Tuples skipped as malformed */
+	Utf8Problem *problems;
+	int			nproblems;
+	int			maxproblems;
+	uint32		dataOff;		/* File offset of current tuple's data */
+} Utf8CheckState;
+
+#endif							/* PG_HEXEDIT_EXTENSION */
+
 /* Program exit code */
 static int	exitCode = 0;
 
@@ -246,19 +1805,61 @@ typedef enum formatChoice
 	ITEM_INDEX,					/* Blocks contain IndexTuple items */
 	ITEM_SPG_INN,				/* Blocks contain SpGistInnerTuple items */
 	ITEM_SPG_LEAF,				/* Blocks contain SpGistLeafTuple items */
-	ITEM_BRIN					/* Blocks contain BrinTuple items */
+	ITEM_BRIN,					/* Blocks contain BrinTuple items */
+	ITEM_PLUGIN					/* Blocks contain items decoded by --plugin */
 } formatChoice;
 
+#ifndef PG_HEXEDIT_EXTENSION
 static void DisplayOptions(unsigned int validOptions);
 static unsigned int GetSegmentNumberFromFileName(const char *fileName);
+static char *GetArchiveMemberName(const char *path);
+static bool ArchiveFill(ArchiveStream *as);
+static size_t ArchiveReadStream(ArchiveStream *as, char *dst, size_t len);
+static uint64 TarParseNumber(const char *field, int len);
+static bool TarPathMatches(const char *name, const char *wanted);
+static bool ArchiveFindMember(ArchiveStream *as);
+static bool ArchiveRestart(ArchiveStream *as);
+static ssize_t ArchiveMemberRead(ArchiveStream *as, char *buf, size_t size);
+static off_t ArchiveMemberSeek(ArchiveStream *as, off_t offset, int whence);
+static void ArchiveMemberClose(ArchiveStream *as);
+#ifdef __GLIBC__
+static ssize_t ArchiveCookieRead(void *cookie, char *buf, size_t size);
+static int	ArchiveCookieSeek(void *cookie, off64_t *offset, int whence);
+#else
+static int	ArchiveCookieRead(void *cookie, char *buf, int size);
+static fpos_t ArchiveCookieSeek(void *cookie, fpos_t offset, int whence);
+#endif
+static int	ArchiveCookieClose(void *cookie);
+static FILE *OpenArchiveMember(const char *path);
+#endif
 static uint32 sdbmhash(const unsigned char *elem, size_t len);
 static char *GetColorFromAttrname(const char *attrName);
+#ifndef PG_HEXEDIT_EXTENSION
 static unsigned int ConsumeOptions(int numOptions, char **options);
 static int	GetOptionValue(char *optionString);
 static XLogRecPtr GetOptionXlogRecPtr(char *optionString);
 static bool ParseAttributeListString(const char *str);
+static int	ToastChunkCmp(const void *a, const void *b);
+static int	ToastChunkFileOrderCmp(const void *a, const void *b);
+static void BuildToastChunkIndex(void);
+static char *ResolveToastPointer(BlockNumber blkno, OffsetNumber offset,
+								 int attnum, unsigned char *attptr,
+								 bool *broken);
+static void EmitToastSummary(void);
+static void EmitXmlToastDocument(int numOptions, char **options);
 static unsigned int GetBlockSize(void);
+#endif
 static unsigned int GetSpecialSectionType(Page page);
+static unsigned int GetPluginSpecialSectionType(Page page,
+												 unsigned int specialSize);
+#ifndef PG_HEXEDIT_EXTENSION
+static void PluginEmitTag(BlockNumber blkno, bool metapage, const char *name,
+						  const char *color, uint32 relfileOff,
+						  uint32 relfileOffEnd);
+static void PluginReportError(const char *fmt,...) pg_attribute_printf(1, 2);
+static bool LoadPlugin(const char *path);
+#endif
+static bool PluginPageHasTuples(Page page, BlockNumber blkno);
 static const char *GetSpecialSectionString(unsigned int type);
 static XLogRecPtr GetPageLsn(Page page);
 static char *GetHeapTupleHeaderFlags(HeapTupleHeader htup, bool isInfomask2);
@@ -270,9 +1871,56 @@ static char *GetBrinTupleFlags(BrinTuple *itup);
 static bool IsBrinPage(Page page);
 static bool IsHashBitmapPage(Page page);
 static bool IsLeafPage(Page page);
+#ifndef PG_HEXEDIT_EXTENSION
+static sessionPageKinds GetSessionPageKind(Page page, BlockNumber blkno);
+static void RecordSessionPage(Page page, BlockNumber blkno);
+static int	AddSessionBookmark(BlockNumber *bookmarks, int nbookmarks,
+							   BlockNumber blkno);
+static void WriteSessionFile(void);
+static void EmitXmlShard(TagShard *shard);
+static void *ShardWorkerMain(void *arg);
+static void EmitXmlShards(int numOptions, char **options);
+static bool OpenRelationCache(void);
+static void CloseRelationCache(void);
+static const char *ReadRelationBlock(BlockNumber blkno, char *dest);
+static const char *GetCachedPageTags(BlockNumber blkno, size_t *len,
+									 const char **problem);
+static bool ServeRequest(const char *request, StringInfo response,
+						 int numOptions, char **options);
+static bool FlushServeOutput(int fd, ServeClient *client);
+static void ServeSignalHandler(int signum);
+static void ServeTags(int numOptions, char **options);
+#endif
+static int	PageTagCmp(const void *a, const void *b);
+static int	CollectPageTags(BlockNumber blkno, PageTag **tags);
+#ifndef PG_HEXEDIT_EXTENSION
+static int	ParsePageTags(BlockNumber blkno, const char *page,
+						  PageTag **tags);
+static short GetViewerColor(const char *color);
+static short GetViewerPair(const char *fontColor, const char *noteColor);
+static ViewerPage *GetViewerPage(BlockNumber blkno);
+static void DrawViewer(uint64 top, uint64 cursor, int bytesPerLine,
+					   const char *message);
+static void ViewerPrompt(const char *prompt, char *buf, int buflen);
+static BlockNumber FindViewerLsn(BlockNumber blkno, XLogRecPtr lsn);
+static void ViewRelation(void);
+static void EmitJsonString(FILE *out, const char *str);
+static void EmitBase64(FILE *out, const unsigned char *data, size_t len);
+static bool WriteHtmlChunk(int chunk, BlockNumber start, BlockNumber end);
+static void EmitHtmlReport(void);
+#endif
 static void EmitXmlPage(BlockNumber blkno);
+#ifndef PG_HEXEDIT_EXTENSION
 static void EmitXmlDocHeader(int numOptions, char **options);
 static void EmitXmlFooter(void);
+#endif
+static void XmlVisitTag(uint32 start, uint32 end, const char *text,
+						const char *fontColor, const char *noteColor);
+static void PageTagsVisitTag(uint32 start, uint32 end, const char *text,
+							 const char *fontColor, const char *noteColor);
+static StringInfo StartTagText(void);
+static void EmitTag(uint32 start, uint32 end, const char *fontColor,
+					const char *noteColor);
 static void EmitXmlTag(BlockNumber blkno, uint32 level, const char *name,
 					   const char *color, uint32 relfileOff,
 					   uint32 relfileOffEnd);
@@ -296,6 +1944,9 @@ static void EmitXmlAttributesHeap(BlockNumber blkno, OffsetNumber offset,
 static void EmitXmlAttributesIndex(BlockNumber blkno, OffsetNumber offset,
 								   uint32 relfileOff, IndexTuple itup,
 								   uint32 tupHeaderOff, int itemSize);
+static bool LocateAttribute(unsigned char *tupdata, bits8 *t_bits, int natts,
+							int datalen, int attnum, int *off,
+							AttributeSpan *span);
 static void EmitXmlAttributesData(BlockNumber blkno, OffsetNumber offset,
 								  uint32 relfileOff, unsigned char *tupdata,
 								  bits8 *t_bits, int nattrs, int datalen);
@@ -316,7 +1967,37 @@ static void EmitXmlSpGistLeafTuple(Page page, BlockNumber blkno,
 static void EmitXmlBrinTuple(Page page, BlockNumber blkno,
 							 OffsetNumber offset, BrinTuple *tuple,
 							 uint32 relfileOff, int itemSize);
+static void ReportPageProblem(PageProblemCallback callback, void *arg,
+							  BlockNumber blkno, OffsetNumber offset,
+							  checkAnomalyCodes code, unsigned int start,
+							  unsigned int end, const char *fmt,...)
+			pg_attribute_printf(8, 9);
+static void ReportXmlPageProblem(void *arg, BlockNumber blkno,
+								 OffsetNumber offset, checkAnomalyCodes code,
+								 unsigned int start, unsigned int end,
+								 const char *detail);
+static pageChecksumResults VerifyPageChecksum(Page page, BlockNumber blkno,
+											  uint16 *calculated);
+static bool CheckPageHeader(Page page, BlockNumber blkno,
+							PageProblemCallback callback, void *arg);
+static bool CheckMaxOffset(Page page, BlockNumber blkno,
+						   PageProblemCallback callback, void *arg);
+static bool CheckLinePointer(Page page, BlockNumber blkno, OffsetNumber offset,
+							 unsigned int limit, PageProblemCallback callback,
+							 void *arg);
+#ifndef PG_HEXEDIT_EXTENSION
+static bool CheckHeapTupleHeader(Page page, BlockNumber blkno,
+								 OffsetNumber offset, unsigned int itemOffset,
+								 unsigned int itemSize,
+								 PageProblemCallback callback, void *arg);
+#endif
 static int	EmitXmlPageHeader(Page page, BlockNumber blkno, uint32 level);
+static const StructDesc *GetMetapageDesc(unsigned int type);
+static const StructDesc *GetSpecialDesc(unsigned int type);
+static const char *GetFieldTagName(const FieldDesc *field, const char *value,
+								   char *tagName);
+static void EmitXmlFields(BlockNumber blkno, uint32 level,
+						  const StructDesc *desc, uint32 structOffset);
 static void EmitXmlPageMeta(BlockNumber blkno, uint32 level);
 static void EmitXmlPageItemIdArray(Page page, BlockNumber blkno);
 static void EmitXmlTuples(Page page, BlockNumber blkno);
@@ -324,8 +2005,233 @@ static void EmitXmlPostingTreeTids(Page page, BlockNumber blkno);
 static void EmitXmlHashBitmap(Page page, BlockNumber blkno);
 static void EmitXmlRevmap(Page page, BlockNumber blkno);
 static void EmitXmlSpecial(BlockNumber blkno, uint32 level);
+#ifndef PG_HEXEDIT_EXTENSION
+static double TimespecDiffSecs(const struct timespec *end,
+							   const struct timespec *start);
+static double DrawIoBucket(IoBucket *bucket, double elapsed, double cost);
+static void ThrottleIo(uint64 nbytes);
+static void EmitThrottleSummary(void);
+static void FormatProgressSecs(char *buf, size_t len, double secs);
+static void ProgressStart(void);
+static void ProgressReport(bool final);
+static void ProgressAdvance(uint64 nblocks, uint64 ntags, uint64 nbytes);
+static void NoticeDirectIoFallback(void);
+static bool BlockReaderOpen(BlockReader *reader);
+static ssize_t BlockReaderRead(BlockReader *reader, char *page,
+							   BlockNumber blkno, BlockNumber lastBlkno);
+static void BlockReaderClose(BlockReader *reader);
+static void NoticeReadAheadFallback(void);
+static void *ReadAheadWorkerMain(void *arg);
+#ifdef USE_IO_URING
+static bool ReadAheadSetupRing(ReadAhead *ra);
+static void ReadAheadReap(ReadAhead *ra);
+#endif
+static bool ReadAheadOpen(ReadAhead *ra, BlockNumber first,
+						  BlockNumber last);
+static ssize_t ReadAheadNext(ReadAhead *ra, char *page);
+static void ReadAheadClose(ReadAhead *ra);
 static void EmitXmlBody(void);
+static bool PageHasLinePointers(Page page, BlockNumber blkno);
+static void WalkHeapTupleAttributes(BlockNumber blkno, OffsetNumber offset,
+									HeapTupleHeader htup,
+									unsigned int itemSize, int nattrs,
+									const PageVisitor *visitor, void *arg);
+static void WalkPageItems(Page page, BlockNumber blkno,
+						  const PageVisitor *visitor, void *arg);
+static void WalkPage(Page page, BlockNumber blkno,
+					 const PageVisitor *visitor, void *arg);
+static void *ScanWorkerMain(void *arg);
+static bool GetScanRange(BlockNumber *first, BlockNumber *last);
+static bool ScanBlocksParallel(const PageVisitor *visitor, void **states);
+static bool HeapTupleIsDeadByHints(HeapTupleHeader htup);
+static void NoteColumnStatsPageProblem(void *arg, BlockNumber blkno,
+									   OffsetNumber offset,
+									   checkAnomalyCodes code,
+									   unsigned int start, unsigned int end,
+									   const char *detail);
+static bool ColumnStatsVisitPage(Page page, BlockNumber blkno, bool sane,
+								 void *arg);
+static bool ColumnStatsVisitItemId(Page page, BlockNumber blkno,
+								   OffsetNumber offset, ItemId itemId,
+								   bool hasStorage, void *arg);
+static int	ColumnStatsVisitHeapTuple(Page page, BlockNumber blkno,
+									  OffsetNumber offset, HeapTupleHeader htup,
+									  unsigned int itemSize, void *arg);
+static bool ColumnStatsVisitAttribute(BlockNumber blkno, OffsetNumber offset,
+									  int attnum, const AttributeSpan *span,
+									  void *arg);
+static void ColumnStatsVisitHeapTupleEnd(BlockNumber blkno,
+										 OffsetNumber offset, int badAttnum,
+										 void *arg);
+static void EmitColumnStats(void);
+static int	FindFirstToastChunk(Oid valueid);
+static char *ReadToastValue(Oid valueid, uint32 extsize);
+static char *DecompressValue(const char *compressed, int32 compressedSize,
+							 int32 rawSize, int method);
+static const char *SalvageVarlena(StringInfo buf, unsigned char *attptr);
+static void NoteSalvagePageProblem(void *arg, BlockNumber blkno,
+								   OffsetNumber offset, checkAnomalyCodes code,
+								   unsigned int start, unsigned int end,
+								   const char *detail);
+static bool SalvageVisitPage(Page page, BlockNumber blkno, bool sane,
+							 void *arg);
+static bool SalvageVisitItemId(Page page, BlockNumber blkno,
+							   OffsetNumber offset, ItemId itemId,
+							   bool hasStorage, void *arg);
+static int	SalvageVisitHeapTuple(Page page, BlockNumber blkno,
+								  OffsetNumber offset, HeapTupleHeader htup,
+								  unsigned int itemSize, void *arg);
+static bool SalvageVisitAttribute(BlockNumber blkno, OffsetNumber offset,
+								  int attnum, const AttributeSpan *span,
+								  void *arg);
+static void SalvageVisitHeapTupleEnd(BlockNumber blkno, OffsetNumber offset,
+									 int badAttnum, void *arg);
+static void SalvageVisitPageEnd(Page page, BlockNumber blkno, void *arg);
+static void FlushSalvageBuffer(SalvageState *state);
+static void SalvageTuples(void);
+static bool ParseByteaAttrList(void);
+static bool ParseUtf8AttrList(void);
+static void NoteUtf8PageProblem(void *arg, BlockNumber blkno,
+								OffsetNumber offset, checkAnomalyCodes code,
+								unsigned int start, unsigned int end,
+								const char *detail);
+static bool Utf8VisitPage(Page page, BlockNumber blkno, bool sane, void *arg);
+static bool Utf8VisitItemId(Page page, BlockNumber blkno, OffsetNumber offset,
+							ItemId itemId, bool hasStorage, void *arg);
+static int	Utf8VisitHeapTuple(Page page, BlockNumber blkno,
+							   OffsetNumber offset, HeapTupleHeader htup,
+							   unsigned int itemSize, void *arg);
+static bool Utf8VisitAttribute(BlockNumber blkno, OffsetNumber offset,
+							   int attnum, const AttributeSpan *span,
+							   void *arg);
+static void Utf8VisitHeapTupleEnd(BlockNumber blkno, OffsetNumber offset,
+								  int badAttnum, void *arg);
+static int	Utf8ProblemCmp(const void *a, const void *b);
+static void EmitXmlUtf8Problems(int numOptions, char **options);
+static bool RecordPageLsn(Page page, BlockNumber blkno, bool sane,
+						  void *arg);
+static void AppendBlockRange(StringInfo buf, BlockNumber first,
+							 BlockNumber last);
+static int	HeatmapRangeCmp(const void *a, const void *b);
+static bool CollectPageLsns(BlockNumber *first, BlockNumber *last);
+static void EmitLsnHeatmap(void);
+static void EmitFpwEstimate(void);
+static bool IsRelationFileName(const char *name, bool segments);
+static void CollectMetricsFiles(const char *relDir);
+static int	ListMetricsSubdirs(const char *relDir, const char *prefix,
+							   char ***subdirs);
+static int	MetricsFileCmp(const void *a, const void *b);
+static void MetricsNoteXid(MetricsState *state, TransactionId xid);
+static void MergeMetricsState(MetricsState *total, MetricsState *state);
+static void NoteMetricsPageProblem(void *arg, BlockNumber blkno,
+								   OffsetNumber offset, checkAnomalyCodes code,
+								   unsigned int start, unsigned int end,
+								   const char *detail);
+static bool MetricsVisitPage(Page page, BlockNumber blkno, bool sane,
+							 void *arg);
+static bool MetricsVisitItemId(Page page, BlockNumber blkno,
+							   OffsetNumber offset, ItemId itemId,
+							   bool hasStorage, void *arg);
+static int	MetricsVisitHeapTuple(Page page, BlockNumber blkno,
+								  OffsetNumber offset, HeapTupleHeader htup,
+								  unsigned int itemSize, void *arg);
+static void EmitPromLabelValue(FILE *out, const char *s);
+static void EmitPromHeader(FILE *out, const char *name, const char *help);
+static void EmitPromRelationSample(FILE *out, const char *name,
+								   MetricsRelation *rel);
+static void EmitPromMetrics(FILE *out, MetricsRelation *rels, int nrels,
+							double duration);
+static void ScanMetricsFile(MetricsRelation *rel, MetricsState *states,
+							void **stateptrs);
+static void EmitMetrics(void);
+static void AddCheckAnomaly(CheckState *state, BlockNumber blkno,
+							OffsetNumber offset, checkAnomalyCodes code,
+							unsigned int start, unsigned int end,
+							const char *fmt,...) pg_attribute_printf(7, 8);
+static int	CheckItemSpanCmp(const void *a, const void *b);
+static int	CheckAnomalyCmp(const void *a, const void *b);
+static void AddCheckPageProblem(void *arg, BlockNumber blkno,
+								OffsetNumber offset, checkAnomalyCodes code,
+								unsigned int start, unsigned int end,
+								const char *detail);
+static bool CheckVisitPage(Page page, BlockNumber blkno, bool sane,
+						   void *arg);
+static bool CheckVisitItemId(Page page, BlockNumber blkno, OffsetNumber offset,
+							 ItemId itemId, bool hasStorage, void *arg);
+static void CheckVisitIndexTuple(Page page, BlockNumber blkno,
+								 OffsetNumber offset, IndexTuple itup,
+								 unsigned int itemSize, void *arg);
+static void CheckVisitPageEnd(Page page, BlockNumber blkno, void *arg);
+static void EmitCheck(int numOptions, char **options);
+static bool FixPageChecksum(Page page, BlockNumber blkno, bool sane,
+							void *arg);
+static int	FixedChecksumCmp(const void *a, const void *b);
+static void EmitFixChecksums(void);
+static bool LookupFieldFlag(const char *name, size_t len, uint64 *value);
+static const FieldDesc *FindFieldDesc(const StructDesc *desc,
+									  uint32 structOffset, uint32 offset);
+static const FieldDesc *GetFieldDescAt(BlockNumber blkno, uint32 offset);
+static bool ParsePatchValue(const char *str, PatchEntry *entry);
+static bool ParsePatchLine(char *line, PatchEntry *entry);
+static bool ReadPatchFile(PatchEntry **entries, int *nentries);
+static int	PatchEntryBlockCmp(const void *a, const void *b);
+static int	PatchEntryLineCmp(const void *a, const void *b);
+static PageTag *FindPatchTag(PatchEntry *entry, PageTag *tags, int ntags);
+static char *FormatPatchBytes(const char *bytes, int nbytes);
+static bool ApplyPatchEntry(PatchEntry *entry, PageTag *tag, char *page);
+static void EmitApply(void);
+static uint64 InjectRandom(uint64 *rng);
+static int	GetInjectTagClass(PageTag *tag, BlockNumber blkno, char *field,
+							  OffsetNumber *offset);
+static void InjectCorruption(uint64 *rng, PageTag *tag, char *page,
+							 BlockNumber blkno, FILE *manifest,
+							 const char *variantName, int class);
+static void EmitInject(void);
+#endif
+
+/* Tag visitor that writes wxHexEditor XML */
+static const TagVisitor xmlTagVisitor = {XmlVisitTag};
+
+/* Tag visitor that collects a page's tags for CollectPageTags() */
+static const TagVisitor pageTagsVisitor = {PageTagsVisitTag};
+
+#ifndef PG_HEXEDIT_EXTENSION
+/* PageVisitors of scan modes that don't emit tags for every page */
+static const PageVisitor columnStatsVisitor = {
+	ColumnStatsVisitPage, ColumnStatsVisitItemId, ColumnStatsVisitHeapTuple,
+	ColumnStatsVisitAttribute, ColumnStatsVisitHeapTupleEnd, NULL, NULL,
+	NoteColumnStatsPageProblem
+};
+static const PageVisitor salvageVisitor = {
+	SalvageVisitPage, SalvageVisitItemId, SalvageVisitHeapTuple,
+	SalvageVisitAttribute, SalvageVisitHeapTupleEnd, NULL,
+	SalvageVisitPageEnd, NoteSalvagePageProblem
+};
+static const PageVisitor utf8Visitor = {
+	Utf8VisitPage, Utf8VisitItemId, Utf8VisitHeapTuple, Utf8VisitAttribute,
+	Utf8VisitHeapTupleEnd, NULL, NULL, NoteUtf8PageProblem
+};
+static const PageVisitor pageLsnVisitor = {RecordPageLsn};
+static const PageVisitor metricsVisitor = {
+	MetricsVisitPage, MetricsVisitItemId, MetricsVisitHeapTuple, NULL, NULL,
+	NULL, NULL, NoteMetricsPageProblem
+};
+static const PageVisitor checkVisitor = {
+	CheckVisitPage, CheckVisitItemId, NULL, NULL, NULL, CheckVisitIndexTuple,
+	CheckVisitPageEnd, AddCheckPageProblem
+};
+static const PageVisitor fixChecksumsVisitor = {FixPageChecksum};
+#endif
 
+/* Visitor that the current thread's decoding routines pass tags to */
+static __thread const TagVisitor *tagVisitor = &xmlTagVisitor;
+
+/* Tags collected by pageTagsVisitor */
+static __thread PageTag *visitedTags = NULL;
+static __thread int nvisitedTags = 0;
+
+
+#ifndef PG_HEXEDIT_EXTENSION
 
 /*	Send properly formed usage information to the user. */
 static void
@@ -341,11 +2247,14 @@ DisplayOptions(unsigned int validOptions)
 			 HEXEDIT_VERSION, PG_VERSION);
 
 	printf
-		("\nUsage: pg_hexedit [-hklz] [-D attrlist] [-n segnumber] [-R startblock [endblock]] [-s segsize] [-x lsn] file\n\n"
+		("\nUsage: pg_hexedit [-hklz] [-D attrlist] [-j njobs] [-n segnumber] [-R startblock [endblock]] [-s segsize] [-T toastfile] [-x lsn] [--plugin library]... [--column-stats] [--salvage outfile [--visible-only] [--salvage-bytea attnames]] [--check-utf8 attnames] [--lsn-heatmap nranges [--lsn-cutoff lsn]... [--bookmarks file]] [--fpw-estimate nranges --redo lsn...] [--metrics outfile] [--check outfile] [--fix-checksums [--baseline file] [--fsync policy]] [--apply patchfile] [--inject directory [--variants n] [--corruptions n] [--classes list] [--seed n]] [--session file] [--shard-blocks nblocks] [--serve socket] [--view] [--html directory] [--direct-io] [--max-rate mbps] [--max-iops iops] [--queue-depth depth] [--progress] [--progress-fd fd] file\n\n"
 		 "Output contents of PostgreSQL relation file as wxHexEditor XML tags\n"
 		 "  -D  Decode tuples using given comma separated list of attribute metadata\n"
 		 "      See README.md for an explanation of the attrlist format\n"
 		 "  -h  Display this information\n"
+		 "  -j  Use [njobs] worker threads (only with --column-stats, --salvage,\n"
+		 "      --check-utf8, --lsn-heatmap, --fpw-estimate, --metrics, --check,\n"
+		 "      --fix-checksums, or --shard-blocks)\n"
 		 "  -k  Verify all block checksums\n"
 		 "  -l  Skip leaf pages\n"
 		 "  -n  Force segment number to [segnumber]\n"
@@ -354,8 +2263,105 @@ DisplayOptions(unsigned int validOptions)
 		 "        [endblock]: block to end at\n"
 		 "      A startblock without an endblock will format the single block\n"
 		 "  -s  Force segment size to [segsize]\n"
+		 "  -T  Resolve external TOAST pointers against TOAST relation file\n"
+		 "      [toastfile], and write its chunk tags to [toastfile].tags\n"
+		 "      (requires -D)\n"
 		 "  -x  Skip pages whose LSN is before [lsn]\n"
 		 "  -z  Verify block checksums when non-zero\n"
+		 "  --plugin\n"
+		 "      Decode pages of access methods that shared [library] knows\n"
+		 "      about (may be repeated)\n"
+		 "  --column-stats\n"
+		 "      Print exact per-attribute statistics for heap relation file\n"
+		 "      instead of tags (requires -D)\n"
+		 "  --salvage\n"
+		 "      Write decodable tuples of heap relation file to [outfile] in\n"
+		 "      COPY BINARY format instead of tags (requires -D, \"-\" is stdout)\n"
+		 "  --visible-only\n"
+		 "      Only salvage tuples that hint bits show are visible\n"
+		 "  --salvage-bytea\n"
+		 "      Salvage stored representation of comma separated [attnames],\n"
+		 "      for loading into bytea columns\n"
+		 "  --check-utf8\n"
+		 "      Only tag inline uncompressed values of comma separated\n"
+		 "      [attnames] that are not valid UTF-8 (requires -D)\n"
+		 "  --lsn-heatmap\n"
+		 "      Print heatmap of page LSN recency over [nranges] block ranges\n"
+		 "      instead of tags\n"
+		 "  --lsn-cutoff\n"
+		 "      List pages whose LSN is at or after [lsn] (may be repeated)\n"
+		 "  --bookmarks\n"
+		 "      Write wxHexEditor GoToOffset lines for hottest ranges to [file]\n"
+		 "  --fpw-estimate\n"
+		 "      Print pages dirtied since checkpoint REDO LSNs, and the WAL bytes\n"
+		 "      that their full-page images cost, over [nranges] block ranges\n"
+		 "      instead of tags\n"
+		 "  --redo\n"
+		 "      Count pages whose LSN is at or after checkpoint REDO [lsn] (may\n"
+		 "      be repeated)\n"
+		 "  --metrics\n"
+		 "      Write Prometheus metrics for relation file (or every relation\n"
+		 "      file, when file is a data directory) to [outfile] instead of\n"
+		 "      tags (\"-\" is stdout)\n"
+		 "  --check\n"
+		 "      List page anomalies in [outfile], and only emit tags for pages\n"
+		 "      that have one\n"
+		 "  --fix-checksums\n"
+		 "      Rewrite incorrect non-zero page checksums (or all incorrect\n"
+		 "      checksums, with -k) in place instead of emitting tags\n"
+		 "  --baseline\n"
+		 "      Only fix pages that differ from snapshot [file] of relation file\n"
+		 "  --fsync\n"
+		 "      Flush fixed checksums (or applied patches) at the [end] (the\n"
+		 "      default), after [each] page, or [none]\n"
+		 "  --apply\n"
+		 "      Apply field assignments in [patchfile] to relation file in place\n"
+		 "      instead of emitting tags (with --fix-checksums, also fix the\n"
+		 "      checksums of patched pages)\n"
+		 "  --inject\n"
+		 "      Write randomly corrupted copies of relation file, and a manifest\n"
+		 "      of each corruption, to [directory] instead of emitting tags\n"
+		 "      (with --fix-checksums, also fix the checksums of corrupted pages)\n"
+		 "  --variants\n"
+		 "      Write [n] corrupted copies (the default is 1)\n"
+		 "  --corruptions\n"
+		 "      Make [n] corruptions in each copy (the default is 1)\n"
+		 "  --classes\n"
+		 "      Only corrupt comma separated [list] of lp, tuple, btree,\n"
+		 "      posting, gin, and page fields (the default is all of them)\n"
+		 "  --seed\n"
+		 "      Seed random corruptions with [n], so that they can be repeated\n"
+		 "  --session\n"
+		 "      Also write wxHexEditor config with bookmarks for interesting\n"
+		 "      pages to [file]\n"
+		 "  --shard-blocks\n"
+		 "      Write tags for each [nblocks] block range to its own file, and\n"
+		 "      print manifest of files instead of tags\n"
+		 "  --serve\n"
+		 "      Answer \"block n\" and \"range a b\" requests for tags on Unix\n"
+		 "      [socket] until interrupted, instead of emitting all tags\n"
+		 "  --view\n"
+		 "      Browse relation file and its tags in an interactive terminal\n"
+		 "      viewer instead of emitting tags\n"
+		 "  --html\n"
+		 "      Write self-contained HTML report of relation file and its tags\n"
+		 "      to [directory] instead of emitting tags\n"
+		 "  --direct-io\n"
+		 "      Read relation file with O_DIRECT (or drop it from the page cache\n"
+		 "      after reading it), so large scans don't evict other data\n"
+		 "  --max-rate\n"
+		 "      Read relation file at no more than [mbps] megabytes per second\n"
+		 "  --max-iops\n"
+		 "      Issue no more than [iops] reads of relation file per second\n"
+		 "  --queue-depth\n"
+		 "      Keep [depth] block reads in flight while emitting tags, using\n"
+		 "      io_uring (or reader threads when it isn't available)\n"
+		 "  --progress\n"
+		 "      Print blocks done, read rate, tag rate, and ETA to stderr about\n"
+		 "      once a second\n"
+		 "  --progress-fd\n"
+		 "      Write the same progress as key=value lines to file descriptor\n"
+		 "      [fd]\n"
 		 "\nReport bugs to <pg@bowt.ie>\n");
 }
 
@@ -385,28 +2391,613 @@ GetSegmentNumberFromFileName(const char *fileName)
 }
 
 /*
- * Hash function is taken from sdbm, a public-domain reimplementation of the
- * ndbm database library.
+ * If path names a relation file within a tar archive (that is, it looks like
+ * archive.tar:path/in/archive, where the archive can also be .tar.gz, .tgz,
+ * or .tar.lz4), return the path within the archive.  Otherwise, return NULL.
  */
-static uint32
-sdbmhash(const unsigned char *elem, size_t len)
+static char *
+GetArchiveMemberName(const char *path)
 {
-	uint32		hash = 0;
+	static const char *const suffixes[] = {".tar", ".tar.gz", ".tgz", ".tar.lz4"};
+	const char *colon;
 	int			i;
 
-	for (i = 0; i < len; elem++, i++)
+	for (colon = strchr(path, ':'); colon; colon = strchr(colon + 1, ':'))
 	{
-		hash = (*elem) + (hash << 6) + (hash << 16) - hash;
+		for (i = 0; i < lengthof(suffixes); i++)
+		{
+			int			len = strlen(suffixes[i]);
+
+			if (colon - path > len && colon[1] != '\0' &&
+				strncmp(colon - len, suffixes[i], len) == 0)
+				return (char *) colon + 1;
+		}
 	}
 
-	return hash;
+	return NULL;
 }
 
 /*
- * Return a cstring of an html color that is a function of attrName argument.
+ * Decompress the next chunk of archive's tar stream into as->out.
+ *
+ * Returns false at the end of the archive, or on error.
  */
-static char *
-GetColorFromAttrname(const char *attrName)
+static bool
+ArchiveFill(ArchiveStream *as)
+{
+	as->outPos = as->outLen = 0;
+
+	if (as->compression == ARCHIVE_PLAIN)
+	{
+		as->outLen = fread(as->out, 1, ARCHIVE_BUF_SIZE, as->archive);
+		return as->outLen > 0;
+	}
+
+	while (as->outLen == 0)
+	{
+		if (as->inPos == as->inLen)
+		{
+			as->inPos = 0;
+			as->inLen = fread(as->in, 1, ARCHIVE_BUF_SIZE, as->archive);
+			if (as->inLen == 0)
+				return false;
+		}
+
+#ifdef HAVE_LIBZ
+		if (as->compression == ARCHIVE_GZIP)
+		{
+			int			rc;
+
+			as->zstream.next_in = (Bytef *) as->in + as->inPos;
+			as->zstream.avail_in = as->inLen - as->inPos;
+			as->zstream.next_out = (Bytef *) as->out;
+			as->zstream.avail_out = ARCHIVE_BUF_SIZE;
+			rc = inflate(&as->zstream, Z_NO_FLUSH);
+			as->inPos = as->inLen - as->zstream.avail_in;
+			as->outLen = ARCHIVE_BUF_SIZE - as->zstream.avail_out;
+
+			/* gzip files may consist of several concatenated members */
+			if (rc == Z_STREAM_END)
+				inflateReset(&as->zstream);
+			else if (rc != Z_OK && rc != Z_BUF_ERROR)
+			{
+				fprintf(stderr, "pg_hexedit error: could not decompress archive \"%s\": %s\n",
+						as->archiveName,
+						as->zstream.msg ? as->zstream.msg : "unknown error");
+				exitCode = 1;
+				return false;
+			}
+		}
+#endif
+#ifdef USE_LZ4
+		if (as->compression == ARCHIVE_LZ4)
+		{
+			size_t		outSize = ARCHIVE_BUF_SIZE;
+			size_t		inSize = as->inLen - as->inPos;
+			size_t		rc;
+
+			rc = LZ4F_decompress(as->lz4, as->out, &outSize,
+								 as->in + as->inPos, &inSize, NULL);
+			if (LZ4F_isError(rc))
+			{
+				fprintf(stderr, "pg_hexedit error: could not decompress archive \"%s\": %s\n",
+						as->archiveName, LZ4F_getErrorName(rc));
+				exitCode = 1;
+				return false;
+			}
+			as->inPos += inSize;
+			as->outLen = outSize;
+		}
+#endif
+	}
+
+	return true;
+}
+
+/*
+ * Read len bytes of archive's tar stream into dst, or skip over them when dst
+ * is NULL.
+ *
+ * Returns the number of bytes read, which is less than len at the end of the
+ * archive.
+ */
+static size_t
+ArchiveReadStream(ArchiveStream *as, char *dst, size_t len)
+{
+	size_t		total = 0;
+
+	while (total < len)
+	{
+		size_t		n;
+
+		if (as->outPos == as->outLen && !ArchiveFill(as))
+			break;
+
+		n = Min(len - total, as->outLen - as->outPos);
+		if (dst)
+			memcpy(dst + total, as->out + as->outPos, n);
+		as->outPos += n;
+		total += n;
+	}
+
+	return total;
+}
+
+/*
+ * Parse a numeric tar header field, which is either octal, or (for large
+ * values) base-256 with the high bit of the first byte set
+ */
+static uint64
+TarParseNumber(const char *field, int len)
+{
+	uint64		value = 0;
+	int			i = 0;
+
+	if ((unsigned char) field[0] & 0x80)
+	{
+		value = (unsigned char) field[0] & 0x7F;
+		for (i = 1; i < len; i++)
+			value = (value << 8) | (unsigned char) field[i];
+		return value;
+	}
+
+	while (i < len && (field[i] == ' ' || field[i] == '\0'))
+		i++;
+	for (; i < len && field[i] >= '0' && field[i] <= '7'; i++)
+		value = (value << 3) | (field[i] - '0');
+
+	return value;
+}
+
+/*
+ * Does archive member name match the path that the user asked for?  A
+ * leading "./" is ignored on both sides.
+ */
+static bool
+TarPathMatches(const char *name, const char *wanted)
+{
+	while (strncmp(name, "./", 2) == 0)
+		name += 2;
+	while (strncmp(wanted, "./", 2) == 0)
+		wanted += 2;
+
+	return strcmp(name, wanted) == 0;
+}
+
+/*
+ * Read tar headers from the start of archive's tar stream until the header of
+ * the relation file is found.  ustar name prefixes, GNU long names, and pax
+ * path records are understood.
+ *
+ * Returns true with the tar stream positioned at the start of the member's
+ * data, or false (having reported why) if it could not be found.
+ */
+static bool
+ArchiveFindMember(ArchiveStream *as)
+{
+	char		header[TAR_BLOCK_SIZE];
+	char	   *longName = NULL;
+	bool		found = false;
+
+	while (ArchiveReadStream(as, header, TAR_BLOCK_SIZE) == TAR_BLOCK_SIZE)
+	{
+		uint64		size = TarParseNumber(header + 124, 12);
+		uint64		padded = TYPEALIGN(TAR_BLOCK_SIZE, size);
+		char		type = header[156];
+		char		name[256 + 1];
+		unsigned int checksum = 0;
+		int			i;
+
+		/* Archive ends with (at least) two zero blocks */
+		if (header[0] == '\0')
+			break;
+
+		for (i = 0; i < TAR_BLOCK_SIZE; i++)
+			checksum += (i >= 148 && i < 156) ? ' ' : (unsigned char) header[i];
+		if (checksum != TarParseNumber(header + 148, 8))
+		{
+			fprintf(stderr, "pg_hexedit error: invalid tar header in archive \"%s\"\n",
+					as->archiveName);
+			exitCode = 1;
+			pg_free(longName);
+			return false;
+		}
+
+		/* GNU long name, or pax extended header for the next member */
+		if ((type == 'L' || type == 'x') && size <= 65536)
+		{
+			char	   *data = (char *) pg_malloc(padded + 1);
+
+			if (ArchiveReadStream(as, data, padded) != padded)
+			{
+				pg_free(data);
+				break;
+			}
+			data[size] = '\0';
+
+			if (type == 'L')
+			{
+				pg_free(longName);
+				longName = data;
+				continue;
+			}
+
+			/* pax records look like "<len> <key>=<value>\n" */
+			for (i = 0; i < size;)
+			{
+				char	   *record = data + i;
+				char	   *key;
+				long		reclen = strtol(record, &key, 10);
+
+				if (reclen <= 0 || i + reclen > size || *key != ' ')
+					break;
+				key++;
+				if (strncmp(key, "path=", 5) == 0)
+				{
+					int			pathLen = record + reclen - 1 - (key + 5);
+
+					pg_free(longName);
+					longName = (char *) pg_malloc(pathLen + 1);
+					memcpy(longName, key + 5, pathLen);
+					longName[pathLen] = '\0';
+				}
+				i += reclen;
+			}
+			pg_free(data);
+			continue;
+		}
+
+		if (longName)
+		{
+			strlcpy(name, longName, sizeof(name));
+			pg_free(longName);
+			longName = NULL;
+		}
+		else if (memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0')
+			snprintf(name, sizeof(name), "%.155s/%.100s", header + 345, header);
+		else
+			snprintf(name, sizeof(name), "%.100s", header);
+
+		if ((type == '0' || type == '\0' || type == '7') &&
+			TarPathMatches(name, as->memberName))
+		{
+			as->memberSize = size;
+			found = true;
+			break;
+		}
+
+		if (ArchiveReadStream(as, NULL, padded) != padded)
+			break;
+	}
+
+	pg_free(longName);
+	if (!found)
+	{
+		fprintf(stderr, "pg_hexedit error: could not find \"%s\" in archive \"%s\"\n",
+				as->memberName, as->archiveName);
+		exitCode = 1;
+	}
+
+	return found;
+}
+
+/*
+ * Read archive from the beginning, up to the start of the relation file's
+ * data, and keep the first ARCHIVE_HEAD_SIZE bytes of the relation file
+ */
+static bool
+ArchiveRestart(ArchiveStream *as)
+{
+	if (fseeko(as->archive, 0, SEEK_SET) != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: could not seek in archive \"%s\": %s\n",
+				as->archiveName, strerror(errno));
+		exitCode = 1;
+		return false;
+	}
+	as->inPos = as->inLen = 0;
+	as->outPos = as->outLen = 0;
+#ifdef HAVE_LIBZ
+	if (as->compression == ARCHIVE_GZIP)
+		inflateReset(&as->zstream);
+#endif
+#ifdef USE_LZ4
+	if (as->compression == ARCHIVE_LZ4)
+	{
+		LZ4F_freeDecompressionContext(as->lz4);
+		as->lz4 = NULL;
+		if (LZ4F_isError(LZ4F_createDecompressionContext(&as->lz4,
+														 LZ4F_VERSION)))
+		{
+			fprintf(stderr, "pg_hexedit error: could not create LZ4 decompression context\n");
+			exitCode = 1;
+			return false;
+		}
+	}
+#endif
+
+	if (!ArchiveFindMember(as))
+		return false;
+
+	as->headLen = ArchiveReadStream(as, as->head,
+									Min(as->memberSize, ARCHIVE_HEAD_SIZE));
+	as->streamPos = as->headLen;
+
+	return true;
+}
+
+/*
+ * Read up to size bytes of the relation file from its current position.
+ *
+ * Returns the number of bytes read, which is 0 at the end of the file.
+ */
+static ssize_t
+ArchiveMemberRead(ArchiveStream *as, char *buf, size_t size)
+{
+	size_t		n;
+
+	if (as->position >= as->memberSize)
+		return 0;
+	size = Min(size, as->memberSize - as->position);
+
+	if (as->position < as->headLen)
+	{
+		n = Min(size, as->headLen - as->position);
+		memcpy(buf, as->head + as->position, n);
+		as->position += n;
+		return n;
+	}
+
+	if (as->position < as->streamPos && !ArchiveRestart(as))
+		return -1;
+	if (as->position > as->streamPos)
+		as->streamPos += ArchiveReadStream(as, NULL,
+										   as->position - as->streamPos);
+
+	n = 0;
+	if (as->position == as->streamPos)
+		n = ArchiveReadStream(as, buf, size);
+	if (n == 0)
+	{
+		if (!as->truncated)
+			fprintf(stderr, "pg_hexedit error: archive \"%s\" ends before the end of \"%s\"\n",
+					as->archiveName, as->memberName);
+		as->truncated = true;
+		exitCode = 1;
+		return 0;
+	}
+	as->streamPos += n;
+	as->position += n;
+
+	return n;
+}
+
+/*
+ * Move relation file's position.  Any skipping (or starting over) happens
+ * when it is next read.
+ *
+ * Returns the new position, or -1 if it would be negative.
+ */
+static off_t
+ArchiveMemberSeek(ArchiveStream *as, off_t offset, int whence)
+{
+	off_t		position = offset;
+
+	if (whence == SEEK_CUR)
+		position += as->position;
+	else if (whence == SEEK_END)
+		position += as->memberSize;
+
+	if (position < 0)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	as->position = position;
+
+	return position;
+}
+
+/*
+ * Release relation file's archive
+ */
+static void
+ArchiveMemberClose(ArchiveStream *as)
+{
+#ifdef HAVE_LIBZ
+	if (as->compression == ARCHIVE_GZIP)
+		inflateEnd(&as->zstream);
+#endif
+#ifdef USE_LZ4
+	if (as->lz4)
+		LZ4F_freeDecompressionContext(as->lz4);
+#endif
+	if (as->archive)
+		fclose(as->archive);
+	if (archiveMember == as)
+		archiveMember = NULL;
+	pg_free(as->archiveName);
+	pg_free(as->memberName);
+	pg_free(as->in);
+	pg_free(as->out);
+	pg_free(as->head);
+	pg_free(as);
+}
+
+/*
+ * stdio callbacks for relation file within archive, which have different
+ * signatures with glibc's fopencookie() and BSD's funopen()
+ */
+#ifdef __GLIBC__
+static ssize_t
+ArchiveCookieRead(void *cookie, char *buf, size_t size)
+{
+	return ArchiveMemberRead((ArchiveStream *) cookie, buf, size);
+}
+
+static int
+ArchiveCookieSeek(void *cookie, off64_t *offset, int whence)
+{
+	off_t		position = ArchiveMemberSeek((ArchiveStream *) cookie,
+											 *offset, whence);
+
+	if (position < 0)
+		return -1;
+	*offset = position;
+
+	return 0;
+}
+#else
+static int
+ArchiveCookieRead(void *cookie, char *buf, int size)
+{
+	return ArchiveMemberRead((ArchiveStream *) cookie, buf, size);
+}
+
+static fpos_t
+ArchiveCookieSeek(void *cookie, fpos_t offset, int whence)
+{
+	return ArchiveMemberSeek((ArchiveStream *) cookie, offset, whence);
+}
+#endif
+
+static int
+ArchiveCookieClose(void *cookie)
+{
+	ArchiveMemberClose((ArchiveStream *) cookie);
+
+	return 0;
+}
+
+/*
+ * Open relation file within tar archive as a stdio stream.  The archive may be
+ * gzip or LZ4 compressed, which is detected from its first few bytes.
+ *
+ * Returns NULL (having reported why) if the relation file could not be found
+ * in the archive.
+ */
+static FILE *
+OpenArchiveMember(const char *path)
+{
+	ArchiveStream *as = (ArchiveStream *) pg_malloc0(sizeof(ArchiveStream));
+	char	   *memberName = GetArchiveMemberName(path);
+	unsigned char magic[4];
+	size_t		nmagic;
+	FILE	   *stream;
+
+	as->archiveName = (char *) pg_malloc(memberName - path);
+	memcpy(as->archiveName, path, memberName - path - 1);
+	as->archiveName[memberName - path - 1] = '\0';
+	as->memberName = pg_strdup(memberName);
+	as->in = (char *) pg_malloc(ARCHIVE_BUF_SIZE);
+	as->out = (char *) pg_malloc(ARCHIVE_BUF_SIZE);
+	as->head = (char *) pg_malloc(ARCHIVE_HEAD_SIZE);
+
+	as->archive = fopen(as->archiveName, "rb");
+	if (!as->archive)
+	{
+		fprintf(stderr, "pg_hexedit error: could not open archive \"%s\": %s\n",
+				as->archiveName, strerror(errno));
+		exitCode = 1;
+		ArchiveMemberClose(as);
+		return NULL;
+	}
+
+	nmagic = fread(magic, 1, sizeof(magic), as->archive);
+	if (nmagic >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+		as->compression = ARCHIVE_GZIP;
+	else if (nmagic == 4 && magic[0] == 0x04 && magic[1] == 0x22 &&
+			 magic[2] == 0x4D && magic[3] == 0x18)
+		as->compression = ARCHIVE_LZ4;
+	else
+		as->compression = ARCHIVE_PLAIN;
+
+#ifdef HAVE_LIBZ
+	if (as->compression == ARCHIVE_GZIP &&
+		inflateInit2(&as->zstream, 15 + 32) != Z_OK)
+	{
+		fprintf(stderr, "pg_hexedit error: could not initialize gzip decompression\n");
+		exitCode = 1;
+		as->compression = ARCHIVE_PLAIN;
+		ArchiveMemberClose(as);
+		return NULL;
+	}
+#else
+	if (as->compression == ARCHIVE_GZIP)
+	{
+		fprintf(stderr, "pg_hexedit error: archive \"%s\" is gzip compressed, but pg_hexedit was built without zlib support\n",
+				as->archiveName);
+		exitCode = 1;
+		ArchiveMemberClose(as);
+		return NULL;
+	}
+#endif
+#ifndef USE_LZ4
+	if (as->compression == ARCHIVE_LZ4)
+	{
+		fprintf(stderr, "pg_hexedit error: archive \"%s\" is LZ4 compressed, but pg_hexedit was built without LZ4 support\n",
+				as->archiveName);
+		exitCode = 1;
+		ArchiveMemberClose(as);
+		return NULL;
+	}
+#endif
+
+	if (!ArchiveRestart(as))
+	{
+		ArchiveMemberClose(as);
+		return NULL;
+	}
+
+#ifdef __GLIBC__
+	{
+		cookie_io_functions_t functions = {ArchiveCookieRead, NULL,
+		ArchiveCookieSeek, ArchiveCookieClose};
+
+		stream = fopencookie(as, "rb", functions);
+	}
+#else
+	stream = funopen(as, ArchiveCookieRead, NULL, ArchiveCookieSeek,
+					 ArchiveCookieClose);
+#endif
+	if (!stream)
+	{
+		fprintf(stderr, "pg_hexedit error: could not open stream for archive \"%s\"\n",
+				as->archiveName);
+		exitCode = 1;
+		ArchiveMemberClose(as);
+		return NULL;
+	}
+	archiveMember = as;
+
+	return stream;
+}
+
+#endif							/* PG_HEXEDIT_EXTENSION */
+
+/*
+ * Hash function is taken from sdbm, a public-domain reimplementation of the
+ * ndbm database library.
+ */
+static uint32
+sdbmhash(const unsigned char *elem, size_t len)
+{
+	uint32		hash = 0;
+	int			i;
+
+	for (i = 0; i < len; elem++, i++)
+	{
+		hash = (*elem) + (hash << 6) + (hash << 16) - hash;
+	}
+
+	return hash;
+}
+
+/*
+ * Return a cstring of an html color that is a function of attrName argument.
+ */
+static char *
+GetColorFromAttrname(const char *attrName)
 {
 	uint32		hash;
 	uint8		red;
@@ -425,6 +3016,8 @@ GetColorFromAttrname(const char *attrName)
 	return colorStr;
 }
 
+#ifndef PG_HEXEDIT_EXTENSION
+
 /*
  * Iterate through the provided options and set the option flags.  An error
  * will result in a positive rc and will force a display of the usage
@@ -654,3334 +3247,12264 @@ ConsumeOptions(int numOptions, char **options)
 				break;
 			}
 		}
-		/* The last option MUST be the file name */
-		else if (x == (numOptions - 1))
+
+		/*
+		 * Check for the special case where the user wants external TOAST
+		 * pointers resolved against a TOAST relation file.
+		 */
+		else if ((optionStringLength == 2)
+				 && (strcmp(optionString, "-T") == 0))
 		{
-			/* Check to see if this looks like an option string before opening */
-			if (optionString[0] != '-')
+			SET_OPTION(blockOptions, BLOCK_TOAST, 'T');
+			/* Only accept the TOAST option once */
+			if (rc == OPT_RC_DUPLICATE)
+				break;
+
+			/* The token immediately following -T is the TOAST file */
+			if (x >= (numOptions - 2))
 			{
-				fp = fopen(optionString, "rb");
-				if (fp)
-				{
-					fileName = options[x];
-					if (!(segmentOptions & SEGMENT_NUMBER_FORCED))
-						segmentNumber = GetSegmentNumberFromFileName(fileName);
-				}
-				else
-				{
-					rc = OPT_RC_FILE;
-					fprintf(stderr, "pg_hexedit error: could not open file \"%s\"\n",
-							optionString);
-					exitCode = 1;
-					break;
-				}
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing TOAST file name\n");
+				exitCode = 1;
+				break;
 			}
+
+			/* Next option encountered must be TOAST file name */
+			optionString = options[++x];
+			toastFp = fopen(optionString, "rb");
+			if (toastFp)
+				toastFileName = optionString;
 			else
 			{
-				/*
-				 * Could be the case where the help flag is used without a
-				 * filename. Otherwise, the last option isn't a file
-				 */
-				if (strcmp(optionString, "-h") == 0)
-					rc = OPT_RC_COPYRIGHT;
-				else
-				{
-					rc = OPT_RC_FILE;
-					fprintf(stderr, "pg_hexedit error: missing file name to dump\n");
-					exitCode = 1;
-				}
+				rc = OPT_RC_FILE;
+				fprintf(stderr, "pg_hexedit error: could not open TOAST file \"%s\"\n",
+						optionString);
+				exitCode = 1;
 				break;
 			}
 		}
-		else
+
+		/*
+		 * Check for the special case where the user wants modes that do not
+		 * emit tags to use several worker threads
+		 */
+		else if ((optionStringLength == 2)
+				 && (strcmp(optionString, "-j") == 0))
 		{
-			unsigned int y;
+			int			localNumWorkers;
 
-			/* Option strings must start with '-' and contain switches */
-			if (optionString[0] != '-')
+			SET_OPTION(blockOptions, BLOCK_JOBS, 'j');
+			/* Only accept the jobs option once */
+			if (rc == OPT_RC_DUPLICATE)
+				break;
+
+			/* The token immediately following -j is the number of jobs */
+			if (x >= (numOptions - 2))
 			{
 				rc = OPT_RC_INVALID;
-				fprintf(stderr, "pg_hexedit error: invalid option string \"%s\"\n",
+				fprintf(stderr, "pg_hexedit error: missing number of jobs\n");
+				exitCode = 1;
+				break;
+			}
+
+			/* Next option encountered must be number of jobs */
+			optionString = options[++x];
+			if ((localNumWorkers = GetOptionValue(optionString)) > 0 &&
+				localNumWorkers <= 256)
+				numWorkers = localNumWorkers;
+			else
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid number of jobs requested \"%s\"\n",
 						optionString);
 				exitCode = 1;
 				break;
 			}
+		}
 
-			/*
-			 * Iterate through the singular option string, throw out garbage,
-			 * duplicates and set flags to be used in formatting
-			 */
-			for (y = 1; y < optionStringLength; y++)
+		/*
+		 * Check for the special case where the user wants per-attribute
+		 * statistics instead of tags
+		 */
+		else if (strcmp(optionString, "--column-stats") == 0)
+		{
+			/* Only accept the column stats option once */
+			if (blockOptions & BLOCK_COLUMN_STATS)
 			{
-				switch (optionString[y])
-				{
-						/* Display the usage screen */
-					case 'h':
-						rc = OPT_RC_COPYRIGHT;
-						break;
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--column-stats\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_COLUMN_STATS;
 
-						/* Verify all block checksums */
-					case 'k':
-						SET_OPTION(blockOptions, BLOCK_CHECKSUMS, 'k');
-						break;
+			/* The last option must still be the file name */
+			if (x == (numOptions - 1))
+			{
+				rc = OPT_RC_FILE;
+				fprintf(stderr, "pg_hexedit error: missing file name to dump\n");
+				exitCode = 1;
+				break;
+			}
+		}
 
-						/* Verify block checksums when non-zero */
-					case 'z':
-						SET_OPTION(blockOptions, BLOCK_ZEROSUMS, 'z');
-						break;
+		/*
+		 * Check for the special case where the user wants tuples salvaged in
+		 * COPY BINARY format instead of tags
+		 */
+		else if (strcmp(optionString, "--salvage") == 0)
+		{
+			/* Only accept the salvage option once */
+			if (blockOptions & BLOCK_SALVAGE)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--salvage\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_SALVAGE;
 
-						/* Skip non-root leaf pages */
-					case 'l':
-						SET_OPTION(blockOptions, BLOCK_SKIP_LEAF, 'l');
-						break;
+			/* The token immediately following --salvage is the output file */
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing salvage output file name\n");
+				exitCode = 1;
+				break;
+			}
 
-					default:
-						rc = OPT_RC_INVALID;
-						fprintf(stderr, "pg_hexedit error: unknown option '%c'\n",
-								optionString[y]);
-						exitCode = 1;
-						break;
-				}
+			/* Next option encountered must be output file name */
+			optionString = options[++x];
+			if (strcmp(optionString, "-") == 0)
+				salvageFp = stdout;
+			else
+				salvageFp = fopen(optionString, "wb");
 
-				if (rc)
-					break;
+			if (salvageFp)
+				salvageFileName = optionString;
+			else
+			{
+				rc = OPT_RC_FILE;
+				fprintf(stderr, "pg_hexedit error: could not open salvage output file \"%s\"\n",
+						optionString);
+				exitCode = 1;
+				break;
 			}
 		}
-	}
-
-	if (rc == OPT_RC_DUPLICATE)
-	{
-		fprintf(stderr, "pg_hexedit error: duplicate option listed '%c'\n",
-				duplicateSwitch);
-		exitCode = 1;
-	}
-
-	return (rc);
-}
 
-/*
- * Given the index into the parameter list, convert and return the current
- * string to a number if possible
- */
-static int
-GetOptionValue(char *optionString)
-{
-	unsigned int x;
-	int			value = -1;
-	int			optionStringLength = strlen(optionString);
+		/*
+		 * Check for the special case where the user only wants tags for
+		 * attribute values that are not valid UTF-8
+		 */
+		else if (strcmp(optionString, "--check-utf8") == 0)
+		{
+			/* Only accept the UTF-8 check option once */
+			if (blockOptions & BLOCK_CHECK_UTF8)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--check-utf8\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_CHECK_UTF8;
 
-	/* Verify the next option looks like a number */
-	for (x = 0; x < optionStringLength; x++)
-	{
-		if (!isdigit((int) optionString[x]))
-			break;
-	}
+			/* The token immediately following --check-utf8 is names list */
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing --check-utf8 attribute names\n");
+				exitCode = 1;
+				break;
+			}
 
-	/* Convert the string to a number if it looks good */
-	if (x == optionStringLength)
-		value = atoi(optionString);
+			/* Resolved against attrlist once all options are consumed */
+			utf8AttrList = options[++x];
+		}
 
-	return value;
-}
+		/*
+		 * Check for the special case where the user wants a page LSN heatmap
+		 * instead of tags
+		 */
+		else if (strcmp(optionString, "--lsn-heatmap") == 0)
+		{
+			/* Only accept the heatmap option once */
+			if (blockOptions & BLOCK_LSN_HEATMAP)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--lsn-heatmap\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_LSN_HEATMAP;
 
-/*
- * Given an alphanumeric LSN, convert and return it to an XLogRecPtr if
- * possible
- */
-static XLogRecPtr
-GetOptionXlogRecPtr(char *optionString)
-{
-	uint32		xlogid;
-	uint32		xrecoff;
-	XLogRecPtr	value = InvalidXLogRecPtr;
+			/* The token immediately following --lsn-heatmap is range count */
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing number of heatmap ranges\n");
+				exitCode = 1;
+				break;
+			}
 
-	if (sscanf(optionString, "%X/%X", &xlogid, &xrecoff) == 2)
-		value = (uint64) xlogid << 32 | xrecoff;
+			optionString = options[++x];
+			if ((heatmapRanges = GetOptionValue(optionString)) <= 0)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid number of heatmap ranges \"%s\"\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
+		}
 
-	return value;
-}
+		/*
+		 * Check for the special case where the user wants a full-page write
+		 * estimate instead of tags
+		 */
+		else if (strcmp(optionString, "--fpw-estimate") == 0)
+		{
+			/* Only accept the estimate option once */
+			if (blockOptions & BLOCK_FPW_ESTIMATE)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--fpw-estimate\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_FPW_ESTIMATE;
 
-/*
- * Given an attrlist string (pg_hexedit -D argument string), deserialize into
- * data structures used by tuple decoding to create per-tuple, per-attribute
- * tags.
- *
- * Returns false on failure, allowing caller to set exitCode and print
- * supplemental information common to all parse failures.
- */
-static bool
-ParseAttributeListString(const char *arg)
-{
-	char	   *attrlist;
-	int			lennamealign;
-	char	   *curropt;
-	char	   *nextopt;
+			/* The token immediately following --fpw-estimate is range count */
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing number of estimate ranges\n");
+				exitCode = 1;
+				break;
+			}
 
-	/* Allocate space for decoding state */
-	attlenrel = pg_malloc(sizeof(int) * MaxTupleAttributeNumber);
-	attnamerel = pg_malloc(sizeof(char *) * MaxTupleAttributeNumber);
-	attcolorrel = pg_malloc(sizeof(char *) * MaxTupleAttributeNumber);
-	attalignrel = pg_malloc(sizeof(char) * MaxTupleAttributeNumber);
+			optionString = options[++x];
+			if ((fpwRanges = GetOptionValue(optionString)) <= 0)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid number of estimate ranges \"%s\"\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
+		}
 
-	/* Create copy of argument string to scribble on */
-	attrlist = pg_strdup(arg);
-
-	nrelatts = 0;
-	lennamealign = 0;
-	curropt = attrlist;
-	while (curropt)
-	{
-		if (*curropt == '"')
+		/* Check for --fpw-estimate REDO LSNs, which may be repeated */
+		else if (strcmp(optionString, "--redo") == 0)
 		{
-			/* Move past leading " character, omitting it */
-			curropt++;
-			/* Find terminating " character, skipping any contained ',' char */
-			nextopt = strchr(curropt, '"');
-			if (!nextopt)
-				return false;
-			/* Eliminate trailing " character from current option */
-			*nextopt = '\0';
-			/* Prepare next option */
-			nextopt++;
-			nextopt = strchr(nextopt, ',');
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing LSN\n");
+				exitCode = 1;
+				break;
+			}
+
+			if (nredoLsns >= MAX_LSN_CUTOFFS)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: at most %d --redo options may be specified\n",
+						MAX_LSN_CUTOFFS);
+				exitCode = 1;
+				break;
+			}
+
+			optionString = options[++x];
+			if ((redoLsns[nredoLsns++] = GetOptionXlogRecPtr(optionString)) == InvalidXLogRecPtr)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid LSN identifier \"%s\"\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
 		}
-		else
-			nextopt = strchr(curropt, ',');
 
-		if (nextopt)
+		/*
+		 * Check for the special case where the user wants Prometheus metrics
+		 * instead of tags
+		 */
+		else if (strcmp(optionString, "--metrics") == 0)
 		{
-			/* Eliminate , character from current option */
-			*nextopt = '\0';
-			nextopt++;
+			/* Only accept the metrics option once */
+			if (blockOptions & BLOCK_METRICS)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--metrics\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_METRICS;
+
+			/* The token immediately following --metrics is the output file */
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing metrics output file name\n");
+				exitCode = 1;
+				break;
+			}
+
+			metricsFileName = options[++x];
 		}
 
-		if (lennamealign == 0)
+		/*
+		 * Check for the special case where the user wants a list of page
+		 * anomalies, and tags for anomalous pages only
+		 */
+		else if (strcmp(optionString, "--check") == 0)
 		{
-			int			attlen;
+			/* Only accept the check option once */
+			if (blockOptions & BLOCK_CHECK)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--check\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_CHECK;
 
-			if (sscanf(curropt, "%d", &attlen) != 1)
+			/* The token immediately following --check is the output file */
+			if (x >= (numOptions - 2))
 			{
-				fprintf(stderr, "pg_hexedit error: could not parse attlen from attrlist argument\n");
-				return false;
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing check output file name\n");
+				exitCode = 1;
+				break;
 			}
-			attlenrel[nrelatts] = attlen;
-			/* Prepare for next item */
-			lennamealign++;
+
+			checkFileName = options[++x];
 		}
-		else if (lennamealign == 1)
+
+		/*
+		 * Check for the special case where the user wants incorrect
+		 * checksums rewritten in place instead of tags
+		 */
+		else if (strcmp(optionString, "--fix-checksums") == 0)
 		{
-			/*
-			 * Copy attribute name, and dynamically generate color for
-			 * attribute
-			 */
-			attnamerel[nrelatts] = pg_strdup(curropt);
-			attcolorrel[nrelatts] = GetColorFromAttrname(curropt);
-			/* Prepare for next item */
-			lennamealign++;
+			/* Only accept the fix checksums option once */
+			if (blockOptions & BLOCK_FIX_CHECKSUMS)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--fix-checksums\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_FIX_CHECKSUMS;
+
+			/* The last option must still be the file name */
+			if (x == (numOptions - 1))
+			{
+				rc = OPT_RC_FILE;
+				fprintf(stderr, "pg_hexedit error: missing file name to dump\n");
+				exitCode = 1;
+				break;
+			}
 		}
-		else
+
+		/* Check for --fix-checksums snapshot of relation file */
+		else if (strcmp(optionString, "--baseline") == 0)
 		{
-			char		attalign = *curropt;
+			if (baselineFileName)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--baseline\"\n");
+				exitCode = 1;
+				break;
+			}
 
-			if (attalign != 'i' && attalign != 'c' && attalign != 'd' &&
-				attalign != 's')
+			if (x >= (numOptions - 2))
 			{
-				fprintf(stderr, "pg_hexedit error: invalid attalign value '%c' in attrlist argument\n",
-						attalign);
-				return false;
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing baseline file name\n");
+				exitCode = 1;
+				break;
 			}
-			if (attlenrel[nrelatts] == -2 && attalign != 'c')
+
+			baselineFileName = options[++x];
+		}
+
+		/* Check for --fix-checksums fsync policy */
+		else if (strcmp(optionString, "--fsync") == 0)
+		{
+			if (fixFsyncPolicySet)
 			{
-				fprintf(stderr, "pg_hexedit error: unexpected attalign '%c' for cstring in attrlist argument\n",
-						attalign);
-				return false;
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--fsync\"\n");
+				exitCode = 1;
+				break;
 			}
-			attalignrel[nrelatts] = attalign;
-			/* Prepare for next item, and next attribute in "descriptor" */
-			if (nrelatts >= MaxTupleAttributeNumber)
+
+			if (x >= (numOptions - 2))
 			{
-				fprintf(stderr, "pg_hexedit error: too many attributes represented in attrlist argument\n");
-				return false;
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing fsync policy\n");
+				exitCode = 1;
+				break;
+			}
+
+			optionString = options[++x];
+			fixFsyncPolicySet = true;
+			if (strcmp(optionString, "end") == 0)
+				fixFsyncPolicy = FIX_FSYNC_END;
+			else if (strcmp(optionString, "each") == 0)
+				fixFsyncPolicy = FIX_FSYNC_EACH;
+			else if (strcmp(optionString, "none") == 0)
+				fixFsyncPolicy = FIX_FSYNC_NONE;
+			else
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid fsync policy \"%s\" (must be end, each, or none)\n",
+						optionString);
+				exitCode = 1;
+				break;
 			}
-			lennamealign = 0;
-			nrelatts++;
 		}
 
-		curropt = nextopt;
-	}
+		/*
+		 * Check for the special case where the user wants a patch file of
+		 * field assignments applied in place instead of tags
+		 */
+		else if (strcmp(optionString, "--apply") == 0)
+		{
+			/* Only accept the apply option once */
+			if (blockOptions & BLOCK_APPLY)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--apply\"\n");
+				exitCode = 1;
+				break;
+			}
 
-	/* Be tidy */
-	pg_free(attrlist);
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing patch file name\n");
+				exitCode = 1;
+				break;
+			}
 
-	/*
-	 * Should be at least one attribute, and should have attlen, attname, and
-	 * attalign for each attribute
-	 */
-	return nrelatts > 0 && lennamealign == 0;
-}
+			blockOptions |= BLOCK_APPLY;
+			applyFileName = options[++x];
+		}
 
-/*
- * Read the page header off of block 0 to determine the block size used in this
- * file.  Can be overridden using the -s option.  The returned value is the
- * block size of block 0 on disk.  If a valid page size could not be read,
- * assumes BLCKSZ.
- */
-static unsigned int
-GetBlockSize(void)
-{
-	unsigned int pageHeaderSize = sizeof(PageHeaderData);
-	unsigned int localSize = BLCKSZ;
-	int			bytesRead = 0;
-	char		localCache[sizeof(PageHeaderData)];
+		/*
+		 * Check for the special case where the user wants randomly corrupted
+		 * copies of the relation file instead of tags
+		 */
+		else if (strcmp(optionString, "--inject") == 0)
+		{
+			/* Only accept the inject option once */
+			if (blockOptions & BLOCK_INJECT)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--inject\"\n");
+				exitCode = 1;
+				break;
+			}
 
-	/* Read the first header off of block 0 to determine the block size */
-	bytesRead = fread(&localCache, 1, pageHeaderSize, fp);
-	rewind(fp);
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing inject output directory name\n");
+				exitCode = 1;
+				break;
+			}
 
-	if (bytesRead == pageHeaderSize)
-		localSize = (unsigned int) PageGetPageSize((Page) &localCache);
-	else
-	{
-		fprintf(stderr, "pg_hexedit error: unable to read full page header from first block\n"
-				"read %u bytes\n", bytesRead);
-		exitCode = 1;
-	}
+			blockOptions |= BLOCK_INJECT;
+			injectDirName = options[++x];
+		}
 
-	if (localSize == 0 || ((localSize - 1) & localSize) != 0)
-	{
-		fprintf(stderr, "pg_hexedit error: invalid block size %u encountered in first block\n",
-				localSize);
-		exitCode = 1;
-		localSize = BLCKSZ;
-	}
+		/* Check for --inject number of corrupted copies, or corruptions */
+		else if (strcmp(optionString, "--variants") == 0 ||
+				 strcmp(optionString, "--corruptions") == 0)
+		{
+			bool		variants = strcmp(optionString, "--variants") == 0;
+			int			value;
 
-	return localSize;
-}
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing number of %s\n",
+						variants ? "variants" : "corruptions");
+				exitCode = 1;
+				break;
+			}
 
-/*
- * Determine the LSN of page as an XLogRecPtr
- */
-static XLogRecPtr
-GetPageLsn(Page page)
-{
-	PageHeader	pageHeader = (PageHeader) page;
+			optionString = options[++x];
+			if ((value = GetOptionValue(optionString)) <= 0)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid number of %s \"%s\"\n",
+						variants ? "variants" : "corruptions", optionString);
+				exitCode = 1;
+				break;
+			}
 
-	return PageXLogRecPtrGet(pageHeader->pd_lsn);
-}
+			if (variants)
+				injectVariants = value;
+			else
+				injectCorruptions = value;
+			injectOptionSet = true;
+		}
 
-/*
- * Determine the contents of the special section on the block and return this
- * enum value
- */
-static unsigned int
+		/* Check for --inject classes of field to corrupt */
+		else if (strcmp(optionString, "--classes") == 0)
+		{
+			char	   *classes;
+			char	   *class;
+
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing list of classes\n");
+				exitCode = 1;
+				break;
+			}
+
+			optionString = options[++x];
+			classes = pg_strdup(optionString);
+			injectClassMask = 0;
+			for (class = strtok(classes, ","); class; class = strtok(NULL, ","))
+			{
+				int			i;
+
+				for (i = 0; i < INJECT_NCLASSES; i++)
+				{
+					if (strcmp(class, injectClassNames[i]) == 0)
+						break;
+				}
+				if (i == INJECT_NCLASSES)
+				{
+					rc = OPT_RC_INVALID;
+					fprintf(stderr, "pg_hexedit error: invalid class \"%s\" (must be lp, tuple, btree, posting, gin, or page)\n",
+							class);
+					exitCode = 1;
+					break;
+				}
+				injectClassMask |= 1 << i;
+			}
+			pg_free(classes);
+			if (rc == OPT_RC_INVALID)
+				break;
+			if (injectClassMask == 0)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid list of classes \"%s\"\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
+			injectOptionSet = true;
+		}
+
+		/* Check for --inject random seed */
+		else if (strcmp(optionString, "--seed") == 0)
+		{
+			char	   *end;
+
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing seed\n");
+				exitCode = 1;
+				break;
+			}
+
+			optionString = options[++x];
+			errno = 0;
+			injectSeed = strtoull(optionString, &end, 10);
+			if (!isdigit((unsigned char) *optionString) || *end != '\0' ||
+				errno != 0)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid seed \"%s\"\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
+			injectSeedSet = true;
+			injectOptionSet = true;
+		}
+
+		/* Check for --plugin shared libraries, which may be repeated */
+		else if (strcmp(optionString, "--plugin") == 0)
+		{
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing plugin file name\n");
+				exitCode = 1;
+				break;
+			}
+
+			if (!LoadPlugin(options[++x]))
+			{
+				rc = OPT_RC_INVALID;
+				exitCode = 1;
+				break;
+			}
+		}
+
+		/* Check for --lsn-heatmap LSN cutoffs, which may be repeated */
+		else if (strcmp(optionString, "--lsn-cutoff") == 0)
+		{
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing LSN\n");
+				exitCode = 1;
+				break;
+			}
+
+			if (nlsnCutoffs >= MAX_LSN_CUTOFFS)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: at most %d --lsn-cutoff options may be specified\n",
+						MAX_LSN_CUTOFFS);
+				exitCode = 1;
+				break;
+			}
+
+			optionString = options[++x];
+			if ((lsnCutoffs[nlsnCutoffs++] = GetOptionXlogRecPtr(optionString)) == InvalidXLogRecPtr)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid LSN identifier \"%s\"\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
+		}
+
+		/* Check for the special case of sharded tags output */
+		else if (strcmp(optionString, "--shard-blocks") == 0)
+		{
+			/* Only accept the shard option once */
+			if (blockOptions & BLOCK_SHARD)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--shard-blocks\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_SHARD;
+
+			/* The token immediately following --shard-blocks is shard size */
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing number of blocks per shard\n");
+				exitCode = 1;
+				break;
+			}
+
+			optionString = options[++x];
+			if ((shardBlocks = GetOptionValue(optionString)) <= 0)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid number of blocks per shard \"%s\"\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
+		}
+
+		/* Check for the special case of serving tags on request */
+		else if (strcmp(optionString, "--serve") == 0)
+		{
+			/* Only accept the serve option once */
+			if (blockOptions & BLOCK_SERVE)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--serve\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_SERVE;
+
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing socket path\n");
+				exitCode = 1;
+				break;
+			}
+
+			serveSocketPath = options[++x];
+			if (strlen(serveSocketPath) >= sizeof(((struct sockaddr_un *) NULL)->sun_path))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: socket path \"%s\" is too long\n",
+						serveSocketPath);
+				exitCode = 1;
+				break;
+			}
+		}
+
+		/* Check for the special case of the interactive viewer */
+		else if (strcmp(optionString, "--view") == 0)
+		{
+			/* Only accept the viewer option once */
+			if (blockOptions & BLOCK_VIEW)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--view\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_VIEW;
+
+			/* --view must be followed by a file name */
+			if (x >= (numOptions - 1))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing file name to view\n");
+				exitCode = 1;
+				break;
+			}
+		}
+
+		/* Check for HTML report directory */
+		else if (strcmp(optionString, "--html") == 0)
+		{
+			if (htmlDirName)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--html\"\n");
+				exitCode = 1;
+				break;
+			}
+
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing HTML report directory\n");
+				exitCode = 1;
+				break;
+			}
+
+			htmlDirName = options[++x];
+			blockOptions |= BLOCK_HTML;
+		}
+
+		/* Check for wxHexEditor session config file */
+		else if (strcmp(optionString, "--session") == 0)
+		{
+			int			kind;
+
+			if (sessionFileName)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--session\"\n");
+				exitCode = 1;
+				break;
+			}
+
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing session file name\n");
+				exitCode = 1;
+				break;
+			}
+
+			sessionFileName = options[++x];
+			for (kind = 0; kind < SESSION_PAGE_NKINDS; kind++)
+				sessionFirstOfKind[kind] = InvalidBlockNumber;
+		}
+
+		/* Check for --lsn-heatmap bookmarks file */
+		else if (strcmp(optionString, "--bookmarks") == 0)
+		{
+			if (bookmarksFileName)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--bookmarks\"\n");
+				exitCode = 1;
+				break;
+			}
+
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing bookmarks file name\n");
+				exitCode = 1;
+				break;
+			}
+
+			bookmarksFileName = options[++x];
+		}
+
+		/* Check for the special case of reading without the page cache */
+		else if (strcmp(optionString, "--direct-io") == 0)
+		{
+			/* Only accept the direct I/O option once */
+			if (blockOptions & BLOCK_DIRECT_IO)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--direct-io\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_DIRECT_IO;
+
+			/* The last option must still be the file name */
+			if (x == (numOptions - 1))
+			{
+				rc = OPT_RC_FILE;
+				fprintf(stderr, "pg_hexedit error: missing file name to dump\n");
+				exitCode = 1;
+				break;
+			}
+		}
+
+		/* Check for I/O throttling limits */
+		else if (strcmp(optionString, "--max-rate") == 0 ||
+				 strcmp(optionString, "--max-iops") == 0)
+		{
+			int		   *limit = (strcmp(optionString, "--max-rate") == 0) ?
+			&maxRate : &maxIops;
+
+			if (*limit != 0)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"%s\"\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
+
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing %s limit\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
+
+			if ((*limit = GetOptionValue(options[x + 1])) <= 0)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid %s limit \"%s\"\n",
+						optionString, options[x + 1]);
+				exitCode = 1;
+				break;
+			}
+			x++;
+		}
+
+		/* Check for read-ahead queue depth */
+		else if (strcmp(optionString, "--queue-depth") == 0)
+		{
+			if (readAheadDepth != 0)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--queue-depth\"\n");
+				exitCode = 1;
+				break;
+			}
+
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing queue depth\n");
+				exitCode = 1;
+				break;
+			}
+
+			optionString = options[++x];
+			readAheadDepth = GetOptionValue(optionString);
+			if (readAheadDepth <= 0 || readAheadDepth > READ_AHEAD_MAX_DEPTH)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid queue depth \"%s\" (must be between 1 and %d)\n",
+						optionString, READ_AHEAD_MAX_DEPTH);
+				exitCode = 1;
+				break;
+			}
+		}
+
+		/* Check for the special case of human-readable progress reports */
+		else if (strcmp(optionString, "--progress") == 0)
+		{
+			/* Only accept the progress option once */
+			if (progressHuman)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--progress\"\n");
+				exitCode = 1;
+				break;
+			}
+			progressHuman = true;
+
+			/* The last option must still be the file name */
+			if (x == (numOptions - 1))
+			{
+				rc = OPT_RC_FILE;
+				fprintf(stderr, "pg_hexedit error: missing file name to dump\n");
+				exitCode = 1;
+				break;
+			}
+		}
+
+		/* Check for machine-readable progress report file descriptor */
+		else if (strcmp(optionString, "--progress-fd") == 0)
+		{
+			if (progressFd >= 0)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--progress-fd\"\n");
+				exitCode = 1;
+				break;
+			}
+
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing progress file descriptor\n");
+				exitCode = 1;
+				break;
+			}
+
+			optionString = options[++x];
+			progressFd = GetOptionValue(optionString);
+			if (progressFd < 0 || fcntl(progressFd, F_GETFD) == -1)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid progress file descriptor \"%s\" (it must be open)\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
+		}
+
+		/*
+		 * Check for the special case of --salvage attributes that are to be
+		 * loaded into bytea columns
+		 */
+		else if (strcmp(optionString, "--salvage-bytea") == 0)
+		{
+			/* Only accept the bytea attributes option once */
+			if (byteaAttrList)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--salvage-bytea\"\n");
+				exitCode = 1;
+				break;
+			}
+
+			/* The token immediately following --salvage-bytea is names list */
+			if (x >= (numOptions - 2))
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: missing --salvage-bytea attribute names\n");
+				exitCode = 1;
+				break;
+			}
+
+			/* Resolved against attrlist once all options are consumed */
+			byteaAttrList = options[++x];
+		}
+
+		/* Check for the special case of the --salvage visibility filter */
+		else if (strcmp(optionString, "--visible-only") == 0)
+		{
+			/* Only accept the visibility filter option once */
+			if (blockOptions & BLOCK_VISIBLE_ONLY)
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: duplicate option listed \"--visible-only\"\n");
+				exitCode = 1;
+				break;
+			}
+			blockOptions |= BLOCK_VISIBLE_ONLY;
+
+			/* The last option must still be the file name */
+			if (x == (numOptions - 1))
+			{
+				rc = OPT_RC_FILE;
+				fprintf(stderr, "pg_hexedit error: missing file name to dump\n");
+				exitCode = 1;
+				break;
+			}
+		}
+		/* The last option MUST be the file name */
+		else if (x == (numOptions - 1))
+		{
+			/* Check to see if this looks like an option string before opening */
+			if (optionString[0] != '-')
+			{
+				fp = fopen(optionString, "rb");
+				if (!fp && GetArchiveMemberName(optionString))
+				{
+					/* Tags are for the relation file, not the archive */
+					fp = OpenArchiveMember(optionString);
+					if (!fp)
+					{
+						rc = OPT_RC_FILE;
+						break;
+					}
+					fileName = archiveMember->memberName;
+					if (!(segmentOptions & SEGMENT_NUMBER_FORCED))
+						segmentNumber = GetSegmentNumberFromFileName(fileName);
+				}
+				else if (fp)
+				{
+					struct stat st;
+
+					fileName = options[x];
+					if (!(segmentOptions & SEGMENT_NUMBER_FORCED))
+						segmentNumber = GetSegmentNumberFromFileName(fileName);
+
+					/* --metrics can scan a whole data directory */
+					if (fstat(fileno(fp), &st) == 0 && S_ISDIR(st.st_mode))
+					{
+						fclose(fp);
+						fp = NULL;
+						metricsDataDir = fileName;
+					}
+				}
+				else
+				{
+					rc = OPT_RC_FILE;
+					fprintf(stderr, "pg_hexedit error: could not open file \"%s\"\n",
+							optionString);
+					exitCode = 1;
+					break;
+				}
+			}
+			else
+			{
+				/*
+				 * Could be the case where the help flag is used without a
+				 * filename. Otherwise, the last option isn't a file
+				 */
+				if (strcmp(optionString, "-h") == 0)
+					rc = OPT_RC_COPYRIGHT;
+				else
+				{
+					rc = OPT_RC_FILE;
+					fprintf(stderr, "pg_hexedit error: missing file name to dump\n");
+					exitCode = 1;
+				}
+				break;
+			}
+		}
+		else
+		{
+			unsigned int y;
+
+			/* Option strings must start with '-' and contain switches */
+			if (optionString[0] != '-')
+			{
+				rc = OPT_RC_INVALID;
+				fprintf(stderr, "pg_hexedit error: invalid option string \"%s\"\n",
+						optionString);
+				exitCode = 1;
+				break;
+			}
+
+			/*
+			 * Iterate through the singular option string, throw out garbage,
+			 * duplicates and set flags to be used in formatting
+			 */
+			for (y = 1; y < optionStringLength; y++)
+			{
+				switch (optionString[y])
+				{
+						/* Display the usage screen */
+					case 'h':
+						rc = OPT_RC_COPYRIGHT;
+						break;
+
+						/* Verify all block checksums */
+					case 'k':
+						SET_OPTION(blockOptions, BLOCK_CHECKSUMS, 'k');
+						break;
+
+						/* Verify block checksums when non-zero */
+					case 'z':
+						SET_OPTION(blockOptions, BLOCK_ZEROSUMS, 'z');
+						break;
+
+						/* Skip non-root leaf pages */
+					case 'l':
+						SET_OPTION(blockOptions, BLOCK_SKIP_LEAF, 'l');
+						break;
+
+					default:
+						rc = OPT_RC_INVALID;
+						fprintf(stderr, "pg_hexedit error: unknown option '%c'\n",
+								optionString[y]);
+						exitCode = 1;
+						break;
+				}
+
+				if (rc)
+					break;
+			}
+		}
+	}
+
+	if (rc == OPT_RC_DUPLICATE)
+	{
+		fprintf(stderr, "pg_hexedit error: duplicate option listed '%c'\n",
+				duplicateSwitch);
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID &&
+			 ((blockOptions & BLOCK_SCAN_MODES) &
+			  ((blockOptions & BLOCK_SCAN_MODES) - 1)) != 0)
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: only one of --column-stats, --salvage, --check-utf8, --lsn-heatmap, --fpw-estimate, --metrics, --check, and --fix-checksums may be specified\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_TOAST) &&
+			 !(blockOptions & BLOCK_DECODE))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: -T requires -D attrlist\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_TOAST) &&
+			 (blockOptions & BLOCK_SCAN_MODES & ~BLOCK_SALVAGE))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: -T cannot be combined with --column-stats, --check-utf8, --lsn-heatmap, --fpw-estimate, --metrics, --check, or --fix-checksums\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID &&
+			 (blockOptions & (BLOCK_COLUMN_STATS | BLOCK_SALVAGE |
+							  BLOCK_CHECK_UTF8)) &&
+			 !(blockOptions & BLOCK_DECODE))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --column-stats, --salvage, and --check-utf8 require -D attrlist\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_VISIBLE_ONLY) &&
+			 !(blockOptions & BLOCK_SALVAGE))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --visible-only is only supported with --salvage\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && byteaAttrList &&
+			 !(blockOptions & BLOCK_SALVAGE))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --salvage-bytea is only supported with --salvage\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_SALVAGE) &&
+			 !ParseByteaAttrList())
+	{
+		/* Give details of problem in ParseByteaAttrList() */
+		rc = OPT_RC_INVALID;
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_CHECK_UTF8) &&
+			 !ParseUtf8AttrList())
+	{
+		/* Give details of problem in ParseUtf8AttrList() */
+		rc = OPT_RC_INVALID;
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (nlsnCutoffs > 0 || bookmarksFileName) &&
+			 !(blockOptions & BLOCK_LSN_HEATMAP))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --lsn-cutoff and --bookmarks are only supported with --lsn-heatmap\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_LSN_HEATMAP) &&
+			 (blockOptions & BLOCK_SKIP_LSN))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --lsn-heatmap cannot be combined with -x (use --lsn-cutoff)\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID &&
+			 (nredoLsns > 0) != ((blockOptions & BLOCK_FPW_ESTIMATE) != 0))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --fpw-estimate requires at least one --redo, and --redo is only supported with --fpw-estimate\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_FPW_ESTIMATE) &&
+			 (blockOptions & BLOCK_SKIP_LSN))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --fpw-estimate cannot be combined with -x (use --redo)\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && sessionFileName &&
+			 (blockOptions & BLOCK_SCAN_MODES))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --session is only supported when tags are emitted for relation file\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_SHARD) &&
+			 ((blockOptions & (BLOCK_SCAN_MODES | BLOCK_TOAST)) ||
+			  sessionFileName))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --shard-blocks cannot be combined with -T, --session, or modes that print something other than tags\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & (BLOCK_SERVE | BLOCK_VIEW)) &&
+			 ((blockOptions & (BLOCK_SCAN_MODES | BLOCK_SHARD | BLOCK_RANGE)) ||
+			  (blockOptions & BLOCK_SERVE && blockOptions & BLOCK_VIEW) ||
+			  sessionFileName))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --serve and --view cannot be combined with each other, -R, --session, --shard-blocks, or modes that print something other than tags\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_HTML) &&
+			 ((blockOptions & (BLOCK_SCAN_MODES | BLOCK_TOAST | BLOCK_SHARD |
+							   BLOCK_SERVE | BLOCK_VIEW)) ||
+			  sessionFileName))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --html cannot be combined with -T, --session, --shard-blocks, --serve, --view, or modes that print something other than tags\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_DIRECT_IO) &&
+			 (blockOptions & (BLOCK_SERVE | BLOCK_VIEW | BLOCK_HTML)))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --direct-io cannot be combined with --serve, --view, or --html, which read relation file through the page cache\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && readAheadDepth > 0 &&
+			 (blockOptions & (BLOCK_SCAN_MODES | BLOCK_SERVE | BLOCK_VIEW |
+							  BLOCK_HTML)))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --queue-depth is only supported when tags are emitted for relation file\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && archiveMember &&
+			 ((blockOptions & (BLOCK_SCAN_MODES | BLOCK_SHARD | BLOCK_SERVE |
+							   BLOCK_VIEW | BLOCK_HTML | BLOCK_DIRECT_IO)) ||
+			  readAheadDepth > 0))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: relation file within archive can only be read sequentially (it is only supported when tags are emitted, without --direct-io or --queue-depth)\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && metricsDataDir &&
+			 !(blockOptions & BLOCK_METRICS))
+	{
+		rc = OPT_RC_FILE;
+		fprintf(stderr, "pg_hexedit error: \"%s\" is a directory (only --metrics accepts a data directory)\n",
+				metricsDataDir);
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && metricsDataDir &&
+			 ((blockOptions & BLOCK_RANGE) ||
+			  (segmentOptions & SEGMENT_NUMBER_FORCED)))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --metrics cannot be combined with -R or -n when it scans a data directory\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_APPLY) &&
+			 ((blockOptions & ((BLOCK_SCAN_MODES & ~BLOCK_FIX_CHECKSUMS) |
+							   BLOCK_TOAST | BLOCK_SKIP_LEAF | BLOCK_SKIP_LSN |
+							   BLOCK_RANGE | BLOCK_JOBS | BLOCK_SHARD |
+							   BLOCK_SERVE | BLOCK_VIEW | BLOCK_HTML |
+							   BLOCK_DIRECT_IO)) ||
+			  sessionFileName || baselineFileName || readAheadDepth > 0 ||
+			  archiveMember))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --apply can only be combined with -D, -k, -n, -s, -z, --fix-checksums, --fsync, --max-rate, --max-iops, and progress options\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_INJECT) &&
+			 ((blockOptions & ((BLOCK_SCAN_MODES & ~BLOCK_FIX_CHECKSUMS) |
+							   BLOCK_APPLY | BLOCK_TOAST | BLOCK_SKIP_LEAF |
+							   BLOCK_SKIP_LSN | BLOCK_JOBS | BLOCK_SHARD |
+							   BLOCK_SERVE | BLOCK_VIEW | BLOCK_HTML |
+							   BLOCK_DIRECT_IO)) ||
+			  sessionFileName || baselineFileName || fixFsyncPolicySet ||
+			  readAheadDepth > 0 || archiveMember))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --inject can only be combined with -D, -k, -n, -R, -s, -z, --fix-checksums, --max-rate, --max-iops, and progress options\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && injectOptionSet &&
+			 !(blockOptions & BLOCK_INJECT))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --variants, --corruptions, --classes, and --seed are only supported with --inject\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && baselineFileName &&
+			 !(blockOptions & BLOCK_FIX_CHECKSUMS))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --baseline is only supported with --fix-checksums\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && fixFsyncPolicySet &&
+			 !(blockOptions & (BLOCK_FIX_CHECKSUMS | BLOCK_APPLY)))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --fsync is only supported with --fix-checksums or --apply\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (progressHuman || progressFd >= 0) &&
+			 (blockOptions & (BLOCK_SERVE | BLOCK_VIEW)))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: --progress and --progress-fd cannot be combined with --serve or --view, which never finish scanning\n");
+		exitCode = 1;
+	}
+	else if (rc == OPT_RC_VALID && (blockOptions & BLOCK_JOBS) &&
+			 !(blockOptions & (BLOCK_SCAN_MODES | BLOCK_SHARD)))
+	{
+		rc = OPT_RC_INVALID;
+		fprintf(stderr, "pg_hexedit error: -j is only supported with --column-stats, --salvage, --check-utf8, --lsn-heatmap, --fpw-estimate, --metrics, --check, --fix-checksums, or --shard-blocks\n");
+		exitCode = 1;
+	}
+
+	return (rc);
+}
+
+/*
+ * Given the index into the parameter list, convert and return the current
+ * string to a number if possible
+ */
+static int
+GetOptionValue(char *optionString)
+{
+	unsigned int x;
+	int			value = -1;
+	int			optionStringLength = strlen(optionString);
+
+	/* Verify the next option looks like a number */
+	for (x = 0; x < optionStringLength; x++)
+	{
+		if (!isdigit((int) optionString[x]))
+			break;
+	}
+
+	/* Convert the string to a number if it looks good */
+	if (x == optionStringLength)
+		value = atoi(optionString);
+
+	return value;
+}
+
+/*
+ * Given an alphanumeric LSN, convert and return it to an XLogRecPtr if
+ * possible
+ */
+static XLogRecPtr
+GetOptionXlogRecPtr(char *optionString)
+{
+	uint32		xlogid;
+	uint32		xrecoff;
+	XLogRecPtr	value = InvalidXLogRecPtr;
+
+	if (sscanf(optionString, "%X/%X", &xlogid, &xrecoff) == 2)
+		value = (uint64) xlogid << 32 | xrecoff;
+
+	return value;
+}
+
+/*
+ * Given an attrlist string (pg_hexedit -D argument string), deserialize into
+ * data structures used by tuple decoding to create per-tuple, per-attribute
+ * tags.
+ *
+ * Returns false on failure, allowing caller to set exitCode and print
+ * supplemental information common to all parse failures.
+ */
+static bool
+ParseAttributeListString(const char *arg)
+{
+	char	   *attrlist;
+	int			lennamealign;
+	char	   *curropt;
+	char	   *nextopt;
+
+	/* Allocate space for decoding state */
+	attlenrel = pg_malloc(sizeof(int) * MaxTupleAttributeNumber);
+	attnamerel = pg_malloc(sizeof(char *) * MaxTupleAttributeNumber);
+	attcolorrel = pg_malloc(sizeof(char *) * MaxTupleAttributeNumber);
+	attalignrel = pg_malloc(sizeof(char) * MaxTupleAttributeNumber);
+
+	/* Create copy of argument string to scribble on */
+	attrlist = pg_strdup(arg);
+
+	nrelatts = 0;
+	lennamealign = 0;
+	curropt = attrlist;
+	while (curropt)
+	{
+		if (*curropt == '"')
+		{
+			/* Move past leading " character, omitting it */
+			curropt++;
+			/* Find terminating " character, skipping any contained ',' char */
+			nextopt = strchr(curropt, '"');
+			if (!nextopt)
+				return false;
+			/* Eliminate trailing " character from current option */
+			*nextopt = '\0';
+			/* Prepare next option */
+			nextopt++;
+			nextopt = strchr(nextopt, ',');
+		}
+		else
+			nextopt = strchr(curropt, ',');
+
+		if (nextopt)
+		{
+			/* Eliminate , character from current option */
+			*nextopt = '\0';
+			nextopt++;
+		}
+
+		if (lennamealign == 0)
+		{
+			int			attlen;
+
+			if (sscanf(curropt, "%d", &attlen) != 1)
+			{
+				fprintf(stderr, "pg_hexedit error: could not parse attlen from attrlist argument\n");
+				return false;
+			}
+			attlenrel[nrelatts] = attlen;
+			/* Prepare for next item */
+			lennamealign++;
+		}
+		else if (lennamealign == 1)
+		{
+			/*
+			 * Copy attribute name, and dynamically generate color for
+			 * attribute
+			 */
+			attnamerel[nrelatts] = pg_strdup(curropt);
+			attcolorrel[nrelatts] = GetColorFromAttrname(curropt);
+			/* Prepare for next item */
+			lennamealign++;
+		}
+		else
+		{
+			char		attalign = *curropt;
+
+			if (attalign != 'i' && attalign != 'c' && attalign != 'd' &&
+				attalign != 's')
+			{
+				fprintf(stderr, "pg_hexedit error: invalid attalign value '%c' in attrlist argument\n",
+						attalign);
+				return false;
+			}
+			if (attlenrel[nrelatts] == -2 && attalign != 'c')
+			{
+				fprintf(stderr, "pg_hexedit error: unexpected attalign '%c' for cstring in attrlist argument\n",
+						attalign);
+				return false;
+			}
+			attalignrel[nrelatts] = attalign;
+			/* Prepare for next item, and next attribute in "descriptor" */
+			if (nrelatts >= MaxTupleAttributeNumber)
+			{
+				fprintf(stderr, "pg_hexedit error: too many attributes represented in attrlist argument\n");
+				return false;
+			}
+			lennamealign = 0;
+			nrelatts++;
+		}
+
+		curropt = nextopt;
+	}
+
+	/* Be tidy */
+	pg_free(attrlist);
+
+	/*
+	 * Should be at least one attribute, and should have attlen, attname, and
+	 * attalign for each attribute
+	 */
+	return nrelatts > 0 && lennamealign == 0;
+}
+
+/*
+ * qsort comparator for -T TOAST chunk index.  Sorts by (chunk_id, chunk_seq),
+ * then by TOAST file position, so that duplicate chunks are adjacent.
+ */
+static int
+ToastChunkCmp(const void *a, const void *b)
+{
+	const ToastChunk *chunka = (const ToastChunk *) a;
+	const ToastChunk *chunkb = (const ToastChunk *) b;
+
+	if (chunka->chunkId != chunkb->chunkId)
+		return chunka->chunkId < chunkb->chunkId ? -1 : 1;
+	if (chunka->chunkSeq != chunkb->chunkSeq)
+		return chunka->chunkSeq < chunkb->chunkSeq ? -1 : 1;
+
+	return ToastChunkFileOrderCmp(a, b);
+}
+
+/*
+ * qsort comparator that sorts -T TOAST chunk index in TOAST file order
+ */
+static int
+ToastChunkFileOrderCmp(const void *a, const void *b)
+{
+	const ToastChunk *chunka = (const ToastChunk *) a;
+	const ToastChunk *chunkb = (const ToastChunk *) b;
+
+	if (chunka->dataOff != chunkb->dataOff)
+		return chunka->dataOff < chunkb->dataOff ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * Scan -T TOAST relation file, and build an index of every chunk found within
+ * it.  The index is used to resolve external on-disk TOAST pointers that are
+ * encountered when decoding the main relation file's tuples.
+ *
+ * TOAST relations always have the same three attributes: chunk_id (an oid),
+ * chunk_seq (an int4), and chunk_data (a bytea).  We rely on that, rather
+ * than requiring a second attrlist argument.
+ */
+static void
+BuildToastChunkIndex(void)
+{
+	char	   *toastBuffer = (char *) pg_malloc(blockSize);
+	BlockNumber blkno = 0;
+	size_t		bytesRead;
+	int			maxchunks = 1024;
+
+	toastSegmentBlockDelta =
+		(segmentSize / blockSize) * GetSegmentNumberFromFileName(toastFileName);
+	toastChunks = (ToastChunk *) pg_malloc(sizeof(ToastChunk) * maxchunks);
+	toaststatsrel = (ToastAttStats *) pg_malloc0(sizeof(ToastAttStats) *
+												  nrelatts);
+
+	while ((bytesRead = fread(toastBuffer, 1, blockSize, toastFp)) == blockSize)
+	{
+		Page		page = (Page) toastBuffer;
+		PageHeader	pageHeader = (PageHeader) page;
+		int			maxOffset;
+		OffsetNumber offset;
+
+		/* Charge the read here, which paces the reads that follow it */
+		ThrottleIo(blockSize);
+
+		if (PageIsNew(page))
+		{
+			blkno++;
+			continue;
+		}
+
+		maxOffset = PageGetMaxOffsetNumber(page);
+		if (pageHeader->pd_special != blockSize ||
+			pageHeader->pd_lower > blockSize ||
+			maxOffset > blockSize / sizeof(ItemIdData))
+		{
+			fprintf(stderr, "pg_hexedit error: block %u of TOAST file \"%s\" is not a valid heap page\n",
+					blkno, toastFileName);
+			exitCode = 1;
+			blkno++;
+			continue;
+		}
+
+		for (offset = FirstOffsetNumber;
+			 offset <= maxOffset;
+			 offset = OffsetNumberNext(offset))
+		{
+			ItemId		itemId = PageGetItemId(page, offset);
+			unsigned int itemSize = ItemIdGetLength(itemId);
+			unsigned int itemOffset = ItemIdGetOffset(itemId);
+			HeapTupleHeader htup;
+			unsigned char *tupdata;
+			unsigned char *chunkdata;
+			unsigned int chunkOff;
+			ToastChunk *chunk;
+
+			if (!ItemIdIsNormal(itemId))
+				continue;
+
+			if (itemOffset + itemSize > blockSize ||
+				itemSize < SizeofHeapTupleHeader)
+			{
+				fprintf(stderr, "pg_hexedit error: (%u,%u) TOAST tuple has invalid line pointer in TOAST file \"%s\"\n",
+						blkno + toastSegmentBlockDelta, offset, toastFileName);
+				exitCode = 1;
+				continue;
+			}
+
+			htup = (HeapTupleHeader) PageGetItem(page, itemId);
+			chunkOff = htup->t_hoff + sizeof(Oid) + sizeof(int32);
+
+			/*
+			 * chunk_data must be a non-NULL inline varlena that is neither
+			 * compressed nor itself external
+			 */
+			if (HeapTupleHeaderGetNatts(htup) < 3 ||
+				((htup->t_infomask & HEAP_HASNULL) &&
+				 (att_isnull(0, htup->t_bits) || att_isnull(1, htup->t_bits) ||
+				  att_isnull(2, htup->t_bits))) ||
+				chunkOff + VARHDRSZ_SHORT > itemSize)
+			{
+				fprintf(stderr, "pg_hexedit error: (%u,%u) TOAST tuple is malformed in TOAST file \"%s\"\n",
+						blkno + toastSegmentBlockDelta, offset, toastFileName);
+				exitCode = 1;
+				continue;
+			}
+
+			tupdata = (unsigned char *) htup + htup->t_hoff;
+			chunkdata = (unsigned char *) htup + chunkOff;
+
+			if (VARATT_IS_1B_E(chunkdata) ||
+				(VARATT_IS_4B(chunkdata) &&
+				 (chunkOff + VARHDRSZ > itemSize || VARATT_IS_4B_C(chunkdata))) ||
+				chunkOff + VARSIZE_ANY(chunkdata) > itemSize)
+			{
+				fprintf(stderr, "pg_hexedit error: (%u,%u) TOAST tuple has malformed chunk_data in TOAST file \"%s\"\n",
+						blkno + toastSegmentBlockDelta, offset, toastFileName);
+				exitCode = 1;
+				continue;
+			}
+
+			if (ntoastchunks >= maxchunks)
+			{
+				maxchunks *= 2;
+				toastChunks = (ToastChunk *) pg_realloc(toastChunks,
+														sizeof(ToastChunk) *
+														maxchunks);
+			}
+
+			chunk = &toastChunks[ntoastchunks++];
+			chunk->chunkId = *((Oid *) tupdata);
+			chunk->chunkSeq = *((int32 *) (tupdata + sizeof(Oid)));
+			chunk->blkno = blkno;
+			chunk->offset = offset;
+			chunk->itemLen = itemSize;
+			chunk->dataOff = blkno * blockSize + itemOffset + chunkOff +
+				(VARATT_IS_1B(chunkdata) ? VARHDRSZ_SHORT : VARHDRSZ);
+			chunk->dataLen = VARSIZE_ANY_EXHDR(chunkdata);
+			chunk->duplicate = false;
+			chunk->refAttnum = -1;
+			chunk->refBlkno = InvalidBlockNumber;
+			chunk->refOffset = InvalidOffsetNumber;
+		}
+
+		blkno++;
+	}
+
+	if (bytesRead != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: TOAST file \"%s\" has partial block %u of size %zu\n",
+				toastFileName, blkno, bytesRead);
+		exitCode = 1;
+	}
+
+	qsort(toastChunks, ntoastchunks, sizeof(ToastChunk), ToastChunkCmp);
+	pg_free(toastBuffer);
+}
+
+/*
+ * Resolve external on-disk TOAST pointer at attptr against -T TOAST chunk
+ * index.
+ *
+ * Chunks are marked as referenced by the TID and attribute, and the
+ * attribute's TOAST accounting is updated.  Missing and duplicate chunks are
+ * reported as errors, and also cause *broken to be set.  Returns a
+ * description of the pointer that is suitable for use in a tag.
+ *
+ * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ */
+static char *
+ResolveToastPointer(BlockNumber blkno, OffsetNumber offset, int attnum,
+					unsigned char *attptr, bool *broken)
+{
+	varatt_external toast_pointer;
+	ToastAttStats *stats = &toaststatsrel[attnum];
+	char	   *description = pg_malloc(128);
+	uint32		extsize;
+	uint64		chunkBytes = 0;
+	int32		expectedSeq = 0;
+	int			nchunks = 0;
+	int			i;
+
+	VARATT_EXTERNAL_GET_POINTER(toast_pointer, attptr);
+#if PG_VERSION_NUM >= 140000
+	extsize = VARATT_EXTERNAL_GET_EXTSIZE(toast_pointer);
+#else
+	extsize = toast_pointer.va_extsize;
+#endif
+
+	*broken = false;
+	stats->nexternal++;
+	stats->rawBytes += toast_pointer.va_rawsize;
+	stats->extBytes += extsize;
+
+	for (i = FindFirstToastChunk(toast_pointer.va_valueid);
+		 i < ntoastchunks && toastChunks[i].chunkId == toast_pointer.va_valueid;
+		 i++)
+	{
+		ToastChunk *chunk = &toastChunks[i];
+
+		if (chunk->chunkSeq < expectedSeq)
+		{
+			fprintf(stderr, "pg_hexedit error: (%u,%u) attnum %d TOAST value %u has duplicate chunk_seq %d at TOAST TID (%u,%u)\n",
+					blkno + segmentBlockDelta, offset, attnum + 1,
+					toast_pointer.va_valueid, chunk->chunkSeq,
+					chunk->blkno + toastSegmentBlockDelta, chunk->offset);
+			exitCode = 1;
+			chunk->duplicate = true;
+			*broken = true;
+		}
+		else
+		{
+			if (chunk->chunkSeq > expectedSeq)
+			{
+				fprintf(stderr, "pg_hexedit error: (%u,%u) attnum %d TOAST value %u is missing chunk_seq %d - %d\n",
+						blkno + segmentBlockDelta, offset, attnum + 1,
+						toast_pointer.va_valueid, expectedSeq,
+						chunk->chunkSeq - 1);
+				exitCode = 1;
+				*broken = true;
+			}
+			expectedSeq = chunk->chunkSeq + 1;
+			chunkBytes += chunk->dataLen;
+		}
+
+		chunk->refAttnum = attnum;
+		chunk->refBlkno = blkno + segmentBlockDelta;
+		chunk->refOffset = offset;
+		stats->toastBytes += MAXALIGN(chunk->itemLen) + sizeof(ItemIdData);
+		nchunks++;
+	}
+
+	if (nchunks == 0)
+	{
+		fprintf(stderr, "pg_hexedit error: (%u,%u) attnum %d TOAST value %u has no chunks in TOAST file \"%s\"\n",
+				blkno + segmentBlockDelta, offset, attnum + 1,
+				toast_pointer.va_valueid, toastFileName);
+		exitCode = 1;
+		*broken = true;
+	}
+	else if (chunkBytes != extsize)
+	{
+		fprintf(stderr, "pg_hexedit error: (%u,%u) attnum %d TOAST value %u chunks total %lu bytes, but external size is %u bytes\n",
+				blkno + segmentBlockDelta, offset, attnum + 1,
+				toast_pointer.va_valueid, (unsigned long) chunkBytes,
+				extsize);
+		exitCode = 1;
+		*broken = true;
+	}
+
+	if (*broken)
+		stats->nbroken++;
+
+	snprintf(description, 128, "va_valueid %u (%d chunks%s)",
+			 toast_pointer.va_valueid, nchunks,
+			 *broken ? ", broken" : "");
+
+	return description;
+}
+
+/*
+ * Print summary of -T TOAST pointer resolution to stderr
+ */
+static void
+EmitToastSummary(void)
+{
+	uint64		unrefBytes = 0;
+	int			nunref = 0;
+	int			i;
+
+	for (i = 0; i < ntoastchunks; i++)
+	{
+		if (toastChunks[i].refAttnum < 0)
+		{
+			nunref++;
+			unrefBytes += MAXALIGN(toastChunks[i].itemLen) + sizeof(ItemIdData);
+		}
+	}
+
+	fprintf(stderr, "pg_hexedit notice: TOAST file \"%s\" has %d chunks (%d chunks using %lu bytes not referenced by tagged tuples)\n",
+			toastFileName, ntoastchunks, nunref, (unsigned long) unrefBytes);
+
+	for (i = 0; i < nrelatts; i++)
+	{
+		ToastAttStats *stats = &toaststatsrel[i];
+
+		if (stats->nexternal == 0)
+			continue;
+
+		fprintf(stderr, "pg_hexedit notice: attribute \"%s\" has %lu external values (%lu broken): %lu bytes raw, %lu bytes external, %lu bytes of TOAST relation space\n",
+				attnamerel[i], (unsigned long) stats->nexternal,
+				(unsigned long) stats->nbroken,
+				(unsigned long) stats->rawBytes,
+				(unsigned long) stats->extBytes,
+				(unsigned long) stats->toastBytes);
+	}
+}
+
+/*
+ * Write a separate wxHexEditor XML document for the -T TOAST file to
+ * <toastfile>.tags.  Each chunk's chunk_data is tagged with the heap TID and
+ * attribute that references it.  Unreferenced chunks and duplicate chunks are
+ * tagged in red.
+ */
+static void
+EmitXmlToastDocument(int numOptions, char **options)
+{
+	char	   *toastTagsPath = psprintf("%s.tags", toastFileName);
+	FILE	   *savedXmlOut = xmlOut;
+	char	   *savedFileName = fileName;
+	unsigned int savedTagNumber = tagNumber;
+	unsigned int savedSegmentBlockDelta = segmentBlockDelta;
+	int			i;
+
+	xmlOut = fopen(toastTagsPath, "w");
+	if (!xmlOut)
+	{
+		fprintf(stderr, "pg_hexedit error: could not open \"%s\" for writing\n",
+				toastTagsPath);
+		exitCode = 1;
+		xmlOut = savedXmlOut;
+		pg_free(toastTagsPath);
+		return;
+	}
+
+	fileName = toastFileName;
+	tagNumber = 0;
+	segmentBlockDelta = toastSegmentBlockDelta;
+
+	/* Tags are emitted in TOAST file order, like main document's tags */
+	qsort(toastChunks, ntoastchunks, sizeof(ToastChunk),
+		  ToastChunkFileOrderCmp);
+
+	EmitXmlDocHeader(numOptions, options);
+	for (i = 0; i < ntoastchunks; i++)
+	{
+		ToastChunk *chunk = &toastChunks[i];
+		char		name[NAMEDATALEN + 64];
+		const char *color;
+
+		if (chunk->dataLen == 0)
+			continue;
+
+		if (chunk->refAttnum < 0)
+		{
+			snprintf(name, sizeof(name), "chunk_id %u chunk_seq %d - unreferenced",
+					 chunk->chunkId, chunk->chunkSeq);
+			color = COLOR_RED_LIGHT;
+		}
+		else
+		{
+			snprintf(name, sizeof(name), "chunk_id %u chunk_seq %d - %s of (%u,%u)%s",
+					 chunk->chunkId, chunk->chunkSeq,
+					 attnamerel[chunk->refAttnum], chunk->refBlkno,
+					 chunk->refOffset, chunk->duplicate ? " duplicate" : "");
+			color = chunk->duplicate ? COLOR_RED_DARK :
+				attcolorrel[chunk->refAttnum];
+		}
+
+		EmitXmlTupleTag(chunk->blkno, chunk->offset, name, color,
+						chunk->dataOff, chunk->dataOff + chunk->dataLen - 1);
+	}
+	EmitXmlFooter();
+
+	fclose(xmlOut);
+	fprintf(stderr, "pg_hexedit notice: wrote TOAST file tags to \"%s\"\n",
+			toastTagsPath);
+
+	xmlOut = savedXmlOut;
+	fileName = savedFileName;
+	tagNumber = savedTagNumber;
+	segmentBlockDelta = savedSegmentBlockDelta;
+	pg_free(toastTagsPath);
+}
+
+/*
+ * Read the page header off of block 0 to determine the block size used in this
+ * file.  Can be overridden using the -s option.  The returned value is the
+ * block size of block 0 on disk.  If a valid page size could not be read,
+ * assumes BLCKSZ.
+ */
+static unsigned int
+GetBlockSize(void)
+{
+	unsigned int pageHeaderSize = sizeof(PageHeaderData);
+	unsigned int localSize = BLCKSZ;
+	int			bytesRead = 0;
+	char		localCache[sizeof(PageHeaderData)];
+
+	/* Read the first header off of block 0 to determine the block size */
+	bytesRead = fread(&localCache, 1, pageHeaderSize, fp);
+	rewind(fp);
+
+	if (bytesRead == pageHeaderSize)
+		localSize = (unsigned int) PageGetPageSize((Page) &localCache);
+	else
+	{
+		fprintf(stderr, "pg_hexedit error: unable to read full page header from first block\n"
+				"read %u bytes\n", bytesRead);
+		exitCode = 1;
+	}
+
+	if (localSize == 0 || ((localSize - 1) & localSize) != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: invalid block size %u encountered in first block\n",
+				localSize);
+		exitCode = 1;
+		localSize = BLCKSZ;
+	}
+
+	return localSize;
+}
+
+#endif							/* PG_HEXEDIT_EXTENSION */
+
+/*
+ * Determine the LSN of page as an XLogRecPtr
+ */
+static XLogRecPtr
+GetPageLsn(Page page)
+{
+	PageHeader	pageHeader = (PageHeader) page;
+
+	return PageXLogRecPtrGet(pageHeader->pd_lsn);
+}
+
+/*
+ * Determine the contents of the special section on the block and return this
+ * enum value
+ */
+static unsigned int
 GetSpecialSectionType(Page page)
 {
-	unsigned int rc;
-	unsigned int specialOffset;
-	unsigned int specialSize;
-	unsigned int specialValue;
+	unsigned int rc;
+	unsigned int specialOffset;
+	unsigned int specialSize;
+	unsigned int specialValue;
+	PageHeader	pageHeader = (PageHeader) page;
+
+	/*
+	 * If this is not a partial header, check the validity of the  special
+	 * section offset and contents
+	 */
+	if (bytesToFormat > sizeof(PageHeaderData))
+	{
+		specialOffset = (unsigned int) pageHeader->pd_special;
+
+		/*
+		 * Check that the special offset can remain on the block or the
+		 * partial block
+		 */
+		if ((specialOffset == 0) ||
+			(specialOffset > blockSize) || (specialOffset > bytesToFormat))
+			rc = SPEC_SECT_ERROR_BOUNDARY;
+		else
+		{
+			/* we may need to examine last 2 bytes of page to identify index */
+			uint16	   *ptype = (uint16 *) (buffer + blockSize - sizeof(uint16));
+
+			specialSize = blockSize - specialOffset;
+
+			/*
+			 * Give --plugin access methods the first chance to recognize the
+			 * page, since the size-based guesses below can't tell a GIN page
+			 * from any other page with an 8 byte special area
+			 */
+			rc = GetPluginSpecialSectionType(page, specialSize);
+			if (rc != SPEC_SECT_ERROR_UNKNOWN)
+				return rc;
+
+			/*
+			 * If there is a special section, use its size to guess its
+			 * contents, checking the last 2 bytes of the page in cases that
+			 * are ambiguous.  Note we don't attempt to dereference  the
+			 * pointers without checking bytesToFormat == blockSize.
+			 */
+			if (specialSize == 0)
+				rc = SPEC_SECT_NONE;
+			else if (specialSize == MAXALIGN(sizeof(uint32)))
+			{
+				/*
+				 * If MAXALIGN is 8, this could be either a sequence or
+				 * SP-GiST or GIN.
+				 */
+				if (bytesToFormat == blockSize)
+				{
+					specialValue = *((int *) (buffer + specialOffset));
+					if (specialValue == SEQUENCE_MAGIC)
+						rc = SPEC_SECT_SEQUENCE;
+					else if (specialSize == MAXALIGN(sizeof(SpGistPageOpaqueData)) &&
+							 *ptype == SPGIST_PAGE_ID)
+						rc = SPEC_SECT_INDEX_SPGIST;
+					else if (specialSize == MAXALIGN(sizeof(BrinSpecialSpace)) &&
+							 IsBrinPage(page))
+						rc = SPEC_SECT_INDEX_BRIN;
+					else if (specialSize == MAXALIGN(sizeof(GinPageOpaqueData)))
+						rc = SPEC_SECT_INDEX_GIN;
+					else
+						rc = SPEC_SECT_ERROR_UNKNOWN;
+				}
+				else
+					rc = SPEC_SECT_ERROR_UNKNOWN;
+			}
+
+			/*
+			 * SP-GiST and GIN have same size special section, so check the
+			 * page ID bytes first
+			 */
+			else if (specialSize == MAXALIGN(sizeof(SpGistPageOpaqueData)) &&
+					 bytesToFormat == blockSize &&
+					 *ptype == SPGIST_PAGE_ID)
+				rc = SPEC_SECT_INDEX_SPGIST;
+			else if (specialSize == MAXALIGN(sizeof(BrinSpecialSpace)) &&
+					 IsBrinPage(page))
+				rc = SPEC_SECT_INDEX_BRIN;
+			else if (specialSize == MAXALIGN(sizeof(GinPageOpaqueData)))
+				rc = SPEC_SECT_INDEX_GIN;
+			else if (specialSize > 2 && bytesToFormat == blockSize)
+			{
+				/*
+				 * As of 8.3, BTree, Hash, and GIST all have the same size
+				 * special section, but the last two bytes of the section can
+				 * be checked to determine what's what.
+				 */
+				if (*ptype <= MAX_BT_CYCLE_ID &&
+					specialSize == MAXALIGN(sizeof(BTPageOpaqueData)))
+					rc = SPEC_SECT_INDEX_BTREE;
+				else if (*ptype == HASHO_PAGE_ID &&
+						 specialSize == MAXALIGN(sizeof(HashPageOpaqueData)))
+					rc = SPEC_SECT_INDEX_HASH;
+				else if (*ptype == GIST_PAGE_ID &&
+						 specialSize == MAXALIGN(sizeof(GISTPageOpaqueData)))
+					rc = SPEC_SECT_INDEX_GIST;
+				else
+					rc = SPEC_SECT_ERROR_UNKNOWN;
+			}
+			else
+				rc = SPEC_SECT_ERROR_UNKNOWN;
+		}
+	}
+	else
+		rc = SPEC_SECT_ERROR_UNKNOWN;
+
+	return rc;
+}
+
+static const char *
+GetSpecialSectionString(unsigned int type)
+{
+	switch (type)
+	{
+		case SPEC_SECT_NONE:
+			return "SPEC_SECT_NONE";
+		case SPEC_SECT_SEQUENCE:
+			return "SPEC_SECT_SEQUENCE";
+		case SPEC_SECT_INDEX_BTREE:
+			return "SPEC_SECT_INDEX_BTREE";
+		case SPEC_SECT_INDEX_HASH:
+			return "SPEC_SECT_INDEX_HASH";
+		case SPEC_SECT_INDEX_GIST:
+			return "SPEC_SECT_INDEX_GIST";
+		case SPEC_SECT_INDEX_GIN:
+			return "SPEC_SECT_INDEX_GIN";
+		case SPEC_SECT_INDEX_SPGIST:
+			return "SPEC_SECT_INDEX_SPGIST";
+		case SPEC_SECT_INDEX_BRIN:
+			return "SPEC_SECT_INDEX_BRIN";
+		case SPEC_SECT_ERROR_UNKNOWN:
+			return "SPEC_SECT_ERROR_UNKNOWN";
+		case SPEC_SECT_ERROR_BOUNDARY:
+			return "SPEC_SECT_ERROR_BOUNDARY";
+		default:
+			if (IsPluginType(type))
+				return pluginTypeNames[type - SPEC_SECT_PLUGIN];
+			return "???";
+	}
+}
+
+/*
+ * Return special section type of --plugin access method that recognizes page,
+ * or SPEC_SECT_ERROR_UNKNOWN when there is none.  Only complete pages are
+ * offered to plugins.
+ */
+static unsigned int
+GetPluginSpecialSectionType(Page page, unsigned int specialSize)
+{
+	int			i;
+
+	if (bytesToFormat != blockSize || specialSize == 0)
+		return SPEC_SECT_ERROR_UNKNOWN;
+
+	for (i = 0; i < npluginAms; i++)
+	{
+		if (pluginAms[i]->recognize(page, specialSize))
+			return SPEC_SECT_PLUGIN + i;
+	}
+
+	return SPEC_SECT_ERROR_UNKNOWN;
+}
+
+/*
+ * Does page of --plugin access method have line pointers and tuples?  Same
+ * rules as PageHasLinePointers(), which handles metapages.
+ */
+static bool
+PluginPageHasTuples(Page page, BlockNumber blkno)
+{
+	const HexeditPluginAm *am = GetPluginAm(specialType);
+
+	return am->hasTuples == NULL || am->hasTuples(page, blkno);
+}
+
+#ifndef PG_HEXEDIT_EXTENSION
+
+/*
+ * HexeditPluginHost emitTag callback.  Metapage fields get the same "name"
+ * form as EmitXmlPageMeta() gives core access methods.
+ */
+static void
+PluginEmitTag(BlockNumber blkno, bool metapage, const char *name,
+			  const char *color, uint32 relfileOff, uint32 relfileOffEnd)
+{
+	EmitXmlTag(metapage ? InvalidBlockNumber : blkno, UINT_MAX, name, color,
+			   relfileOff, relfileOffEnd);
+}
+
+/*
+ * HexeditPluginHost reportError callback
+ */
+static void
+PluginReportError(const char *fmt,...)
+{
+	va_list		args;
+
+	fprintf(stderr, "pg_hexedit error: ");
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+	exitCode = 1;
+}
+
+/*
+ * Load --plugin shared library, and register the access methods that it
+ * decodes.  Returns false after reporting why when plugin can't be used.
+ */
+static bool
+LoadPlugin(const char *path)
+{
+	static const HexeditPluginHost pluginHost = {
+		HEXEDIT_PLUGIN_API_VERSION,
+		PluginEmitTag,
+		EmitXmlTupleTag,
+		PluginReportError
+	};
+	void	   *handle;
+	HexeditPluginInit init;
+	const HexeditPluginAm *ams;
+	int			nams = 0;
+	int			i;
+
+	handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (handle == NULL)
+	{
+		fprintf(stderr, "pg_hexedit error: could not load plugin \"%s\": %s\n",
+				path, dlerror());
+		return false;
+	}
+
+	init = (HexeditPluginInit) dlsym(handle, HEXEDIT_PLUGIN_INIT_FUNCTION);
+	if (init == NULL)
+	{
+		fprintf(stderr, "pg_hexedit error: plugin \"%s\" does not export %s()\n",
+				path, HEXEDIT_PLUGIN_INIT_FUNCTION);
+		dlclose(handle);
+		return false;
+	}
+
+	ams = init(&pluginHost, &nams);
+	if (ams == NULL || nams <= 0)
+	{
+		fprintf(stderr, "pg_hexedit error: plugin \"%s\" could not be initialized (pg_hexedit plugin API version is %d)\n",
+				path, HEXEDIT_PLUGIN_API_VERSION);
+		dlclose(handle);
+		return false;
+	}
+
+	if (npluginAms + nams > MAX_PLUGIN_AMS)
+	{
+		fprintf(stderr, "pg_hexedit error: plugins may decode no more than %d access methods\n",
+				MAX_PLUGIN_AMS);
+		dlclose(handle);
+		return false;
+	}
+
+	for (i = 0; i < nams; i++)
+	{
+		if (ams[i].name == NULL || ams[i].recognize == NULL)
+		{
+			fprintf(stderr, "pg_hexedit error: plugin \"%s\" access method %d lacks a name or recognize callback\n",
+					path, i + 1);
+			dlclose(handle);
+			return false;
+		}
+	}
+
+	/* Plugin stays loaded until exit */
+	for (i = 0; i < nams; i++)
+	{
+		pluginAms[npluginAms] = &ams[i];
+		pluginTypeNames[npluginAms] = psprintf("SPEC_SECT_PLUGIN (%s)",
+											   ams[i].name);
+		npluginAms++;
+	}
+
+	return true;
+}
+
+#endif							/* PG_HEXEDIT_EXTENSION */
+
+/*
+ * Given Heap tuple header, return string buffer with t_infomask or t_infomask2
+ * flags.
+ *
+ * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ */
+static char *
+GetHeapTupleHeaderFlags(HeapTupleHeader htup, bool isInfomask2)
+{
+	unsigned int bitmapLength = 0;
+	unsigned int oidLength = 0;
+	unsigned int computedLength;
+	unsigned int localHoff;
+	unsigned int localBitOffset;
+	char	   *flagString = NULL;
+
+	flagString = pg_malloc(512);
+	localHoff = htup->t_hoff;
+	localBitOffset = offsetof(HeapTupleHeaderData, t_bits);
+
+	/*
+	 * Place readable versions of the tuple info mask into a buffer. Assume
+	 * that the string can not expand beyond 512 bytes.
+	 */
+	flagString[0] = '\0';
+	if (!isInfomask2)
+	{
+		strcat(flagString, "t_infomask (");
+
+		if (htup->t_infomask & HEAP_HASNULL)
+			strcat(flagString, "HEAP_HASNULL|");
+		if (htup->t_infomask & HEAP_HASVARWIDTH)
+			strcat(flagString, "HEAP_HASVARWIDTH|");
+		if (htup->t_infomask & HEAP_HASEXTERNAL)
+			strcat(flagString, "HEAP_HASEXTERNAL|");
+		if (htup->t_infomask & HEAP_HASOID)
+			strcat(flagString, "HEAP_HASOID|");
+		if (htup->t_infomask & HEAP_XMAX_KEYSHR_LOCK)
+			strcat(flagString, "HEAP_XMAX_KEYSHR_LOCK|");
+		if (htup->t_infomask & HEAP_COMBOCID)
+			strcat(flagString, "HEAP_COMBOCID|");
+		if (htup->t_infomask & HEAP_XMAX_EXCL_LOCK)
+			strcat(flagString, "HEAP_XMAX_EXCL_LOCK|");
+		if (htup->t_infomask & HEAP_XMAX_LOCK_ONLY)
+			strcat(flagString, "HEAP_XMAX_LOCK_ONLY|");
+		if (htup->t_infomask & HEAP_XMIN_COMMITTED)
+			strcat(flagString, "HEAP_XMIN_COMMITTED|");
+		if (htup->t_infomask & HEAP_XMIN_INVALID)
+			strcat(flagString, "HEAP_XMIN_INVALID|");
+		if (htup->t_infomask & HEAP_XMAX_COMMITTED)
+			strcat(flagString, "HEAP_XMAX_COMMITTED|");
+		if (htup->t_infomask & HEAP_XMAX_INVALID)
+			strcat(flagString, "HEAP_XMAX_INVALID|");
+		if (htup->t_infomask & HEAP_XMAX_IS_MULTI)
+			strcat(flagString, "HEAP_XMAX_IS_MULTI|");
+		if (htup->t_infomask & HEAP_UPDATED)
+			strcat(flagString, "HEAP_UPDATED|");
+		if (htup->t_infomask & HEAP_MOVED_OFF)
+			strcat(flagString, "HEAP_MOVED_OFF|");
+		if (htup->t_infomask & HEAP_MOVED_IN)
+			strcat(flagString, "HEAP_MOVED_IN|");
+
+		if (strlen(flagString))
+			flagString[strlen(flagString) - 1] = '\0';
+		strcat(flagString, ")");
+	}
+	else
+	{
+		sprintf(flagString, "t_infomask2 HeapTupleHeaderGetNatts(): %d ",
+				HeapTupleHeaderGetNatts(htup));
+
+		if (htup->t_infomask2 & ~HEAP_NATTS_MASK)
+			strcat(flagString, "(");
+
+
+		if (htup->t_infomask2 & HEAP_KEYS_UPDATED)
+			strcat(flagString, "HEAP_KEYS_UPDATED|");
+		if (htup->t_infomask2 & HEAP_HOT_UPDATED)
+			strcat(flagString, "HEAP_HOT_UPDATED|");
+		if (htup->t_infomask2 & HEAP_ONLY_TUPLE)
+			strcat(flagString, "HEAP_ONLY_TUPLE|");
+
+		if (strlen(flagString))
+			flagString[strlen(flagString) - 1] = '\0';
+		if (htup->t_infomask2 & ~HEAP_NATTS_MASK)
+			strcat(flagString, ")");
+	}
+
+	/*
+	 * As t_bits is a variable length array, and may contain an Oid field,
+	 * determine the length of the header proper as a sanity check.
+	 */
+	if (htup->t_infomask & HEAP_HASNULL)
+		bitmapLength = BITMAPLEN(HeapTupleHeaderGetNatts(htup));
+	else
+		bitmapLength = 0;
+
+	if (htup->t_infomask & HEAP_HASOID)
+		oidLength += sizeof(Oid);
+
+	computedLength =
+		MAXALIGN(localBitOffset + bitmapLength + oidLength);
+
+	/*
+	 * Inform the user of a header size mismatch or dump the t_bits array
+	 */
+	if (computedLength != localHoff)
+	{
+		fprintf
+			(stderr,
+			 "pg_hexedit error: computed header length not equal to header size.\n"
+			 "computed: %u header: %d\n", computedLength, localHoff);
+
+		exitCode = 1;
+	}
+
+	return flagString;
+}
+
+/*
+ * Given IndexTuple, return string buffer with t_info reported tuple length,
+ * and flags.
+ *
+ * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ */
+static char *
+GetIndexTupleFlags(IndexTuple itup)
+{
+	char	   *flagString = NULL;
+
+	flagString = pg_malloc(512);
+
+	/*
+	 * Place readable versions of the tuple info mask into a buffer.  Assume
+	 * that the string can not expand beyond 128 bytes.
+	 */
+	flagString[0] = '\0';
+	sprintf(flagString, "t_info IndexTupleSize(): %zu",
+			IndexTupleSize(itup));
+
+	if (itup->t_info & ~INDEX_SIZE_MASK)
+		strcat(flagString, ", (");
+
+	/*
+	 * Use specific index AM local name for generic reserved
+	 * INDEX_AM_RESERVED_BIT IndexTuple status bit
+	 */
+	if (itup->t_info & INDEX_AM_RESERVED_BIT)
+	{
+		if (specialType == SPEC_SECT_INDEX_HASH)
+			strcat(flagString, "INDEX_MOVED_BY_SPLIT_MASK|");
+		else if (specialType == SPEC_SECT_INDEX_BTREE)
+			strcat(flagString, "INDEX_ALT_TID_MASK|");
+		else
+			strcat(flagString, "INDEX_AM_RESERVED_BIT|");
+	}
+	if (itup->t_info & INDEX_VAR_MASK)
+		strcat(flagString, "INDEX_VAR_MASK|");
+	if (itup->t_info & INDEX_NULL_MASK)
+		strcat(flagString, "INDEX_NULL_MASK|");
+
+	if (itup->t_info & ~INDEX_SIZE_MASK)
+	{
+		flagString[strlen(flagString) - 1] = '\0';
+		strcat(flagString, ")");
+	}
+
+	return flagString;
+}
+
+static const char *
+GetSpGistStateString(unsigned int code)
+{
+	switch (code)
+	{
+		case SPGIST_LIVE:
+			return "SPGIST_LIVE";
+		case SPGIST_REDIRECT:
+			return "SPGIST_REDIRECT";
+		case SPGIST_DEAD:
+			return "SPGIST_DEAD";
+		case SPGIST_PLACEHOLDER:
+			return "SPGIST_PLACEHOLDER";
+		default:
+			return "???";
+	}
+}
+
+/*
+ * Given SpGistInnerTuple, return string buffer with tuple-reported state from
+ * bitfields.
+ *
+ * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ */
+static char *
+GetSpGistInnerTupleState(SpGistInnerTuple itup)
+{
+	char	   *flagString = NULL;
+
+	flagString = pg_malloc(128);
+
+	sprintf(flagString, "tupstate: %s, allTheSame: %u, nNodes: %u, prefixSize: %u",
+			GetSpGistStateString(itup->tupstate), itup->allTheSame, itup->nNodes, itup->prefixSize);
+
+	return flagString;
+}
+
+/*
+ * Given SpGistLeafTuple, return string buffer with tuple-reported state from
+ * bitfields.
+ *
+ * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ */
+static char *
+GetSpGistLeafTupleState(SpGistLeafTuple itup)
+{
+	char	   *flagString = NULL;
+
+	flagString = pg_malloc(128);
+
+	sprintf(flagString, "tupstate: %s, size: %u",
+			GetSpGistStateString(itup->tupstate), itup->size);
+
+	return flagString;
+}
+
+/*
+ * Given BrinTuple, return string buffer with bt_info reported data offset, and
+ * tuple flags.
+ *
+ * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ */
+static char *
+GetBrinTupleFlags(BrinTuple *itup)
+{
+	char	   *flagString = NULL;
+
+	flagString = pg_malloc(128);
+
+	/*
+	 * Place readable versions of the tuple info mask into a buffer.  Assume
+	 * that the string can not expand beyond 128 bytes.
+	 */
+	flagString[0] = '\0';
+	sprintf(flagString, "bt_info BrinTupleDataOffset(): %zu",
+			BrinTupleDataOffset(itup));
+
+	if (itup->bt_info & (BRIN_PLACEHOLDER_MASK | BRIN_NULLS_MASK))
+		strcat(flagString, ", (");
+
+	if (itup->bt_info & BRIN_PLACEHOLDER_MASK)
+		strcat(flagString, "BRIN_PLACEHOLDER_MASK|");
+	if (itup->bt_info & BRIN_NULLS_MASK)
+		strcat(flagString, "BRIN_NULLS_MASK|");
+
+	if (itup->bt_info & (BRIN_PLACEHOLDER_MASK | BRIN_NULLS_MASK))
+	{
+		flagString[strlen(flagString) - 1] = '\0';
+		strcat(flagString, ")");
+	}
+
+	return flagString;
+}
+
+/*	Check whether page is a BRIN meta page */
+static bool
+IsBrinPage(Page page)
+{
+	if (bytesToFormat != blockSize)
+		return false;
+
+	if (BRIN_IS_META_PAGE(page) || BRIN_IS_REVMAP_PAGE(page) ||
+		BRIN_IS_REGULAR_PAGE(page))
+		return true;
+	return false;
+}
+
+/*	Check whether page is a hash bitmap page */
+static bool
+IsHashBitmapPage(Page page)
+{
+	HashPageOpaque opaque;
+
+	/* Defensive */
+	if (bytesToFormat != blockSize)
+		return false;
+	if (specialType != SPEC_SECT_INDEX_HASH)
+		return false;
+
+	opaque = (HashPageOpaque) PageGetSpecialPointer(page);
+	if (opaque->hasho_flag & LH_BITMAP_PAGE)
+		return true;
+
+	return false;
+}
+
+/* Check whether page is a leaf page */
+static bool
+IsLeafPage(Page page)
+{
+	if (specialType == SPEC_SECT_INDEX_BTREE)
+	{
+		BTPageOpaque btreeSection = (BTPageOpaque) PageGetSpecialPointer(page);
+
+		/*
+		 * Don't count a root page as a leaf (i.e.  the root before the first
+		 * root page split).
+		 */
+		if ((btreeSection->btpo_flags & BTP_LEAF) &&
+			!(btreeSection->btpo_flags & BTP_ROOT))
+			return true;
+	}
+	else if (specialType == SPEC_SECT_INDEX_GIST)
+	{
+		if (GistPageIsLeaf(page))
+			return true;
+	}
+	else if (specialType == SPEC_SECT_INDEX_GIN)
+	{
+		/* This works for both posting trees, and the main entry tree */
+		if (GinPageIsLeaf(page))
+			return true;
+	}
+	else if (specialType == SPEC_SECT_INDEX_SPGIST)
+	{
+		if (SpGistPageIsLeaf(page))
+			return true;
+	}
+	else if (IsPluginType(specialType))
+	{
+		const HexeditPluginAm *am = GetPluginAm(specialType);
+
+		if (am->isLeaf && am->isLeaf(page))
+			return true;
+	}
+
+	return false;
+}
+
+#ifndef PG_HEXEDIT_EXTENSION
+
+/*
+ * Get kind of page for --session.  Page's special section type must already
+ * be in specialType.
+ */
+static sessionPageKinds
+GetSessionPageKind(Page page, BlockNumber blkno)
+{
+	BlockNumber relblkno = blkno + segmentBlockDelta;
+
+	/* Same test for a metapage as EmitXmlPage() */
+	if (blkno == 0 && segmentNumber == 0 &&
+		specialType != SPEC_SECT_NONE &&
+		specialType != SPEC_SECT_INDEX_GIST &&
+		specialType != SPEC_SECT_SEQUENCE &&
+		!PluginLacksMetapage(specialType))
+		return SESSION_PAGE_META;
+
+	switch (specialType)
+	{
+		case SPEC_SECT_INDEX_BTREE:
+			{
+				BTPageOpaque btreeSection = (BTPageOpaque) PageGetSpecialPointer(page);
+
+				if (P_ISDELETED(btreeSection))
+					return SESSION_PAGE_DELETED;
+				if (P_ISROOT(btreeSection))
+					return SESSION_PAGE_ROOT;
+				break;
+			}
+		case SPEC_SECT_INDEX_HASH:
+			{
+				HashPageOpaque hashSection = (HashPageOpaque) PageGetSpecialPointer(page);
+
+				if (IsHashBitmapPage(page))
+					return SESSION_PAGE_BITMAP;
+				if (hashSection->hasho_flag & LH_OVERFLOW_PAGE)
+					return SESSION_PAGE_OVERFLOW;
+				return SESSION_PAGE_DATA;
+			}
+		case SPEC_SECT_INDEX_GIST:
+			if (GistPageIsDeleted(page))
+				return SESSION_PAGE_DELETED;
+			/* GiST root is always block 0 (GIST_ROOT_BLKNO) */
+			if (relblkno == 0)
+				return SESSION_PAGE_ROOT;
+			break;
+		case SPEC_SECT_INDEX_GIN:
+			if (GinPageIsDeleted(page))
+				return SESSION_PAGE_DELETED;
+			if (relblkno == GIN_ROOT_BLKNO)
+				return SESSION_PAGE_ROOT;
+			if (GinPageIsData(page))
+				return SESSION_PAGE_POSTING;
+			break;
+		case SPEC_SECT_INDEX_SPGIST:
+			if (SpGistPageIsDeleted(page))
+				return SESSION_PAGE_DELETED;
+			if (relblkno == SPGIST_ROOT_BLKNO)
+				return SESSION_PAGE_ROOT;
+			break;
+		case SPEC_SECT_INDEX_BRIN:
+			if (BRIN_IS_REVMAP_PAGE(page))
+				return SESSION_PAGE_REVMAP;
+			return SESSION_PAGE_DATA;
+		default:
+			return SESSION_PAGE_DATA;
+	}
+
+	return IsLeafPage(page) ? SESSION_PAGE_LEAF : SESSION_PAGE_INTERNAL;
+}
+
+/*
+ * Remember page for --session if it's the first of its kind, or if it's among
+ * the pages with the newest LSNs seen so far
+ */
+static void
+RecordSessionPage(Page page, BlockNumber blkno)
+{
+	sessionPageKinds kind = GetSessionPageKind(page, blkno);
+	XLogRecPtr	pageLSN = GetPageLsn(page);
+	int			i;
+
+	if (sessionFirstOfKind[kind] == InvalidBlockNumber)
+		sessionFirstOfKind[kind] = blkno;
+
+	if (pageLSN == InvalidXLogRecPtr)
+		return;
+
+	/* Insertion sort into newest LSNs, newest first */
+	if (nsessionNewestBlocks < MAX_SESSION_NEWEST_PAGES)
+		nsessionNewestBlocks++;
+	else if (pageLSN <= sessionNewestLsns[nsessionNewestBlocks - 1])
+		return;
+
+	for (i = nsessionNewestBlocks - 1;
+		 i > 0 && sessionNewestLsns[i - 1] < pageLSN; i--)
+	{
+		sessionNewestLsns[i] = sessionNewestLsns[i - 1];
+		sessionNewestBlocks[i] = sessionNewestBlocks[i - 1];
+	}
+	sessionNewestLsns[i] = pageLSN;
+	sessionNewestBlocks[i] = blkno;
+}
+
+/*
+ * Append blkno to bookmarks unless it's already there.  Returns new number of
+ * bookmarks.
+ */
+static int
+AddSessionBookmark(BlockNumber *bookmarks, int nbookmarks, BlockNumber blkno)
+{
+	int			i;
+
+	if (blkno == InvalidBlockNumber)
+		return nbookmarks;
+
+	for (i = 0; i < nbookmarks; i++)
+	{
+		if (bookmarks[i] == blkno)
+			return nbookmarks;
+	}
+
+	bookmarks[nbookmarks] = blkno;
+
+	return nbookmarks + 1;
+}
+
+/*
+ * Write wxHexEditor session config file for --session.  This has the same
+ * settings that the convenience scripts used to write themselves, plus
+ * "Go to Offset" dialog cache entries for the root, the metapage, the first
+ * page of each other kind, pages that raised errors, pages with the newest
+ * LSNs, and the start of each decile of the file.  Bookmarks are byte offsets
+ * into the file, in that order.
+ *
+ * BYTES_PER_LINE_LIMIT and FONTSIZE environment variables (see hexedit.cfg)
+ * are used for the corresponding settings when they are set.
+ */
+static void
+WriteSessionFile(void)
+{
+	BlockNumber bookmarks[MAX_SESSION_BOOKMARKS];
+	int			nbookmarks = 0;
+	FILE	   *sessionFp;
+	struct stat st;
+	const char *bytesPerLineLimit = getenv("BYTES_PER_LINE_LIMIT");
+	const char *fontSize = getenv("FONTSIZE");
+	int			i;
+
+	for (i = 0; i < SESSION_PAGE_NKINDS; i++)
+		nbookmarks = AddSessionBookmark(bookmarks, nbookmarks,
+										sessionFirstOfKind[i]);
+	for (i = 0; i < nsessionErrorBlocks; i++)
+		nbookmarks = AddSessionBookmark(bookmarks, nbookmarks,
+										sessionErrorBlocks[i]);
+	for (i = 0; i < nsessionNewestBlocks; i++)
+		nbookmarks = AddSessionBookmark(bookmarks, nbookmarks,
+										sessionNewestBlocks[i]);
+
+	/* Deciles are of the whole file, not just blocks that were tagged */
+	if (fstat(fileno(fp), &st) == 0 && st.st_size / blockSize >= SESSION_DECILES)
+	{
+		for (i = 1; i < SESSION_DECILES; i++)
+			nbookmarks = AddSessionBookmark(bookmarks, nbookmarks,
+											(st.st_size / blockSize) * i /
+											SESSION_DECILES);
+	}
+
+	sessionFp = fopen(sessionFileName, "w");
+	if (!sessionFp)
+	{
+		fprintf(stderr, "pg_hexedit error: could not open session file \"%s\" for writing\n",
+				sessionFileName);
+		exitCode = 1;
+		return;
+	}
+
+	fprintf(sessionFp, "UpdateCheck=0\n");
+	fprintf(sessionFp, "FakeBlockLines=1\n");
+	fprintf(sessionFp, "FakeBlockSize=%uk\n", blockSize / 1024);
+	fprintf(sessionFp, "ColourHexBackground=#FFFFFF\n");
+	fprintf(sessionFp, "ColourHexBackgroundZebra=#FFFFFF\n");
+	fprintf(sessionFp, "UseBytesPerLineLimit=1\n");
+	fprintf(sessionFp, "BytesPerLineLimit=%s\n",
+			bytesPerLineLimit ? bytesPerLineLimit : "32");
+	fprintf(sessionFp, "FontSize=%s\n", fontSize ? fontSize : "10");
+	fprintf(sessionFp, "CharacterEncodingFamily=Code for Information Interchange\n");
+	fprintf(sessionFp, "CharacterEncoding=ASCII - American Standard Code for Information Interchange\n");
+	fprintf(sessionFp, "ScreenFullScreen=1\n");
+	fprintf(sessionFp, "AutoShowTagPanel=0\n");
+	fprintf(sessionFp, "GoToOptions=7\n");
+	for (i = 0; i < nbookmarks; i++)
+		fprintf(sessionFp, "GoToOffset%d=%lu\n", i,
+				(unsigned long) bookmarks[i] * blockSize);
+
+	fclose(sessionFp);
+
+	fprintf(stderr, "pg_hexedit notice: wrote %d bookmarks to session file \"%s\"\n",
+			nbookmarks, sessionFileName);
+}
+
+#endif							/* PG_HEXEDIT_EXTENSION */
+
+/*
+ * For each block, dump out formatted header and content information
+ */
+static void
+EmitXmlPage(BlockNumber blkno)
+{
+	Page		page = (Page) buffer;
+	XLogRecPtr	pageLSN;
+	uint32		level = UINT_MAX;
+	int			rc;
+
+	/*
+	 * Maintain max block number for blocks that have some kind of content
+	 * (could just be zero block, could be block that we'd skip due to current
+	 * -x option)
+	 */
+	maxBlockNumber = Max(maxBlockNumber, blkno);
+
+	if (PageIsNew(page))
+	{
+		/*
+		 * Assume new/zeroed block has LSN 0 for -x option (but don't update
+		 * minPageLSN because it's not useful to consider that 0)
+		 */
+		if ((blockOptions & BLOCK_SKIP_LSN))
+		{
+			nblocksskipped++;
+		}
+
+		return;
+	}
+
+	/* Get details of page first */
+	pageOffset = blockSize * currentBlock;
+	specialType = GetSpecialSectionType(page);
+
+	/*
+	 * A Postgres segment file should consists of blocks that are all of the
+	 * same special section reported type (excluding those blocks that have
+	 * yet to be initialized by PageInit()).  Raise error when this
+	 * expectation is not met.
+	 */
+	if (firstType == SPEC_SECT_ERROR_UNKNOWN)
+		firstType = specialType;
+
+	if (firstType != specialType)
+	{
+		fprintf(stderr, "pg_hexedit error: special section indicated type unexpectedly changed from \"%s\" to \"%s\" at file block %u\n",
+				GetSpecialSectionString(firstType),
+				GetSpecialSectionString(specialType), blkno);
+		exitCode = 1;
+	}
+
+#ifndef PG_HEXEDIT_EXTENSION
+	if (sessionFileName)
+		RecordSessionPage(page, blkno);
+#endif
+
+	/*
+	 * Check to see if we must skip this block due to it falling behind LSN
+	 * threshold
+	 */
+	pageLSN = GetPageLsn(page);
+	if ((blockOptions & BLOCK_SKIP_LSN) && pageLSN < afterThreshold)
+	{
+		rc = 0;
+		nblocksskipped++;
+		return;
+	}
+
+	/*
+	 * Maintain Min and Max LSNs for annotated pages (reported for -x, and in
+	 * --shard-blocks manifest)
+	 */
+	nblockstagged++;
+	if (pageLSN < minPageLSN)
+	{
+		minPageLSN = pageLSN;
+		minPageLSNBlock = blkno;
+	}
+	if (pageLSN > maxPageLSN)
+	{
+		maxPageLSN = pageLSN;
+		maxPageLSNBlock = blkno;
+	}
+
+	/* Get "level" for page.  Only B-Tree tags get a "level" */
+	if (specialType == SPEC_SECT_INDEX_BTREE)
+	{
+		BTPageOpaque btreeSection = (BTPageOpaque) PageGetSpecialPointer(page);
+
+#if PG_VERSION_NUM < 140000
+		level = btreeSection->btpo.level;
+#else
+		level = btreeSection->btpo_level;
+#endif
+	}
+
+	/*
+	 * We optionally itemize leaf blocks as whole tags, in order to limit the
+	 * size of tag files sharply.  Internal pages can be more interesting when
+	 * debugging certain types of problems, such as problems with the balance
+	 * of some tree structure.
+	 */
+	if ((blockOptions & BLOCK_SKIP_LEAF) && IsLeafPage(page))
+	{
+		EmitXmlTag(blkno, level, "leaf page", COLOR_GREEN_DARK,
+				   pageOffset,
+				   (pageOffset + BLCKSZ) - 1);
+		rc = 0;
+		return;
+	}
+
+	/*
+	 * Every block that we aren't skipping will have header, items and
+	 * possibly special section tags created.  Beware of partial block reads,
+	 * though.
+	 */
+	rc = EmitXmlPageHeader(page, blkno, level);
+
+	/* If we didn't encounter a partial read in header, carry on...  */
+	if (rc != EOF_ENCOUNTERED)
+	{
+		/*
+		 * All AMs have a single metapage at block zero of the first segment,
+		 * with the exception of heapam and GiST. (Sequences more or less
+		 * reuse the heap format, and so don't have a metapage.)
+		 */
+		if (blkno == 0 && segmentNumber == 0 &&
+			specialType != SPEC_SECT_NONE &&
+			specialType != SPEC_SECT_INDEX_GIST &&
+			specialType != SPEC_SECT_SEQUENCE &&
+			!PluginLacksMetapage(specialType))
+		{
+			/* If it's a meta page, the meta block will have no tuples */
+			EmitXmlPageMeta(blkno, level);
+		}
+		else if (specialType == SPEC_SECT_INDEX_BTREE &&
+				 P_ISDELETED((BTPageOpaque) PageGetSpecialPointer(page)))
+		{
+			/*
+			 * Deleted nbtree pages only contain BTDeletedPageData on Postgres
+			 * 14+ -- don't bother distinguishing deleted pages.  Cannot trust
+			 * maxoff from page.
+			 */
+		}
+		else if (specialType == SPEC_SECT_INDEX_HASH && IsHashBitmapPage(page))
+		{
+			/* Hash bitmap pages don't use IndexTuple or ItemId */
+			EmitXmlHashBitmap(page, blkno);
+		}
+		else if (specialType == SPEC_SECT_INDEX_GIST && GistPageIsDeleted(page))
+		{
+			/*
+			 * Deleted GiST pages only contain GISTDeletedPageContents on
+			 * Postgres 12+ -- don't bother distinguishing deleted pages.
+			 * Cannot trust maxoff from page.
+			 */
+		}
+		else if (specialType == SPEC_SECT_INDEX_GIN && GinPageIsDeleted(page))
+		{
+			/*
+			 * Unfortunately, GIN_DELETED pages don't have page state needed
+			 * by GinPageIsData().  Don't attempt to emit tags for tuples on
+			 * deleted GIN pages.
+			 */
+		}
+		else if (specialType == SPEC_SECT_INDEX_GIN && GinPageIsData(page))
+		{
+			/* GIN data/posting tree pages don't use IndexTuple or ItemId */
+			EmitXmlPostingTreeTids(page, blkno);
+		}
+		else if (specialType == SPEC_SECT_INDEX_BRIN && BRIN_IS_REVMAP_PAGE(page))
+		{
+			/* BRIN revmap pages don't use IndexTuple/BrinTuple or ItemId */
+			EmitXmlRevmap(page, blkno);
+		}
+		else if (IsPluginType(specialType) && !PluginPageHasTuples(page, blkno))
+		{
+			/* Plugin tags everything on page from its emitPage callback */
+		}
+		else
+		{
+			/* Conventional heap/index page format */
+			EmitXmlPageItemIdArray(page, blkno);
+			EmitXmlTuples(page, blkno);
+		}
+
+		/* Only heapam doesn't have a special area (even sequences have one) */
+		if (specialType != SPEC_SECT_NONE)
+			EmitXmlSpecial(blkno, level);
+	}
+}
+
+#ifndef PG_HEXEDIT_EXTENSION
+
+/*
+ * Display a header for the dump so we know the file name, the options and the
+ * time the dump was taken
+ */
+static void
+EmitXmlDocHeader(int numOptions, char **options)
+{
+	unsigned int x;
+	char		optionBuffer[52] = "\0";
+	char		timeStr[1000];
+
+	/* Format time without newline */
+	time_t		rightNow = time(NULL);
+	struct tm	localNow;
+
+	localtime_r(&rightNow, &localNow);
+	strftime(timeStr, sizeof(timeStr), "%H:%M:%S %A, %B %d %Y", &localNow);
+
+	/*
+	 * Iterate through the options and cache them. The maximum we can display
+	 * is 50 option characters + spaces.
+	 */
+	for (x = 1; x < (numOptions - 1); x++)
+	{
+		if ((strlen(optionBuffer) + strlen(options[x])) > 50)
+			break;
+		strcat(optionBuffer, options[x]);
+		strcat(optionBuffer, " ");
+	}
+
+	fprintf(xmlOut, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	fprintf(xmlOut, "<!-- Dump created on: %s -->\n", timeStr);
+	fprintf(xmlOut, "<!-- Options used: %s -->\n", (strlen(optionBuffer)) ? optionBuffer : "None");
+	fprintf(xmlOut, "<!-- Block size: %u -->\n", blockSize);
+	fprintf(xmlOut, "<!-- pg_hexedit version: %s -->\n", HEXEDIT_VERSION);
+	fprintf(xmlOut, "<!-- pg_hexedit build PostgreSQL version: %s -->\n", PG_VERSION);
+	fprintf(xmlOut, "<wxHexEditor_XML_TAG>\n");
+	fprintf(xmlOut, "  <filename path=\"%s\">\n", fileName);
+}
+
+static void
+EmitXmlFooter(void)
+{
+	fprintf(xmlOut, "  </filename>\n");
+	fprintf(xmlOut, "</wxHexEditor_XML_TAG>\n");
+}
+
+#endif							/* PG_HEXEDIT_EXTENSION */
+
+/*
+ * Write tag as wxHexEditor XML.  This is the default tag visitor.
+ */
+static void
+XmlVisitTag(uint32 start, uint32 end, const char *text,
+			const char *fontColor, const char *noteColor)
+{
+	int			nbytes;
+
+	nbytes = fprintf(xmlOut,
+					 "    <TAG id=\"%u\">\n"
+					 "      <start_offset>%u</start_offset>\n"
+					 "      <end_offset>%u</end_offset>\n"
+					 "      <tag_text>%s</tag_text>\n"
+					 "      <font_colour>%s</font_colour>\n"
+					 "      <note_colour>%s</note_colour>\n"
+					 "    </TAG>\n",
+					 tagNumber++, start, end, text, fontColor, noteColor);
+	if (nbytes > 0)
+		xmlTagBytes += nbytes;
+}
+
+/*
+ * Reset and return the current thread's tag text buffer, for caller to build
+ * a tag's text in before calling EmitTag()
+ */
+static StringInfo
+StartTagText(void)
+{
+	if (!tagText.data)
+		initStringInfo(&tagText);
+	else
+		resetStringInfo(&tagText);
+
+	return &tagText;
+}
+
+/*
+ * Pass tag whose text was built by StartTagText() caller to the current
+ * thread's tag visitor
+ */
+static inline void
+EmitTag(uint32 start, uint32 end, const char *fontColor,
+		const char *noteColor)
+{
+	tagVisitor->onTag(start, end, tagText.data, fontColor, noteColor);
+}
+
+/*
+ * Emit a generic wxHexEditor tag for tuple data.
+ *
+ * Note: endOffset is an offset to the last byte whose range the tag covers, so
+ * callers generally pass (relfileOff + length) - 1.  This is slightly less
+ * verbose than getting callers to pass length.
+ *
+ * B-Tree index callers may optionally pass a "level".  Passing
+ * InvalidBlockNumber avoids emitting any block number.
+ */
+static void
+EmitXmlTag(BlockNumber blkno, uint32 level, const char *name, const char *color,
+		   uint32 relfileOff, uint32 relfileOffEnd)
+{
+	StringInfo	text = StartTagText();
+
+	Assert(relfileOff <= relfileOffEnd);
+
+	if (blkno == InvalidBlockNumber)
+		appendStringInfoString(text, name);
+	else if (level != UINT_MAX)
+		appendStringInfo(text, "block %u (level %u) %s",
+						 blkno + segmentBlockDelta, level, name);
+	else
+		appendStringInfo(text, "block %u %s", blkno + segmentBlockDelta, name);
+	EmitTag(relfileOff, relfileOffEnd, COLOR_FONT_STANDARD, color);
+}
+
+/*
+ * Emit a wxHexEditor tag for a line pointer (ItemId).
+ */
+static void
+EmitXmlItemId(BlockNumber blkno, OffsetNumber offset, ItemId itemId,
+			  uint32 relfileOff, const char *textFlags)
+{
+	char	   *fontColor;
+	char	   *itemIdColor;
+
+	fontColor = COLOR_FONT_STANDARD;
+	itemIdColor = COLOR_BLUE_LIGHT;
+
+	/*
+	 * The color of the tag and tag font is chosen to give a cue about line
+	 * pointer details.  Unused line pointers (which are reusable) have a
+	 * non-contrasting font color to deemphasize their importance.  LP_DEAD
+	 * line pointers (which are dead but not necessarily reusable yet) don't
+	 * stay around for long in most real world workloads, and so it seems
+	 * useful to make them stick out.
+	 */
+	if (ItemIdIsRedirected(itemId))
+		itemIdColor = COLOR_BLUE_DARK;
+	else if (ItemIdIsDead(itemId))
+		itemIdColor = COLOR_BROWN;
+	else if (!ItemIdIsUsed(itemId))
+		fontColor = COLOR_BLUE_DARK;
+
+	/* Interpret the content of each ItemId separately */
+	appendStringInfo(StartTagText(),
+					 "(%u,%d) lp_len: %u, lp_off: %u, lp_flags: %s",
+					 blkno + segmentBlockDelta, offset, ItemIdGetLength(itemId),
+					 ItemIdGetOffset(itemId), textFlags);
+	EmitTag(relfileOff, (relfileOff + sizeof(ItemIdData)) - 1, fontColor,
+			itemIdColor);
+}
+
+/*
+ * Emit a wxHexEditor tag for individual tuple, whose TID is to be represented
+ * in the tag annotation.  Could be an IndexTuple, heap tuple, or special
+ * tuple-like structure (e.g., GIN data/posting tree page item).
+ *
+ * Note: relfileOffEnd is an offset to the last byte whose range the tag
+ * covers, so callers generally pass (relfileOff + length) - 1.  This is
+ * slightly less verbose than getting callers to pass length.
+ */
+static inline void
+EmitXmlTupleTag(BlockNumber blkno, OffsetNumber offset, const char *name,
+				const char *color, uint32 relfileOff, uint32 relfileOffEnd)
+{
+	EmitXmlTupleTagFont(blkno, offset, name, color, COLOR_FONT_STANDARD,
+						relfileOff, relfileOffEnd);
+}
+
+/*
+ * Like EmitXmlTupleTag(), but lets caller specify font color
+ */
+static void
+EmitXmlTupleTagFont(BlockNumber blkno, OffsetNumber offset, const char *name,
+					const char *color, const char *fontColor,
+					uint32 relfileOff, uint32 relfileOffEnd)
+{
+	if (relfileOff > relfileOffEnd)
+	{
+		fprintf(stderr, "pg_hexedit error: (%u,%u) tuple tag \"%s\" is malformed (%u > %u)\n",
+				blkno + segmentBlockDelta, offset, name, relfileOff,
+				relfileOffEnd);
+		exitCode = 1;
+		return;
+	}
+
+	appendStringInfo(StartTagText(), "(%u,%u) %s", blkno + segmentBlockDelta,
+					 offset, name);
+	EmitTag(relfileOff, relfileOffEnd, fontColor, color);
+}
+
+/*
+ * Like EmitXmlTupleTagFont(), but lets caller specify name in two parts
+ */
+static void
+EmitXmlTupleTagFontTwoName(BlockNumber blkno, OffsetNumber offset,
+						   const char *name1, const char *name2,
+						   const char *color, const char *fontColor,
+						   uint32 relfileOff, uint32 relfileOffEnd)
+{
+	if (relfileOff > relfileOffEnd)
+	{
+		fprintf(stderr, "pg_hexedit error: (%u,%u) tuple tag \"%s - %s\" is malformed (%u > %u)\n",
+				blkno + segmentBlockDelta, offset, name1, name2, relfileOff,
+				relfileOffEnd);
+		exitCode = 1;
+		return;
+	}
+
+	appendStringInfo(StartTagText(), "(%u,%u) %s - %s",
+					 blkno + segmentBlockDelta, offset, name1, name2);
+	EmitTag(relfileOff, relfileOffEnd, fontColor, color);
+}
+
+/*
+ * Emit wxHexEditor tags for individual non-NULL attributes in heap tuple
+ */
+static void
+EmitXmlAttributesHeap(BlockNumber blkno, OffsetNumber offset,
+					  uint32 relfileOff, HeapTupleHeader htup, int itemSize)
+{
+	unsigned char *tupdata = (unsigned char *) htup + htup->t_hoff;
+	bits8	   *t_bits;
+	int			nattrs = HeapTupleHeaderGetNatts(htup);
+	int			datalen = itemSize - htup->t_hoff;
+
+	/*
+	 * If an argument describing the relation's tuples was not provided, just
+	 * create a single tag
+	 */
+	if (nrelatts == 0)
+	{
+		EmitXmlTupleTag(blkno, offset, "contents", COLOR_WHITE, relfileOff,
+						(relfileOff + datalen) - 1);
+		return;
+	}
+
+	if (nattrs > nrelatts)
+	{
+		fprintf(stderr, "pg_hexedit error: %d attributes found in (%u,%u) exceeds the number inferred for relation from -D argument %d\n",
+				nattrs, blkno, offset, nrelatts);
+		exitCode = 1;
+		nattrs = nrelatts;
+	}
+
+	t_bits = (htup->t_infomask & HEAP_HASNULL) != 0 ? htup->t_bits : NULL;
+
+	EmitXmlAttributesData(blkno, offset, relfileOff, tupdata, t_bits, nattrs,
+						  datalen);
+}
+
+/*
+ * Emit wxHexEditor tags for individual non-NULL attributes in index tuple
+ */
+static void
+EmitXmlAttributesIndex(BlockNumber blkno, OffsetNumber offset,
+					   uint32 relfileOff, IndexTuple itup, uint32 tupHeaderOff,
+					   int itemSize)
+{
+	unsigned char *tupdata;
+	bits8	   *t_bits;
+	int			datalen;
+	int			nattrs = nrelatts;
+	bool		haveargreltuple = true;
+
+	/*
+	 * If an argument describing the relation's tuples was not provided, just
+	 * create a single tag, but show pivot tuple heap TID representation, or
+	 * posting list representation, since we don't need -D metadata for that.
+	 *
+	 * Play it safe here -- don't attempt to emit attribute values when an
+	 * error was already encountered.  We may be able to limp on for much
+	 * longer this way, especially in the event of an access method that we
+	 * know nothing about but follows the familiar bufpage.c conventions, such
+	 * as zheap.
+	 *
+	 * Multi-column GIN entries have two attributes in main entry key tuples:
+	 * an implicit int16 leading attribute that indicates which pg_attribute
+	 * listing the entry relates to, as well as the actual value.  This isn't
+	 * something that we currently support, though, so just treat this case as
+	 * if we had no catalog metadata.
+	 */
+	if (nrelatts == 0 || exitCode != 0 ||
+		(specialType == SPEC_SECT_INDEX_GIN && nrelatts > 1))
+	{
+		/* Won't be able to emit tags based on tuple metadata argument */
+		haveargreltuple = false;
+	}
+
+	/* Set up state for emitting attributes */
+	tupdata = (unsigned char *) itup + IndexInfoFindDataOffset(itup->t_info);
+	t_bits = IndexTupleHasNulls(itup) ?
+		(bits8 *) ((unsigned char *) itup + sizeof(IndexTupleData)) : NULL;
+	datalen = itemSize - IndexInfoFindDataOffset(itup->t_info) - 1;
+
+	/*
+	 * This is based on BTreeTupleGetNAtts(), which cannot be called from
+	 * frontend code.
+	 *
+	 * On Postgres v12+, account for possible heap TID tiebreaker attribute in
+	 * pivot tuples.  These TIDs are white because they are considered keys,
+	 * not pointers.  This color scheme is based on the precedent set by GIN's
+	 * internal posting tree pages.
+	 */
+	if (specialType == SPEC_SECT_INDEX_BTREE &&
+#if PG_VERSION_NUM < 130000
+		(itup->t_info & INDEX_ALT_TID_MASK) != 0)
+#else
+		 BTreeTupleIsPivot(itup)) /* This inline function is only in Postgres 13 */
+#endif /* PG_VERSION_NUM < 130000 */
+	{
+		nattrs =
+			(ItemPointerGetOffsetNumberNoCheck(&(itup)->t_tid) &
+			 BT_OFFSET_MASK);
+
+		if (haveargreltuple && nattrs > nrelatts)
+		{
+			fprintf(stderr, "pg_hexedit error: %d attributes found in (%u,%u) exceeds the number inferred for relation from -D argument %d\n",
+					nattrs, blkno, offset, nrelatts);
+			exitCode = 1;
+			nattrs = nrelatts;
+		}
+		if (BTreeTupleGetHeapTID(itup) != NULL)
+		{
+			/*
+			 * Heap TID attribute is considered a column internally, but has
+			 * no pg_attribute entry.
+			 *
+			 * Note that this only handles the special representation of heap
+			 * TID that's used in pivot tuples (includes leaf page high key).
+			 * Non-pivot tuples represent heap TID using IndexTupleData.t_tid,
+			 * or by using a posting list.
+			 */
+			uint32		htidoffset;
+
+			htidoffset = (tupHeaderOff + IndexTupleSize(itup)) -
+				sizeof(ItemPointerData);
+			datalen -= sizeof(ItemPointerData);
+
+			EmitXmlTupleTag(blkno, offset, "BTreeTupleGetHeapTID()->bi_hi", COLOR_PINK,
+							htidoffset, (htidoffset + sizeof(uint16)) - 1);
+			htidoffset += sizeof(uint16);
+			EmitXmlTupleTag(blkno, offset, "BTreeTupleGetHeapTID()->bi_lo", COLOR_PINK,
+							htidoffset, (htidoffset + sizeof(uint16)) - 1);
+			htidoffset += sizeof(uint16);
+			EmitXmlTupleTag(blkno, offset, "BTreeTupleGetHeapTID()->offsetNumber", COLOR_PINK,
+							htidoffset, (htidoffset + sizeof(uint16)) - 1);
+		}
+	}
+
+	/*
+	 * On Postgres v13+, account for nbtree posting list tuples
+	 */
+#if PG_VERSION_NUM >= 130000
+	else if (specialType == SPEC_SECT_INDEX_BTREE && BTreeTupleIsPosting(itup))
+	{
+		uint32	postoffset = tupHeaderOff + BTreeTupleGetPostingOffset(itup);
+		int		i;
+
+		datalen = postoffset - relfileOff - 1;
+
+		/*
+		 * Annotate each posting list TID individually, while alternating the
+		 * color to increase legibility.
+		 *
+		 * This deliberately doesn't look anything like pivot tuple heap TID
+		 * annotations, and deliberately doesn't recreate the slight variation
+		 * in color within TIDs from tuple headers.  Small posting list tuples
+		 * should appear prominently among duplicates that aren't posting
+		 * lists.
+		 */
+		for (i = 0; i < BTreeTupleGetNPosting(itup); i++)
+		{
+			char   *color = (i % 2 == 0 ? COLOR_RED_LIGHT : COLOR_GREEN_LIGHT);
+			char	tidstr[30];
+
+			sprintf(tidstr, "TID[%d] bi_hi", i);
+			EmitXmlTupleTag(blkno, offset, tidstr, color, postoffset,
+							(postoffset + sizeof(uint16)) - 1);
+			postoffset += sizeof(uint16);
+			sprintf(tidstr, "TID[%d] bi_lo", i);
+			EmitXmlTupleTag(blkno, offset, tidstr, color, postoffset,
+							(postoffset + sizeof(uint16)) - 1);
+			postoffset += sizeof(uint16);
+			sprintf(tidstr, "TID[%d] offsetNumber", i);
+			EmitXmlTupleTag(blkno, offset, tidstr, color, postoffset,
+							(postoffset + sizeof(uint16)) - 1);
+			postoffset += sizeof(uint16);
+		}
+	}
+#endif /* PG_VERSION_NUM >= 130000 */
+
+	/*
+	 * Finally, emit pg_attribute-wise columns, or plain gray tag that
+	 * represents where the pg_attribute-wise tuple values would go if we had
+	 * valid -D info
+	 */
+	if (haveargreltuple)
+		EmitXmlAttributesData(blkno, offset, relfileOff, tupdata, t_bits,
+							  nattrs, MAXALIGN(datalen));
+	else
+		EmitXmlTupleTag(blkno, offset, "contents", COLOR_WHITE,
+						relfileOff, relfileOff + datalen);
+
+}
+
+/*
+ * Locate zero-based attribute attnum within a heap or index tuple data area
+ * of datalen bytes, using the catalog metadata passed by user.  *off is the
+ * offset just past the previous attribute (0 for the first attribute), and is
+ * advanced past this one.  Attributes that null bitmap t_bits (if any) marks
+ * NULL are NULL, as are attributes at or beyond natts, which were added after
+ * the tuple was formed.
+ *
+ * This code is loosely based on nocachegetattr().  Every byte of the
+ * attribute, and every byte examined to find its length, is known to be
+ * within the data area on return.  Returns false when attribute doesn't fit.
+ *
+ * Every consumer of individual attributes locates them here, so that they
+ * all agree on alignment, NULLs, and bounds.
+ */
+static bool
+LocateAttribute(unsigned char *tupdata, bits8 *t_bits, int natts,
+				int datalen, int attnum, int *off, AttributeSpan *span)
+{
+	int			attlen = attlenrel[attnum];
+	char		attalign = attalignrel[attnum];
+	int			start = *off;
+
+	memset(span, 0, sizeof(AttributeSpan));
+	if (attnum >= natts || (t_bits && att_isnull(attnum, t_bits)))
+	{
+		span->isnull = true;
+		span->off = start;
+		span->ptr = tupdata + start;
+		return true;
+	}
+
+	if (attlen == -1)
+	{
+		/* Padding is only skipped when a 4 byte varlena header follows it */
+		if (start >= datalen)
+			return false;
+		start = att_align_pointer(start, attalign, -1, tupdata + start);
+		if (start >= datalen)
+			return false;
+		span->ptr = tupdata + start;
+
+		if (VARATT_IS_1B(span->ptr))
+		{
+			/* Length of external TOAST pointer depends on its va_tag */
+			if (VARATT_IS_1B_E(span->ptr) &&
+				start + VARHDRSZ_EXTERNAL > datalen)
+				return false;
+			span->hdrlen = VARHDRSZ_SHORT;
+		}
+		else
+		{
+			if (start + VARHDRSZ > datalen)
+				return false;
+			span->hdrlen = VARHDRSZ;
+		}
+
+		span->len = VARSIZE_ANY(span->ptr);
+		if (span->len < span->hdrlen)
+			return false;
+	}
+	else if (attlen == -2)
+	{
+		start = att_align_nominal(start, attalign);
+		if (start >= datalen)
+			return false;
+		span->ptr = tupdata + start;
+
+		/* Unterminated cstring is one byte too long */
+		span->len = strnlen((char *) span->ptr, datalen - start) + 1;
+	}
+	else
+	{
+		start = att_align_nominal(start, attalign);
+		span->ptr = tupdata + start;
+		span->len = attlen;
+	}
+
+	if (start + span->len > datalen)
+		return false;
+
+	span->off = start;
+	*off = start + span->len;
+
+	return true;
+}
+
+/*
+ * Emit wxHexEditor tags for individual non-NULL attributes.
+ *
+ * This relies on catalog metadata passed by user, since frontend code cannot
+ * use tuple descriptors or access system catalog metadata itself.
+ */
+static void
+EmitXmlAttributesData(BlockNumber blkno, OffsetNumber offset,
+					  uint32 relfileOff, unsigned char *tupdata, bits8 *t_bits,
+					  int nattrs, int datalen)
+{
+	int			off = 0;
+	int			i;
+
+	for (i = 0; i < nattrs; i++)
+	{
+		char	   *attname = attnamerel[i];
+		char	   *attcolor = attcolorrel[i];
+		AttributeSpan span;
+		uint32		valueOff;
+		uint32		valueEnd;
+		char	   *toastdesc = NULL;
+		bool		toastbroken = false;
+
+		if (!LocateAttribute(tupdata, t_bits, nattrs, datalen, i, &off,
+							 &span))
+		{
+			fprintf(stderr, "pg_hexedit error: unexpected out of bounds tuple data for attnum %d in (%u,%u)\n",
+					i + 1, blkno, offset);
+			exitCode = 1;
+			return;
+		}
+		if (span.isnull)
+			continue;
+
+		valueOff = relfileOff + span.off + span.hdrlen;
+		valueEnd = relfileOff + span.off + span.len - 1;
+
+		/* Varlena header receives its own minimal tag */
+		if (span.hdrlen > 0)
+		{
+			const char *hdrname;
+
+			if (VARATT_IS_1B_E(span.ptr))
+				hdrname = "varattrib_1b_e";
+			else if (VARATT_IS_1B(span.ptr))
+				hdrname = "varattrib_1b";
+			else if (VARATT_IS_4B_C(span.ptr))
+				hdrname = "va_compressed";
+			else
+				hdrname = "va_4byte";
+
+			EmitXmlTupleTagFontTwoName(blkno, offset, attname, hdrname,
+									   attcolor, COLOR_BROWN,
+									   relfileOff + span.off, valueOff - 1);
+
+			/* Empty values have no bytes to tag */
+			if (span.len == span.hdrlen)
+				continue;
+		}
+
+#ifndef PG_HEXEDIT_EXTENSION
+
+		/*
+		 * Resolve external on-disk TOAST pointer against -T chunk index, and
+		 * describe the outcome in the attribute's tag
+		 */
+		if (toastChunks && span.hdrlen > 0 &&
+			VARATT_IS_EXTERNAL_ONDISK(span.ptr))
+			toastdesc = ResolveToastPointer(blkno, offset, i, span.ptr,
+											&toastbroken);
+#endif
+
+		if (toastdesc)
+		{
+			EmitXmlTupleTagFontTwoName(blkno, offset, attname, toastdesc,
+									   attcolor,
+									   toastbroken ? COLOR_RED_DARK : COLOR_FONT_STANDARD,
+									   valueOff, valueEnd);
+			pg_free(toastdesc);
+		}
+		else
+			EmitXmlTupleTag(blkno, offset, attname, attcolor, valueOff,
+							valueEnd);
+	}
+}
+
+/*
+ * Emit a wxHexEditor tag for entire heap tuple.
+ *
+ * Note: Caller passes itemSize from ItemId because that's the only place that
+ * it's available from.
+ */
+static void
+EmitXmlHeapTuple(BlockNumber blkno, OffsetNumber offset,
+				 HeapTupleHeader htup, uint32 relfileOff,
+				 int itemSize)
+{
+	TransactionId rawXmin = HeapTupleHeaderGetRawXmin(htup);
+	TransactionId rawXmax = HeapTupleHeaderGetRawXmax(htup);
+	char		xmin[128];
+	char		xmax[128];
+	char	   *xminFontColor;
+	char	   *xmaxFontColor;
+	BlockNumber logBlock = blkno + segmentBlockDelta;
+	char	   *blkFontColor;
+	char	   *offsetFontColor;
+	char	   *flagString;
+	uint32		relfileOffNext = 0;
+	uint32		relfileOffOrig = relfileOff;
+
+	/*
+	 * Produce xmin and xmax tags for tuple.
+	 *
+	 * The choice of colors here is not completely arbitrary.  There is some
+	 * attempt at analogy in the choice of colors.  For example, xmin and xmax
+	 * are symmetric, and so are both COLOR_RED_LIGHT.
+	 *
+	 * Tuple freezing and MultiXacts leave us with a lot of potentially
+	 * interesting information to represent here.  We use special font colors
+	 * to represent special transaction IDs, and include certain special
+	 * status information about the TransactionId/MultiXact contained within
+	 * each field.  The extra information in the tags is redundant with the
+	 * infomask tags (tags for where the information is actually represented),
+	 * but it seems useful to add some visual cues.
+	 */
+	strcpy(xmin, "xmin");
+	strcpy(xmax, "xmax");
+	xminFontColor = COLOR_FONT_STANDARD;
+	xmaxFontColor = COLOR_FONT_STANDARD;
+
+	/*
+	 * HeapTupleHeaderXminFrozen() doesn't actually consider pre-9.4
+	 * pg_upgrad'ed tuples that have FrozenTransactionId as their raw xmin
+	 */
+	if (!HeapTupleHeaderXminFrozen(htup) && rawXmin != FrozenTransactionId)
+	{
+		if (rawXmin == BootstrapTransactionId)
+		{
+			strcat(xmin, " - BootstrapTransactionId");
+			xminFontColor = COLOR_WHITE;
+		}
+		else if (rawXmin == InvalidTransactionId)
+		{
+			strcat(xmin, " - InvalidTransactionId");
+			xminFontColor = COLOR_YELLOW_LIGHT;
+		}
+	}
+	else
+	{
+		/*
+		 * Raw xmin is frozen.  Frozen xmin XIDs are only preserved for
+		 * forensic reasons (on Postgres 9.4+), so use low-contrast font to
+		 * deemphasize the XID.  (Raw xmin could be FrozenTransactionId here
+		 * in a pg_upgrade'd database, which is just as uninteresting.)
+		 */
+		strcat(xmin, " - Frozen");
+		xminFontColor = COLOR_RED_DARK;
+	}
+
+	/*
+	 * Deliberately tag InvalidTransactionId and HEAP_XMAX_INVALID separately
+	 * for xmax annotation, since they can be set separately in a way that
+	 * might be interesting.  Also indicate (redundantly) if the xmax is a
+	 * MultiXactId, or is the XID on a non-updating locker xact.
+	 *
+	 * Representing HEAP_XMAX_IS_MULTI and HEAP_XMAX_LOCK_ONLY but not
+	 * HEAP_XMAX_COMMITTED here is a bit arbitrary.  We do this because
+	 * HEAP_XMAX_IS_MULTI and HEAP_XMAX_LOCK_ONLY are basic facts about the
+	 * class of data that the xmax field contains, as opposed to status
+	 * information for the tuple as a whole.
+	 *
+	 * The general idea is to make it as easy as possible for the user to get
+	 * a sense of the structure of update chains on the page.
+	 */
+	if ((htup->t_infomask & HEAP_XMAX_IS_MULTI) != 0)
+	{
+		strcat(xmax, " - HEAP_XMAX_IS_MULTI");
+		xmaxFontColor = COLOR_GREEN_DARK;
+	}
+	if (rawXmax == InvalidTransactionId)
+	{
+		strcat(xmax, " - InvalidTransactionId");
+		xmaxFontColor = COLOR_YELLOW_LIGHT;
+	}
+	if ((htup->t_infomask & HEAP_XMAX_INVALID) != 0)
+	{
+		strcat(xmax, " - HEAP_XMAX_INVALID");
+		/* Matches InvalidTransactionId case */
+		xmaxFontColor = COLOR_YELLOW_LIGHT;
+	}
+
+	/*
+	 * Handle HEAP_XMAX_LOCK_ONLY last, since the HEAP_XMAX_INVALID hint seems
+	 * like it shouldn't affect font color.
+	 */
+	if ((htup->t_infomask & HEAP_XMAX_LOCK_ONLY) != 0)
+	{
+		/*
+		 * This color is deliberately chosen to be similar to the special
+		 * t_ctid font colors
+		 */
+		strcat(xmax, " - HEAP_XMAX_LOCK_ONLY");
+		xmaxFontColor = COLOR_BLUE_DARK;
+	}
+
+	relfileOffNext = relfileOff + sizeof(TransactionId);
+	EmitXmlTupleTagFont(blkno, offset, xmin, COLOR_RED_LIGHT, xminFontColor,
+						relfileOff, relfileOffNext - 1);
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(TransactionId);
+	EmitXmlTupleTagFont(blkno, offset, xmax, COLOR_RED_LIGHT, xmaxFontColor,
+						relfileOff, relfileOffNext - 1);
+	relfileOff = relfileOffNext;
+
+	if (!(htup->t_infomask & HEAP_MOVED))
+	{
+		/*
+		 * t_cid is COLOR_RED_DARK in order to signal that it's associated
+		 * with though somewhat different to xmin and xmax.
+		 */
+		relfileOffNext += sizeof(CommandId);
+		EmitXmlTupleTag(blkno, offset, "t_cid", COLOR_RED_DARK, relfileOff,
+						relfileOffNext - 1);
+	}
+	else
+	{
+		/*
+		 * This must be a rare case where pg_upgrade has been run, and we're
+		 * left with a tuple with a t_xvac field instead of a t_cid field,
+		 * because at some point old-style VACUUM FULL was run. (This would
+		 * have had to have been on or before version 9.0, which has been out
+		 * of support for some time.)
+		 *
+		 * Make it COLOR_PINK, so that it sticks out like a sore thumb.
+		 */
+		StaticAssertStmt(sizeof(CommandId) == sizeof(TransactionId),
+						 "t_cid width must match t_xvac");
+		relfileOffNext += sizeof(TransactionId);
+		EmitXmlTupleTag(blkno, offset, "t_xvac", COLOR_PINK, relfileOff,
+						relfileOffNext - 1);
+	}
+
+	/*
+	 * Don't use ItemPointerData directly, to avoid having apparent mix in
+	 * endianness in these fields.  Delineate which subfield is which by using
+	 * multiple tags.
+	 *
+	 * The block component of each TID is COLOR_BLUE_LIGHT.  The same color is
+	 * used for ItemIds, since both are physical pointers.  offsetNumber is a
+	 * logical pointer, though, and so we make that COLOR_BLUE_DARK to
+	 * slightly distinguish it.
+	 *
+	 * It seems useful to provide a subtle cue about whether or not the tuple
+	 * is the latest version within the t_ctid subfields, since this helps the
+	 * user to notice update chains.  Check if tuple's t_ctid points to the
+	 * tuple itself; if it does, use non-contrasting font colors to
+	 * deemphasize.
+	 */
+	blkFontColor = COLOR_FONT_STANDARD;
+	offsetFontColor = COLOR_FONT_STANDARD;
+	if (ItemPointerGetBlockNumber(&htup->t_ctid) == logBlock &&
+		ItemPointerGetOffsetNumber(&htup->t_ctid) == offset)
+	{
+		blkFontColor = COLOR_BLUE_DARK;
+		offsetFontColor = COLOR_BLUE_LIGHT;
+	}
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(uint16);
+	EmitXmlTupleTagFont(blkno, offset, "t_ctid->bi_hi", COLOR_BLUE_LIGHT,
+						blkFontColor, relfileOff, relfileOffNext - 1);
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(uint16);
+	EmitXmlTupleTagFont(blkno, offset, "t_ctid->bi_lo", COLOR_BLUE_LIGHT,
+						blkFontColor, relfileOff, relfileOffNext - 1);
+
+	/*
+	 * Note: offsetNumber could be SpecTokenOffsetNumber, but we don't
+	 * annotate that
+	 */
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(uint16);
+	EmitXmlTupleTagFont(blkno, offset, "t_ctid->offsetNumber", COLOR_BLUE_DARK,
+						offsetFontColor, relfileOff, relfileOffNext - 1);
+
+	flagString = GetHeapTupleHeaderFlags(htup, true);
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(uint16);
+	EmitXmlTupleTag(blkno, offset, flagString, COLOR_GREEN_LIGHT, relfileOff,
+					relfileOffNext - 1);
+	pg_free(flagString);
+	flagString = GetHeapTupleHeaderFlags(htup, false);
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(uint16);
+	EmitXmlTupleTag(blkno, offset, flagString, COLOR_GREEN_DARK, relfileOff,
+					relfileOffNext - 1);
+	pg_free(flagString);
+
+	/*
+	 * Metadata about the tuple shape and width is COLOR_YELLOW_DARK, in line
+	 * with general convention.  t_hoff is a fixed addressable field, so we
+	 * make it COLOR_YELLOW_LIGHT to represent that it's associated but
+	 * distinct.
+	 */
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(uint8);
+	EmitXmlTupleTag(blkno, offset, "t_hoff", COLOR_YELLOW_LIGHT, relfileOff,
+					relfileOffNext - 1);
+
+	/*
+	 * We consider the size of the t_bits field (if any) to be what the
+	 * att_isnull() macro requires.  There is one bit per attribute, which is
+	 * rounded up to the nearest byte boundary.
+	 *
+	 * This often leaves a conspicuous empty space between the t_bits area and
+	 * the first attribute/beginning of tuple contents.  This happens because
+	 * the first attribute of the tuple must be accessed at a MAXALIGN()'d
+	 * offset relative to the start of the tuple (often 32 bytes from the
+	 * beginning of the tuple).  The empty space for alignment doesn't seem
+	 * like it should count as t_bits overhead.
+	 *
+	 * (t_bits doesn't have any alignment requirements, which is why there can
+	 * be a one byte t_bits array when there aren't so many attributes.  That
+	 * can fit snugly before the first attribute, which will only have a 24
+	 * byte offset from the beginning of the tuple provided there is no oid
+	 * field.)
+	 */
+	relfileOff = relfileOffNext;
+	relfileOffNext = relfileOffOrig + htup->t_hoff;
+	if (htup->t_infomask & HEAP_HASOID)
+		relfileOffNext -= sizeof(Oid);
+	if (htup->t_infomask & HEAP_HASNULL)
+		EmitXmlTupleTag(blkno, offset, "t_bits", COLOR_YELLOW_DARK, relfileOff,
+						relfileOff + ((HeapTupleHeaderGetNatts(htup) + 0x07) >> 3) - 1);
+
+	/*
+	 * Represent Oid as a distinct field with the same color as t_bits, since
+	 * it's also an optional heap tuple header.
+	 */
+	if (htup->t_infomask & HEAP_HASOID)
+	{
+		relfileOff = relfileOffNext;
+		relfileOffNext += sizeof(Oid);
+		EmitXmlTupleTag(blkno, offset, "HeapTupleHeaderGetOid()",
+						COLOR_YELLOW_DARK, relfileOff, relfileOffNext - 1);
+	}
+
+	/*
+	 * Handle rare edge case where tuple has no contents because it consists
+	 * entirely of NULL attributes.  We trust lp_len to handle this, which is
+	 * what caller passed us.
+	 */
+	if (itemSize == (relfileOffNext - relfileOffOrig))
+		return;
+	else if (itemSize < (relfileOffNext - relfileOffOrig))
+	{
+		fprintf(stderr, "pg_hexedit error: lp_len %d from (%u,%u) is undersized\n",
+				itemSize, blkno + segmentBlockDelta, offset);
+		exitCode = 1;
+		return;
+	}
+
+	relfileOff = relfileOffNext;
+	EmitXmlAttributesHeap(blkno, offset, relfileOff, htup, itemSize);
+}
+
+/*
+ * Emit a wxHexEditor tag for entire index tuple.
+ *
+ * Function deals with B-Tree, GiST, and hash tuples in a generic way, because
+ * they use the IndexTuple format without adornment.  These index AMs use line
+ * pointer metadata to represent that index tuples are logically dead by
+ * setting the LP_DEAD bit.  Unlike the heap LP_DEAD case, there will still be
+ * a tuple on the page when this is set (the tuple "has storage").  Caller
+ * passes an argument that has us redundantly use color to represent that the
+ * index tuple is dead, meaning that the space it occupies will soon be
+ * recycled.
+ *
+ * This function is also used for GIN tuples in pending list and main B-Tree
+ * key pages, and so must deal with the various abuses of the IndexTuple format
+ * that GIN makes to store posting lists in main B-Tree key pages (pending
+ * pages don't compress TIDs, and posting tree pages are dealt with in special
+ * GIN-only paths).
+ *
+ * This function is not used for BrinTuples, because they share nothing with
+ * IndexTuples in terms of layout, despite being conceptually similar (BRIN
+ * tuples store blocks, not exact TIDs).
+ *
+ * Note: Caller does not need to pass itemSize from ItemId, because that's
+ * redundant in the case of IndexTuples, and because SP-GiST callers will not
+ * be able to pass an lp_len for an inner-node-contained IndexTuple.  However,
+ * most still pass it, since it's a useful cross-check in the event of
+ * corruption such as a torn page.
+ */
+static void
+EmitXmlIndexTuple(Page page, BlockNumber blkno, OffsetNumber offset,
+				  IndexTuple tuple, uint32 relfileOff, int itemSize, bool dead)
+{
+	uint32		relfileOffNext = 0;
+	uint32		relfileOffOrig = relfileOff;
+	char	   *tagColor;
+	char	   *fontColor;
+	char	   *flagString;
+
+	/* Make font color indicate if LP_DEAD bit is set */
+	fontColor = dead ? COLOR_BROWN : COLOR_FONT_STANDARD;
+
+	if (itemSize < 0)
+		itemSize = IndexTupleSize(tuple);
+	else if (itemSize != IndexTupleSize(tuple))
+	{
+		fprintf(stderr, "pg_hexedit error: (%u,%u) lp_len %u does not equal IndexTupleSize() %lu\n",
+				blkno + segmentBlockDelta, offset, itemSize,
+				IndexTupleSize(tuple));
+		exitCode = 1;
+		itemSize = Max(sizeof(IndexTupleData),
+					   Min(itemSize, IndexTupleSize(tuple)));
+	}
+
+	if (specialType != SPEC_SECT_INDEX_GIN || !GinPageIsLeaf(page) ||
+		GinIsPostingTree(tuple))
+	{
+		/*
+		 * Emit t_tid tags.  TID tag style should be kept consistent with
+		 * EmitXmlHeapTuple().
+		 */
+		relfileOffNext = relfileOff + sizeof(uint16);
+		tagColor = dead ? COLOR_BLACK : COLOR_BLUE_LIGHT;
+		EmitXmlTupleTagFont(blkno, offset, "t_tid->bi_hi",
+							tagColor, fontColor,
+							relfileOff, relfileOffNext - 1);
+		relfileOff = relfileOffNext;
+		relfileOffNext += sizeof(uint16);
+		EmitXmlTupleTagFont(blkno, offset, "t_tid->bi_lo",
+							tagColor, fontColor,
+							relfileOff, relfileOffNext - 1);
+
+		/*
+		 * Handle cases where item pointer offset is abused, but t_tid still
+		 * contains a valid block number.  These cases are handled here
+		 * because they involve IndexTuples that contain a t_tid that is still
+		 * essentially a conventional TID.  These cases are:
+		 *
+		 * 1. GIN posting tree pointers (within the leaf level of the main
+		 * entry tree).  The fact that it's a posting tree pointer (and not
+		 * the start of a posting list) is indicated by using the magic offset
+		 * number GIN_TREE_POSTING.  We use GinIsPostingTree() to test this.
+		 *
+		 * 2. nbtree pivot tuples, which use the item offset field to
+		 * represent how many suffix attributes remain (suffix truncation
+		 * optimization makes the number variable for pivot tuples).  This is
+		 * indicated by the INDEX_ALT_TID_MASK bit having been set.  Note that
+		 * nbtree uses BTreeTupleGetNAtts() to obtain the number of suffix
+		 * attributes.
+		 */
+		relfileOff = relfileOffNext;
+		relfileOffNext += sizeof(uint16);
+		tagColor = dead ? COLOR_BLACK : COLOR_BLUE_DARK;
+		if (specialType == SPEC_SECT_INDEX_GIN && GinIsPostingTree(tuple))
+			EmitXmlTupleTagFont(blkno, offset,
+								"t_tid->offsetNumber/GinIsPostingTree()",
+								tagColor, fontColor,
+								relfileOff, relfileOffNext - 1);
+		else if (specialType == SPEC_SECT_INDEX_BTREE &&
+#if PG_VERSION_NUM < 130000
+				 (tuple->t_info & INDEX_ALT_TID_MASK) != 0)
+#else
+				 BTreeTupleIsPivot(tuple)) /* This macro is only in Postgres 13 */
+#endif /* PG_VERSION_NUM < 130000 */
+			EmitXmlTupleTagFont(blkno, offset,
+								"t_tid->offsetNumber/BTreeTupleGetNAtts()",
+								tagColor, fontColor,
+								relfileOff, relfileOffNext - 1);
+#if PG_VERSION_NUM >= 130000
+		else if (specialType == SPEC_SECT_INDEX_BTREE &&
+				 BTreeTupleIsPosting(tuple))
+			EmitXmlTupleTagFont(blkno, offset,
+								"t_tid->offsetNumber/BTreeTupleGetNPosting()",
+								tagColor, fontColor,
+								relfileOff, relfileOffNext - 1);
+#endif /* PG_VERSION_NUM >= 130000 */
+
+		/*
+		 * Regular/common case, where offset number is actually intended to be
+		 * accessed as a conventional offset (i.e. accessed using macros such
+		 * as ItemPointerGetOffsetNumber())
+		 */
+		else
+			EmitXmlTupleTagFont(blkno, offset, "t_tid->offsetNumber",
+								tagColor, fontColor,
+								relfileOff, relfileOffNext - 1);
+	}
+	else
+	{
+		/*
+		 * GIN posting lists (within the leaf level of the main entry tree)
+		 * abuse every item pointer field, so everything is handled here all
+		 * at once.  Naturally, there are block numbers (as well as offset
+		 * numbers) contained within posting lists, since a posting list is
+		 * literally a list of TIDs.  However, none of this information is
+		 * accessed in the conventional manner.
+		 */
+		relfileOffNext = relfileOff + sizeof(uint16);
+		tagColor = dead ? COLOR_BLACK : COLOR_BLUE_LIGHT;
+		EmitXmlTupleTagFont(blkno, offset, "t_tid->bi_hi/GinItupIsCompressed()",
+							tagColor, fontColor,
+							relfileOff, relfileOffNext - 1);
+		relfileOff = relfileOffNext;
+		relfileOffNext += sizeof(uint16);
+		EmitXmlTupleTagFont(blkno, offset,
+							"t_tid->bi_lo/GinGetPostingOffset()",
+							tagColor, fontColor,
+							relfileOff, relfileOffNext - 1);
+		relfileOff = relfileOffNext;
+		relfileOffNext += sizeof(uint16);
+		tagColor = dead ? COLOR_BLACK : COLOR_BLUE_DARK;
+		EmitXmlTupleTagFont(blkno, offset,
+							"t_tid->offsetNumber/GinGetNPosting()",
+							tagColor, fontColor,
+							relfileOff, relfileOffNext - 1);
+	}
+
+	/*
+	 * Metadata about the tuple shape and width is COLOR_YELLOW_DARK, which
+	 * also matches EmitXmlHeapTuple()
+	 */
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(unsigned short);
+	flagString = GetIndexTupleFlags(tuple);
+	tagColor = dead ? COLOR_BLACK : COLOR_YELLOW_DARK;
+	EmitXmlTupleTagFont(blkno, offset, flagString,
+						tagColor, fontColor,
+						relfileOff, relfileOffNext - 1);
+	pg_free(flagString);
+	relfileOff = relfileOffNext;
+
+	/*
+	 * NULL bitmap, if any, is counted as a separate tag, and not an extension
+	 * of t_info.  This is a little arbitrary, but makes more sense overall.
+	 * This matches heap tuple header tags.
+	 *
+	 * GIN has special rules for multicolumn indexes.  We don't break down the
+	 * structure of GIN's special representation of NULLness because doing so
+	 * requires access to catalog metadata.  See the GIN README for details.
+	 *
+	 * SP-GiST node tuples (from internal SP-GiST pages) do not have a NULL
+	 * bitmap, since there is implicitly only ever one attribute that could be
+	 * NULL, so the bit alone suffices.  See comments above
+	 * SpGistNodeTupleData.
+	 */
+	Assert(specialType != SPEC_SECT_INDEX_SPGIST || !SpGistPageIsLeaf(page));
+	if (IndexTupleHasNulls(tuple) && specialType != SPEC_SECT_INDEX_SPGIST)
+	{
+		relfileOffNext +=
+			(IndexInfoFindDataOffset(tuple->t_info) - (relfileOff - relfileOffOrig));
+
+		tagColor = dead ? COLOR_BLACK : COLOR_YELLOW_DARK;
+		EmitXmlTupleTagFont(blkno, offset, "IndexAttributeBitMapData array",
+							tagColor, fontColor,
+							relfileOff, relfileOffNext - 1);
+		relfileOff = relfileOffNext;
+	}
+
+	/*
+	 * Tuple contents, plus possible posting list for GIN leaf pages.
+	 *
+	 * All-attributes-NULL IndexTuples will not have any contents here, so we
+	 * avoid creating a tuple content tag entirely.  The same applies to
+	 * "minus infinity" items from nbtree internal pages (though they don't
+	 * have a NULL bitmap).
+	 *
+	 * Tuple contents is represented in the same way in the event of a dead
+	 * tuple.
+	 */
+	relfileOffNext = relfileOffOrig + itemSize;
+	if (relfileOff < relfileOffNext)
+	{
+		/*
+		 * If this is a GIN page, we've already determined that this tuple is
+		 * from the main key B-Tree (posting trees don't use IndexTuples at
+		 * all).  We should only treat it as containing a posting list (in
+		 * addition to tuple contents) if:
+		 *
+		 * 1. It does not point to a posting tree.  Pointers to posting trees
+		 * are always simple block numbers (the posting tree root page block)
+		 * with magic offset number GIN_TREE_POSTING.
+		 *
+		 * 2. The posting list consists of one or more items.  See
+		 * ginReadTuple().
+		 *
+		 * 3. This isn't an internal page IndexTuple.  These use the item
+		 * pointer representation in the conventional way.
+		 *
+		 * 4. This isn't a pending list page.  These also don't abuse the item
+		 * pointer representation.
+		 *
+		 * The !GinPageIsLeaf() part of the test handles points 3 and 4.
+		 */
+		if (specialType != SPEC_SECT_INDEX_GIN || !GinPageIsLeaf(page) ||
+			GinIsPostingTree(tuple) || GinGetNPosting(tuple) == 0)
+			EmitXmlAttributesIndex(blkno, offset, relfileOff, tuple,
+								   relfileOffOrig, itemSize);
+		else
+		{
+			Size		postoffset = itemSize - GinGetPostingOffset(tuple);
+			const char *color;
+
+			EmitXmlAttributesIndex(blkno, offset, relfileOff, tuple, relfileOffOrig,
+								   GinGetPostingOffset(tuple));
+			relfileOff = relfileOffNext - postoffset;
+
+			/*
+			 * Compressed TIDs are orange.  Old Postgres versions have
+			 * old-style uncompressed lists of TIDs in leaf pages, so their
+			 * posting lists should be blue instead of orange, like regular
+			 * block number item pointer fields.  See ginPostingListDecode()
+			 * for details on how this representation is decompressed.
+			 */
+			color =
+			GinItupIsCompressed(tuple) ? COLOR_ORANGE : COLOR_BLUE_LIGHT;
+
+			EmitXmlTupleTag(blkno, offset, "posting list", color, relfileOff,
+							relfileOffNext - 1);
+		}
+	}
+}
+
+/*
+ * Emit a wxHexEditor tag for internal SP-GiST page tuple.
+ *
+ * This is similar to EmitXmlIndexTuple(), but SP-GiST never directly uses
+ * IndexTuple representation, so requires this custom tuple formatting
+ * function.  (Actually, SP-GiST internal/inner tuples end up reusing the
+ * IndexTuple representation internally, which we must deal with here.)
+ *
+ * We are prepared for the possibility that tuple is actually SpGistDeadTuple.
+ *
+ * Note that lp_len isn't needed here, since it's redundant, just as it is with
+ * the IndexTuple representation.
+ */
+static void
+EmitXmlSpGistInnerTuple(Page page, BlockNumber blkno, OffsetNumber offset,
+						SpGistInnerTuple tuple, uint32 relfileOff)
+{
+	SpGistNodeTuple node;
+	uint32		relfileOffNext = 0;
+	uint32		relfileOffOrig = relfileOff;
+	char	   *flagString;
+	bool		dead = (tuple->tupstate != SPGIST_LIVE);
+	int			i;
+
+	Assert(!SpGistPageIsLeaf(page));
+	Assert(!SpGistPageIsMeta(page));
+
+	/*
+	 * Reuse dead tuple handling within leaf tuple routine.  This correctly
+	 * indicates "inner page leaf tuple" size by interpreting the leaf tuple
+	 * "size" field, and there are no other fields that could be interpreted
+	 * incorrectly, so this seems to be the right approach.
+	 */
+	if (dead)
+	{
+		EmitXmlSpGistLeafTuple(page, blkno, offset, (SpGistLeafTuple) tuple,
+							   relfileOff);
+		return;
+	}
+
+	/*
+	 * Metadata about the tuple shape and width is COLOR_YELLOW_LIGHT, to
+	 * indicate that the field is metadata, but to create a contrast with
+	 * IndexTuple metadata fields (which are COLOR_YELLOW_DARK).
+	 */
+	flagString = GetSpGistInnerTupleState(tuple);
+	relfileOffNext = relfileOff + sizeof(unsigned int);
+	EmitXmlTupleTag(blkno, offset, flagString, COLOR_YELLOW_LIGHT, relfileOff,
+					relfileOffNext - 1);
+	pg_free(flagString);
+
+	relfileOff = relfileOffNext;
+	relfileOffNext = relfileOff + sizeof(uint16);
+	EmitXmlTupleTag(blkno, offset, "SpGistInnerTuple size", COLOR_YELLOW_LIGHT,
+					relfileOff, relfileOffNext - 1);
+
+	/*
+	 * Emit node tuple's contents (prefix).  The prefix value is optional.
+	 * Some SP-GiST operator classes never use them.  See spgist/README.
+	 */
+	relfileOff = relfileOffOrig + SGNTHDRSZ;
+	relfileOffNext = relfileOffOrig + SGNTHDRSZ + tuple->prefixSize;
+	if (relfileOff < relfileOffNext)
+		EmitXmlTupleTag(blkno, offset, "contents (prefix)", COLOR_WHITE,
+						relfileOff, relfileOffNext - 1);
+
+	/*
+	 * Print all SpGistNodeTuple entries, which actually share IndexTuple
+	 * representation
+	 */
+	SGITITERATE(tuple, i, node)
+	{
+		EmitXmlIndexTuple(page, blkno, offset, node,
+						  relfileOffOrig + ((char *) node - (char *) tuple),
+						  -1, false);
+	}
+}
+
+/*
+ * Emit a wxHexEditor tag for leaf SP-GiST page tuple.
+ *
+ * We are prepared for the possibility that tuple is actually SpGistDeadTuple.
+ */
+static void
+EmitXmlSpGistLeafTuple(Page page, BlockNumber blkno, OffsetNumber offset,
+					   SpGistLeafTuple tuple, uint32 relfileOff)
+{
+	uint32		relfileOffNext = 0;
+	uint32		relfileOffOrig = relfileOff;
+	char	   *flagString;
+	bool		dead = (tuple->tupstate != SPGIST_LIVE);
+
+	Assert(!SpGistPageIsMeta(page));
+
+	/*
+	 * Metadata about the tuple shape and width is COLOR_YELLOW_LIGHT, to
+	 * indicate that the field is metadata, but to create a contrast with
+	 * IndexTuple metadata fields (which are COLOR_YELLOW_DARK).
+	 */
+	flagString = GetSpGistLeafTupleState(tuple);
+	relfileOffNext = relfileOff + sizeof(unsigned int);
+	EmitXmlTupleTag(blkno, offset, flagString, COLOR_YELLOW_LIGHT, relfileOff,
+					relfileOffNext - 1);
+	pg_free(flagString);
+
+	relfileOff = relfileOffNext;
+	relfileOffNext = relfileOff + sizeof(OffsetNumber);
+	EmitXmlTupleTag(blkno, offset, "nextOffset", COLOR_YELLOW_DARK,
+					relfileOff, relfileOffNext - 1);
+
+	/* Heap pointer */
+	relfileOff = relfileOffNext;
+	relfileOffNext = relfileOff + sizeof(uint16);
+	EmitXmlTupleTag(blkno, offset, dead ? "pointer->bi_hi" : "heapPtr->bi_hi",
+					COLOR_BLUE_LIGHT, relfileOff, relfileOffNext - 1);
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(uint16);
+	EmitXmlTupleTag(blkno, offset, dead ? "pointer->bi_lo" : "heapPtr->bi_lo",
+					COLOR_BLUE_LIGHT, relfileOff, relfileOffNext - 1);
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(uint16);
+	EmitXmlTupleTag(blkno, offset, dead ? "pointer->offsetNumber" : "heapPtr->offsetNumber",
+					COLOR_BLUE_DARK, relfileOff, relfileOffNext - 1);
+
+	if (!dead)
+	{
+		/* Must not be inner tuple if not dead */
+		Assert(SpGistPageIsLeaf(page));
+
+		/* Emit tuple contents */
+#if PG_VERSION_NUM >= 140000
+		relfileOff = relfileOffOrig + SGLTHDRSZ(SGLT_GET_HASNULLMASK(tuple));
+#else
+		relfileOff = relfileOffOrig + SGLTHDRSZ;
+#endif
+		relfileOffNext = relfileOffOrig + tuple->size;
+		if (relfileOff < relfileOffNext)
+			EmitXmlTupleTag(blkno, offset, "contents", COLOR_WHITE,
+							relfileOff, relfileOffNext - 1);
+	}
+	else
+	{
+		/* XID */
+		relfileOff = relfileOffNext;
+		relfileOffNext = relfileOff + sizeof(TransactionId);
+		EmitXmlTupleTag(blkno, offset, "xid", COLOR_RED_LIGHT,
+						relfileOff, relfileOffNext - 1);
+	}
+}
+
+/*
+ * Emit a wxHexEditor tag for entire BRIN regular page tuple.
+ *
+ * This is similar to EmitXmlIndexTuple(), but BRIN never uses IndexTuple
+ * representation, so requires this custom tuple formatting function.
+ */
+static void
+EmitXmlBrinTuple(Page page, BlockNumber blkno, OffsetNumber offset,
+				 BrinTuple *tuple, uint32 relfileOff, int itemSize)
+{
+	uint32		relfileOffNext = 0;
+	uint32		relfileOffOrig = relfileOff;
+	char	   *flagString;
+
+	if (!BRIN_IS_REGULAR_PAGE(page))
+	{
+		fprintf(stderr, "pg_hexedit error: non-regular BRIN page formatted as regular");
+		exitCode = 1;
+	}
+
+	/*
+	 * Emit bt_info tags.  A straight block number is used here, in contrast
+	 * to the legacy bi_hi/bi_lo representation used everywhere else.  We
+	 * still match color/style, though.
+	 */
+	relfileOffNext = relfileOff + sizeof(BlockNumber);
+	EmitXmlTupleTag(blkno, offset, "bt_blkno", COLOR_BLUE_LIGHT, relfileOff,
+					relfileOffNext - 1);
+
+	/*
+	 * Metadata about the tuple shape and width is COLOR_YELLOW_DARK, which
+	 * also matches EmitXmlHeapTuple()
+	 */
+	relfileOff = relfileOffNext;
+	relfileOffNext += sizeof(unsigned short);
+	flagString = GetBrinTupleFlags(tuple);
+	EmitXmlTupleTag(blkno, offset, flagString, COLOR_YELLOW_DARK, relfileOff,
+					relfileOffNext - 1);
+	pg_free(flagString);
+	relfileOff = relfileOffNext;
+
+	/*
+	 * NULL bitmap, if any, is counted as a separate tag, and not an extension
+	 * of bt_info.  This matches index tuples.
+	 */
+	if (BrinTupleHasNulls(tuple))
+	{
+		relfileOffNext +=
+			(BrinTupleDataOffset(tuple) - (relfileOff - relfileOffOrig));
+
+		EmitXmlTupleTag(blkno, offset, "IndexAttributeBitMapData array",
+						COLOR_YELLOW_DARK, relfileOff, relfileOffNext - 1);
+		relfileOff = relfileOffNext;
+	}
+
+	/*
+	 * Tuple contents.
+	 *
+	 * All-attributes-NULL BrinTuples will not have any contents here, so we
+	 * avoid creating a tuple content tag entirely.
+	 *
+	 * We use the lp_len value here, since there is no IndexTupleSize()
+	 * equivalent -- lp_len is really all we have to go on in the case of BRIN
+	 * tuples.
+	 *
+	 * Tagging individual attributes is hard for BRIN indexes, so we don't do
+	 * that here.  We'd need to know how many columns are stored for each
+	 * attribute, which isn't stored in the system catalogs or in the on-disk
+	 * representation.  BrinOpcInfo.oi_nstored stores this information, which
+	 * is returned by one of the opclass methods, so full backend access is
+	 * truly necessary (in practice it's 2 for minmax operator classes, and 3
+	 * for inclusion operator classes).
+	 */
+	relfileOffNext = relfileOffOrig + itemSize;
+	if (relfileOff < relfileOffNext)
+		EmitXmlTupleTag(blkno, offset, "contents", COLOR_WHITE, relfileOff,
+						relfileOffNext - 1);
+}
+
+/*
+ * Format anomaly's detail, and report it through callback
+ */
+static void
+ReportPageProblem(PageProblemCallback callback, void *arg, BlockNumber blkno,
+				  OffsetNumber offset, checkAnomalyCodes code,
+				  unsigned int start, unsigned int end, const char *fmt,...)
+{
+	char		detail[64];
+	va_list		args;
+
+	/* Visitors that don't care about anomalies have no callback */
+	if (!callback)
+		return;
+
+	va_start(args, fmt);
+	vsnprintf(detail, sizeof(detail), fmt, args);
+	va_end(args);
+
+	callback(arg, blkno, offset, code, start, end, detail);
+}
+
+/*
+ * PageProblemCallback used while emitting tags.  Anomalies are reported on
+ * stderr, one line each.
+ */
+static void
+ReportXmlPageProblem(void *arg, BlockNumber blkno, OffsetNumber offset,
+					 checkAnomalyCodes code, unsigned int start,
+					 unsigned int end, const char *detail)
+{
+	if (offset == InvalidOffsetNumber)
+		fprintf(stderr, "pg_hexedit error: invalid header information in block %u: %s (%s)\n",
+				blkno, checkAnomalyNames[code], detail);
+	else if (code >= CHECK_TUPLE_TOO_SHORT)
+		fprintf(stderr, "pg_hexedit error: (%u,%u) invalid tuple: %s (%s)\n",
+				blkno + segmentBlockDelta, offset, checkAnomalyNames[code],
+				detail);
+	else
+		fprintf(stderr, "pg_hexedit error: (%u,%u) invalid line pointer: %s (%s)\n",
+				blkno + segmentBlockDelta, offset, checkAnomalyNames[code],
+				detail);
+	exitCode = 1;
+}
+
+/*
+ * Verify the checksum of page at file block blkno.
+ *
+ * These are the rules used by -z, unless -k was also given: a zero checksum
+ * is taken to mean that the page was written without data checksums enabled,
+ * and isn't verified.  New pages never have a checksum.  *calculated is set
+ * whenever the checksum is verified.
+ */
+static pageChecksumResults
+VerifyPageChecksum(Page page, BlockNumber blkno, uint16 *calculated)
+{
+	PageHeader	pageHeader = (PageHeader) page;
+
+	if (PageIsNew(page) ||
+		(!(blockOptions & BLOCK_CHECKSUMS) && pageHeader->pd_checksum == 0))
+		return PAGE_CHECKSUM_SKIPPED;
+
+	*calculated = pg_checksum_page(page, blkno + segmentBlockDelta);
+	if (*calculated != pageHeader->pd_checksum)
+		return PAGE_CHECKSUM_INVALID;
+
+	return PAGE_CHECKSUM_VALID;
+}
+
+/*
+ * Check the header of page at file block blkno, reporting each anomaly
+ * through callback.  Returns false when pd_lower, pd_upper and pd_special
+ * can't be used to locate the line pointer array, the tuple space, and the
+ * special section.
+ */
+static bool
+CheckPageHeader(Page page, BlockNumber blkno, PageProblemCallback callback,
+				void *arg)
+{
+	PageHeader	pageHeader = (PageHeader) page;
+	bool		sane = true;
+
+	if (PageGetPageSize(page) != blockSize)
+		ReportPageProblem(callback, arg, blkno, InvalidOffsetNumber,
+						  CHECK_PAGE_SIZE,
+						  offsetof(PageHeaderData, pd_pagesize_version),
+						  offsetof(PageHeaderData, pd_prune_xid) - 1,
+						  "page size %u, block size %u",
+						  (unsigned int) PageGetPageSize(page), blockSize);
+	if (PageGetPageLayoutVersion(page) != PG_PAGE_LAYOUT_VERSION)
+		ReportPageProblem(callback, arg, blkno, InvalidOffsetNumber,
+						  CHECK_LAYOUT_VERSION,
+						  offsetof(PageHeaderData, pd_pagesize_version),
+						  offsetof(PageHeaderData, pd_prune_xid) - 1,
+						  "layout version %u",
+						  (unsigned int) PageGetPageLayoutVersion(page));
+	if (pageHeader->pd_lower < SizeOfPageHeaderData)
+	{
+		ReportPageProblem(callback, arg, blkno, InvalidOffsetNumber,
+						  CHECK_LOWER_BEFORE_HEADER,
+						  offsetof(PageHeaderData, pd_lower),
+						  offsetof(PageHeaderData, pd_upper) - 1,
+						  "pd_lower %u", pageHeader->pd_lower);
+		sane = false;
+	}
+	if (pageHeader->pd_lower > pageHeader->pd_upper)
+	{
+		ReportPageProblem(callback, arg, blkno, InvalidOffsetNumber,
+						  CHECK_LOWER_AFTER_UPPER,
+						  offsetof(PageHeaderData, pd_lower),
+						  offsetof(PageHeaderData, pd_special) - 1,
+						  "pd_lower %u, pd_upper %u", pageHeader->pd_lower,
+						  pageHeader->pd_upper);
+		sane = false;
+	}
+	if (pageHeader->pd_upper > pageHeader->pd_special)
+	{
+		ReportPageProblem(callback, arg, blkno, InvalidOffsetNumber,
+						  CHECK_UPPER_AFTER_SPECIAL,
+						  offsetof(PageHeaderData, pd_upper),
+						  offsetof(PageHeaderData, pd_pagesize_version) - 1,
+						  "pd_upper %u, pd_special %u", pageHeader->pd_upper,
+						  pageHeader->pd_special);
+		sane = false;
+	}
+	if (pageHeader->pd_special > blockSize)
+	{
+		ReportPageProblem(callback, arg, blkno, InvalidOffsetNumber,
+						  CHECK_SPECIAL_PAST_END,
+						  offsetof(PageHeaderData, pd_special),
+						  offsetof(PageHeaderData, pd_pagesize_version) - 1,
+						  "pd_special %u", pageHeader->pd_special);
+		sane = false;
+	}
+
+	return sane;
+}
+
+/*
+ * Check that page's line pointer array fits on the page, reporting an
+ * anomaly through callback when it doesn't.  This can only happen when the
+ * header fails CheckPageHeader(), but callers that examine line pointers
+ * regardless must check.
+ */
+static bool
+CheckMaxOffset(Page page, BlockNumber blkno, PageProblemCallback callback,
+			   void *arg)
+{
+	int			maxOffset = PageGetMaxOffsetNumber(page);
+
+	if (maxOffset < 0 ||
+		maxOffset > (blockSize - SizeOfPageHeaderData) / sizeof(ItemIdData))
+	{
+		ReportPageProblem(callback, arg, blkno, InvalidOffsetNumber,
+						  CHECK_MAX_OFFSET,
+						  offsetof(PageHeaderData, pd_lower),
+						  offsetof(PageHeaderData, pd_upper) - 1,
+						  "max offset %d", maxOffset);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Check line pointer at offset, reporting any anomaly through callback.  Only
+ * the first limit bytes of the page are available.  Returns true when the
+ * line pointer points to storage that can be examined.
+ */
+static bool
+CheckLinePointer(Page page, BlockNumber blkno, OffsetNumber offset,
+				 unsigned int limit, PageProblemCallback callback, void *arg)
+{
+	ItemId		itemId = PageGetItemId(page, offset);
+	unsigned int itemSize = ItemIdGetLength(itemId);
+	unsigned int itemOffset = ItemIdGetOffset(itemId);
+	unsigned int itemFlags = ItemIdGetFlags(itemId);
+	unsigned int lpStart = (char *) itemId - (char *) page;
+	unsigned int lpEnd = lpStart + sizeof(ItemIdData) - 1;
+	int			maxOffset = PageGetMaxOffsetNumber(page);
+
+	/* LD_DEAD items may have storage, so we go by lp_len alone */
+	if (itemSize == 0)
+	{
+		if (itemFlags == LP_NORMAL)
+			ReportPageProblem(callback, arg, blkno, offset,
+							  CHECK_ITEM_ZERO_LENGTH, lpStart, lpEnd,
+							  "lp_off %u", itemOffset);
+		else if (itemFlags == LP_REDIRECT &&
+				 specialType == SPEC_SECT_NONE &&
+				 (itemOffset < FirstOffsetNumber ||
+				  itemOffset > maxOffset || itemOffset == offset))
+			ReportPageProblem(callback, arg, blkno, offset,
+							  CHECK_REDIRECT_TARGET, lpStart, lpEnd,
+							  "redirect to %u, max offset %d", itemOffset,
+							  maxOffset);
+		return false;
+	}
+	if (itemFlags == LP_REDIRECT || itemFlags == LP_UNUSED)
+	{
+		ReportPageProblem(callback, arg, blkno, offset, CHECK_ITEM_HAS_LENGTH,
+						  lpStart, lpEnd, "lp_flags %u, lp_len %u", itemFlags,
+						  itemSize);
+		return false;
+	}
+	if (itemOffset + itemSize > limit)
+	{
+		ReportPageProblem(callback, arg, blkno, offset, CHECK_ITEM_PAST_END,
+						  lpStart, lpEnd, "lp_off %u, lp_len %u, limit %u",
+						  itemOffset, itemSize, limit);
+		return false;
+	}
+
+	return true;
+}
+
+#ifndef PG_HEXEDIT_EXTENSION
+
+/*
+ * Check the header of heap tuple at offset, whose storage is known to fit on
+ * page, reporting any anomaly through callback.  Returns true when the
+ * tuple's null bitmap and data can be located using its header.
+ */
+static bool
+CheckHeapTupleHeader(Page page, BlockNumber blkno, OffsetNumber offset,
+					 unsigned int itemOffset, unsigned int itemSize,
+					 PageProblemCallback callback, void *arg)
+{
+	HeapTupleHeader htup = (HeapTupleHeader) (page + itemOffset);
+	unsigned int end = itemOffset + itemSize - 1;
+	unsigned int hoff;
+	unsigned int natts;
+
+	if (itemSize < SizeofHeapTupleHeader)
+	{
+		ReportPageProblem(callback, arg, blkno, offset, CHECK_TUPLE_TOO_SHORT,
+						  itemOffset, end, "lp_len %u", itemSize);
+		return false;
+	}
+
+	hoff = htup->t_hoff;
+	if (hoff < SizeofHeapTupleHeader || hoff > itemSize ||
+		hoff != MAXALIGN(hoff))
+	{
+		ReportPageProblem(callback, arg, blkno, offset, CHECK_TUPLE_HOFF,
+						  itemOffset, end, "t_hoff %u, lp_len %u", hoff,
+						  itemSize);
+		return false;
+	}
+
+	natts = HeapTupleHeaderGetNatts(htup);
+	if ((htup->t_infomask & HEAP_HASNULL) &&
+		SizeofHeapTupleHeader + BITMAPLEN(natts) > hoff)
+	{
+		ReportPageProblem(callback, arg, blkno, offset,
+						  CHECK_TUPLE_NULL_BITMAP, itemOffset,
+						  itemOffset + hoff - 1, "natts %u, t_hoff %u", natts,
+						  hoff);
+		return false;
+	}
+
+	return true;
+}
+
+#endif							/* PG_HEXEDIT_EXTENSION */
+
+/*
+ * Dump out a formatted block header for the requested block.
+ */
+static int
+EmitXmlPageHeader(Page page, BlockNumber blkno, uint32 level)
+{
+	int			rc = 0;
+	unsigned int headerBytes;
+
+	/*
+	 * Only attempt to format the header if the entire header (minus the item
+	 * array) is available
+	 */
+	if (bytesToFormat < offsetof(PageHeaderData, pd_linp[0]))
+	{
+		headerBytes = bytesToFormat;
+		rc = EOF_ENCOUNTERED;
+	}
+	else
+	{
+		/* Interpret the contents of the header */
+		PageHeader	pageHeader = (PageHeader) page;
+		XLogRecPtr	pageLSN = GetPageLsn(page);
+		int			maxOffset = PageGetMaxOffsetNumber(page);
+		char	   *flagString;
+		uint16		calc_checksum;
+
+		headerBytes = offsetof(PageHeaderData, pd_linp[0]);
+		blockVersion = (unsigned int) PageGetPageLayoutVersion(page);
+
+		/* We don't count itemidarray as header */
+		if (maxOffset > 0)
+		{
+			unsigned int itemsLength = maxOffset * sizeof(ItemIdData);
+
+			if (bytesToFormat < (headerBytes + itemsLength))
+			{
+				headerBytes = bytesToFormat;
+				rc = EOF_ENCOUNTERED;
+			}
+		}
+
+		/*
+		 * For historical reasons, the 64-bit page header LSN value is stored
+		 * as two 32-bit values.  This makes interpreting what is really just
+		 * a 64-bit unsigned int confusing on little-endian systems, because
+		 * the bytes are "in big endian order" across its two 32-bit halves,
+		 * but are in the expected little-endian order *within* each half.
+		 *
+		 * This is rather similar to the situation with t_ctid.  Unlike in
+		 * that case, we choose to make LSN a single field here, because we
+		 * don't want to have two tooltips with the format value for each
+		 * field.
+		 */
+		flagString = pg_malloc(128);
+		sprintf(flagString, "LSN: %X/%08X", (uint32) (pageLSN >> 32), (uint32) pageLSN);
+		EmitXmlTag(blkno, level, flagString, COLOR_YELLOW_LIGHT, pageOffset,
+				   (pageOffset + sizeof(PageXLogRecPtr)) - 1);
+		EmitXmlTag(blkno, level, "checksum", COLOR_GREEN_DARK,
+				   pageOffset + offsetof(PageHeaderData, pd_checksum),
+				   (pageOffset + offsetof(PageHeaderData, pd_flags)) - 1);
+
+		/* Generate generic page header flags (reuse buffer) */
+		flagString[0] = '\0';
+		strcat(flagString, "pd_flags - ");
+		if (pageHeader->pd_flags & PD_HAS_FREE_LINES)
+			strcat(flagString, "PD_HAS_FREE_LINES|");
+		if (pageHeader->pd_flags & PD_PAGE_FULL)
+			strcat(flagString, "PD_PAGE_FULL|");
+		if (pageHeader->pd_flags & PD_ALL_VISIBLE)
+			strcat(flagString, "PD_ALL_VISIBLE|");
+		if (strlen(flagString))
+			flagString[strlen(flagString) - 1] = '\0';
+
+		EmitXmlTag(blkno, level, flagString, COLOR_YELLOW_DARK,
+				   pageOffset + offsetof(PageHeaderData, pd_flags),
+				   (pageOffset + offsetof(PageHeaderData, pd_lower)) - 1);
+		pg_free(flagString);
+		EmitXmlTag(blkno, level, "pd_lower", COLOR_MAROON,
+				   pageOffset + offsetof(PageHeaderData, pd_lower),
+				   (pageOffset + offsetof(PageHeaderData, pd_upper)) - 1);
+		EmitXmlTag(blkno, level, "pd_upper", COLOR_MAROON,
+				   pageOffset + offsetof(PageHeaderData, pd_upper),
+				   (pageOffset + offsetof(PageHeaderData, pd_special)) - 1);
+		EmitXmlTag(blkno, level, "pd_special", COLOR_GREEN_BRIGHT,
+				   pageOffset + offsetof(PageHeaderData, pd_special),
+				   (pageOffset + offsetof(PageHeaderData, pd_pagesize_version)) - 1);
+		EmitXmlTag(blkno, level, "pd_pagesize_version", COLOR_BROWN,
+				   pageOffset + offsetof(PageHeaderData, pd_pagesize_version),
+				   (pageOffset + offsetof(PageHeaderData, pd_prune_xid)) - 1);
+		EmitXmlTag(blkno, level, "pd_prune_xid", COLOR_RED_LIGHT,
+				   pageOffset + offsetof(PageHeaderData, pd_prune_xid),
+				   (pageOffset + offsetof(PageHeaderData, pd_linp[0])) - 1);
+
+		/*
+		 * Eye the contents of the header and alert the user to possible
+		 * problems
+		 */
+		CheckPageHeader(page, blkno, ReportXmlPageProblem, NULL);
+
+		/* Verify checksums as valid if requested */
+		if ((blockOptions & (BLOCK_CHECKSUMS | BLOCK_ZEROSUMS)) &&
+			VerifyPageChecksum(page, blkno, &calc_checksum) ==
+			PAGE_CHECKSUM_INVALID)
+		{
+			fprintf(stderr, "pg_hexedit error: checksum failure in block %u (calculated 0x%04x)\n",
+					blkno, calc_checksum);
+			exitCode = 1;
+		}
+	}
+
+	/*
+	 * If we have reached the end of file while interpreting the header, give
+	 * up
+	 */
+	if (rc == EOF_ENCOUNTERED)
+	{
+		fprintf(stderr, "pg_hexedit error: end of block encountered within page header with bytes read: %4u\n",
+				bytesToFormat);
+		exitCode = 1;
+	}
+
+	return rc;
+}
+
+/*
+ * Get descriptor of metapage of access method with given special section
+ * type, or NULL when there is none
+ */
+static const StructDesc *
+GetMetapageDesc(unsigned int type)
+{
+#if PG_VERSION_NUM >= 130000
+	StaticAssertLastField(BTMetaPageData, btm_allequalimage);
+#else
+	StaticAssertLastField(BTMetaPageData, btm_last_cleanup_num_heap_tuples);
+#endif
+	StaticAssertLastField(HashMetaPageData, hashm_mapp);
+	StaticAssertLastField(GinMetaPageData, ginVersion);
+	StaticAssertLastField(SpGistLastUsedPage, freeSpace);
+	StaticAssertLastField(SpGistMetaPageData, lastUsedPages);
+	StaticAssertLastField(BrinMetaPageData, lastRevmapPage);
+
+	switch (type)
+	{
+		case SPEC_SECT_INDEX_BTREE:
+			return &btreeMetaDesc;
+		case SPEC_SECT_INDEX_HASH:
+			return &hashMetaDesc;
+		case SPEC_SECT_INDEX_GIN:
+			return &ginMetaDesc;
+		case SPEC_SECT_INDEX_SPGIST:
+			return &spgistMetaDesc;
+		case SPEC_SECT_INDEX_BRIN:
+			return &brinMetaDesc;
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Get descriptor of special area with given special section type, or NULL
+ * when there is none
+ */
+static const StructDesc *
+GetSpecialDesc(unsigned int type)
+{
+	StaticAssertLastField(SequenceMagic, magic);
+	StaticAssertLastField(BTPageOpaqueData, btpo_cycleid);
+	StaticAssertLastField(HashPageOpaqueData, hasho_page_id);
+	StaticAssertLastField(GISTPageOpaqueData, gist_page_id);
+	StaticAssertLastField(GinPageOpaqueData, flags);
+	StaticAssertLastField(SpGistPageOpaqueData, spgist_page_id);
+	StaticAssertLastField(BrinSpecialSpace, vector);
+
+	switch (type)
+	{
+		case SPEC_SECT_SEQUENCE:
+			return &sequenceSpecialDesc;
+		case SPEC_SECT_INDEX_BTREE:
+			return &btreeSpecialDesc;
+		case SPEC_SECT_INDEX_HASH:
+			return &hashSpecialDesc;
+		case SPEC_SECT_INDEX_GIST:
+			return &gistSpecialDesc;
+		case SPEC_SECT_INDEX_GIN:
+			return &ginSpecialDesc;
+		case SPEC_SECT_INDEX_SPGIST:
+			return &spgistSpecialDesc;
+		case SPEC_SECT_INDEX_BRIN:
+			return &brinSpecialDesc;
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Get tag text for field whose bytes are at value.  Decoded fields have the
+ * names of their flags (or value) appended, as in "btpo_flags - BTP_LEAF".
+ * tagName must have room for 256 bytes.
+ */
+static const char *
+GetFieldTagName(const FieldDesc *field, const char *value, char *tagName)
+{
+	uint32		fieldValue;
+	int			i;
+
+	if (field->decoder == FIELD_PLAIN)
+		return field->name;
+
+	if (field->size == sizeof(uint8))
+		fieldValue = *(uint8 *) value;
+	else if (field->size == sizeof(uint16))
+	{
+		uint16		value16;
+
+		memcpy(&value16, value, sizeof(uint16));
+		fieldValue = value16;
+	}
+	else
+		memcpy(&fieldValue, value, sizeof(uint32));
+
+	strcpy(tagName, field->name);
+	strcat(tagName, " - ");
+	for (i = 0; i < field->nflags; i++)
+	{
+		if (field->decoder == FIELD_FLAGS ?
+			(fieldValue & field->flags[i].value) != 0 :
+			fieldValue == field->flags[i].value)
+		{
+			strcat(tagName, field->flags[i].name);
+			strcat(tagName, "|");
+		}
+	}
+	tagName[strlen(tagName) - 1] = '\0';
+
+	return tagName;
+}
+
+/*
+ * Emit tags for fields of struct at page offset structOffset, using the
+ * struct's descriptor.  Pass InvalidBlockNumber as blkno for metapages.
+ */
+static void
+EmitXmlFields(BlockNumber blkno, uint32 level, const StructDesc *desc,
+			  uint32 structOffset)
+{
+	char		tagName[256];
+	int			i;
+	int			j;
+
+	for (i = 0; i < desc->nfields; i++)
+	{
+		const FieldDesc *field = &desc->fields[i];
+		uint32		start = structOffset + field->offset;
+		uint32		end = structOffset + (i + 1 < desc->nfields ?
+										  desc->fields[i + 1].offset :
+										  desc->size);
+
+		if (field->elem)
+		{
+			for (j = 0; j < field->nelems; j++)
+				EmitXmlFields(blkno, level, field->elem,
+							  start + j * field->elem->size);
+			continue;
+		}
+
+		EmitXmlTag(blkno, level, GetFieldTagName(field, buffer + start, tagName),
+				   field->color, pageOffset + start, (pageOffset + end) - 1);
+	}
+}
+
+/*
+ * Dump out a formatted metapage tags for metapage block.
+ */
+static void
+EmitXmlPageMeta(BlockNumber blkno, uint32 level)
+{
+	const StructDesc *desc = GetMetapageDesc(specialType);
+
+	if (desc)
+		EmitXmlFields(InvalidBlockNumber, level, desc,
+					  MAXALIGN(SizeOfPageHeaderData));
+	else if (IsPluginType(specialType))
+		GetPluginAm(specialType)->emitMetapage(buffer, blkno, pageOffset);
+	else
+	{
+		fprintf(stderr, "pg_hexedit error: unsupported metapage special section type \"%s\"\n",
+				GetSpecialSectionString(specialType));
+		exitCode = 1;
+	}
+}
+
+/*
+ * Emit formatted ItemId tags for tuples that reside on this block.
+ */
+static void
+EmitXmlPageItemIdArray(Page page, BlockNumber blkno)
+{
+	int			maxOffset = PageGetMaxOffsetNumber(page);
+	OffsetNumber offset;
+	unsigned int headerBytes;
+
+	headerBytes = offsetof(PageHeaderData, pd_linp[0]);
+
+	/*
+	 * It's either a non-meta index page, or a heap page.  Create tags for all
+	 * ItemId entries/line pointers on page.
+	 */
+	for (offset = FirstOffsetNumber;
+		 offset <= maxOffset;
+		 offset = OffsetNumberNext(offset))
+	{
+		ItemId		itemId;
+		unsigned int itemFlags;
+		char		textFlags[16];
+
+		itemId = PageGetItemId(page, offset);
+
+		itemFlags = (unsigned int) ItemIdGetFlags(itemId);
+
+		switch (itemFlags)
+		{
+			case LP_UNUSED:
+				strcpy(textFlags, "LP_UNUSED");
+				break;
+			case LP_NORMAL:
+				strcpy(textFlags, "LP_NORMAL");
+				break;
+			case LP_REDIRECT:
+				strcpy(textFlags, "LP_REDIRECT");
+				break;
+			case LP_DEAD:
+				strcpy(textFlags, "LP_DEAD");
+				break;
+			default:
+				sprintf(textFlags, "0x%02x", itemFlags);
+				fprintf(stderr, "pg_hexedit error: invalid line pointer flags for (%u,%u): %s\n",
+						blkno + segmentBlockDelta, offset, textFlags);
+				exitCode = 1;
+				break;
+		}
+
+		EmitXmlItemId(blkno, offset, itemId,
+					  pageOffset + headerBytes + (sizeof(ItemIdData) * (offset - 1)),
+					  textFlags);
+	}
+}
+
+/*
+ * Emit formatted tuples that reside on this block.
+ *
+ * This is responsible for emitting tuples from all pages that use an ItemId
+ * array.  This includes heapam, sequences, B-Tree, GiST, hash, regular BRIN
+ * pages, and GIN pages for the main B-Tree over key values (not data/posting
+ * tree pages).  It's also responsible for pending list GIN pages, which are
+ * similar to GIN pages for the main B-Tree.
+ */
+static void
+EmitXmlTuples(Page page, BlockNumber blkno)
+{
+	OffsetNumber offset;
+	int			itemSize;
+	int			itemOffset;
+	ItemId		itemId;
+	int			formatAs;
+	int			maxOffset = PageGetMaxOffsetNumber(page);
+
+	/* Loop through the items on the block */
+	if (maxOffset == 0 ||
+		!CheckMaxOffset(page, blkno, ReportXmlPageProblem, NULL))
+		return;
+
+	/* Use the special section to determine the format style */
+	switch (specialType)
+	{
+		case SPEC_SECT_NONE:
+		case SPEC_SECT_SEQUENCE:
+			formatAs = ITEM_HEAP;
+			break;
+		case SPEC_SECT_INDEX_BTREE:
+		case SPEC_SECT_INDEX_HASH:
+		case SPEC_SECT_INDEX_GIST:
+		case SPEC_SECT_INDEX_GIN:
+			formatAs = ITEM_INDEX;
+			break;
+		case SPEC_SECT_INDEX_SPGIST:
+			if (!SpGistPageIsLeaf(page))
+				formatAs = ITEM_SPG_INN;
+			else
+				formatAs = ITEM_SPG_LEAF;
+			break;
+		case SPEC_SECT_INDEX_BRIN:
+			formatAs = ITEM_BRIN;
+			break;
+		default:
+			if (IsPluginType(specialType))
+			{
+				formatAs = ITEM_PLUGIN;
+				break;
+			}
+			/* Only complain the first time an error like this is seen */
+			if (exitCode == 0)
+				fprintf(stderr, "pg_hexedit error: unsupported special section type \"%s\"\n",
+						GetSpecialSectionString(specialType));
+			formatAs = ITEM_INDEX;
+			exitCode = 1;
+	}
+
+	for (offset = FirstOffsetNumber;
+		 offset <= maxOffset;
+		 offset = OffsetNumberNext(offset))
+	{
+		/*
+		 * Make sure the item has storage that can physically fit on this
+		 * block before formatting
+		 */
+		if (!CheckLinePointer(page, blkno, offset,
+							  Min(blockSize, bytesToFormat),
+							  ReportXmlPageProblem, NULL))
+			continue;
+
+		itemId = PageGetItemId(page, offset);
+		itemSize = (int) ItemIdGetLength(itemId);
+		itemOffset = (int) ItemIdGetOffset(itemId);
+
+		if (formatAs == ITEM_HEAP)
+		{
+			HeapTupleHeader htup;
+
+			htup = (HeapTupleHeader) PageGetItem(page, itemId);
+
+			EmitXmlHeapTuple(blkno, offset, htup,
+							 pageOffset + itemOffset, itemSize);
+		}
+		else if (formatAs == ITEM_INDEX)
+		{
+			IndexTuple	tuple;
+			bool		dead;
+
+			tuple = (IndexTuple) PageGetItem(page, itemId);
+			dead = ItemIdIsDead(itemId);
+
+			EmitXmlIndexTuple(page, blkno, offset, tuple,
+							  pageOffset + itemOffset, itemSize, dead);
+		}
+		else if (formatAs == ITEM_SPG_INN)
+		{
+			SpGistInnerTuple tuple;
+
+			tuple = (SpGistInnerTuple) PageGetItem(page, itemId);
+
+			EmitXmlSpGistInnerTuple(page, blkno, offset, tuple,
+									pageOffset + itemOffset);
+		}
+		else if (formatAs == ITEM_SPG_LEAF)
+		{
+			SpGistLeafTuple tuple;
+
+			tuple = (SpGistLeafTuple) PageGetItem(page, itemId);
+
+			EmitXmlSpGistLeafTuple(page, blkno, offset, tuple,
+								   pageOffset + itemOffset);
+		}
+		else if (formatAs == ITEM_BRIN)
+		{
+			BrinTuple  *tuple;
+
+			tuple = (BrinTuple *) PageGetItem(page, itemId);
+
+			EmitXmlBrinTuple(page, blkno, offset, tuple,
+							 pageOffset + itemOffset, itemSize);
+		}
+		else if (formatAs == ITEM_PLUGIN)
+		{
+			const HexeditPluginAm *am = GetPluginAm(specialType);
+
+			if (am->emitTuple)
+				am->emitTuple(page, blkno, offset, PageGetItem(page, itemId),
+							  pageOffset + itemOffset, itemSize);
+			else
+				EmitXmlTupleTag(blkno, offset, "contents", COLOR_WHITE,
+								pageOffset + itemOffset,
+								(pageOffset + itemOffset + itemSize) - 1);
+		}
+	}
+}
+
+/*
+ * Emit posting tree page pseudo-tuples.
+ *
+ * Posting tree pages don't store regular tuples. Non-leaf pages contain
+ * PostingItems, which are pairs of ItemPointers and child block numbers.  Leaf
+ * pages contain GinPostingLists and an uncompressed array of item pointers.
+ *
+ * In a leaf page, the compressed posting lists are stored after the regular
+ * page header, one after each other.  Although GIN does not store regular
+ * tuples, pd_lower is used to indicate the end of the posting lists. After
+ * that, free space follows.
+ */
+static void
+EmitXmlPostingTreeTids(Page page, BlockNumber blkno)
+{
+	OffsetNumber offsetnum;
+	OffsetNumber maxoff = GinPageGetOpaque(page)->maxoff;
+	unsigned int specialOffset = ((PageHeader) page)->pd_special;
+	unsigned int itemOffset;
+	unsigned int itemOffsetNext;
+
+	Assert(GinPageIsData(page));
+
+	if (!GinPageIsLeaf(page))
+	{
+		itemOffset = GinDataPageGetData(page) - page;
+
+		/* Don't tag PostingItems that a corrupt maxoff puts past the page */
+		if (itemOffset + maxoff * sizeof(PostingItem) > specialOffset)
+		{
+			fprintf(stderr, "pg_hexedit error: GIN posting tree block %u maxoff %u exceeds space for PostingItems\n",
+					blkno + segmentBlockDelta, maxoff);
+			exitCode = 1;
+			maxoff = (specialOffset - itemOffset) / sizeof(PostingItem);
+		}
+
+		for (offsetnum = FirstOffsetNumber;
+			 offsetnum <= maxoff;
+			 offsetnum = OffsetNumberNext(offsetnum))
+		{
+			EmitXmlTupleTag(blkno, offsetnum, "PostingItem->child_blkno->bi_hi", COLOR_BLUE_LIGHT,
+							pageOffset + itemOffset,
+							(pageOffset + itemOffset + sizeof(uint16)) - 1);
+			itemOffset += sizeof(uint16);
+			EmitXmlTupleTag(blkno, offsetnum, "PostingItem->child_blkno->bi_lo", COLOR_BLUE_LIGHT,
+							pageOffset + itemOffset,
+							(pageOffset + itemOffset + sizeof(uint16)) - 1);
+			itemOffset += sizeof(uint16);
+
+			/*
+			 * These TIDs are white because within this page (an internal
+			 * posting tree page) they are keys, not pointers.  This is
+			 * similar to nbtree internal pages (pivot tuples).
+			 */
+			EmitXmlTupleTag(blkno, offsetnum, "PostingItem->key->bi_hi", COLOR_WHITE,
+							pageOffset + itemOffset,
+							(pageOffset + itemOffset + sizeof(uint16)) - 1);
+			itemOffset += sizeof(uint16);
+			EmitXmlTupleTag(blkno, offsetnum, "PostingItem->key->bi_lo", COLOR_WHITE,
+							pageOffset + itemOffset,
+							(pageOffset + itemOffset + sizeof(uint16)) - 1);
+			itemOffset += sizeof(uint16);
+			EmitXmlTupleTag(blkno, offsetnum, "PostingItem->key->offsetNumber", COLOR_WHITE,
+							pageOffset + itemOffset,
+							(pageOffset + itemOffset + sizeof(uint16)) - 1);
+			itemOffset += sizeof(uint16);
+		}
+	}
+	else
+	{
+		GinPostingList *seg,
+				   *nextseg;
+		Pointer		endptr;
+
+		/*
+		 * See description of posting page/data page format at top of
+		 * ginpostlinglist.c for more information.
+		 *
+		 * We don't emit anything for pre-9.4 uncompressed data pages
+		 * versions, since those versions are unsupported by pg_hexedit.  They
+		 * could still be encountered if the database underwent pg_upgrade,
+		 * but that should be rare.
+		 */
+		if (!GinPageIsCompressed(page))
+			return;
+
+		itemOffset = GinDataPageGetData(page) - page;
+		if (((PageHeader) page)->pd_lower < itemOffset ||
+			((PageHeader) page)->pd_lower > specialOffset)
+		{
+			fprintf(stderr, "pg_hexedit error: GIN posting tree block %u pd_lower %u is outside posting list space\n",
+					blkno + segmentBlockDelta, ((PageHeader) page)->pd_lower);
+			exitCode = 1;
+			return;
+		}
+
+		/* Only segments that end by pd_lower are tagged */
+		offsetnum = FirstOffsetNumber;
+		seg = GinDataLeafPageGetPostingList(page);
+		nextseg = GinNextPostingListSegment(seg);
+		itemOffsetNext = itemOffset + ((Pointer) nextseg - (Pointer) seg);
+
+		endptr = ((Pointer) seg) + GinDataLeafPageGetPostingListSize(page);
+		while ((Pointer) nextseg <= endptr)
+		{
+			EmitXmlTupleTag(blkno, offsetnum, "GinPostingList->first->bi_hi", COLOR_BLUE_LIGHT,
+							pageOffset + itemOffset,
+							(pageOffset + itemOffset + sizeof(uint16)) - 1);
+			itemOffset += sizeof(uint16);
+			EmitXmlTupleTag(blkno, offsetnum, "GinPostingList->first->bi_lo", COLOR_BLUE_LIGHT,
+							pageOffset + itemOffset,
+							(pageOffset + itemOffset + sizeof(uint16)) - 1);
+			itemOffset += sizeof(uint16);
+			EmitXmlTupleTag(blkno, offsetnum, "GinPostingList->first->offsetNumber", COLOR_BLUE_DARK,
+							pageOffset + itemOffset,
+							(pageOffset + itemOffset + sizeof(uint16)) - 1);
+			itemOffset += sizeof(uint16);
+
+			/* Make nbytes dark yellow, to match similar IndexTuple metadata */
+			EmitXmlTupleTag(blkno, offsetnum, "GinPostingList->nbytes", COLOR_YELLOW_DARK,
+							pageOffset + itemOffset,
+							(pageOffset + itemOffset + sizeof(uint16)) - 1);
+			itemOffset += sizeof(uint16);
+			/* Compressed TIDs are orange */
+			EmitXmlTupleTag(blkno, offsetnum, "varbyte encoded TIDs", COLOR_ORANGE,
+							pageOffset + itemOffset,
+							(pageOffset + itemOffset + seg->nbytes) - 1);
+			itemOffset = itemOffsetNext;
+			seg = nextseg;
+			nextseg = GinNextPostingListSegment(seg);
+			itemOffsetNext = itemOffset + ((Pointer) nextseg - (Pointer) seg);
+			offsetnum = OffsetNumberNext(offsetnum);
+		}
+	}
+}
+
+/*
+ * Emit hash bitmap page.
+ *
+ * This is just a matter of emitting a single tag for everything after the page
+ * header, but before pd_lower.  Versions of Postgres before 11 left pd_lower
+ * at the end of the page header, so bitmap pages of indexes that were
+ * pg_upgrade'd from them don't get a tag.
+ */
+static void
+EmitXmlHashBitmap(Page page, BlockNumber blkno)
+{
+	PageHeader	pageHeader = (PageHeader) page;
+	uint32		relfileOff = pageOffset + (PageGetContents(page) - page);
+	uint32		relfileOffNext = pageOffset + pageHeader->pd_lower;
+
+	if (pageHeader->pd_lower > pageHeader->pd_special)
+	{
+		fprintf(stderr, "pg_hexedit error: hash bitmap block %u pd_lower %u is past pd_special %u\n",
+				blkno + segmentBlockDelta, pageHeader->pd_lower,
+				pageHeader->pd_special);
+		exitCode = 1;
+		return;
+	}
+	if (relfileOffNext <= relfileOff)
+		return;
+
+	EmitXmlTag(blkno, UINT_MAX, "hash bitmap", COLOR_YELLOW_DARK, relfileOff,
+			   relfileOffNext - 1);
+}
+
+/*
+ * Emit BRIN revmap TIDs as pseudo-tuples.
+ *
+ * BRIN revmap pages don't store an ItemId array, or regular tuples.  Instead,
+ * the page contains an array of straight TIDs.
+ *
+ * We don't look at pd_upper, in keeping with pageinspect's brin_revmap_data(),
+ * which also always emits REVMAP_PAGE_MAXITEMS entries.
+ */
+static void
+EmitXmlRevmap(Page page, BlockNumber blkno)
+{
+	OffsetNumber offsetnum;
+	uint32		relfileOff = pageOffset + (PageGetContents(page) - page);
+	uint32		relfileOffNext;
+
+	for (offsetnum = FirstOffsetNumber;
+		 offsetnum <= REVMAP_PAGE_MAXITEMS;
+		 offsetnum = OffsetNumberNext(offsetnum))
+	{
+		/*
+		 * Emit t_tid tags.  TID tag style should be kept consistent with
+		 * EmitXmlHeapTuple().
+		 *
+		 * Note: We use pseudo offset numbers here.  This is a somewhat
+		 * subjective interpretation of revmap page contents.  We want to
+		 * impose some conventions, even if they aren't particularly well
+		 * justified by struct definitions.
+		 */
+		relfileOffNext = relfileOff + sizeof(uint16);
+		EmitXmlTupleTag(blkno, offsetnum, "rm_tids[i]->bi_hi", COLOR_BLUE_LIGHT, relfileOff,
+						relfileOffNext - 1);
+		relfileOff = relfileOffNext;
+		relfileOffNext += sizeof(uint16);
+		EmitXmlTupleTag(blkno, offsetnum, "rm_tids[i]->bi_lo", COLOR_BLUE_LIGHT, relfileOff,
+						relfileOffNext - 1);
+		relfileOff = relfileOffNext;
+		relfileOffNext += sizeof(uint16);
+		EmitXmlTupleTag(blkno, offsetnum, "rm_tids[i]->offsetNumber", COLOR_BLUE_DARK,
+						relfileOff, relfileOffNext - 1);
+		relfileOff = relfileOffNext;
+	}
+}
+
+/*
+ * On blocks that have special sections, print the contents according to
+ * previously determined special section type.
+ *
+ * Color of special section fields should be COLOR_GREEN_BRIGHT, to match
+ * pd_special field in page header.
+ */
+static void
+EmitXmlSpecial(BlockNumber blkno, uint32 level)
+{
+	PageHeader	pageHeader = (PageHeader) buffer;
+	unsigned int specialOffset = pageHeader->pd_special;
+	const StructDesc *desc = GetSpecialDesc(specialType);
+
+	if (desc)
+		EmitXmlFields(blkno, level, desc, specialOffset);
+	else if (specialType == SPEC_SECT_NONE ||
+			 specialType == SPEC_SECT_ERROR_UNKNOWN ||
+			 specialType == SPEC_SECT_ERROR_BOUNDARY)
+	{
+		fprintf(stderr, "pg_hexedit error: invalid special section type \"%s\"\n",
+				GetSpecialSectionString(specialType));
+		exitCode = 1;
+	}
+	else if (IsPluginType(specialType))
+	{
+		const HexeditPluginAm *am = GetPluginAm(specialType);
+
+		if (am->emitPage)
+			am->emitPage(buffer, blkno, pageOffset);
+		else
+			EmitXmlTag(blkno, level, "special area", COLOR_GREEN_BRIGHT,
+					   pageOffset + specialOffset,
+					   (pageOffset + blockSize) - 1);
+	}
+	else
+	{
+		/* Only complain the first time an error like this is seen */
+		if (exitCode == 0)
+			fprintf(stderr, "pg_hexedit error: unsupported special section type \"%s\"\n",
+					GetSpecialSectionString(specialType));
+		exitCode = 1;
+	}
+}
+
+#ifndef PG_HEXEDIT_EXTENSION
+
+/*
+ * Number of seconds from start to end
+ */
+static double
+TimespecDiffSecs(const struct timespec *end, const struct timespec *start)
+{
+	return (end->tv_sec - start->tv_sec) +
+		(end->tv_nsec - start->tv_nsec) / 1000000000.0;
+}
+
+/*
+ * Refill token bucket for elapsed seconds, and take cost tokens from it.
+ * Caller must hold throttleLock.
+ *
+ * Returns number of seconds that caller must wait before its read.
+ */
+static double
+DrawIoBucket(IoBucket *bucket, double elapsed, double cost)
+{
+	if (bucket->rate <= 0)
+		return 0;
+
+	bucket->tokens = Min(bucket->tokens + elapsed * bucket->rate,
+						 bucket->rate * THROTTLE_BURST_SECS);
+	bucket->tokens -= cost;
+
+	return bucket->tokens < 0 ? -bucket->tokens / bucket->rate : 0;
+}
+
+/*
+ * Called before each read of nbytes from relation file or -T TOAST file.
+ * Sleeps for as long as it takes to stay within --max-rate and --max-iops.
+ * This is a no-op unless at least one of them was specified.
+ */
+static void
+ThrottleIo(uint64 nbytes)
+{
+	struct timespec now;
+	double		elapsed;
+	double		wait;
+	double		opsWait;
+
+	if (maxRate == 0 && maxIops == 0)
+		return;
+
+	pthread_mutex_lock(&throttleLock);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (throttleReads == 0)
+	{
+		throttleStart = throttleRefill = now;
+		throttleBytes.rate = (double) maxRate * 1024 * 1024;
+		throttleBytes.tokens = throttleBytes.rate * THROTTLE_BURST_SECS;
+		throttleOps.rate = maxIops;
+		throttleOps.tokens = throttleOps.rate * THROTTLE_BURST_SECS;
+	}
+	elapsed = TimespecDiffSecs(&now, &throttleRefill);
+	throttleRefill = now;
+
+	wait = DrawIoBucket(&throttleBytes, elapsed, nbytes);
+	opsWait = DrawIoBucket(&throttleOps, elapsed, 1);
+	wait = Max(wait, opsWait);
+	throttleReadBytes += nbytes;
+	throttleReads++;
+	throttleSleepSecs += wait;
+	pthread_mutex_unlock(&throttleLock);
+
+	if (wait > 0)
+	{
+		struct timespec delay;
+
+		delay.tv_sec = (time_t) wait;
+		delay.tv_nsec = (long) ((wait - delay.tv_sec) * 1000000000.0);
+		while (nanosleep(&delay, &delay) != 0 && errno == EINTR)
+			;
+	}
+}
+
+/*
+ * Report the I/O rate that --max-rate and --max-iops actually achieved, so
+ * that it can be compared against their targets
+ */
+static void
+EmitThrottleSummary(void)
+{
+	struct timespec now;
+	double		secs;
+
+	if ((maxRate == 0 && maxIops == 0) || throttleReads == 0)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	secs = Max(TimespecDiffSecs(&now, &throttleStart), 0.001);
+
+	fprintf(stderr, "pg_hexedit notice: read %.1f MB in " UINT64_FORMAT " reads over %.1f seconds (readers slept for %.1f seconds in total)\n",
+			throttleReadBytes / (1024.0 * 1024.0), throttleReads, secs,
+			throttleSleepSecs);
+	if (maxRate > 0)
+		fprintf(stderr, "pg_hexedit notice: actual rate %.2f MB/s is %.0f%% of --max-rate %d MB/s\n",
+				throttleReadBytes / (1024.0 * 1024.0) / secs,
+				100.0 * throttleReadBytes / (1024.0 * 1024.0) / secs / maxRate,
+				maxRate);
+	if (maxIops > 0)
+		fprintf(stderr, "pg_hexedit notice: actual rate %.1f IOPS is %.0f%% of --max-iops %d\n",
+				throttleReads / secs, 100.0 * throttleReads / secs / maxIops,
+				maxIops);
+}
+
+/*
+ * Format a number of seconds as h:mm:ss for --progress
+ */
+static void
+FormatProgressSecs(char *buf, size_t len, double secs)
+{
+	uint64		whole = (secs > 0) ? (uint64) secs : 0;
+
+	snprintf(buf, len, UINT64_FORMAT ":%02u:%02u", whole / 3600,
+			 (unsigned int) (whole / 60 % 60), (unsigned int) (whole % 60));
+}
+
+/*
+ * Start timing --progress, and work out how many blocks the run will process:
+ * every block in the file, or the -R range
+ */
+static void
+ProgressStart(void)
+{
+	struct stat st;
+	uint64		nblocks = 0;
+
+	if (!progressHuman && progressFd < 0)
+		return;
+
+	if (archiveMember)
+		nblocks = (archiveMember->memberSize + blockSize - 1) / blockSize;
+	else if (fp && fstat(fileno(fp), &st) == 0)
+		nblocks = (st.st_size + blockSize - 1) / blockSize;
+
+	if (blockOptions & BLOCK_RANGE)
+	{
+		nblocks = Min(nblocks, (uint64) blockEnd + 1);
+		nblocks = (nblocks > blockStart) ? nblocks - blockStart : 0;
+	}
+
+	progressTotalBlocks = nblocks;
+	clock_gettime(CLOCK_MONOTONIC, &progressStart);
+}
+
+/*
+ * Write a progress report, unless it isn't time for one yet (or another
+ * thread is already writing one).  The final report is always written.
+ */
+static void
+ProgressReport(bool final)
+{
+	struct timespec now;
+	double		elapsed;
+	uint64		blocks;
+	uint64		tags;
+	uint64		output;
+	double		blocksPerSec;
+	double		readRate;
+	double		tagRate;
+	double		eta;
+	char		elapsedBuf[32];
+	char		etaBuf[32];
+
+	if (!progressHuman && progressFd < 0)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = TimespecDiffSecs(&now, &progressStart);
+	if (!final && elapsed < progressNextReport)
+		return;
+
+	if (final)
+		pthread_mutex_lock(&progressLock);
+	else if (pthread_mutex_trylock(&progressLock) != 0)
+		return;
+	else if (elapsed < progressNextReport)
+	{
+		pthread_mutex_unlock(&progressLock);
+		return;
+	}
+	progressNextReport = elapsed + PROGRESS_INTERVAL_SECS;
+
+	blocks = __atomic_load_n(&progressBlocks, __ATOMIC_RELAXED);
+	tags = __atomic_load_n(&progressTags, __ATOMIC_RELAXED);
+	output = __atomic_load_n(&progressOutput, __ATOMIC_RELAXED);
+	elapsed = Max(elapsed, 0.001);
+	blocksPerSec = blocks / elapsed;
+	readRate = blocksPerSec * blockSize / (1024.0 * 1024.0);
+	tagRate = tags / elapsed;
+	eta = 0;
+	if (!final && blocks < progressTotalBlocks)
+		eta = (blocksPerSec > 0) ?
+			(progressTotalBlocks - blocks) / blocksPerSec : -1;
+	FormatProgressSecs(elapsedBuf, sizeof(elapsedBuf), elapsed);
+	if (eta >= 0)
+		FormatProgressSecs(etaBuf, sizeof(etaBuf), eta);
+	else
+		strlcpy(etaBuf, "unknown", sizeof(etaBuf));
+
+	if (progressHuman)
+	{
+		fprintf(stderr, "pg_hexedit progress: " UINT64_FORMAT "/" UINT64_FORMAT " blocks (%.1f%%), %.1f MB/s read",
+				blocks, progressTotalBlocks,
+				progressTotalBlocks > 0 ?
+				Min(100.0, 100.0 * blocks / progressTotalBlocks) : 100.0,
+				readRate);
+		if (maxRate > 0)
+			fprintf(stderr, " (%.0f%% of --max-rate)",
+					100.0 * readRate / maxRate);
+		fprintf(stderr, ", %.0f tags/s, %.1f MB written, %s elapsed, %s%s\n",
+				tagRate, output / (1024.0 * 1024.0), elapsedBuf,
+				final ? "done" : "ETA ", final ? "" : etaBuf);
+	}
+	if (progressFd >= 0)
+		dprintf(progressFd, "progress blocks_done=" UINT64_FORMAT " blocks_total=" UINT64_FORMAT " read_mb_per_sec=%.2f tags_per_sec=%.0f output_bytes=" UINT64_FORMAT " elapsed_secs=%.1f eta_secs=%.0f max_rate_mb_per_sec=%d done=%d\n",
+				blocks, progressTotalBlocks, readRate, tagRate, output,
+				elapsed, eta, maxRate, final ? 1 : 0);
+
+	pthread_mutex_unlock(&progressLock);
+}
+
+/*
+ * Count blocks that were just processed, along with the tags and output
+ * bytes that they produced, for --progress.  This is cheap enough to call
+ * once per block from any thread.
+ */
+static void
+ProgressAdvance(uint64 nblocks, uint64 ntags, uint64 nbytes)
+{
+	uint64		blocks;
+
+	if (!progressHuman && progressFd < 0)
+		return;
+
+	if (ntags > 0)
+		__atomic_add_fetch(&progressTags, ntags, __ATOMIC_RELAXED);
+	if (nbytes > 0)
+		__atomic_add_fetch(&progressOutput, nbytes, __ATOMIC_RELAXED);
+	blocks = __atomic_add_fetch(&progressBlocks, nblocks, __ATOMIC_RELAXED);
+
+	if (nblocks > 0 && blocks % PROGRESS_CHECK_BLOCKS < nblocks)
+		ProgressReport(false);
+}
+
+/*
+ * Tell user that --direct-io could not use O_DIRECT.  Only called once, by
+ * whichever thread finds out first.
+ */
+static void
+NoticeDirectIoFallback(void)
+{
+	fprintf(stderr, "pg_hexedit notice: O_DIRECT is not supported for file \"%s\", so --direct-io will drop blocks from the page cache after reading them instead\n",
+			fileName);
+}
+
+/*
+ * Open a --direct-io reader for the relation file.  Each reader has its own
+ * file descriptor, so it can be used by any one thread.
+ *
+ * Returns false if the file could not be opened.
+ */
+static bool
+BlockReaderOpen(BlockReader *reader)
+{
+	struct stat st;
+
+	reader->direct = (PG_HEXEDIT_O_DIRECT != 0);
+	reader->fd = open(fileName, O_RDONLY | PG_HEXEDIT_O_DIRECT);
+
+	/* File systems such as tmpfs refuse O_DIRECT when the file is opened */
+	if (reader->fd < 0 && reader->direct && errno == EINVAL)
+	{
+		reader->direct = false;
+		reader->fd = open(fileName, O_RDONLY);
+	}
+
+	if (reader->fd < 0)
+	{
+		fprintf(stderr, "pg_hexedit error: could not open file \"%s\": %s\n",
+				fileName, strerror(errno));
+		exitCode = 1;
+		return false;
+	}
+
+	if (!reader->direct)
+		pthread_once(&directIoNoticeOnce, NoticeDirectIoFallback);
+
+	if (fstat(reader->fd, &st) != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: could not stat file \"%s\": %s\n",
+				fileName, strerror(errno));
+		exitCode = 1;
+		close(reader->fd);
+		return false;
+	}
+	reader->fileSize = st.st_size;
+
+	reader->unaligned = (char *) pg_malloc(DIRECT_IO_READ_SIZE + DIRECT_IO_ALIGN);
+	reader->buf = (char *) TYPEALIGN(DIRECT_IO_ALIGN, reader->unaligned);
+	reader->bufStart = 0;
+	reader->bufLen = 0;
+
+	return true;
+}
+
+/*
+ * Copy block blkno into page using a --direct-io reader.  When the block isn't
+ * already in the reader's buffer, the buffer is refilled with a single large
+ * read that starts at the block, and extends no further than the end of
+ * lastBlkno, or the end of the file.
+ *
+ * Returns the number of bytes copied, which is less than blockSize at the end
+ * of the file, or -1 on a read error.
+ */
+static ssize_t
+BlockReaderRead(BlockReader *reader, char *page, BlockNumber blkno,
+				BlockNumber lastBlkno)
+{
+	off_t		offset = (off_t) blkno * blockSize;
+	off_t		available;
+
+	if (offset < reader->bufStart ||
+		offset + blockSize > reader->bufStart + (off_t) reader->bufLen)
+	{
+		off_t		readStart = TYPEALIGN_DOWN(DIRECT_IO_ALIGN, offset);
+		off_t		readEnd;
+		ssize_t		bytesRead;
+
+		/* Blocks before the read cursor won't be needed again */
+#if defined(USE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
+		if (!reader->direct && reader->bufLen > 0)
+			(void) posix_fadvise(reader->fd, reader->bufStart, reader->bufLen,
+								 POSIX_FADV_DONTNEED);
+#endif
+
+		readEnd = (off_t) TYPEALIGN(DIRECT_IO_ALIGN,
+									((off_t) lastBlkno + 1) * blockSize);
+		readEnd = Min(readEnd, readStart + DIRECT_IO_READ_SIZE);
+		readEnd = Min(readEnd, (off_t) TYPEALIGN(DIRECT_IO_ALIGN,
+												 reader->fileSize));
+		if (readEnd <= readStart)
+			return 0;
+
+		ThrottleIo(readEnd - readStart);
+		bytesRead = pg_pread(reader->fd, reader->buf, readEnd - readStart,
+							 readStart);
+
+		/*
+		 * Some file systems accept O_DIRECT when the file is opened, but not
+		 * when it is read.  Fall back on buffered reads in that case.
+		 */
+		if (bytesRead < 0 && reader->direct && errno == EINVAL &&
+			fcntl(reader->fd, F_SETFL,
+				  fcntl(reader->fd, F_GETFL) & ~PG_HEXEDIT_O_DIRECT) == 0)
+		{
+			reader->direct = false;
+			pthread_once(&directIoNoticeOnce, NoticeDirectIoFallback);
+			bytesRead = pg_pread(reader->fd, reader->buf, readEnd - readStart,
+								 readStart);
+		}
+
+		if (bytesRead < 0)
+		{
+			reader->bufLen = 0;
+			return -1;
+		}
+
+		reader->bufStart = readStart;
+		reader->bufLen = bytesRead;
+	}
+
+	available = reader->bufStart + (off_t) reader->bufLen - offset;
+	if (available <= 0)
+		return 0;
+	available = Min(available, blockSize);
+	memcpy(page, reader->buf + (offset - reader->bufStart), available);
+
+	return available;
+}
+
+/*
+ * Close a --direct-io reader
+ */
+static void
+BlockReaderClose(BlockReader *reader)
+{
+#if defined(USE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
+	if (!reader->direct && reader->bufLen > 0)
+		(void) posix_fadvise(reader->fd, reader->bufStart, reader->bufLen,
+							 POSIX_FADV_DONTNEED);
+#endif
+	close(reader->fd);
+	pg_free(reader->unaligned);
+}
+
+/*
+ * Tell user that --queue-depth could not use io_uring.  Only called once, by
+ * whichever thread finds out first.
+ */
+static void
+NoticeReadAheadFallback(void)
+{
+	fprintf(stderr, "pg_hexedit notice: io_uring is not available (%s), so --queue-depth will use reader threads instead\n",
+			strerror(ioUringErrno));
+}
+
+/*
+ * --queue-depth reader thread.  Reads the next block whenever its slot is
+ * free, until told to exit.
+ */
+static void *
+ReadAheadWorkerMain(void *arg)
+{
+	ReadAhead  *ra = (ReadAhead *) arg;
+
+	pthread_mutex_lock(&ra->lock);
+	for (;;)
+	{
+		BlockNumber blkno;
+		int			slot;
+		ssize_t		bytesRead;
+
+		while (!ra->shutdown &&
+			   (ra->nextRead > ra->last ||
+				ra->nextRead >= ra->nextDeliver + ra->depth))
+			pthread_cond_wait(&ra->changed, &ra->lock);
+		if (ra->shutdown)
+			break;
+
+		blkno = ra->nextRead++;
+		slot = blkno % ra->depth;
+		pthread_mutex_unlock(&ra->lock);
+
+		ThrottleIo(blockSize);
+		bytesRead = pg_pread(ra->fd, ra->slots + (size_t) slot * blockSize,
+							 blockSize, (off_t) blkno * blockSize);
+		if (bytesRead < 0)
+			bytesRead = -errno;
+
+		pthread_mutex_lock(&ra->lock);
+		ra->results[slot] = bytesRead;
+		ra->ready[slot] = true;
+		pthread_cond_broadcast(&ra->changed);
+	}
+	pthread_mutex_unlock(&ra->lock);
+
+	return NULL;
+}
+
+#ifdef USE_IO_URING
+/*
+ * Set up io_uring submission and completion rings for read-ahead pipeline.
+ * liburing isn't used, so that there is no extra build dependency.
+ *
+ * Returns false (with ioUringErrno set) if the kernel or its configuration
+ * doesn't allow io_uring.
+ */
+static bool
+ReadAheadSetupRing(ReadAhead *ra)
+{
+	struct io_uring_params params;
+	int			slot;
+
+	memset(&params, 0, sizeof(params));
+	ra->ringFd = syscall(__NR_io_uring_setup, ra->depth, &params);
+	if (ra->ringFd < 0)
+	{
+		ioUringErrno = errno;
+		ra->ringFd = -1;
+		return false;
+	}
+
+	ra->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ra->cqRingSize = params.cq_off.cqes +
+		params.cq_entries * sizeof(struct io_uring_cqe);
+	ra->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	ra->sqRing = mmap(NULL, ra->sqRingSize, PROT_READ | PROT_WRITE,
+					  MAP_SHARED | MAP_POPULATE, ra->ringFd,
+					  IORING_OFF_SQ_RING);
+	ra->cqRing = mmap(NULL, ra->cqRingSize, PROT_READ | PROT_WRITE,
+					  MAP_SHARED | MAP_POPULATE, ra->ringFd,
+					  IORING_OFF_CQ_RING);
+	ra->sqes = mmap(NULL, ra->sqesSize, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, ra->ringFd, IORING_OFF_SQES);
+	if (ra->sqRing == MAP_FAILED || ra->cqRing == MAP_FAILED ||
+		ra->sqes == MAP_FAILED)
+	{
+		ioUringErrno = errno;
+		if (ra->sqRing != MAP_FAILED)
+			munmap(ra->sqRing, ra->sqRingSize);
+		if (ra->cqRing != MAP_FAILED)
+			munmap(ra->cqRing, ra->cqRingSize);
+		if (ra->sqes != MAP_FAILED)
+			munmap(ra->sqes, ra->sqesSize);
+		close(ra->ringFd);
+		ra->ringFd = -1;
+		return false;
+	}
+
+	ra->sqHead = (unsigned *) ((char *) ra->sqRing + params.sq_off.head);
+	ra->sqTail = (unsigned *) ((char *) ra->sqRing + params.sq_off.tail);
+	ra->sqMask = (unsigned *) ((char *) ra->sqRing + params.sq_off.ring_mask);
+	ra->sqArray = (unsigned *) ((char *) ra->sqRing + params.sq_off.array);
+	ra->cqHead = (unsigned *) ((char *) ra->cqRing + params.cq_off.head);
+	ra->cqTail = (unsigned *) ((char *) ra->cqRing + params.cq_off.tail);
+	ra->cqMask = (unsigned *) ((char *) ra->cqRing + params.cq_off.ring_mask);
+	ra->cqes = (struct io_uring_cqe *) ((char *) ra->cqRing +
+										params.cq_off.cqes);
+
+	ra->iovecs = (struct iovec *) pg_malloc(sizeof(struct iovec) * ra->depth);
+	for (slot = 0; slot < ra->depth; slot++)
+	{
+		ra->iovecs[slot].iov_base = ra->slots + (size_t) slot * blockSize;
+		ra->iovecs[slot].iov_len = blockSize;
+	}
+	ra->inFlight = 0;
+
+	return true;
+}
+
+/*
+ * Record the results of every io_uring read that has completed
+ */
+static void
+ReadAheadReap(ReadAhead *ra)
+{
+	unsigned	head = *ra->cqHead;
+
+	while (head != __atomic_load_n(ra->cqTail, __ATOMIC_ACQUIRE))
+	{
+		struct io_uring_cqe *cqe = &ra->cqes[head & *ra->cqMask];
+		int			slot = cqe->user_data % ra->depth;
+
+		ra->results[slot] = cqe->res;
+		ra->ready[slot] = true;
+		ra->inFlight--;
+		head++;
+	}
+	__atomic_store_n(ra->cqHead, head, __ATOMIC_RELEASE);
+}
+#endif
+
+/*
+ * Open a --queue-depth read-ahead pipeline for blocks first through last of
+ * the relation file (or through its last block, when last is past the end of
+ * the file).  Each pipeline has its own file descriptor, so it can be used by
+ * any one thread.
+ *
+ * Returns false if the pipeline could not be set up.
+ */
+static bool
+ReadAheadOpen(ReadAhead *ra, BlockNumber first, BlockNumber last)
+{
+	struct stat st;
+	BlockNumber nblocks;
+	int			i;
+
+	memset(ra, 0, sizeof(ReadAhead));
+	ra->ringFd = -1;
+	ra->depth = readAheadDepth;
+
+	/* O_DIRECT reads into each slot must be aligned */
+	ra->direct = (blockOptions & BLOCK_DIRECT_IO) &&
+		PG_HEXEDIT_O_DIRECT != 0 && blockSize % DIRECT_IO_ALIGN == 0;
+	ra->fd = open(fileName, O_RDONLY | (ra->direct ? PG_HEXEDIT_O_DIRECT : 0));
+	if (ra->fd < 0 && ra->direct && errno == EINVAL)
+	{
+		ra->direct = false;
+		ra->fd = open(fileName, O_RDONLY);
+	}
+
+	if (ra->fd < 0 || fstat(ra->fd, &st) != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: could not open file \"%s\": %s\n",
+				fileName, strerror(errno));
+		exitCode = 1;
+		if (ra->fd >= 0)
+			close(ra->fd);
+		return false;
+	}
+
+	if ((blockOptions & BLOCK_DIRECT_IO) && !ra->direct)
+		pthread_once(&directIoNoticeOnce, NoticeDirectIoFallback);
+
+	/* Include a partial block at the end of the file */
+	nblocks = (st.st_size + blockSize - 1) / blockSize;
+	ra->nextRead = ra->nextDeliver = first;
+	ra->last = (nblocks == 0) ? 0 : Min(last, nblocks - 1);
+	if (nblocks == 0 || first > ra->last)
+		ra->nextRead = ra->nextDeliver = ra->last + 1;
+
+	ra->unaligned = (char *) pg_malloc((size_t) ra->depth * blockSize +
+									   DIRECT_IO_ALIGN);
+	ra->slots = (char *) TYPEALIGN(DIRECT_IO_ALIGN, ra->unaligned);
+	ra->results = (ssize_t *) pg_malloc0(sizeof(ssize_t) * ra->depth);
+	ra->ready = (bool *) pg_malloc0(sizeof(bool) * ra->depth);
+	pthread_mutex_init(&ra->lock, NULL);
+	pthread_cond_init(&ra->changed, NULL);
+
+#ifdef USE_IO_URING
+	if (ReadAheadSetupRing(ra))
+		return true;
+#else
+	ioUringErrno = ENOSYS;
+#endif
+	pthread_once(&readAheadNoticeOnce, NoticeReadAheadFallback);
+
+	ra->threads = (pthread_t *) pg_malloc(sizeof(pthread_t) * ra->depth);
+	for (i = 0; i < ra->depth; i++)
+	{
+		if (pthread_create(&ra->threads[i], NULL, ReadAheadWorkerMain,
+						   ra) != 0)
+			break;
+		ra->nthreads++;
+	}
+
+	if (ra->nthreads == 0)
+	{
+		fprintf(stderr, "pg_hexedit error: could not create --queue-depth reader thread\n");
+		exitCode = 1;
+		ReadAheadClose(ra);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Copy the next block from a --queue-depth read-ahead pipeline into page,
+ * after issuing reads for as many of the blocks after it as its free slots
+ * allow.
+ *
+ * Returns the number of bytes copied, which is less than blockSize for a
+ * partial block at the end of the file, and 0 once there are no more blocks.
+ * Returns -1 (with errno set) on a read error.
+ */
+static ssize_t
+ReadAheadNext(ReadAhead *ra, char *page)
+{
+	int			slot;
+	ssize_t		bytesRead;
+
+	if (ra->nextDeliver > ra->last)
+		return 0;
+	slot = ra->nextDeliver % ra->depth;
+
+	if (ra->ringFd < 0)
+	{
+		pthread_mutex_lock(&ra->lock);
+		while (!ra->ready[slot])
+			pthread_cond_wait(&ra->changed, &ra->lock);
+		pthread_mutex_unlock(&ra->lock);
+	}
+#ifdef USE_IO_URING
+	else
+	{
+		for (;;)
+		{
+			unsigned	tail = *ra->sqTail;
+			unsigned	toSubmit;
+			bool		ready;
+
+			while (ra->nextRead <= ra->last &&
+				   ra->nextRead < ra->nextDeliver + ra->depth)
+			{
+				BlockNumber blkno = ra->nextRead++;
+				unsigned	index = tail & *ra->sqMask;
+				struct io_uring_sqe *sqe = &ra->sqes[index];
+
+				ThrottleIo(blockSize);
+				memset(sqe, 0, sizeof(struct io_uring_sqe));
+				sqe->opcode = IORING_OP_READV;
+				sqe->fd = ra->fd;
+				sqe->off = (uint64) blkno * blockSize;
+				sqe->addr = (uint64) (uintptr_t) &ra->iovecs[blkno % ra->depth];
+				sqe->len = 1;
+				sqe->user_data = blkno;
+				ra->sqArray[index] = index;
+				tail++;
+				ra->inFlight++;
+			}
+			__atomic_store_n(ra->sqTail, tail, __ATOMIC_RELEASE);
+
+			toSubmit = tail - __atomic_load_n(ra->sqHead, __ATOMIC_ACQUIRE);
+			ready = ra->ready[slot];
+			if ((toSubmit > 0 || !ready) &&
+				syscall(__NR_io_uring_enter, ra->ringFd, toSubmit,
+						ready ? 0 : 1, ready ? 0 : IORING_ENTER_GETEVENTS,
+						NULL, 0) < 0 &&
+				errno != EINTR && errno != EAGAIN && errno != EBUSY)
+				return -1;
+
+			ReadAheadReap(ra);
+			if (ra->ready[slot])
+				break;
+		}
+	}
+#endif
+
+	bytesRead = ra->results[slot];
+	if (bytesRead > 0)
+		memcpy(page, ra->slots + (size_t) slot * blockSize, bytesRead);
+
+#if defined(USE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
+	if ((blockOptions & BLOCK_DIRECT_IO) && !ra->direct)
+		(void) posix_fadvise(ra->fd, (off_t) ra->nextDeliver * blockSize,
+							 blockSize, POSIX_FADV_DONTNEED);
+#endif
+
+	/* Free the slot */
+	if (ra->ringFd < 0)
+		pthread_mutex_lock(&ra->lock);
+	ra->ready[slot] = false;
+	ra->nextDeliver++;
+	if (ra->ringFd < 0)
+	{
+		pthread_cond_broadcast(&ra->changed);
+		pthread_mutex_unlock(&ra->lock);
+	}
+
+	if (bytesRead < 0)
+	{
+		errno = -bytesRead;
+		return -1;
+	}
+
+	return bytesRead;
+}
+
+/*
+ * Close a --queue-depth read-ahead pipeline, once every read still in flight
+ * has completed
+ */
+static void
+ReadAheadClose(ReadAhead *ra)
+{
+	int			i;
+
+#ifdef USE_IO_URING
+	if (ra->ringFd >= 0)
+	{
+		while (ra->inFlight > 0)
+		{
+			if (syscall(__NR_io_uring_enter, ra->ringFd, 0, 1,
+						IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+				errno != EINTR)
+				break;
+			ReadAheadReap(ra);
+		}
+		munmap(ra->sqRing, ra->sqRingSize);
+		munmap(ra->cqRing, ra->cqRingSize);
+		munmap(ra->sqes, ra->sqesSize);
+		close(ra->ringFd);
+		pg_free(ra->iovecs);
+	}
+#endif
+
+	pthread_mutex_lock(&ra->lock);
+	ra->shutdown = true;
+	pthread_cond_broadcast(&ra->changed);
+	pthread_mutex_unlock(&ra->lock);
+	for (i = 0; i < ra->nthreads; i++)
+		pthread_join(ra->threads[i], NULL);
+	if (ra->threads)
+		pg_free(ra->threads);
+
+	pthread_mutex_destroy(&ra->lock);
+	pthread_cond_destroy(&ra->changed);
+	close(ra->fd);
+	pg_free(ra->unaligned);
+	pg_free(ra->results);
+	pg_free(ra->ready);
+}
+
+/*
+ * Dump the main body of XML tags (does not include header, header comments, or
+ * footer.)
+ */
+static void
+EmitXmlBody(void)
+{
+	unsigned int initialRead = 1;
+	unsigned int contentsToDump = 1;
+	BlockNumber lastBlock = (blockOptions & BLOCK_RANGE) ?
+	blockEnd : MaxBlockNumber;
+	BlockReader reader;
+	ReadAhead	readAhead;
+	bool		readAheadIo = readAheadDepth > 0;
+	bool		directIo = !readAheadIo &&
+	(blockOptions & BLOCK_DIRECT_IO) != 0;
+
+	if (readAheadIo &&
+		!ReadAheadOpen(&readAhead,
+					   (blockOptions & BLOCK_RANGE) ? blockStart : 0,
+					   lastBlock))
+		return;
+	if (directIo && !BlockReaderOpen(&reader))
+		return;
+
+	/*
+	 * If the user requested a block range, seek to the correct position
+	 * within the file for the start block.
+	 */
+	if (blockOptions & BLOCK_RANGE)
+	{
+		unsigned int position = blockSize * blockStart;
+
+		if (fseek(fp, position, SEEK_SET) != 0)
+		{
+			fprintf(stderr, "pg_hexedit error: seek error encountered before requested start block %d\n",
+					blockStart);
+			contentsToDump = 0;
+			exitCode = 1;
+		}
+		else
+			currentBlock = blockStart;
+	}
+
+	/*
+	 * Iterate through the blocks in the file until you reach the end or the
+	 * requested range end
+	 */
+	while (contentsToDump)
+	{
+		unsigned int blockTagNumber = tagNumber;
+		uint64		blockTagBytes = xmlTagBytes;
+
+		if (readAheadIo || directIo)
+		{
+			ssize_t		bytesRead;
+
+			if (readAheadIo)
+				bytesRead = ReadAheadNext(&readAhead, buffer);
+			else
+				bytesRead = BlockReaderRead(&reader, buffer, currentBlock,
+											lastBlock);
+			if (bytesRead < 0)
+			{
+				fprintf(stderr, "pg_hexedit error: could not read block %u: %s\n",
+						currentBlock, strerror(errno));
+				exitCode = 1;
+				break;
+			}
+			bytesToFormat = bytesRead;
+		}
+		else
+		{
+			ThrottleIo(blockSize);
+			bytesToFormat = fread(buffer, 1, blockSize, fp);
+		}
+
+		if (bytesToFormat == 0)
+		{
+			/*
+			 * fseek() won't pop an error if you seek passed eof.  The next
+			 * subsequent read gets the error.
+			 */
+			if (initialRead)
+			{
+				fprintf(stderr, "pg_hexedit error: premature end of file encountered\n");
+				exitCode = 1;
+			}
+			contentsToDump = 0;
+		}
+		else if (sessionFileName)
+		{
+			int			savedExitCode = exitCode;
+
+			/* Bookmark block when emitting its tags raised an error */
+			exitCode = 0;
+			EmitXmlPage(currentBlock);
+			if (exitCode != 0 &&
+				nsessionErrorBlocks < MAX_SESSION_ERROR_PAGES)
+				sessionErrorBlocks[nsessionErrorBlocks++] = currentBlock;
+			exitCode |= savedExitCode;
+		}
+		else
+			EmitXmlPage(currentBlock);
+
+		if (bytesToFormat > 0)
+			ProgressAdvance(1, tagNumber - blockTagNumber,
+							xmlTagBytes - blockTagBytes);
+
+		/* Check to see if we are at the end of the requested range. */
+		if ((blockOptions & BLOCK_RANGE) &&
+			(currentBlock >= blockEnd) && (contentsToDump))
+		{
+			contentsToDump = 0;
+		}
+		else
+			currentBlock++;
+
+		initialRead = 0;
+	}
+
+	if (readAheadIo)
+		ReadAheadClose(&readAhead);
+	if (directIo)
+		BlockReaderClose(&reader);
+}
+
+/*
+ * Does page have line pointers?  This is true of the same pages that
+ * EmitXmlPage() passes to EmitXmlTuples(), so WalkPage() doesn't visit the
+ * items of metapages, deleted pages, GIN posting tree pages and the like.
+ * Caller must set specialType and bytesToFormat for page first.
+ */
+static bool
+PageHasLinePointers(Page page, BlockNumber blkno)
+{
+	/* Metapages (see EmitXmlPage()) */
+	if (blkno == 0 && segmentNumber == 0 &&
+		specialType != SPEC_SECT_NONE &&
+		specialType != SPEC_SECT_INDEX_GIST &&
+		specialType != SPEC_SECT_SEQUENCE &&
+		!PluginLacksMetapage(specialType))
+		return false;
+
+	switch (specialType)
+	{
+		case SPEC_SECT_INDEX_BTREE:
+			return !P_ISDELETED((BTPageOpaque) PageGetSpecialPointer(page));
+		case SPEC_SECT_INDEX_HASH:
+			return !IsHashBitmapPage(page);
+		case SPEC_SECT_INDEX_GIST:
+			return !GistPageIsDeleted(page);
+		case SPEC_SECT_INDEX_GIN:
+			return !GinPageIsDeleted(page) && !GinPageIsData(page);
+		case SPEC_SECT_INDEX_BRIN:
+			return !BRIN_IS_REVMAP_PAGE(page);
+		default:
+			if (IsPluginType(specialType))
+				return PluginPageHasTuples(page, blkno);
+			return true;
+	}
+}
+
+/*
+ * Locate leading nattrs attributes of heap tuple, whose header is sane,
+ * passing each one to visitor
+ */
+static void
+WalkHeapTupleAttributes(BlockNumber blkno, OffsetNumber offset,
+						HeapTupleHeader htup, unsigned int itemSize,
+						int nattrs, const PageVisitor *visitor, void *arg)
+{
+	int			natts = HeapTupleHeaderGetNatts(htup);
+	bits8	   *t_bits = NULL;
+	unsigned char *tupdata = (unsigned char *) htup + htup->t_hoff;
+	int			datalen = itemSize - htup->t_hoff;
+	int			off = 0;
+	int			badAttnum = -1;
+	int			i;
+
+	if (htup->t_infomask & HEAP_HASNULL)
+		t_bits = htup->t_bits;
+
+	for (i = 0; i < nattrs; i++)
+	{
+		AttributeSpan span;
+
+		if (!LocateAttribute(tupdata, t_bits, natts, datalen, i, &off,
+							 &span) ||
+			(visitor->onAttribute &&
+			 !visitor->onAttribute(blkno, offset, i, &span, arg)))
+		{
+			badAttnum = i;
+			break;
+		}
+	}
+
+	if (visitor->onHeapTupleEnd)
+		visitor->onHeapTupleEnd(blkno, offset, badAttnum, arg);
+}
+
+/*
+ * Visit the items of page, whose line pointer array is known to fit.  Line
+ * pointers and heap tuple headers are checked using the same routines that
+ * EmitXmlPage() and --check use.
+ */
+static void
+WalkPageItems(Page page, BlockNumber blkno, const PageVisitor *visitor,
+			  void *arg)
+{
+	int			maxOffset = PageGetMaxOffsetNumber(page);
+	OffsetNumber offset;
+
+	for (offset = FirstOffsetNumber;
+		 offset <= maxOffset;
+		 offset = OffsetNumberNext(offset))
+	{
+		ItemId		itemId = PageGetItemId(page, offset);
+		unsigned int itemSize = ItemIdGetLength(itemId);
+		unsigned int itemOffset = ItemIdGetOffset(itemId);
+		bool		hasStorage;
+
+		hasStorage = CheckLinePointer(page, blkno, offset, blockSize,
+									  visitor->onProblem, arg);
+		if ((visitor->onItemId &&
+			 !visitor->onItemId(page, blkno, offset, itemId, hasStorage,
+								arg)) ||
+			!hasStorage)
+			continue;
+
+		if (specialType == SPEC_SECT_NONE || specialType == SPEC_SECT_SEQUENCE)
+		{
+			HeapTupleHeader htup = (HeapTupleHeader) PageGetItem(page, itemId);
+			int			nattrs = 0;
+
+			if (!CheckHeapTupleHeader(page, blkno, offset, itemOffset,
+									  itemSize, visitor->onProblem, arg))
+				continue;
+
+			if (visitor->onHeapTuple)
+				nattrs = visitor->onHeapTuple(page, blkno, offset, htup,
+											  itemSize, arg);
+			if (nattrs > 0)
+				WalkHeapTupleAttributes(blkno, offset, htup, itemSize,
+										Min(nattrs, nrelatts), visitor, arg);
+		}
+		else if (visitor->onIndexTuple &&
+				 (specialType == SPEC_SECT_INDEX_BTREE ||
+				  specialType == SPEC_SECT_INDEX_HASH ||
+				  specialType == SPEC_SECT_INDEX_GIST ||
+				  specialType == SPEC_SECT_INDEX_GIN))
+			visitor->onIndexTuple(page, blkno, offset,
+								  (IndexTuple) PageGetItem(page, itemId),
+								  itemSize, arg);
+	}
+}
+
+/*
+ * Walk page at file block blkno on behalf of visitor.  Every page that isn't
+ * new has its header checked before visitor sees it.  Only the items of pages
+ * that have line pointers are visited, and only when the line pointer array
+ * fits on the page, even if visitor walks pages whose header isn't otherwise
+ * sane.  Anomalies are reported through visitor's onProblem callback.
+ */
+static void
+WalkPage(Page page, BlockNumber blkno, const PageVisitor *visitor, void *arg)
+{
+	char	   *savedBuffer = buffer;
+	unsigned int savedBytesToFormat = bytesToFormat;
+	unsigned int savedSpecialType = specialType;
+	bool		sane = false;
+
+	/* Workers use their own page, not buffer */
+	buffer = (char *) page;
+	bytesToFormat = blockSize;
+	specialType = SPEC_SECT_NONE;
+	if (!PageIsNew(page))
+	{
+		sane = CheckPageHeader(page, blkno, visitor->onProblem, arg);
+		specialType = GetSpecialSectionType(page);
+	}
+
+	if (!visitor->onPage || visitor->onPage(page, blkno, sane, arg))
+	{
+		if (PageHasLinePointers(page, blkno) &&
+			CheckMaxOffset(page, blkno, visitor->onProblem, arg))
+			WalkPageItems(page, blkno, visitor, arg);
+
+		if (visitor->onPageEnd)
+			visitor->onPageEnd(page, blkno, arg);
+	}
+
+	buffer = savedBuffer;
+	bytesToFormat = savedBytesToFormat;
+	specialType = savedSpecialType;
+}
+
+/*
+ * Parallel block scan worker.  Claims batches of blocks until none remain,
+ * reading each block into a private buffer with pg_pread() (or a private
+ * --direct-io reader), so that none of the global state used when emitting
+ * tags (buffer, currentBlock, etc) is touched.  Each block is passed to
+ * WalkPage() with the worker's visitor.
+ */
+static void *
+ScanWorkerMain(void *arg)
+{
+	ScanWorker *worker = (ScanWorker *) arg;
+	char	   *page = (char *) pg_malloc(blockSize);
+	int			fd = worker->fd;
+	BlockReader reader;
+	bool		directIo = (blockOptions & BLOCK_DIRECT_IO) != 0;
+
+	if (directIo && !BlockReaderOpen(&reader))
+	{
+		pg_free(page);
+		return NULL;
+	}
+
+	for (;;)
+	{
+		BlockNumber first;
+		BlockNumber last;
+		BlockNumber blkno;
+
+		pthread_mutex_lock(&scanLock);
+		first = scanNextBlock;
+		last = Min(first + SCAN_BATCH_BLOCKS - 1, scanLastBlock);
+		scanNextBlock = last + 1;
+		pthread_mutex_unlock(&scanLock);
+
+		if (first > scanLastBlock)
+			break;
+
+		for (blkno = first; blkno <= last; blkno++)
+		{
+			ssize_t		bytesRead;
+
+			if (directIo)
+				bytesRead = BlockReaderRead(&reader, page, blkno, last);
+			else
+			{
+				ThrottleIo(blockSize);
+				bytesRead = pg_pread(fd, page, blockSize,
+									 (off_t) blkno * blockSize);
+			}
+			if (bytesRead != blockSize)
+			{
+				fprintf(stderr, "pg_hexedit error: could not read block %u (read %zd bytes)\n",
+						blkno, bytesRead);
+				exitCode = 1;
+				continue;
+			}
+
+			if ((blockOptions & BLOCK_SKIP_LSN) &&
+				GetPageLsn((Page) page) < afterThreshold)
+				continue;
+
+			WalkPage((Page) page, blkno, worker->visitor, worker->state);
+		}
+
+		ProgressAdvance(last - first + 1, 0, 0);
+	}
+
+	if (directIo)
+		BlockReaderClose(&reader);
+	pg_free(page);
+
+	return NULL;
+}
+
+/*
+ * Determine the first and last file block that a parallel block scan visits:
+ * every block in the file, or the -R range.
+ *
+ * Returns false if there are no blocks to scan.
+ */
+static bool
+GetScanRange(BlockNumber *first, BlockNumber *last)
+{
+	struct stat st;
+	BlockNumber nblocks;
+
+	if (fstat(fileno(fp), &st) != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: could not stat file \"%s\"\n",
+				fileName);
+		exitCode = 1;
+		return false;
+	}
+
+	nblocks = st.st_size / blockSize;
+	*first = 0;
+	if (blockOptions & BLOCK_RANGE)
+	{
+		*first = blockStart;
+		nblocks = Min(nblocks, blockEnd + 1);
+	}
+
+	if (*first >= nblocks)
+	{
+		fprintf(stderr, "pg_hexedit error: premature end of file encountered\n");
+		exitCode = 1;
+		return false;
+	}
+	*last = nblocks - 1;
+
+	return true;
+}
+
+/*
+ * Scan file's blocks (or the -R range) using numWorkers worker threads.
+ * visitor walks each block, with states[i] passed by i'th worker.  Blocks
+ * are visited in no particular order, so callers must merge their per-worker
+ * states afterwards.
+ *
+ * Returns false if scan could not begin.
+ */
+static bool
+ScanBlocksParallel(const PageVisitor *visitor, void **states)
+{
+	ScanWorker *workers;
+	struct stat st;
+	int			i;
+
+	if (!GetScanRange(&scanNextBlock, &scanLastBlock))
+		return false;
+
+	if (fstat(fileno(fp), &st) == 0 && st.st_size % blockSize != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: file \"%s\" has partial block %u of size %u\n",
+				fileName, (unsigned int) (st.st_size / blockSize),
+				(unsigned int) (st.st_size % blockSize));
+		exitCode = 1;
+	}
+
+	workers = (ScanWorker *) pg_malloc0(sizeof(ScanWorker) * numWorkers);
+	for (i = 0; i < numWorkers; i++)
+	{
+		workers[i].fd = fileno(fp);
+		workers[i].visitor = visitor;
+		workers[i].state = states[i];
+	}
+
+	/* Worker 0 is always the main thread */
+	for (i = 1; i < numWorkers; i++)
+	{
+		if (pthread_create(&workers[i].thread, NULL, ScanWorkerMain,
+						   &workers[i]) != 0)
+		{
+			fprintf(stderr, "pg_hexedit error: could not create worker thread %d\n",
+					i);
+			exitCode = 1;
+			break;
+		}
+	}
+	ScanWorkerMain(&workers[0]);
+	while (--i > 0)
+		pthread_join(workers[i].thread, NULL);
+
+	pg_free(workers);
+
+	return true;
+}
+
+/*
+ * Do htup's hint bits show that it is dead?
+ *
+ * No commit log is available, so this only recognizes tuples whose xmin is
+ * known to have aborted, or whose deleter is known to have committed.  Note
+ * that frozen tuples set both HEAP_XMIN_COMMITTED and HEAP_XMIN_INVALID, so
+ * the latter bit can't be tested on its own.
+ */
+static bool
+HeapTupleIsDeadByHints(HeapTupleHeader htup)
+{
+	return HeapTupleHeaderXminInvalid(htup) ||
+		((htup->t_infomask & HEAP_XMAX_COMMITTED) &&
+		 !HEAP_XMAX_IS_LOCKED_ONLY(htup->t_infomask));
+}
+
+/*
+ * PageProblemCallback for --column-stats.  Anomalies are reported on stderr,
+ * and tuples that have one are counted as malformed.
+ */
+static void
+NoteColumnStatsPageProblem(void *arg, BlockNumber blkno, OffsetNumber offset,
+						   checkAnomalyCodes code, unsigned int start,
+						   unsigned int end, const char *detail)
+{
+	ReportXmlPageProblem(arg, blkno, offset, code, start, end, detail);
+	if (offset != InvalidOffsetNumber)
+		((ColumnStatsState *) arg)->nmalformed++;
+}
+
+/*
+ * --column-stats onPage callback.  Only heap pages are considered.  Pages
+ * whose header has other anomalies still have their items visited.
+ */
+static bool
+ColumnStatsVisitPage(Page page, BlockNumber blkno, bool sane, void *arg)
+{
+	ColumnStatsState *state = (ColumnStatsState *) arg;
+
+	if (PageIsNew(page) || ((PageHeader) page)->pd_special != blockSize)
+	{
+		state->nskippedpages++;
+		return false;
+	}
+
+	state->nheappages++;
+	return true;
+}
+
+/*
+ * --column-stats onItemId callback
+ */
+static bool
+ColumnStatsVisitItemId(Page page, BlockNumber blkno, OffsetNumber offset,
+					   ItemId itemId, bool hasStorage, void *arg)
+{
+	return ItemIdIsNormal(itemId);
+}
+
+/*
+ * --column-stats onHeapTuple callback.  Tuples whose hint bits show that
+ * they're dead are skipped, since no commit log is available to determine
+ * visibility in general.
+ */
+static int
+ColumnStatsVisitHeapTuple(Page page, BlockNumber blkno, OffsetNumber offset,
+						  HeapTupleHeader htup, unsigned int itemSize,
+						  void *arg)
+{
+	ColumnStatsState *state = (ColumnStatsState *) arg;
+
+	if (HeapTupleIsDeadByHints(htup))
+	{
+		state->ndead++;
+		return 0;
+	}
+
+	return nrelatts;
+}
+
+/*
+ * --column-stats onAttribute callback.  This only records how each value of
+ * the current tuple is stored.  Attributes beyond the tuple's natts (i.e.
+ * attributes added after the tuple was written) are counted as NULL.
+ */
+static bool
+ColumnStatsVisitAttribute(BlockNumber blkno, OffsetNumber offset, int attnum,
+						  const AttributeSpan *span, void *arg)
+{
+	ColumnStatsState *state = (ColumnStatsState *) arg;
+
+	state->kinds[attnum] = COLUMN_VALUE_NULL;
+	state->methods[attnum] = COLUMN_COMPRESSION_NONE;
+	state->widths[attnum] = span->len;
+	if (span->isnull)
+		return true;
+
+	state->kinds[attnum] = COLUMN_VALUE_PLAIN;
+	if (span->hdrlen == 0)
+		return true;
+
+	if (VARATT_IS_EXTERNAL_ONDISK(span->ptr))
+	{
+		varatt_external toast_pointer;
+
+		state->kinds[attnum] = COLUMN_VALUE_EXTERNAL;
+		VARATT_EXTERNAL_GET_POINTER(toast_pointer, span->ptr);
+		if (VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer))
+		{
+#if PG_VERSION_NUM >= 140000
+			if (VARATT_EXTERNAL_GET_COMPRESS_METHOD(toast_pointer) ==
+				TOAST_LZ4_COMPRESSION_ID)
+				state->methods[attnum] = COLUMN_COMPRESSION_LZ4;
+			else
+#endif
+				state->methods[attnum] = COLUMN_COMPRESSION_PGLZ;
+		}
+	}
+	else if (VARATT_IS_COMPRESSED(span->ptr))
+	{
+		state->kinds[attnum] = COLUMN_VALUE_COMPRESSED;
+#if PG_VERSION_NUM >= 140000
+		if (VARDATA_COMPRESSED_GET_COMPRESS_METHOD(span->ptr) ==
+			TOAST_LZ4_COMPRESSION_ID)
+			state->methods[attnum] = COLUMN_COMPRESSION_LZ4;
+		else
+#endif
+			state->methods[attnum] = COLUMN_COMPRESSION_PGLZ;
+	}
+
+	return true;
+}
+
+/*
+ * --column-stats onHeapTupleEnd callback.  Statistics are only updated once
+ * the whole tuple has been found to be well-formed.
+ */
+static void
+ColumnStatsVisitHeapTupleEnd(BlockNumber blkno, OffsetNumber offset,
+							 int badAttnum, void *arg)
+{
+	ColumnStatsState *state = (ColumnStatsState *) arg;
+	int			i;
+
+	if (badAttnum >= 0)
+	{
+		fprintf(stderr, "pg_hexedit error: unexpected out of bounds tuple data for attnum %d in (%u,%u)\n",
+				badAttnum + 1, blkno + segmentBlockDelta, offset);
+		exitCode = 1;
+		state->nmalformed++;
+		return;
+	}
+
+	for (i = 0; i < nrelatts; i++)
+	{
+		ColumnStats *col = &state->cols[i];
+
+		if (state->kinds[i] == COLUMN_VALUE_NULL)
+		{
+			col->nnull++;
+			continue;
+		}
+
+		col->nvalues++;
+		col->totalWidth += state->widths[i];
+		col->maxWidth = Max(col->maxWidth, state->widths[i]);
+		if (state->kinds[i] == COLUMN_VALUE_COMPRESSED)
+			col->ncompressed++;
+		else if (state->kinds[i] == COLUMN_VALUE_EXTERNAL)
+			col->nexternal++;
+		if (state->methods[i] == COLUMN_COMPRESSION_PGLZ)
+			col->npglz++;
+		else if (state->methods[i] == COLUMN_COMPRESSION_LZ4)
+			col->nlz4++;
+	}
+	state->ntuples++;
+}
+
+/*
+ * Print exact per-attribute statistics for the file to stdout, in place of
+ * tags.  Output uses the same unaligned format as "psql -A", with columns
+ * named after their pg_stats counterparts where one exists.
+ */
+static void
+EmitColumnStats(void)
+{
+	ColumnStatsState *states;
+	ColumnStatsState total;
+	void	  **stateptrs;
+	int			w;
+	int			i;
+
+	states = (ColumnStatsState *) pg_malloc0(sizeof(ColumnStatsState) *
+											 numWorkers);
+	stateptrs = (void **) pg_malloc(sizeof(void *) * numWorkers);
+	for (w = 0; w < numWorkers; w++)
+	{
+		states[w].cols = (ColumnStats *) pg_malloc0(sizeof(ColumnStats) *
+													nrelatts);
+		states[w].widths = (uint32 *) pg_malloc(sizeof(uint32) * nrelatts);
+		states[w].kinds = (uint8 *) pg_malloc(nrelatts);
+		states[w].methods = (uint8 *) pg_malloc(nrelatts);
+		stateptrs[w] = &states[w];
+	}
+
+	if (!ScanBlocksParallel(&columnStatsVisitor, stateptrs))
+		return;
+
+	/* Merge per-worker statistics into first worker's state */
+	memset(&total, 0, sizeof(total));
+	total.cols = states[0].cols;
+	for (w = 0; w < numWorkers; w++)
+	{
+		total.nheappages += states[w].nheappages;
+		total.nskippedpages += states[w].nskippedpages;
+		total.ntuples += states[w].ntuples;
+		total.ndead += states[w].ndead;
+		total.nmalformed += states[w].nmalformed;
+
+		if (w == 0)
+			continue;
+
+		for (i = 0; i < nrelatts; i++)
+		{
+			ColumnStats *col = &total.cols[i];
+			ColumnStats *wcol = &states[w].cols[i];
+
+			col->nnull += wcol->nnull;
+			col->nvalues += wcol->nvalues;
+			col->totalWidth += wcol->totalWidth;
+			col->maxWidth = Max(col->maxWidth, wcol->maxWidth);
+			col->ncompressed += wcol->ncompressed;
+			col->nexternal += wcol->nexternal;
+			col->npglz += wcol->npglz;
+			col->nlz4 += wcol->nlz4;
+		}
+	}
+
+	printf("attnum|attname|null_frac|avg_width|max_width|compressed_frac|external_frac|compression\n");
+	for (i = 0; i < nrelatts; i++)
+	{
+		ColumnStats *col = &total.cols[i];
+		double		ntotal = col->nnull + col->nvalues;
+		const char *compression = "";
+
+		if (col->npglz > 0 && col->nlz4 > 0)
+			compression = "pglz,lz4";
+		else if (col->npglz > 0)
+			compression = "pglz";
+		else if (col->nlz4 > 0)
+			compression = "lz4";
+
+		printf("%d|%s|%.4f|%lu|%u|%.4f|%.4f|%s\n",
+			   i + 1, attnamerel[i],
+			   ntotal > 0 ? col->nnull / ntotal : 0.0,
+			   col->nvalues > 0 ?
+			   (unsigned long) (col->totalWidth / col->nvalues) : 0,
+			   col->maxWidth,
+			   col->nvalues > 0 ? col->ncompressed / (double) col->nvalues : 0.0,
+			   col->nvalues > 0 ? col->nexternal / (double) col->nvalues : 0.0,
+			   compression);
+	}
+
+	fprintf(stderr, "pg_hexedit notice: --column-stats used %lu tuples from %lu heap pages (%lu pages skipped, %lu hinted dead tuples skipped, %lu malformed tuples skipped)\n",
+			(unsigned long) total.ntuples, (unsigned long) total.nheappages,
+			(unsigned long) total.nskippedpages, (unsigned long) total.ndead,
+			(unsigned long) total.nmalformed);
+
+	for (w = 0; w < numWorkers; w++)
+	{
+		pg_free(states[w].cols);
+		pg_free(states[w].widths);
+		pg_free(states[w].kinds);
+		pg_free(states[w].methods);
+	}
+	pg_free(states);
+	pg_free(stateptrs);
+}
+
+/*
+ * Return index of first chunk with chunk_id valueid in -T TOAST chunk index,
+ * or the index where such a chunk would appear
+ */
+static int
+FindFirstToastChunk(Oid valueid)
+{
+	int			lo = 0;
+	int			hi = ntoastchunks;
+
+	while (lo < hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
+
+		if (toastChunks[mid].chunkId < valueid)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * Reassemble external on-disk TOAST value from -T TOAST file's chunks.  The
+ * first copy of any duplicated chunk is used.  Returns NULL when a chunk is
+ * missing or unreadable, or when extsize is more than the value's chunks
+ * hold between them (in which case nothing is allocated).
+ *
+ * Unlike ResolveToastPointer(), the chunk index is not modified, so this is
+ * safe to call from parallel block scan workers.
+ *
+ * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ */
+static char *
+ReadToastValue(Oid valueid, uint32 extsize)
+{
+	char	   *data;
+	uint64		available = 0;
+	uint32		nbytes = 0;
+	int32		expectedSeq = 0;
+	int			first = FindFirstToastChunk(valueid);
+	int			i;
+
+	for (i = first; i < ntoastchunks && toastChunks[i].chunkId == valueid; i++)
+		available += toastChunks[i].dataLen;
+	if (extsize > available)
+		return NULL;
+
+	data = (char *) pg_malloc(extsize + 1);
+	for (i = first; i < ntoastchunks && toastChunks[i].chunkId == valueid; i++)
+	{
+		ToastChunk *chunk = &toastChunks[i];
+
+		if (chunk->chunkSeq < expectedSeq)
+			continue;
+
+		if (chunk->chunkSeq > expectedSeq ||
+			nbytes + chunk->dataLen > extsize)
+			break;
+
+		ThrottleIo(chunk->dataLen);
+		if (pg_pread(fileno(toastFp), data + nbytes, chunk->dataLen,
+					 chunk->dataOff) != chunk->dataLen)
+			break;
+
+		nbytes += chunk->dataLen;
+		expectedSeq++;
+	}
+
+	if (nbytes != extsize)
+	{
+		pg_free(data);
+		return NULL;
+	}
+
+	return data;
+}
+
+/*
+ * Decompress compressed varlena payload.  Returns NULL when payload is
+ * damaged, or when this build of pg_hexedit does not support the compression
+ * method.
+ *
+ * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ */
+static char *
+DecompressValue(const char *compressed, int32 compressedSize, int32 rawSize,
+				int method)
+{
+	char	   *raw = (char *) pg_malloc(rawSize + 1);
+	int32		nbytes = -1;
+
+	if (method == COLUMN_COMPRESSION_PGLZ)
+		nbytes = pglz_decompress(compressed, compressedSize, raw, rawSize,
+								 true);
+#ifdef USE_LZ4
+	else if (method == COLUMN_COMPRESSION_LZ4)
+		nbytes = LZ4_decompress_safe(compressed, raw, compressedSize, rawSize);
+#endif
+
+	if (nbytes != rawSize)
+	{
+		pg_free(raw);
+		return NULL;
+	}
+
+	return raw;
+}
+
+/*
+ * Append COPY BINARY field for varlena at attptr to buf.  The field is the
+ * value's payload, after any decompression, and after reassembly from -T
+ * TOAST file's chunks for external values.
+ *
+ * Returns NULL on success, or a description of the problem when value could
+ * not be salvaged.
+ */
+static const char *
+SalvageVarlena(StringInfo buf, unsigned char *attptr)
+{
+	char	   *payload;
+	char	   *compressed;
+	char	   *external = NULL;
+	char	   *raw;
+	int32		payloadSize;
+	int32		compressedSize;
+	int32		rawSize;
+	int32		fieldSize;
+	int			method = COLUMN_COMPRESSION_PGLZ;
+
+	if (VARATT_IS_EXTERNAL_ONDISK(attptr))
+	{
+		varatt_external toast_pointer;
+		uint32		extsize;
+
+		if (!toastChunks)
+			return "external TOAST value requires -T";
+
+		VARATT_EXTERNAL_GET_POINTER(toast_pointer, attptr);
+#if PG_VERSION_NUM >= 140000
+		extsize = VARATT_EXTERNAL_GET_EXTSIZE(toast_pointer);
+#else
+		extsize = toast_pointer.va_extsize;
+#endif
+		if (toast_pointer.va_rawsize < VARHDRSZ ||
+			extsize > toast_pointer.va_rawsize)
+			return "TOAST pointer is corrupt";
+		if ((Size) toast_pointer.va_rawsize >= MaxAllocSize)
+			return "TOAST pointer size exceeds MaxAllocSize";
+
+		external = ReadToastValue(toast_pointer.va_valueid, extsize);
+		if (!external)
+			return "TOAST chunks are missing or damaged";
+
+		if (!VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer))
+		{
+			payload = external;
+			payloadSize = extsize;
+		}
+		else
+		{
+			/* External compressed data retains va_tcinfo word */
+			if (extsize < sizeof(uint32))
+			{
+				pg_free(external);
+				return "TOAST pointer is corrupt";
+			}
+#if PG_VERSION_NUM >= 140000
+			if (VARATT_EXTERNAL_GET_COMPRESS_METHOD(toast_pointer) ==
+				TOAST_LZ4_COMPRESSION_ID)
+				method = COLUMN_COMPRESSION_LZ4;
+#endif
+			compressed = external + sizeof(uint32);
+			compressedSize = extsize - sizeof(uint32);
+			rawSize = toast_pointer.va_rawsize - VARHDRSZ;
+			payload = raw = DecompressValue(compressed, compressedSize,
+											rawSize, method);
+			payloadSize = rawSize;
+			pg_free(external);
+			external = raw;
+			if (!payload)
+				return "compressed TOAST value is damaged or uses unsupported compression method";
+		}
+	}
+	else if (VARATT_IS_EXTERNAL(attptr))
+		return "unexpected external varlena tag";
+	else if (VARATT_IS_COMPRESSED(attptr))
+	{
+		compressedSize = VARSIZE_4B(attptr) -
+			offsetof(varattrib_4b, va_compressed.va_data);
+#if PG_VERSION_NUM >= 140000
+		rawSize = VARDATA_COMPRESSED_GET_EXTSIZE(attptr);
+		if (VARDATA_COMPRESSED_GET_COMPRESS_METHOD(attptr) ==
+			TOAST_LZ4_COMPRESSION_ID)
+			method = COLUMN_COMPRESSION_LZ4;
+#else
+		rawSize = ((varattrib_4b *) attptr)->va_compressed.va_rawsize;
+#endif
+		if (compressedSize < 0 || rawSize < 0)
+			return "compressed value header is corrupt";
+		if ((Size) rawSize >= MaxAllocSize)
+			return "compressed value size exceeds MaxAllocSize";
+
+		compressed = (char *) attptr +
+			offsetof(varattrib_4b, va_compressed.va_data);
+		payload = external = DecompressValue(compressed, compressedSize,
+											 rawSize, method);
+		payloadSize = rawSize;
+		if (!payload)
+			return "compressed value is damaged or uses unsupported compression method";
+	}
+	else
+	{
+		payload = VARDATA_ANY(attptr);
+		payloadSize = VARSIZE_ANY_EXHDR(attptr);
+	}
+
+	fieldSize = pg_hton32(payloadSize);
+	appendBinaryStringInfo(buf, (char *) &fieldSize, sizeof(int32));
+	appendBinaryStringInfo(buf, payload, payloadSize);
+
+	if (external)
+		pg_free(external);
+
+	return NULL;
+}
+
+/*
+ * PageProblemCallback for --salvage.  Anomalies are reported on stderr, and
+ * tuples that have one are counted as damaged.
+ */
+static void
+NoteSalvagePageProblem(void *arg, BlockNumber blkno, OffsetNumber offset,
+					   checkAnomalyCodes code, unsigned int start,
+					   unsigned int end, const char *detail)
+{
+	ReportXmlPageProblem(arg, blkno, offset, code, start, end, detail);
+	if (offset != InvalidOffsetNumber)
+		((SalvageState *) arg)->ndamaged++;
+}
+
+/*
+ * --salvage onPage callback.  Only heap pages are considered.  Pages whose
+ * header has other anomalies (such as a corrupt pd_upper) still have their
+ * items salvaged, since only pd_lower is needed to find them.
+ */
+static bool
+SalvageVisitPage(Page page, BlockNumber blkno, bool sane, void *arg)
+{
+	SalvageState *state = (SalvageState *) arg;
+
+	if (PageIsNew(page) || ((PageHeader) page)->pd_special != blockSize)
+	{
+		state->nskippedpages++;
+		return false;
+	}
+
+	state->nheappages++;
+	return true;
+}
+
+/*
+ * --salvage onItemId callback
+ */
+static bool
+SalvageVisitItemId(Page page, BlockNumber blkno, OffsetNumber offset,
+				   ItemId itemId, bool hasStorage, void *arg)
+{
+	return ItemIdIsNormal(itemId);
+}
+
+/*
+ * --salvage onHeapTuple callback.  Starts tuple's COPY BINARY row in worker's
+ * buffer, which every attribute is then appended to.
+ */
+static int
+SalvageVisitHeapTuple(Page page, BlockNumber blkno, OffsetNumber offset,
+					  HeapTupleHeader htup, unsigned int itemSize, void *arg)
+{
+	SalvageState *state = (SalvageState *) arg;
+	int16		nfields = pg_hton16(nrelatts);
+
+	/*
+	 * --visible-only requires hint bits showing that xmin committed (possibly
+	 * frozen), and that there is no updater or deleter
+	 */
+	if ((blockOptions & BLOCK_VISIBLE_ONLY) &&
+		(!(htup->t_infomask & HEAP_XMIN_COMMITTED) ||
+		 !((htup->t_infomask & HEAP_XMAX_INVALID) ||
+		   HEAP_XMAX_IS_LOCKED_ONLY(htup->t_infomask))))
+	{
+		state->ninvisible++;
+		return 0;
+	}
+
+	state->tupleStart = state->buf.len;
+	state->problem = NULL;
+	appendBinaryStringInfo(&state->buf, (char *) &nfields, sizeof(int16));
+
+	return nrelatts;
+}
+
+/*
+ * --salvage onAttribute callback.  Appends attribute to worker's buffer as a
+ * COPY BINARY field.
+ *
+ * COPY BINARY expects each type's send format, which pg_hexedit cannot know
+ * from attlen and attalign alone.  Values are written in the format that is
+ * correct for the most common types: 2, 4, and 8 byte values (other than
+ * those with char alignment) are assumed to be integers or floats, and are
+ * converted to network byte order.  NAMEDATALEN byte values with char
+ * alignment are assumed to be names, and cstrings are written without their
+ * terminator.  Varlena payloads are written as-is, which is correct for text,
+ * varchar, bpchar, and bytea.
+ *
+ * Other fixed-length values (such as interval, timetz, and uuid) are made up
+ * of several fields whose order and byte order differ between types of the
+ * same size, so there is no format that is correct for all of them.  They can
+ * only be salvaged into bytea columns named by --salvage-bytea, which get
+ * every value's stored representation as-is.  Tuples with such values in other
+ * attributes are treated as damaged, rather than loading garbage.
+ */
+static bool
+SalvageVisitAttribute(BlockNumber blkno, OffsetNumber offset, int attnum,
+					  const AttributeSpan *span, void *arg)
+{
+	SalvageState *state = (SalvageState *) arg;
+	StringInfo	buf = &state->buf;
+	int			attlen = attlenrel[attnum];
+	char		attalign = attalignrel[attnum];
+	int32		nullField = pg_hton32(-1);
+	int32		fieldSize;
+
+	if (span->isnull)
+		appendBinaryStringInfo(buf, (char *) &nullField, sizeof(int32));
+	else if (attlen > 0 && byteasalvagerel[attnum])
+	{
+		fieldSize = pg_hton32(attlen);
+		appendBinaryStringInfo(buf, (char *) &fieldSize, sizeof(int32));
+		appendBinaryStringInfo(buf, (char *) span->ptr, attlen);
+	}
+	else if (attlen == -1)
+	{
+		if ((state->problem = SalvageVarlena(buf, span->ptr)) != NULL)
+			return false;
+	}
+	else if (attlen == -2)
+	{
+		/* Terminator isn't part of the field */
+		fieldSize = pg_hton32(span->len - 1);
+		appendBinaryStringInfo(buf, (char *) &fieldSize, sizeof(int32));
+		appendBinaryStringInfo(buf, (char *) span->ptr, span->len - 1);
+	}
+	else if (attlen == NAMEDATALEN && attalign == 'c')
+	{
+		int			len = strnlen((char *) span->ptr, NAMEDATALEN);
+
+		fieldSize = pg_hton32(len);
+		appendBinaryStringInfo(buf, (char *) &fieldSize, sizeof(int32));
+		appendBinaryStringInfo(buf, (char *) span->ptr, len);
+	}
+	else if (attlen > sizeof(int64))
+	{
+		state->problem = "fixed-length value larger than 8 bytes requires --salvage-bytea";
+		return false;
+	}
+	else
+	{
+		fieldSize = pg_hton32(attlen);
+		appendBinaryStringInfo(buf, (char *) &fieldSize, sizeof(int32));
+
+		if (attlen == sizeof(int16) && attalign != 'c')
+		{
+			int16		value = pg_hton16(*((int16 *) span->ptr));
+
+			appendBinaryStringInfo(buf, (char *) &value, attlen);
+		}
+		else if (attlen == sizeof(int32) && attalign != 'c')
+		{
+			int32		value = pg_hton32(*((int32 *) span->ptr));
+
+			appendBinaryStringInfo(buf, (char *) &value, attlen);
+		}
+		else if (attlen == sizeof(int64) && attalign != 'c')
+		{
+			int64		value;
+
+			memcpy(&value, span->ptr, sizeof(int64));
+			value = pg_hton64(value);
+			appendBinaryStringInfo(buf, (char *) &value, attlen);
+		}
+		else
+			appendBinaryStringInfo(buf, (char *) span->ptr, attlen);
+	}
+
+	return true;
+}
+
+/*
+ * --salvage onHeapTupleEnd callback.  Tuples that could not be salvaged are
+ * removed from worker's buffer.
+ */
+static void
+SalvageVisitHeapTupleEnd(BlockNumber blkno, OffsetNumber offset,
+						 int badAttnum, void *arg)
+{
+	SalvageState *state = (SalvageState *) arg;
+	const char *problem = state->problem;
+
+	if (badAttnum < 0)
+	{
+		state->ntuples++;
+		return;
+	}
+
+	if (!problem)
+		problem = attlenrel[badAttnum] == -2 ? "unterminated cstring" :
+			"out of bounds tuple data";
+	fprintf(stderr, "pg_hexedit error: (%u,%u) attnum %d could not be salvaged: %s\n",
+			blkno + segmentBlockDelta, offset, badAttnum + 1, problem);
+	exitCode = 1;
+	state->buf.len = state->tupleStart;
+	state->buf.data[state->tupleStart] = '\0';
+	state->ndamaged++;
+}
+
+/*
+ * --salvage onPageEnd callback
+ */
+static void
+SalvageVisitPageEnd(Page page, BlockNumber blkno, void *arg)
+{
+	SalvageState *state = (SalvageState *) arg;
+
+	if (state->buf.len >= SALVAGE_FLUSH_SIZE)
+		FlushSalvageBuffer(state);
+}
+
+/*
+ * Append worker's buffered COPY BINARY rows to salvage output file
+ */
+static void
+FlushSalvageBuffer(SalvageState *state)
+{
+	pthread_mutex_lock(&salvageLock);
+	if (fwrite(state->buf.data, 1, state->buf.len, salvageFp) != state->buf.len)
+	{
+		fprintf(stderr, "pg_hexedit error: could not write to salvage output file \"%s\"\n",
+				salvageFileName);
+		exitCode = 1;
+	}
+	pthread_mutex_unlock(&salvageLock);
+
+	resetStringInfo(&state->buf);
+}
+
+/*
+ * Write every decodable LP_NORMAL heap tuple to salvage output file in COPY
+ * BINARY format, using numWorkers worker threads.  Rows are written in no
+ * particular order.  Damaged pages and tuples are skipped, and reported on
+ * stderr.
+ */
+static void
+SalvageTuples(void)
+{
+	static const char signature[11] = "PGCOPY\n\377\r\n\0";
+	SalvageState *states;
+	SalvageState total;
+	void	  **stateptrs;
+	int32		headerWord = 0;
+	int16		trailer = pg_hton16(-1);
+	int			w;
+
+	/* Header: signature, flags field, and header extension area length */
+	fwrite(signature, 1, sizeof(signature), salvageFp);
+	fwrite(&headerWord, 1, sizeof(int32), salvageFp);
+	fwrite(&headerWord, 1, sizeof(int32), salvageFp);
+
+	states = (SalvageState *) pg_malloc0(sizeof(SalvageState) * numWorkers);
+	stateptrs = (void **) pg_malloc(sizeof(void *) * numWorkers);
+	for (w = 0; w < numWorkers; w++)
+	{
+		initStringInfo(&states[w].buf);
+		stateptrs[w] = &states[w];
+	}
+
+	ScanBlocksParallel(&salvageVisitor, stateptrs);
+
+	memset(&total, 0, sizeof(total));
+	for (w = 0; w < numWorkers; w++)
+	{
+		FlushSalvageBuffer(&states[w]);
+		total.nheappages += states[w].nheappages;
+		total.nskippedpages += states[w].nskippedpages;
+		total.ntuples += states[w].ntuples;
+		total.ninvisible += states[w].ninvisible;
+		total.ndamaged += states[w].ndamaged;
+		pg_free(states[w].buf.data);
+	}
+
+	fwrite(&trailer, 1, sizeof(int16), salvageFp);
+	if (fflush(salvageFp) != 0 || ferror(salvageFp))
+	{
+		fprintf(stderr, "pg_hexedit error: could not write to salvage output file \"%s\"\n",
+				salvageFileName);
+		exitCode = 1;
+	}
+
+	fprintf(stderr, "pg_hexedit notice: --salvage wrote %lu tuples from %lu heap pages (%lu pages skipped, %lu invisible tuples skipped, %lu damaged tuples skipped)\n",
+			(unsigned long) total.ntuples, (unsigned long) total.nheappages,
+			(unsigned long) total.nskippedpages,
+			(unsigned long) total.ninvisible,
+			(unsigned long) total.ndamaged);
+	fprintf(stderr, "pg_hexedit tip: load salvaged tuples with \"COPY table FROM 'file' WITH (FORMAT binary)\"\n");
+
+	pg_free(states);
+	pg_free(stateptrs);
+}
+
+/*
+ * Resolve --salvage-bytea attribute names against -D attrlist.  Without the
+ * option, no attribute is salvaged as bytea.
+ */
+static bool
+ParseByteaAttrList(void)
+{
+	char	   *attrlist;
+	char	   *saveptr = NULL;
+	char	   *attname;
+	bool		found = false;
+
+	byteasalvagerel = (bool *) pg_malloc0(sizeof(bool) * nrelatts);
+	if (!byteaAttrList)
+		return true;
+
+	attrlist = pg_strdup(byteaAttrList);
+	for (attname = strtok_r(attrlist, ",", &saveptr);
+		 attname != NULL;
+		 attname = strtok_r(NULL, ",", &saveptr))
+	{
+		int			i;
+
+		for (i = 0; i < nrelatts; i++)
+		{
+			if (strcmp(attnamerel[i], attname) == 0)
+				break;
+		}
+
+		if (i == nrelatts)
+		{
+			fprintf(stderr, "pg_hexedit error: --salvage-bytea attribute \"%s\" does not appear in attrlist\n",
+					attname);
+			pg_free(attrlist);
+			return false;
+		}
+
+		byteasalvagerel[i] = true;
+		found = true;
+	}
+
+	pg_free(attrlist);
+
+	if (!found)
+		fprintf(stderr, "pg_hexedit error: missing --salvage-bytea attribute names\n");
+
+	return found;
+}
+
+/*
+ * Resolve --check-utf8 attribute names against -D attrlist.  Only varlena
+ * attributes can be checked.
+ */
+static bool
+ParseUtf8AttrList(void)
+{
+	char	   *attrlist = pg_strdup(utf8AttrList);
+	char	   *saveptr = NULL;
+	char	   *attname;
+	bool		found = false;
+
+	utf8checkrel = (bool *) pg_malloc0(sizeof(bool) * nrelatts);
+
+	for (attname = strtok_r(attrlist, ",", &saveptr);
+		 attname != NULL;
+		 attname = strtok_r(NULL, ",", &saveptr))
+	{
+		int			i;
+
+		for (i = 0; i < nrelatts; i++)
+		{
+			if (strcmp(attnamerel[i], attname) == 0)
+				break;
+		}
+
+		if (i == nrelatts)
+		{
+			fprintf(stderr, "pg_hexedit error: --check-utf8 attribute \"%s\" does not appear in attrlist\n",
+					attname);
+			pg_free(attrlist);
+			return false;
+		}
+		if (attlenrel[i] != -1)
+		{
+			fprintf(stderr, "pg_hexedit error: --check-utf8 attribute \"%s\" is not a varlena attribute\n",
+					attname);
+			pg_free(attrlist);
+			return false;
+		}
+
+		utf8checkrel[i] = true;
+		lastUtf8Att = Max(lastUtf8Att, i);
+		found = true;
+	}
+
+	pg_free(attrlist);
+
+	if (!found)
+		fprintf(stderr, "pg_hexedit error: missing --check-utf8 attribute names\n");
+
+	return found;
+}
+
+/*
+ * PageProblemCallback for --check-utf8.  Anomalies are reported on stderr,
+ * and tuples that have one are counted as malformed.
+ */
+static void
+NoteUtf8PageProblem(void *arg, BlockNumber blkno, OffsetNumber offset,
+					checkAnomalyCodes code, unsigned int start,
+					unsigned int end, const char *detail)
+{
+	ReportXmlPageProblem(arg, blkno, offset, code, start, end, detail);
+	if (offset != InvalidOffsetNumber)
+		((Utf8CheckState *) arg)->nmalformed++;
+}
+
+/*
+ * --check-utf8 onPage callback.  Only heap pages are considered.  Pages whose
+ * header has other anomalies still have their items visited.
+ */
+static bool
+Utf8VisitPage(Page page, BlockNumber blkno, bool sane, void *arg)
+{
+	return !PageIsNew(page) && ((PageHeader) page)->pd_special == blockSize;
+}
+
+/*
+ * --check-utf8 onItemId callback
+ */
+static bool
+Utf8VisitItemId(Page page, BlockNumber blkno, OffsetNumber offset,
+				ItemId itemId, bool hasStorage, void *arg)
+{
+	return ItemIdIsNormal(itemId);
+}
+
+/*
+ * --check-utf8 onHeapTuple callback.  Tuples whose hint bits show that
+ * they're dead are skipped.
+ */
+static int
+Utf8VisitHeapTuple(Page page, BlockNumber blkno, OffsetNumber offset,
+				   HeapTupleHeader htup, unsigned int itemSize, void *arg)
+{
+	Utf8CheckState *state = (Utf8CheckState *) arg;
+
+	if (HeapTupleIsDeadByHints(htup))
+		return 0;
+
+	state->dataOff = blkno * blockSize + ((char *) htup - (char *) page) +
+		htup->t_hoff;
+
+	/* No need to locate attributes past last attribute that is validated */
+	return lastUtf8Att + 1;
+}
+
+/*
+ * --check-utf8 onAttribute callback.  Only inline uncompressed values are
+ * validated, and any problem is recorded.
+ */
+static bool
+Utf8VisitAttribute(BlockNumber blkno, OffsetNumber offset, int attnum,
+				   const AttributeSpan *span, void *arg)
+{
+	Utf8CheckState *state = (Utf8CheckState *) arg;
+	const char *payload;
+	int			len;
+	int			validLen;
+	Utf8Problem *problem;
+
+	if (span->isnull || !utf8checkrel[attnum])
+		return true;
+
+	if (VARATT_IS_EXTERNAL(span->ptr) || VARATT_IS_COMPRESSED(span->ptr))
+	{
+		state->nunchecked++;
+		return true;
+	}
+
+	payload = (char *) span->ptr + span->hdrlen;
+	len = span->len - span->hdrlen;
+	validLen = pg_encoding_verifymbstr(PG_UTF8, payload, len);
+	state->nvalues++;
+	state->nbytes += len;
+
+	if (validLen == len)
+		return true;
+
+	if (state->nproblems >= state->maxproblems)
+	{
+		state->maxproblems = Max(64, state->maxproblems * 2);
+		state->problems = (Utf8Problem *)
+			pg_realloc(state->problems,
+					   sizeof(Utf8Problem) * state->maxproblems);
+	}
+
+	problem = &state->problems[state->nproblems++];
+	problem->blkno = blkno;
+	problem->offset = offset;
+	problem->attnum = attnum;
+	problem->relfileOff = state->dataOff + span->off + span->hdrlen;
+	problem->len = len;
+	problem->validLen = validLen;
+
+	return true;
+}
+
+/*
+ * --check-utf8 onHeapTupleEnd callback
+ */
+static void
+Utf8VisitHeapTupleEnd(BlockNumber blkno, OffsetNumber offset, int badAttnum,
+					  void *arg)
+{
+	if (badAttnum >= 0)
+		((Utf8CheckState *) arg)->nmalformed++;
+}
+
+/*
+ * qsort comparator that sorts --check-utf8 problems in file order
+ */
+static int
+Utf8ProblemCmp(const void *a, const void *b)
+{
+	const Utf8Problem *problema = (const Utf8Problem *) a;
+	const Utf8Problem *problemb = (const Utf8Problem *) b;
+
+	if (problema->relfileOff != problemb->relfileOff)
+		return problema->relfileOff < problemb->relfileOff ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * Validate --check-utf8 attributes across file using numWorkers worker
+ * threads, and emit a tag document with a tag for each invalid value only.
+ * The TIDs of invalid values are also listed on stderr.
+ */
+static void
+EmitXmlUtf8Problems(int numOptions, char **options)
+{
+	Utf8CheckState *states;
+	Utf8CheckState total;
+	void	  **stateptrs;
+	int			w;
+	int			i;
+
+	states = (Utf8CheckState *) pg_malloc0(sizeof(Utf8CheckState) *
+										   numWorkers);
+	stateptrs = (void **) pg_malloc(sizeof(void *) * numWorkers);
+	for (w = 0; w < numWorkers; w++)
+		stateptrs[w] = &states[w];
+
+	EmitXmlDocHeader(numOptions, options);
+	ScanBlocksParallel(&utf8Visitor, stateptrs);
+
+	/* Merge per-worker problems into a single array */
+	memset(&total, 0, sizeof(total));
+	for (w = 0; w < numWorkers; w++)
+	{
+		total.nvalues += states[w].nvalues;
+		total.nbytes += states[w].nbytes;
+		total.nunchecked += states[w].nunchecked;
+		total.nmalformed += states[w].nmalformed;
+		total.nproblems += states[w].nproblems;
+	}
+	total.problems = (Utf8Problem *) pg_malloc(sizeof(Utf8Problem) *
+											   Max(total.nproblems, 1));
+	for (w = 0, i = 0; w < numWorkers; w++)
+	{
+		if (states[w].nproblems > 0)
+			memcpy(&total.problems[i], states[w].problems,
+				   sizeof(Utf8Problem) * states[w].nproblems);
+		i += states[w].nproblems;
+		if (states[w].problems)
+			pg_free(states[w].problems);
+	}
+	qsort(total.problems, total.nproblems, sizeof(Utf8Problem),
+		  Utf8ProblemCmp);
+
+	for (i = 0; i < total.nproblems; i++)
+	{
+		Utf8Problem *problem = &total.problems[i];
+		char		name[64];
+
+		snprintf(name, sizeof(name), "invalid UTF-8 at byte %u",
+				 problem->validLen);
+		EmitXmlTupleTagFontTwoName(problem->blkno, problem->offset,
+								   attnamerel[problem->attnum], name,
+								   attcolorrel[problem->attnum],
+								   COLOR_RED_DARK, problem->relfileOff,
+								   problem->relfileOff + problem->len - 1);
+		fprintf(stderr, "pg_hexedit error: (%u,%u) attribute \"%s\" is not valid UTF-8 (first invalid byte at offset %u of %u)\n",
+				problem->blkno + segmentBlockDelta, problem->offset,
+				attnamerel[problem->attnum], problem->validLen, problem->len);
+		exitCode = 1;
+	}
+	EmitXmlFooter();
+
+	fprintf(stderr, "pg_hexedit notice: --check-utf8 validated %lu values (%lu bytes), found %d invalid values (%lu compressed or external values not checked, %lu malformed tuples skipped)\n",
+			(unsigned long) total.nvalues, (unsigned long) total.nbytes,
+			total.nproblems, (unsigned long) total.nunchecked,
+			(unsigned long) total.nmalformed);
+
+	pg_free(total.problems);
+	pg_free(states);
+	pg_free(stateptrs);
+}
+
+/*
+ * onPage callback for --lsn-heatmap and --fpw-estimate, which never need a
+ * page's items.  Workers only write to their own blocks' elements of pageLsns
+ * and pageHoles, so no per-worker state is needed.
+ */
+static bool
+RecordPageLsn(Page page, BlockNumber blkno, bool sane, void *arg)
+{
 	PageHeader	pageHeader = (PageHeader) page;
 
+	if (PageIsNew(page))
+		return false;
+
+	pageLsns[blkno] = GetPageLsn(page);
+
 	/*
-	 * If this is not a partial header, check the validity of the  special
-	 * section offset and contents
+	 * Full-page images omit the hole between pd_lower and pd_upper of pages
+	 * with a standard layout.  Follow XLogRecordAssemble() in assuming this
+	 * is one when the header's offsets are sane.
 	 */
-	if (bytesToFormat > sizeof(PageHeaderData))
+	if (pageHoles && sane && pageHeader->pd_lower < pageHeader->pd_upper)
+		pageHoles[blkno] = pageHeader->pd_upper - pageHeader->pd_lower;
+
+	return false;
+}
+
+/*
+ * Append block range to comma separated list of block ranges in buf
+ */
+static void
+AppendBlockRange(StringInfo buf, BlockNumber first, BlockNumber last)
+{
+	if (buf->len > 0)
+		appendStringInfoChar(buf, ',');
+
+	if (first == last)
+		appendStringInfo(buf, "%u", first);
+	else
+		appendStringInfo(buf, "%u-%u", first, last);
+}
+
+/*
+ * qsort comparator that sorts --lsn-heatmap ranges hottest first
+ */
+static int
+HeatmapRangeCmp(const void *a, const void *b)
+{
+	const HeatmapRange *rangea = (const HeatmapRange *) a;
+	const HeatmapRange *rangeb = (const HeatmapRange *) b;
+
+	if (rangea->heat != rangeb->heat)
+		return rangea->heat > rangeb->heat ? -1 : 1;
+	if (rangea->maxLsn != rangeb->maxLsn)
+		return rangea->maxLsn > rangeb->maxLsn ? -1 : 1;
+	if (rangea->start != rangeb->start)
+		return rangea->start < rangeb->start ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * Scan blocks in file (or -R range), recording each page's LSN in pageLsns,
+ * and page hole length in pageHoles when it is allocated.  New pages and
+ * pages outside the range are left as zeroes.  Range scanned is returned in
+ * first and last.
+ */
+static bool
+CollectPageLsns(BlockNumber *first, BlockNumber *last)
+{
+	void	  **stateptrs;
+	bool		result;
+
+	if (!GetScanRange(first, last))
+		return false;
+
+	pageLsns = (XLogRecPtr *) pg_malloc0(sizeof(XLogRecPtr) * (*last + 1));
+	if (blockOptions & BLOCK_FPW_ESTIMATE)
+		pageHoles = (uint16 *) pg_malloc0(sizeof(uint16) * (*last + 1));
+
+	stateptrs = (void **) pg_malloc0(sizeof(void *) * numWorkers);
+	result = ScanBlocksParallel(&pageLsnVisitor, stateptrs);
+	pg_free(stateptrs);
+
+	return result;
+}
+
+/*
+ * Print heatmap of page LSN recency per block range to stdout, in place of
+ * tags.  Output uses the same unaligned format as "psql -A".
+ *
+ * A page's recency is its LSN's position between the oldest and newest page
+ * LSN in the scan, from 0.0 to 1.0.  A range's heat is the mean recency of
+ * its pages.  Pages without an LSN (new pages, and pages of relations that
+ * are not WAL-logged) are excluded.
+ *
+ * Pages whose LSN is at or after each --lsn-cutoff are also listed, and
+ * --bookmarks receives a GoToOffset line for the newest page in each of the
+ * hottest ranges.  Block numbers are file-relative, so that they can be used
+ * with -R.
+ */
+static void
+EmitLsnHeatmap(void)
+{
+	HeatmapRange *ranges;
+	BlockNumber first;
+	BlockNumber last;
+	BlockNumber blkno;
+	BlockNumber rangeSize;
+	XLogRecPtr	minLsn = PG_UINT64_MAX;
+	XLogRecPtr	maxLsn = InvalidXLogRecPtr;
+	uint32		nwithlsn = 0;
+	int			nranges;
+	int			r;
+	int			c;
+
+	if (!CollectPageLsns(&first, &last))
+		return;
+
+	for (blkno = first; blkno <= last; blkno++)
 	{
-		specialOffset = (unsigned int) pageHeader->pd_special;
+		if (pageLsns[blkno] == InvalidXLogRecPtr)
+			continue;
 
-		/*
-		 * Check that the special offset can remain on the block or the
-		 * partial block
-		 */
-		if ((specialOffset == 0) ||
-			(specialOffset > blockSize) || (specialOffset > bytesToFormat))
-			rc = SPEC_SECT_ERROR_BOUNDARY;
-		else
+		nwithlsn++;
+		minLsn = Min(minLsn, pageLsns[blkno]);
+		maxLsn = Max(maxLsn, pageLsns[blkno]);
+	}
+
+	rangeSize = ((last - first + 1) + heatmapRanges - 1) / heatmapRanges;
+	nranges = ((last - first + 1) + rangeSize - 1) / rangeSize;
+	ranges = (HeatmapRange *) pg_malloc0(sizeof(HeatmapRange) * nranges);
+
+	printf("range|start_block|end_block|pages|min_lsn|max_lsn|heat|heatmap\n");
+	for (r = 0; r < nranges; r++)
+	{
+		HeatmapRange *range = &ranges[r];
+		double		recency = 0.0;
+		char		heatmap[21];
+		int			width;
+
+		range->start = first + r * rangeSize;
+		range->end = Min(range->start + rangeSize - 1, last);
+		range->minLsn = InvalidXLogRecPtr;
+		range->maxLsn = InvalidXLogRecPtr;
+		range->maxLsnBlock = range->start;
+
+		for (blkno = range->start; blkno <= range->end; blkno++)
 		{
-			/* we may need to examine last 2 bytes of page to identify index */
-			uint16	   *ptype = (uint16 *) (buffer + blockSize - sizeof(uint16));
+			XLogRecPtr	lsn = pageLsns[blkno];
+
+			if (lsn == InvalidXLogRecPtr)
+				continue;
+
+			if (range->npages == 0 || lsn < range->minLsn)
+				range->minLsn = lsn;
+			if (lsn > range->maxLsn)
+			{
+				range->maxLsn = lsn;
+				range->maxLsnBlock = blkno;
+			}
+			range->npages++;
+			recency += maxLsn == minLsn ? 1.0 :
+				(double) (lsn - minLsn) / (double) (maxLsn - minLsn);
+		}
+
+		if (range->npages > 0)
+			range->heat = recency / range->npages;
+
+		width = (int) (range->heat * (sizeof(heatmap) - 1) + 0.5);
+		memset(heatmap, '.', sizeof(heatmap) - 1);
+		memset(heatmap, '#', width);
+		heatmap[sizeof(heatmap) - 1] = '\0';
+
+		printf("%d|%u|%u|%u|%X/%08X|%X/%08X|%.4f|%s\n",
+			   r + 1, range->start, range->end, range->npages,
+			   (uint32) (range->minLsn >> 32), (uint32) range->minLsn,
+			   (uint32) (range->maxLsn >> 32), (uint32) range->maxLsn,
+			   range->heat, heatmap);
+	}
 
-			specialSize = blockSize - specialOffset;
+	if (nlsnCutoffs > 0)
+	{
+		StringInfoData blocks;
 
-			/*
-			 * If there is a special section, use its size to guess its
-			 * contents, checking the last 2 bytes of the page in cases that
-			 * are ambiguous.  Note we don't attempt to dereference  the
-			 * pointers without checking bytesToFormat == blockSize.
-			 */
-			if (specialSize == 0)
-				rc = SPEC_SECT_NONE;
-			else if (specialSize == MAXALIGN(sizeof(uint32)))
+		initStringInfo(&blocks);
+		printf("\nlsn_cutoff|pages|blocks\n");
+		for (c = 0; c < nlsnCutoffs; c++)
+		{
+			BlockNumber runStart = InvalidBlockNumber;
+			uint32		npages = 0;
+
+			resetStringInfo(&blocks);
+			for (blkno = first; blkno <= last; blkno++)
 			{
-				/*
-				 * If MAXALIGN is 8, this could be either a sequence or
-				 * SP-GiST or GIN.
-				 */
-				if (bytesToFormat == blockSize)
+				if (pageLsns[blkno] != InvalidXLogRecPtr &&
+					pageLsns[blkno] >= lsnCutoffs[c])
 				{
-					specialValue = *((int *) (buffer + specialOffset));
-					if (specialValue == SEQUENCE_MAGIC)
-						rc = SPEC_SECT_SEQUENCE;
-					else if (specialSize == MAXALIGN(sizeof(SpGistPageOpaqueData)) &&
-							 *ptype == SPGIST_PAGE_ID)
-						rc = SPEC_SECT_INDEX_SPGIST;
-					else if (specialSize == MAXALIGN(sizeof(BrinSpecialSpace)) &&
-							 IsBrinPage(page))
-						rc = SPEC_SECT_INDEX_BRIN;
-					else if (specialSize == MAXALIGN(sizeof(GinPageOpaqueData)))
-						rc = SPEC_SECT_INDEX_GIN;
-					else
-						rc = SPEC_SECT_ERROR_UNKNOWN;
+					npages++;
+					if (runStart == InvalidBlockNumber)
+						runStart = blkno;
+				}
+				else if (runStart != InvalidBlockNumber)
+				{
+					AppendBlockRange(&blocks, runStart, blkno - 1);
+					runStart = InvalidBlockNumber;
 				}
-				else
-					rc = SPEC_SECT_ERROR_UNKNOWN;
 			}
+			if (runStart != InvalidBlockNumber)
+				AppendBlockRange(&blocks, runStart, last);
 
-			/*
-			 * SP-GiST and GIN have same size special section, so check the
-			 * page ID bytes first
-			 */
-			else if (specialSize == MAXALIGN(sizeof(SpGistPageOpaqueData)) &&
-					 bytesToFormat == blockSize &&
-					 *ptype == SPGIST_PAGE_ID)
-				rc = SPEC_SECT_INDEX_SPGIST;
-			else if (specialSize == MAXALIGN(sizeof(BrinSpecialSpace)) &&
-					 IsBrinPage(page))
-				rc = SPEC_SECT_INDEX_BRIN;
-			else if (specialSize == MAXALIGN(sizeof(GinPageOpaqueData)))
-				rc = SPEC_SECT_INDEX_GIN;
-			else if (specialSize > 2 && bytesToFormat == blockSize)
+			printf("%X/%08X|%u|%s\n",
+				   (uint32) (lsnCutoffs[c] >> 32), (uint32) lsnCutoffs[c],
+				   npages, blocks.data);
+		}
+		pg_free(blocks.data);
+	}
+
+	if (bookmarksFileName)
+	{
+		FILE	   *bookmarksFp = fopen(bookmarksFileName, "w");
+		int			nbookmarks = 0;
+
+		if (!bookmarksFp)
+		{
+			fprintf(stderr, "pg_hexedit error: could not open bookmarks file \"%s\" for writing\n",
+					bookmarksFileName);
+			exitCode = 1;
+		}
+		else
+		{
+			qsort(ranges, nranges, sizeof(HeatmapRange), HeatmapRangeCmp);
+			for (r = 0; r < nranges && nbookmarks < MAX_BOOKMARKS; r++)
 			{
-				/*
-				 * As of 8.3, BTree, Hash, and GIST all have the same size
-				 * special section, but the last two bytes of the section can
-				 * be checked to determine what's what.
-				 */
-				if (*ptype <= MAX_BT_CYCLE_ID &&
-					specialSize == MAXALIGN(sizeof(BTPageOpaqueData)))
-					rc = SPEC_SECT_INDEX_BTREE;
-				else if (*ptype == HASHO_PAGE_ID &&
-						 specialSize == MAXALIGN(sizeof(HashPageOpaqueData)))
-					rc = SPEC_SECT_INDEX_HASH;
-				else if (*ptype == GIST_PAGE_ID &&
-						 specialSize == MAXALIGN(sizeof(GISTPageOpaqueData)))
-					rc = SPEC_SECT_INDEX_GIST;
-				else
-					rc = SPEC_SECT_ERROR_UNKNOWN;
+				if (ranges[r].npages == 0)
+					continue;
+
+				fprintf(bookmarksFp, "GoToOffset%d=%lu\n", nbookmarks++,
+						(unsigned long) ranges[r].maxLsnBlock * blockSize);
 			}
-			else
-				rc = SPEC_SECT_ERROR_UNKNOWN;
+			fclose(bookmarksFp);
 		}
 	}
+
+	if (nwithlsn == 0)
+		fprintf(stderr, "pg_hexedit notice: --lsn-heatmap found no pages with an LSN among %u blocks\n",
+				last - first + 1);
 	else
-		rc = SPEC_SECT_ERROR_UNKNOWN;
+		fprintf(stderr, "pg_hexedit notice: --lsn-heatmap scanned %u blocks (%u with an LSN), LSNs range from %X/%08X to %X/%08X\n",
+				last - first + 1, nwithlsn,
+				(uint32) (minLsn >> 32), (uint32) minLsn,
+				(uint32) (maxLsn >> 32), (uint32) maxLsn);
+
+	pg_free(ranges);
+	pg_free(pageLsns);
+	pageLsns = NULL;
+}
 
-	return rc;
+/*
+ * Print number of pages dirtied since each --redo checkpoint REDO LSN, and
+ * the WAL bytes that full-page images of those pages cost, to stdout in place
+ * of tags.  Output uses the same unaligned format as "psql -A".  A summary
+ * for the whole file is followed by a breakdown per block range.
+ *
+ * With full_page_writes, the first modification of a page after a checkpoint
+ * begins logs an image of the page.  A page whose LSN is at or after a REDO
+ * LSN was therefore logged in full at least once since that checkpoint, and
+ * is likely to be logged in full again during the next checkpoint cycle if
+ * it remains hot.  Image size excludes the page's hole, and includes block
+ * and image headers, but not the WAL record that contains the image.  It is
+ * the size before any wal_compression.
+ */
+static void
+EmitFpwEstimate(void)
+{
+	BlockNumber first;
+	BlockNumber last;
+	BlockNumber blkno;
+	BlockNumber rangeSize;
+	XLogRecPtr	latestRedo = InvalidXLogRecPtr;
+	uint64		latestDirtied = 0;
+	uint64		latestBytes = 0;
+	int			nranges;
+	int			r;
+	int			c;
+
+	if (!CollectPageLsns(&first, &last))
+		return;
+
+	rangeSize = ((last - first + 1) + fpwRanges - 1) / fpwRanges;
+	nranges = ((last - first + 1) + rangeSize - 1) / rangeSize;
+
+	printf("redo_lsn|pages|dirtied|dirtied_frac|fpi_bytes\n");
+	for (c = 0; c < nredoLsns; c++)
+	{
+		uint64		dirtied = 0;
+		uint64		bytes = 0;
+
+		for (blkno = first; blkno <= last; blkno++)
+		{
+			if (pageLsns[blkno] == InvalidXLogRecPtr ||
+				pageLsns[blkno] < redoLsns[c])
+				continue;
+
+			dirtied++;
+			bytes += SizeOfXLogRecordBlockHeader +
+				SizeOfXLogRecordBlockImageHeader +
+				blockSize - pageHoles[blkno];
+		}
+
+		printf("%X/%08X|%u|" UINT64_FORMAT "|%.4f|" UINT64_FORMAT "\n",
+			   (uint32) (redoLsns[c] >> 32), (uint32) redoLsns[c],
+			   last - first + 1, dirtied,
+			   (double) dirtied / (last - first + 1), bytes);
+
+		if (redoLsns[c] >= latestRedo)
+		{
+			latestRedo = redoLsns[c];
+			latestDirtied = dirtied;
+			latestBytes = bytes;
+		}
+	}
+
+	printf("\nredo_lsn|range|start_block|end_block|dirtied|fpi_bytes\n");
+	for (c = 0; c < nredoLsns; c++)
+	{
+		for (r = 0; r < nranges; r++)
+		{
+			BlockNumber start = first + r * rangeSize;
+			BlockNumber end = Min(start + rangeSize - 1, last);
+			uint32		dirtied = 0;
+			uint64		bytes = 0;
+
+			for (blkno = start; blkno <= end; blkno++)
+			{
+				if (pageLsns[blkno] == InvalidXLogRecPtr ||
+					pageLsns[blkno] < redoLsns[c])
+					continue;
+
+				dirtied++;
+				bytes += SizeOfXLogRecordBlockHeader +
+					SizeOfXLogRecordBlockImageHeader +
+					blockSize - pageHoles[blkno];
+			}
+
+			printf("%X/%08X|%d|%u|%u|%u|" UINT64_FORMAT "\n",
+				   (uint32) (redoLsns[c] >> 32), (uint32) redoLsns[c],
+				   r + 1, start, end, dirtied, bytes);
+		}
+	}
+
+	fprintf(stderr, "pg_hexedit notice: " UINT64_FORMAT " of %u pages dirtied since latest REDO %X/%08X, for an estimated " UINT64_FORMAT " bytes of full-page images per checkpoint cycle\n",
+			latestDirtied, last - first + 1,
+			(uint32) (latestRedo >> 32), (uint32) latestRedo, latestBytes);
+
+	pg_free(pageHoles);
+	pg_free(pageLsns);
+	pageHoles = NULL;
+	pageLsns = NULL;
 }
 
-static const char *
-GetSpecialSectionString(unsigned int type)
+/*
+ * Does name look like a relation's main fork segment file ("16384" or
+ * "16384.1")?  With segments false, only the relfilenode form is accepted,
+ * as needed for database directories.
+ */
+static bool
+IsRelationFileName(const char *name, bool segments)
+{
+	const char *p = name;
+
+	if (!isdigit((unsigned char) *p))
+		return false;
+	while (isdigit((unsigned char) *p))
+		p++;
+
+	if (*p == '.' && segments && isdigit((unsigned char) p[1]))
+	{
+		p++;
+		while (isdigit((unsigned char) *p))
+			p++;
+	}
+
+	return *p == '\0';
+}
+
+/*
+ * Add every main fork segment file in directory relDir (relative to
+ * metricsDataDir) to metricsFiles.  Other forks and temporary relations are
+ * skipped, as are files that vanish while the directory is being read.
+ */
+static void
+CollectMetricsFiles(const char *relDir)
+{
+	char		path[MAXPGPATH];
+	DIR		   *dir;
+	struct dirent *de;
+
+	snprintf(path, sizeof(path), "%s/%s", metricsDataDir, relDir);
+	dir = opendir(path);
+	if (!dir)
+	{
+		if (errno != ENOENT)
+		{
+			fprintf(stderr, "pg_hexedit error: could not open directory \"%s\": %s\n",
+					path, strerror(errno));
+			exitCode = 1;
+		}
+		return;
+	}
+
+	while ((de = readdir(dir)) != NULL)
+	{
+		MetricsFile *file;
+		struct stat st;
+		char		relPath[MAXPGPATH];
+
+		if (!IsRelationFileName(de->d_name, true))
+			continue;
+
+		snprintf(relPath, sizeof(relPath), "%s/%s", relDir, de->d_name);
+		snprintf(path, sizeof(path), "%s/%s", metricsDataDir, relPath);
+		if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+			continue;
+
+		if (nmetricsFiles == maxMetricsFiles)
+		{
+			maxMetricsFiles = Max(maxMetricsFiles * 2, 64);
+			metricsFiles = (MetricsFile *)
+				pg_realloc(metricsFiles, sizeof(MetricsFile) * maxMetricsFiles);
+		}
+
+		file = &metricsFiles[nmetricsFiles++];
+		file->path = pg_strdup(path);
+		file->relPath = pg_strdup(relPath);
+		file->segno = GetSegmentNumberFromFileName(relPath);
+		if (file->segno > 0)
+			*strrchr(file->relPath, '.') = '\0';
+		file->size = st.st_size;
+	}
+
+	closedir(dir);
+}
+
+/*
+ * Add every subdirectory of relDir (relative to metricsDataDir) whose name
+ * is all digits (or starts with prefix, when that isn't NULL) to subdirs
+ */
+static int
+ListMetricsSubdirs(const char *relDir, const char *prefix, char ***subdirs)
+{
+	char		path[MAXPGPATH];
+	DIR		   *dir;
+	struct dirent *de;
+	int			nsubdirs = 0;
+
+	*subdirs = NULL;
+	snprintf(path, sizeof(path), "%s/%s", metricsDataDir, relDir);
+	dir = opendir(path);
+	if (!dir)
+	{
+		if (errno != ENOENT)
+		{
+			fprintf(stderr, "pg_hexedit error: could not open directory \"%s\": %s\n",
+					path, strerror(errno));
+			exitCode = 1;
+		}
+		return 0;
+	}
+
+	while ((de = readdir(dir)) != NULL)
+	{
+		if (prefix ? strncmp(de->d_name, prefix, strlen(prefix)) != 0 :
+			!IsRelationFileName(de->d_name, false))
+			continue;
+
+		*subdirs = (char **) pg_realloc(*subdirs,
+										sizeof(char *) * (nsubdirs + 1));
+		(*subdirs)[nsubdirs] = psprintf("%s/%s", relDir, de->d_name);
+		nsubdirs++;
+	}
+	closedir(dir);
+
+	return nsubdirs;
+}
+
+/*
+ * qsort comparator that sorts --metrics files by relation, and then by
+ * segment number
+ */
+static int
+MetricsFileCmp(const void *a, const void *b)
+{
+	const MetricsFile *filea = (const MetricsFile *) a;
+	const MetricsFile *fileb = (const MetricsFile *) b;
+	int			cmp = strcmp(filea->relPath, fileb->relPath);
+
+	if (cmp != 0)
+		return cmp;
+	if (filea->segno != fileb->segno)
+		return filea->segno < fileb->segno ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * Note that state's relation has an unfrozen XID, keeping track of the
+ * oldest one seen (in modulo-2^32 XID order)
+ */
+static void
+MetricsNoteXid(MetricsState *state, TransactionId xid)
+{
+	if (state->oldestXid == InvalidTransactionId ||
+		(int32) (xid - state->oldestXid) < 0)
+		state->oldestXid = xid;
+}
+
+/*
+ * Add the metrics in state to total
+ */
+static void
+MergeMetricsState(MetricsState *total, MetricsState *state)
+{
+	int			t;
+
+	total->nblocks += state->nblocks;
+	for (t = 0; t < METRICS_PAGE_NTYPES; t++)
+		total->npages[t] += state->npages[t];
+	total->freeBytes += state->freeBytes;
+	total->nitems += state->nitems;
+	total->ndeadItems += state->ndeadItems;
+	total->ndeadTuples += state->ndeadTuples;
+	total->nchecksumFailures += state->nchecksumFailures;
+	if (state->oldestXid != InvalidTransactionId)
+		MetricsNoteXid(total, state->oldestXid);
+}
+
+/*
+ * PageProblemCallback for --metrics, which only needs to know whether the
+ * page header has any anomaly.  Errors aren't reported for individual pages,
+ * since they're counted instead.
+ */
+static void
+NoteMetricsPageProblem(void *arg, BlockNumber blkno, OffsetNumber offset,
+					   checkAnomalyCodes code, unsigned int start,
+					   unsigned int end, const char *detail)
+{
+	if (offset == InvalidOffsetNumber)
+		((MetricsState *) arg)->invalidPage = true;
+}
+
+/*
+ * --metrics onPage callback
+ */
+static bool
+MetricsVisitPage(Page page, BlockNumber blkno, bool sane, void *arg)
+{
+	MetricsState *state = (MetricsState *) arg;
+	PageHeader	pageHeader = (PageHeader) page;
+	uint16		calculated;
+
+	state->nblocks++;
+
+	/* New pages are all free space, and never have a checksum */
+	if (PageIsNew(page))
+	{
+		state->npages[METRICS_PAGE_NEW]++;
+		state->freeBytes += blockSize - SizeOfPageHeaderData;
+		return false;
+	}
+
+	if (VerifyPageChecksum(page, blkno, &calculated) == PAGE_CHECKSUM_INVALID)
+		state->nchecksumFailures++;
+
+	if (state->invalidPage)
+	{
+		state->npages[METRICS_PAGE_INVALID]++;
+		state->invalidPage = false;
+		return false;
+	}
+
+	switch (specialType)
+	{
+		case SPEC_SECT_NONE:
+			state->pageType = METRICS_PAGE_HEAP;
+			break;
+		case SPEC_SECT_SEQUENCE:
+			state->pageType = METRICS_PAGE_SEQUENCE;
+			break;
+		case SPEC_SECT_INDEX_BTREE:
+			state->pageType = METRICS_PAGE_BTREE;
+			break;
+		case SPEC_SECT_INDEX_HASH:
+			state->pageType = METRICS_PAGE_HASH;
+			break;
+		case SPEC_SECT_INDEX_GIST:
+			state->pageType = METRICS_PAGE_GIST;
+			break;
+		case SPEC_SECT_INDEX_GIN:
+			state->pageType = METRICS_PAGE_GIN;
+			break;
+		case SPEC_SECT_INDEX_SPGIST:
+			state->pageType = METRICS_PAGE_SPGIST;
+			break;
+		case SPEC_SECT_INDEX_BRIN:
+			state->pageType = METRICS_PAGE_BRIN;
+			break;
+		default:
+			if (IsPluginType(specialType))
+				state->pageType = METRICS_PAGE_PLUGIN;
+			else
+				state->pageType = METRICS_PAGE_UNKNOWN;
+			break;
+	}
+
+	state->npages[state->pageType]++;
+	state->freeBytes += pageHeader->pd_upper - pageHeader->pd_lower;
+
+	return true;
+}
+
+/*
+ * --metrics onItemId callback.  Every line pointer is counted, but only the
+ * tuples of heap pages are examined.
+ */
+static bool
+MetricsVisitItemId(Page page, BlockNumber blkno, OffsetNumber offset,
+				   ItemId itemId, bool hasStorage, void *arg)
+{
+	MetricsState *state = (MetricsState *) arg;
+
+	state->nitems++;
+	if (ItemIdIsDead(itemId))
+		state->ndeadItems++;
+
+	return state->pageType == METRICS_PAGE_HEAP && ItemIdIsNormal(itemId);
+}
+
+/*
+ * --metrics onHeapTuple callback
+ */
+static int
+MetricsVisitHeapTuple(Page page, BlockNumber blkno, OffsetNumber offset,
+					  HeapTupleHeader htup, unsigned int itemSize, void *arg)
+{
+	MetricsState *state = (MetricsState *) arg;
+	TransactionId xmax;
+
+	if (HeapTupleIsDeadByHints(htup))
+	{
+		state->ndeadTuples++;
+		return 0;
+	}
+
+	if (!HeapTupleHeaderXminFrozen(htup) &&
+		TransactionIdIsNormal(HeapTupleHeaderGetRawXmin(htup)))
+		MetricsNoteXid(state, HeapTupleHeaderGetRawXmin(htup));
+
+	xmax = HeapTupleHeaderGetRawXmax(htup);
+	if (!(htup->t_infomask & (HEAP_XMAX_INVALID | HEAP_XMAX_IS_MULTI)) &&
+		TransactionIdIsNormal(xmax))
+		MetricsNoteXid(state, xmax);
+
+	return 0;
+}
+
+/*
+ * Write s to out as a Prometheus label value, escaping it as needed
+ */
+static void
+EmitPromLabelValue(FILE *out, const char *s)
 {
-	switch (type)
+	fputc('"', out);
+	for (; *s; s++)
 	{
-		case SPEC_SECT_NONE:
-			return "SPEC_SECT_NONE";
-		case SPEC_SECT_SEQUENCE:
-			return "SPEC_SECT_SEQUENCE";
-		case SPEC_SECT_INDEX_BTREE:
-			return "SPEC_SECT_INDEX_BTREE";
-		case SPEC_SECT_INDEX_HASH:
-			return "SPEC_SECT_INDEX_HASH";
-		case SPEC_SECT_INDEX_GIST:
-			return "SPEC_SECT_INDEX_GIST";
-		case SPEC_SECT_INDEX_GIN:
-			return "SPEC_SECT_INDEX_GIN";
-		case SPEC_SECT_INDEX_SPGIST:
-			return "SPEC_SECT_INDEX_SPGIST";
-		case SPEC_SECT_INDEX_BRIN:
-			return "SPEC_SECT_INDEX_BRIN";
-		case SPEC_SECT_ERROR_UNKNOWN:
-			return "SPEC_SECT_ERROR_UNKNOWN";
-		case SPEC_SECT_ERROR_BOUNDARY:
-			return "SPEC_SECT_ERROR_BOUNDARY";
-		default:
-			return "???";
+		if (*s == '\\' || *s == '"')
+			fprintf(out, "\\%c", *s);
+		else if (*s == '\n')
+			fputs("\\n", out);
+		else
+			fputc(*s, out);
 	}
+	fputc('"', out);
 }
 
 /*
- * Given Heap tuple header, return string buffer with t_infomask or t_infomask2
- * flags.
- *
- * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ * Write HELP and TYPE lines for a --metrics metric
  */
-static char *
-GetHeapTupleHeaderFlags(HeapTupleHeader htup, bool isInfomask2)
+static void
+EmitPromHeader(FILE *out, const char *name, const char *help)
 {
-	unsigned int bitmapLength = 0;
-	unsigned int oidLength = 0;
-	unsigned int computedLength;
-	unsigned int localHoff;
-	unsigned int localBitOffset;
-	char	   *flagString = NULL;
+	fprintf(out, "# HELP %s %s\n# TYPE %s gauge\n", name, help, name);
+}
 
-	flagString = pg_malloc(512);
-	localHoff = htup->t_hoff;
-	localBitOffset = offsetof(HeapTupleHeaderData, t_bits);
+/*
+ * Write the start of a --metrics sample line for rel, up to and including
+ * its labels (but not their closing brace)
+ */
+static void
+EmitPromRelationSample(FILE *out, const char *name, MetricsRelation *rel)
+{
+	char	   *components[5];
+	char	   *path = pg_strdup(rel->path);
+	char	   *slash;
+	const char *tablespace = "";
+	const char *database = "";
+	int			n = 0;
 
 	/*
-	 * Place readable versions of the tuple info mask into a buffer. Assume
-	 * that the string can not expand beyond 512 bytes.
+	 * Work out the tablespace and database from the last few components of
+	 * path: global/rel, base/db/rel, or pg_tblspc/spc/version/db/rel
 	 */
-	flagString[0] = '\0';
-	if (!isInfomask2)
+	while (n < lengthof(components) &&
+		   (slash = strrchr(path, '/')) != NULL)
 	{
-		strcat(flagString, "t_infomask (");
-
-		if (htup->t_infomask & HEAP_HASNULL)
-			strcat(flagString, "HEAP_HASNULL|");
-		if (htup->t_infomask & HEAP_HASVARWIDTH)
-			strcat(flagString, "HEAP_HASVARWIDTH|");
-		if (htup->t_infomask & HEAP_HASEXTERNAL)
-			strcat(flagString, "HEAP_HASEXTERNAL|");
-		if (htup->t_infomask & HEAP_HASOID)
-			strcat(flagString, "HEAP_HASOID|");
-		if (htup->t_infomask & HEAP_XMAX_KEYSHR_LOCK)
-			strcat(flagString, "HEAP_XMAX_KEYSHR_LOCK|");
-		if (htup->t_infomask & HEAP_COMBOCID)
-			strcat(flagString, "HEAP_COMBOCID|");
-		if (htup->t_infomask & HEAP_XMAX_EXCL_LOCK)
-			strcat(flagString, "HEAP_XMAX_EXCL_LOCK|");
-		if (htup->t_infomask & HEAP_XMAX_LOCK_ONLY)
-			strcat(flagString, "HEAP_XMAX_LOCK_ONLY|");
-		if (htup->t_infomask & HEAP_XMIN_COMMITTED)
-			strcat(flagString, "HEAP_XMIN_COMMITTED|");
-		if (htup->t_infomask & HEAP_XMIN_INVALID)
-			strcat(flagString, "HEAP_XMIN_INVALID|");
-		if (htup->t_infomask & HEAP_XMAX_COMMITTED)
-			strcat(flagString, "HEAP_XMAX_COMMITTED|");
-		if (htup->t_infomask & HEAP_XMAX_INVALID)
-			strcat(flagString, "HEAP_XMAX_INVALID|");
-		if (htup->t_infomask & HEAP_XMAX_IS_MULTI)
-			strcat(flagString, "HEAP_XMAX_IS_MULTI|");
-		if (htup->t_infomask & HEAP_UPDATED)
-			strcat(flagString, "HEAP_UPDATED|");
-		if (htup->t_infomask & HEAP_MOVED_OFF)
-			strcat(flagString, "HEAP_MOVED_OFF|");
-		if (htup->t_infomask & HEAP_MOVED_IN)
-			strcat(flagString, "HEAP_MOVED_IN|");
+		components[n++] = slash + 1;
+		*slash = '\0';
+	}
+	if (n < lengthof(components))
+		components[n++] = path;
 
-		if (strlen(flagString))
-			flagString[strlen(flagString) - 1] = '\0';
-		strcat(flagString, ")");
+	if (n >= 2 && strcmp(components[1], "global") == 0)
+	{
+		tablespace = "1664";
+		database = "0";
 	}
-	else
+	else if (n >= 3 && strcmp(components[2], "base") == 0)
 	{
-		sprintf(flagString, "t_infomask2 HeapTupleHeaderGetNatts(): %d ",
-				HeapTupleHeaderGetNatts(htup));
+		tablespace = "1663";
+		database = components[1];
+	}
+	else if (n >= 5 && strcmp(components[4], "pg_tblspc") == 0)
+	{
+		tablespace = components[3];
+		database = components[1];
+	}
 
-		if (htup->t_infomask2 & ~HEAP_NATTS_MASK)
-			strcat(flagString, "(");
+	fprintf(out, "%s{path=", name);
+	EmitPromLabelValue(out, rel->path);
+	fprintf(out, ",tablespace=\"%s\",database=\"%s\",relfilenode=",
+			IsRelationFileName(tablespace, false) ? tablespace : "",
+			IsRelationFileName(database, false) ? database : "");
+	EmitPromLabelValue(out, n > 0 ? components[0] : "");
 
+	pg_free(path);
+}
 
-		if (htup->t_infomask2 & HEAP_KEYS_UPDATED)
-			strcat(flagString, "HEAP_KEYS_UPDATED|");
-		if (htup->t_infomask2 & HEAP_HOT_UPDATED)
-			strcat(flagString, "HEAP_HOT_UPDATED|");
-		if (htup->t_infomask2 & HEAP_ONLY_TUPLE)
-			strcat(flagString, "HEAP_ONLY_TUPLE|");
+/*
+ * Write per-relation --metrics metrics to out, in the Prometheus text
+ * exposition format
+ */
+static void
+EmitPromMetrics(FILE *out, MetricsRelation *rels, int nrels, double duration)
+{
+	static const struct
+	{
+		const char *name;
+		const char *help;
+		size_t		offset;
+	}			counts[] =
+	{
+		{
+			"pg_hexedit_relation_blocks",
+			"Blocks in main fork segment files of relation.",
+			offsetof(MetricsState, nblocks)
+		},
+		{
+			"pg_hexedit_relation_free_bytes",
+			"Bytes between pd_lower and pd_upper of relation's pages (new pages count as free).",
+			offsetof(MetricsState, freeBytes)
+		},
+		{
+			"pg_hexedit_relation_line_pointers",
+			"Line pointers on relation's pages.",
+			offsetof(MetricsState, nitems)
+		},
+		{
+			"pg_hexedit_relation_dead_items",
+			"LP_DEAD line pointers on relation's pages.",
+			offsetof(MetricsState, ndeadItems)
+		},
+		{
+			"pg_hexedit_relation_dead_tuples",
+			"Heap tuples that hint bits show are dead.",
+			offsetof(MetricsState, ndeadTuples)
+		},
+		{
+			"pg_hexedit_relation_checksum_failures",
+			"Pages whose checksum is incorrect.",
+			offsetof(MetricsState, nchecksumFailures)
+		}
+	};
+	int			m;
+	int			r;
+	int			t;
+
+	EmitPromHeader(out, "pg_hexedit_relation_pages",
+				   "Pages of relation by page type.");
+	for (r = 0; r < nrels; r++)
+	{
+		for (t = 0; t < METRICS_PAGE_NTYPES; t++)
+		{
+			if (rels[r].state.npages[t] == 0)
+				continue;
 
-		if (strlen(flagString))
-			flagString[strlen(flagString) - 1] = '\0';
-		if (htup->t_infomask2 & ~HEAP_NATTS_MASK)
-			strcat(flagString, ")");
+			EmitPromRelationSample(out, "pg_hexedit_relation_pages", &rels[r]);
+			fprintf(out, ",type=\"%s\"} " UINT64_FORMAT "\n",
+					metricsPageTypeNames[t], rels[r].state.npages[t]);
+		}
 	}
 
-	/*
-	 * As t_bits is a variable length array, and may contain an Oid field,
-	 * determine the length of the header proper as a sanity check.
-	 */
-	if (htup->t_infomask & HEAP_HASNULL)
-		bitmapLength = BITMAPLEN(HeapTupleHeaderGetNatts(htup));
-	else
-		bitmapLength = 0;
-
-	if (htup->t_infomask & HEAP_HASOID)
-		oidLength += sizeof(Oid);
-
-	computedLength =
-		MAXALIGN(localBitOffset + bitmapLength + oidLength);
+	for (m = 0; m < lengthof(counts); m++)
+	{
+		EmitPromHeader(out, counts[m].name, counts[m].help);
+		for (r = 0; r < nrels; r++)
+		{
+			EmitPromRelationSample(out, counts[m].name, &rels[r]);
+			fprintf(out, "} " UINT64_FORMAT "\n",
+					*(uint64 *) ((char *) &rels[r].state + counts[m].offset));
+		}
+	}
 
-	/*
-	 * Inform the user of a header size mismatch or dump the t_bits array
-	 */
-	if (computedLength != localHoff)
+	EmitPromHeader(out, "pg_hexedit_relation_oldest_unfrozen_xid",
+				   "Oldest XID on relation's heap pages that is not frozen (only for relations that have one).");
+	for (r = 0; r < nrels; r++)
 	{
-		fprintf
-			(stderr,
-			 "pg_hexedit error: computed header length not equal to header size.\n"
-			 "computed: %u header: %d\n", computedLength, localHoff);
+		if (rels[r].state.oldestXid == InvalidTransactionId)
+			continue;
 
-		exitCode = 1;
+		EmitPromRelationSample(out, "pg_hexedit_relation_oldest_unfrozen_xid",
+							   &rels[r]);
+		fprintf(out, "} %u\n", rels[r].state.oldestXid);
 	}
 
-	return flagString;
+	EmitPromHeader(out, "pg_hexedit_metrics_relations",
+				   "Relations scanned.");
+	fprintf(out, "pg_hexedit_metrics_relations %d\n", nrels);
+	EmitPromHeader(out, "pg_hexedit_metrics_scan_duration_seconds",
+				   "Time taken to scan relations.");
+	fprintf(out, "pg_hexedit_metrics_scan_duration_seconds %.3f\n", duration);
+	EmitPromHeader(out, "pg_hexedit_metrics_scan_success",
+				   "Whether scan completed without errors.");
+	fprintf(out, "pg_hexedit_metrics_scan_success %d\n", exitCode == 0);
+	EmitPromHeader(out, "pg_hexedit_metrics_last_run_timestamp_seconds",
+				   "Time that scan completed.");
+	fprintf(out, "pg_hexedit_metrics_last_run_timestamp_seconds %ld\n",
+			(long) time(NULL));
 }
 
 /*
- * Given IndexTuple, return string buffer with t_info reported tuple length,
- * and flags.
+ * Scan one relation segment file for --metrics, adding its metrics to rel
+ */
+static void
+ScanMetricsFile(MetricsRelation *rel, MetricsState *states, void **stateptrs)
+{
+	char		header[sizeof(PageHeaderData)];
+	int			w;
+
+	memset(states, 0, sizeof(MetricsState) * numWorkers);
+
+	/* Keep block size of previous file when first page is new */
+	if (pg_pread(fileno(fp), header, sizeof(header), 0) == sizeof(header) &&
+		PageGetPageSize((Page) header) != 0)
+		blockSize = GetBlockSize();
+	segmentBlockDelta = (segmentSize / blockSize) * segmentNumber;
+
+	if (!ScanBlocksParallel(&metricsVisitor, stateptrs))
+		return;
+
+	for (w = 0; w < numWorkers; w++)
+		MergeMetricsState(&rel->state, &states[w]);
+}
+
+/*
+ * Write Prometheus metrics that summarize the physical storage of the
+ * relation file, or of every relation in a data directory, to the --metrics
+ * file instead of tags.  Metrics are aggregated per relation, over all of the
+ * segment files of its main fork.
  *
- * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ * The file is written under a temporary name, and then renamed into place,
+ * so that node_exporter's textfile collector never sees a partial file.
  */
-static char *
-GetIndexTupleFlags(IndexTuple itup)
+static void
+EmitMetrics(void)
 {
-	char	   *flagString = NULL;
+	MetricsRelation *rels;
+	MetricsState *states;
+	void	  **stateptrs;
+	struct timespec start;
+	struct timespec end;
+	FILE	   *out;
+	char		tmpPath[MAXPGPATH];
+	uint64		totalBlocks = 0;
+	int			nrels = 0;
+	int			i;
 
-	flagString = pg_malloc(512);
+	clock_gettime(CLOCK_MONOTONIC, &start);
 
-	/*
-	 * Place readable versions of the tuple info mask into a buffer.  Assume
-	 * that the string can not expand beyond 128 bytes.
-	 */
-	flagString[0] = '\0';
-	sprintf(flagString, "t_info IndexTupleSize(): %zu",
-			IndexTupleSize(itup));
+	if (metricsDataDir)
+	{
+		char	  **dbDirs;
+		char	  **spcDirs;
+		int			ndbDirs;
+		int			nspcDirs;
+		int			d;
+
+		CollectMetricsFiles("global");
+		ndbDirs = ListMetricsSubdirs("base", NULL, &dbDirs);
+		for (d = 0; d < ndbDirs; d++)
+			CollectMetricsFiles(dbDirs[d]);
+
+		/* pg_tblspc/spc/PG_version_catversion/db */
+		nspcDirs = ListMetricsSubdirs("pg_tblspc", NULL, &spcDirs);
+		for (i = 0; i < nspcDirs; i++)
+		{
+			char	  **versionDirs;
+			int			nversionDirs = ListMetricsSubdirs(spcDirs[i], "PG_",
+														  &versionDirs);
+			int			v;
 
-	if (itup->t_info & ~INDEX_SIZE_MASK)
-		strcat(flagString, ", (");
+			for (v = 0; v < nversionDirs; v++)
+			{
+				char	  **spcDbDirs;
+				int			nspcDbDirs = ListMetricsSubdirs(versionDirs[v], NULL,
+														   &spcDbDirs);
 
-	/*
-	 * Use specific index AM local name for generic reserved
-	 * INDEX_AM_RESERVED_BIT IndexTuple status bit
-	 */
-	if (itup->t_info & INDEX_AM_RESERVED_BIT)
+				for (d = 0; d < nspcDbDirs; d++)
+				{
+					CollectMetricsFiles(spcDbDirs[d]);
+					pg_free(spcDbDirs[d]);
+				}
+				pg_free(spcDbDirs);
+				pg_free(versionDirs[v]);
+			}
+			pg_free(versionDirs);
+			pg_free(spcDirs[i]);
+		}
+		pg_free(spcDirs);
+		for (d = 0; d < ndbDirs; d++)
+			pg_free(dbDirs[d]);
+		pg_free(dbDirs);
+
+		if (nmetricsFiles == 0)
+		{
+			fprintf(stderr, "pg_hexedit error: no relation files found in data directory \"%s\"\n",
+					metricsDataDir);
+			exitCode = 1;
+			return;
+		}
+		qsort(metricsFiles, nmetricsFiles, sizeof(MetricsFile),
+			  MetricsFileCmp);
+	}
+	else
 	{
-		if (specialType == SPEC_SECT_INDEX_HASH)
-			strcat(flagString, "INDEX_MOVED_BY_SPLIT_MASK|");
-		else if (specialType == SPEC_SECT_INDEX_BTREE)
-			strcat(flagString, "INDEX_ALT_TID_MASK|");
-		else
-			strcat(flagString, "INDEX_AM_RESERVED_BIT|");
+		struct stat st;
+
+		/* Label relation by file name, less any segment number suffix */
+		metricsFiles = (MetricsFile *) pg_malloc0(sizeof(MetricsFile));
+		metricsFiles[0].path = fileName;
+		metricsFiles[0].relPath = pg_strdup(fileName);
+		metricsFiles[0].segno = segmentNumber;
+		if (GetSegmentNumberFromFileName(fileName) > 0)
+			*strrchr(metricsFiles[0].relPath, '.') = '\0';
+		if (fstat(fileno(fp), &st) == 0)
+			metricsFiles[0].size = st.st_size;
+		nmetricsFiles = 1;
 	}
-	if (itup->t_info & INDEX_VAR_MASK)
-		strcat(flagString, "INDEX_VAR_MASK|");
-	if (itup->t_info & INDEX_NULL_MASK)
-		strcat(flagString, "INDEX_NULL_MASK|");
 
-	if (itup->t_info & ~INDEX_SIZE_MASK)
+	for (i = 0; i < nmetricsFiles; i++)
+		totalBlocks += metricsFiles[i].size / blockSize;
+	progressTotalBlocks = totalBlocks;
+
+	rels = (MetricsRelation *) pg_malloc0(sizeof(MetricsRelation) *
+										  nmetricsFiles);
+	states = (MetricsState *) pg_malloc0(sizeof(MetricsState) * numWorkers);
+	stateptrs = (void **) pg_malloc(sizeof(void *) * numWorkers);
+	for (i = 0; i < numWorkers; i++)
+		stateptrs[i] = &states[i];
+
+	for (i = 0; i < nmetricsFiles; i++)
 	{
-		flagString[strlen(flagString) - 1] = '\0';
-		strcat(flagString, ")");
+		MetricsFile *file = &metricsFiles[i];
+		MetricsRelation *rel;
+
+		if (nrels == 0 || strcmp(rels[nrels - 1].path, file->relPath) != 0)
+			rels[nrels++].path = file->relPath;
+		rel = &rels[nrels - 1];
+
+		/* Empty files are common, and have no header to read */
+		if (file->size == 0)
+			continue;
+
+		if (metricsDataDir)
+		{
+			fp = fopen(file->path, "rb");
+			if (!fp)
+			{
+				/* Relation may have been dropped since directory was read */
+				if (errno != ENOENT)
+				{
+					fprintf(stderr, "pg_hexedit error: could not open file \"%s\": %s\n",
+							file->path, strerror(errno));
+					exitCode = 1;
+				}
+				continue;
+			}
+			fileName = file->path;
+			segmentNumber = file->segno;
+		}
+
+		ScanMetricsFile(rel, states, stateptrs);
+
+		if (metricsDataDir)
+		{
+			fclose(fp);
+			fp = NULL;
+		}
 	}
 
-	return flagString;
-}
+	clock_gettime(CLOCK_MONOTONIC, &end);
 
-static const char *
-GetSpGistStateString(unsigned int code)
-{
-	switch (code)
+	if (strcmp(metricsFileName, "-") == 0)
+		EmitPromMetrics(stdout, rels, nrels, TimespecDiffSecs(&end, &start));
+	else
+	{
+		snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", metricsFileName);
+		out = fopen(tmpPath, "w");
+		if (!out)
+		{
+			fprintf(stderr, "pg_hexedit error: could not open metrics file \"%s\" for writing: %s\n",
+					tmpPath, strerror(errno));
+			exitCode = 1;
+		}
+		else
+		{
+			EmitPromMetrics(out, rels, nrels, TimespecDiffSecs(&end, &start));
+			if (fclose(out) != 0 || rename(tmpPath, metricsFileName) != 0)
+			{
+				fprintf(stderr, "pg_hexedit error: could not write metrics file \"%s\": %s\n",
+						metricsFileName, strerror(errno));
+				exitCode = 1;
+				unlink(tmpPath);
+			}
+		}
+	}
+
+	fprintf(stderr, "pg_hexedit notice: --metrics scanned " UINT64_FORMAT " blocks of %d relations (%d files)\n",
+			totalBlocks, nrels, nmetricsFiles);
+
+	for (i = 0; i < nmetricsFiles; i++)
 	{
-		case SPGIST_LIVE:
-			return "SPGIST_LIVE";
-		case SPGIST_REDIRECT:
-			return "SPGIST_REDIRECT";
-		case SPGIST_DEAD:
-			return "SPGIST_DEAD";
-		case SPGIST_PLACEHOLDER:
-			return "SPGIST_PLACEHOLDER";
-		default:
-			return "???";
+		if (metricsDataDir)
+			pg_free(metricsFiles[i].path);
+		pg_free(metricsFiles[i].relPath);
 	}
+	pg_free(metricsFiles);
+	metricsFiles = NULL;
+	pg_free(rels);
+	pg_free(states);
+	pg_free(stateptrs);
 }
 
 /*
- * Given SpGistInnerTuple, return string buffer with tuple-reported state from
- * bitfields.
- *
- * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ * Record --check anomaly.  start and end are the page offsets of the first
+ * and last bytes that the anomaly's tag covers.
  */
-static char *
-GetSpGistInnerTupleState(SpGistInnerTuple itup)
+static void
+AddCheckAnomaly(CheckState *state, BlockNumber blkno, OffsetNumber offset,
+				checkAnomalyCodes code, unsigned int start, unsigned int end,
+				const char *fmt,...)
 {
-	char	   *flagString = NULL;
+	CheckAnomaly *anomaly;
+	va_list		args;
 
-	flagString = pg_malloc(128);
+	if (state->nanomalies == state->maxanomalies)
+	{
+		state->maxanomalies = Max(state->maxanomalies * 2, 64);
+		state->anomalies = (CheckAnomaly *)
+			pg_realloc(state->anomalies,
+					   sizeof(CheckAnomaly) * state->maxanomalies);
+	}
 
-	sprintf(flagString, "tupstate: %s, allTheSame: %u, nNodes: %u, prefixSize: %u",
-			GetSpGistStateString(itup->tupstate), itup->allTheSame, itup->nNodes, itup->prefixSize);
+	anomaly = &state->anomalies[state->nanomalies++];
+	anomaly->blkno = blkno;
+	anomaly->offset = offset;
+	anomaly->code = code;
+	anomaly->start = Min(start, blockSize - 1);
+	anomaly->end = Min(Max(start, end), blockSize - 1);
 
-	return flagString;
+	va_start(args, fmt);
+	vsnprintf(anomaly->detail, sizeof(anomaly->detail), fmt, args);
+	va_end(args);
 }
 
 /*
- * Given SpGistLeafTuple, return string buffer with tuple-reported state from
- * bitfields.
- *
- * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ * PageProblemCallback for --check, which records each anomaly
  */
-static char *
-GetSpGistLeafTupleState(SpGistLeafTuple itup)
+static void
+AddCheckPageProblem(void *arg, BlockNumber blkno, OffsetNumber offset,
+					checkAnomalyCodes code, unsigned int start,
+					unsigned int end, const char *detail)
 {
-	char	   *flagString = NULL;
+	AddCheckAnomaly((CheckState *) arg, blkno, offset, code, start, end, "%s",
+					detail);
+}
 
-	flagString = pg_malloc(128);
+/*
+ * qsort comparator that sorts --check item spans by their start offset
+ */
+static int
+CheckItemSpanCmp(const void *a, const void *b)
+{
+	const CheckItemSpan *spana = (const CheckItemSpan *) a;
+	const CheckItemSpan *spanb = (const CheckItemSpan *) b;
 
-	sprintf(flagString, "tupstate: %s, size: %u",
-			GetSpGistStateString(itup->tupstate), itup->size);
+	if (spana->start != spanb->start)
+		return spana->start < spanb->start ? -1 : 1;
+	if (spana->offset != spanb->offset)
+		return spana->offset < spanb->offset ? -1 : 1;
 
-	return flagString;
+	return 0;
 }
 
 /*
- * Given BrinTuple, return string buffer with bt_info reported data offset, and
- * tuple flags.
- *
- * Note:  Caller is responsible for pg_free()'ing returned buffer.
+ * qsort comparator that sorts --check anomalies by block, then by offset
  */
-static char *
-GetBrinTupleFlags(BrinTuple *itup)
+static int
+CheckAnomalyCmp(const void *a, const void *b)
 {
-	char	   *flagString = NULL;
+	const CheckAnomaly *anomalya = (const CheckAnomaly *) a;
+	const CheckAnomaly *anomalyb = (const CheckAnomaly *) b;
 
-	flagString = pg_malloc(128);
+	if (anomalya->blkno != anomalyb->blkno)
+		return anomalya->blkno < anomalyb->blkno ? -1 : 1;
+	if (anomalya->offset != anomalyb->offset)
+		return anomalya->offset < anomalyb->offset ? -1 : 1;
+	if (anomalya->code != anomalyb->code)
+		return anomalya->code < anomalyb->code ? -1 : 1;
 
-	/*
-	 * Place readable versions of the tuple info mask into a buffer.  Assume
-	 * that the string can not expand beyond 128 bytes.
-	 */
-	flagString[0] = '\0';
-	sprintf(flagString, "bt_info BrinTupleDataOffset(): %zu",
-			BrinTupleDataOffset(itup));
+	return 0;
+}
 
-	if (itup->bt_info & (BRIN_PLACEHOLDER_MASK | BRIN_NULLS_MASK))
-		strcat(flagString, ", (");
+/*
+ * --check onPage callback.  Only the items of pages with a sane header are
+ * examined.  Their line pointers and heap tuple headers are checked by
+ * WalkPage() itself.
+ */
+static bool
+CheckVisitPage(Page page, BlockNumber blkno, bool sane, void *arg)
+{
+	CheckState *state = (CheckState *) arg;
+	PageHeader	pageHeader = (PageHeader) page;
+	unsigned int special = pageHeader->pd_special;
+	uint16		calculated;
 
-	if (itup->bt_info & BRIN_PLACEHOLDER_MASK)
-		strcat(flagString, "BRIN_PLACEHOLDER_MASK|");
-	if (itup->bt_info & BRIN_NULLS_MASK)
-		strcat(flagString, "BRIN_NULLS_MASK|");
+	state->npages++;
+	if (PageIsNew(page))
+		return false;
 
-	if (itup->bt_info & (BRIN_PLACEHOLDER_MASK | BRIN_NULLS_MASK))
-	{
-		flagString[strlen(flagString) - 1] = '\0';
-		strcat(flagString, ")");
-	}
+	if (!state->spans)
+		state->spans = (CheckItemSpan *)
+			pg_malloc(sizeof(CheckItemSpan) * (blockSize / sizeof(ItemIdData)));
+	state->nspans = 0;
+
+	if (VerifyPageChecksum(page, blkno, &calculated) == PAGE_CHECKSUM_INVALID)
+		AddCheckAnomaly(state, blkno, InvalidOffsetNumber, CHECK_CHECKSUM,
+						offsetof(PageHeaderData, pd_checksum),
+						offsetof(PageHeaderData, pd_flags) - 1,
+						"calculated 0x%04x, stored 0x%04x",
+						calculated, pageHeader->pd_checksum);
+
+	if (specialType == SPEC_SECT_ERROR_UNKNOWN ||
+		specialType == SPEC_SECT_ERROR_BOUNDARY)
+		AddCheckAnomaly(state, blkno, InvalidOffsetNumber,
+						CHECK_SPECIAL_UNKNOWN,
+						sane ? special : offsetof(PageHeaderData, pd_special),
+						sane ? blockSize - 1 :
+						offsetof(PageHeaderData, pd_pagesize_version) - 1,
+						"special section size %d", (int) blockSize - (int) special);
+	else
+		checkPageTypes[blkno] = specialType;
 
-	return flagString;
+	return sane;
 }
 
-/*	Check whether page is a BRIN meta page */
+/*
+ * --check onItemId callback.  Records the storage of items that have it, so
+ * that overlaps can be found once the page's items have all been visited.
+ */
 static bool
-IsBrinPage(Page page)
+CheckVisitItemId(Page page, BlockNumber blkno, OffsetNumber offset,
+				 ItemId itemId, bool hasStorage, void *arg)
 {
-	if (bytesToFormat != blockSize)
+	CheckState *state = (CheckState *) arg;
+	PageHeader	pageHeader = (PageHeader) page;
+	unsigned int itemSize = ItemIdGetLength(itemId);
+	unsigned int itemOffset = ItemIdGetOffset(itemId);
+
+	if (!hasStorage)
 		return false;
 
-	if (BRIN_IS_META_PAGE(page) || BRIN_IS_REVMAP_PAGE(page) ||
-		BRIN_IS_REGULAR_PAGE(page))
-		return true;
-	return false;
+	if (itemOffset < pageHeader->pd_upper ||
+		itemOffset + itemSize > pageHeader->pd_special)
+		AddCheckAnomaly(state, blkno, offset, CHECK_ITEM_OUTSIDE_TUPLES,
+						itemOffset, itemOffset + itemSize - 1,
+						"lp_off %u, lp_len %u, pd_upper %u, pd_special %u",
+						itemOffset, itemSize, pageHeader->pd_upper,
+						pageHeader->pd_special);
+
+	state->spans[state->nspans].start = itemOffset;
+	state->spans[state->nspans].end = itemOffset + itemSize;
+	state->spans[state->nspans].offset = offset;
+	state->nspans++;
+
+	return true;
 }
 
-/*	Check whether page is a hash bitmap page */
-static bool
-IsHashBitmapPage(Page page)
+/*
+ * --check onIndexTuple callback
+ */
+static void
+CheckVisitIndexTuple(Page page, BlockNumber blkno, OffsetNumber offset,
+					 IndexTuple itup, unsigned int itemSize, void *arg)
 {
-	HashPageOpaque opaque;
+	unsigned int itemOffset = (char *) itup - (char *) page;
+
+	if (itemSize < sizeof(IndexTupleData) || IndexTupleSize(itup) > itemSize)
+		AddCheckAnomaly((CheckState *) arg, blkno, offset,
+						CHECK_INDEX_TUPLE_SIZE, itemOffset,
+						itemOffset + itemSize - 1, "tuple size %u, lp_len %u",
+						itemSize < sizeof(IndexTupleData) ? 0 :
+						(unsigned int) IndexTupleSize(itup), itemSize);
+}
 
-	/* Defensive */
-	if (bytesToFormat != blockSize)
-		return false;
-	if (specialType != SPEC_SECT_INDEX_HASH)
-		return false;
+/*
+ * --check onPageEnd callback.  Reports items whose storage overlaps the
+ * previous item's (by start offset).
+ */
+static void
+CheckVisitPageEnd(Page page, BlockNumber blkno, void *arg)
+{
+	CheckState *state = (CheckState *) arg;
+	int			i;
 
-	opaque = (HashPageOpaque) PageGetSpecialPointer(page);
-	if (opaque->hasho_flag & LH_BITMAP_PAGE)
-		return true;
+	qsort(state->spans, state->nspans, sizeof(CheckItemSpan),
+		  CheckItemSpanCmp);
+	for (i = 1; i < state->nspans; i++)
+	{
+		CheckItemSpan *prev = &state->spans[i - 1];
+		CheckItemSpan *span = &state->spans[i];
 
-	return false;
+		if (span->start < prev->end)
+			AddCheckAnomaly(state, blkno, span->offset, CHECK_ITEM_OVERLAP,
+							span->start, Min(span->end, prev->end) - 1,
+							"overlaps item %u", prev->offset);
+	}
 }
 
-/* Check whether page is a leaf page */
-static bool
-IsLeafPage(Page page)
+/*
+ * Check every page of file (or -R range) for anomalies, instead of emitting
+ * all tags.  Every anomaly is listed in the --check file, which uses the same
+ * unaligned format as "psql -A".  Tags are only emitted for pages that have
+ * an anomaly, followed by a tag for each of the page's anomalies.  Block
+ * numbers are file-relative, so that they can be used with -R.
+ *
+ * Page header and line pointer checks are shared with EmitXmlPage() and its
+ * callees, which make them as tags are emitted.  --check adds checks for
+ * overlapping items, items outside the tuple space, and tuple header bounds.
+ * A special section type change is reported for each page whose type differs
+ * from the type of the first page.
+ */
+static void
+EmitCheck(int numOptions, char **options)
 {
-	if (specialType == SPEC_SECT_INDEX_BTREE)
+	CheckState *states;
+	CheckState	total;
+	void	  **stateptrs;
+	FILE	   *checkFp;
+	BlockNumber first;
+	BlockNumber last;
+	BlockNumber blkno;
+	BlockNumber lastTagged = InvalidBlockNumber;
+	unsigned int firstSpecialType = CHECK_TYPE_NONE;
+	int			npages = 0;
+	int			w;
+	int			i;
+
+	if (!GetScanRange(&first, &last))
+		return;
+
+	checkPageTypes = (uint8 *) pg_malloc(last + 1);
+	memset(checkPageTypes, CHECK_TYPE_NONE, last + 1);
+	states = (CheckState *) pg_malloc0(sizeof(CheckState) * numWorkers);
+	stateptrs = (void **) pg_malloc(sizeof(void *) * numWorkers);
+	for (w = 0; w < numWorkers; w++)
+		stateptrs[w] = &states[w];
+
+	if (!ScanBlocksParallel(&checkVisitor, stateptrs))
+		return;
+
+	/* Merge per-worker anomalies into a single array */
+	memset(&total, 0, sizeof(total));
+	for (w = 0; w < numWorkers; w++)
 	{
-		BTPageOpaque btreeSection = (BTPageOpaque) PageGetSpecialPointer(page);
+		total.npages += states[w].npages;
+		total.nanomalies += states[w].nanomalies;
+	}
+	total.maxanomalies = total.nanomalies + (last - first + 1);
+	total.anomalies = (CheckAnomaly *) pg_malloc(sizeof(CheckAnomaly) *
+												 total.maxanomalies);
+	for (w = 0, i = 0; w < numWorkers; w++)
+	{
+		if (states[w].nanomalies > 0)
+			memcpy(&total.anomalies[i], states[w].anomalies,
+				   sizeof(CheckAnomaly) * states[w].nanomalies);
+		i += states[w].nanomalies;
+		pg_free(states[w].anomalies);
+		pg_free(states[w].spans);
+	}
 
-		/*
-		 * Don't count a root page as a leaf (i.e.  the root before the first
-		 * root page split).
-		 */
-		if ((btreeSection->btpo_flags & BTP_LEAF) &&
-			!(btreeSection->btpo_flags & BTP_ROOT))
-			return true;
+	/* Special section type changes are only known once scan is done */
+	for (blkno = first; blkno <= last; blkno++)
+	{
+		if (checkPageTypes[blkno] == CHECK_TYPE_NONE)
+			continue;
+
+		if (firstSpecialType == CHECK_TYPE_NONE)
+			firstSpecialType = checkPageTypes[blkno];
+		else if (checkPageTypes[blkno] != firstSpecialType)
+			AddCheckAnomaly(&total, blkno, InvalidOffsetNumber,
+							CHECK_SPECIAL_CHANGED, 0, SizeOfPageHeaderData - 1,
+							"%s, not %s",
+							GetSpecialSectionString(checkPageTypes[blkno]),
+							GetSpecialSectionString(firstSpecialType));
 	}
-	else if (specialType == SPEC_SECT_INDEX_GIST)
+	qsort(total.anomalies, total.nanomalies, sizeof(CheckAnomaly),
+		  CheckAnomalyCmp);
+
+	checkFp = fopen(checkFileName, "w");
+	if (!checkFp)
 	{
-		if (GistPageIsLeaf(page))
-			return true;
+		fprintf(stderr, "pg_hexedit error: could not open check output file \"%s\" for writing: %s\n",
+				checkFileName, strerror(errno));
+		exitCode = 1;
 	}
-	else if (specialType == SPEC_SECT_INDEX_GIN)
+	else
 	{
-		/* This works for both posting trees, and the main entry tree */
-		if (GinPageIsLeaf(page))
-			return true;
+		fprintf(checkFp, "block|offset|code|detail\n");
+		for (i = 0; i < total.nanomalies; i++)
+		{
+			CheckAnomaly *anomaly = &total.anomalies[i];
+
+			fprintf(checkFp, "%u|%u|%s|%s\n", anomaly->blkno, anomaly->offset,
+					checkAnomalyNames[anomaly->code], anomaly->detail);
+		}
+		if (fclose(checkFp) != 0)
+		{
+			fprintf(stderr, "pg_hexedit error: could not write check output file \"%s\"\n",
+					checkFileName);
+			exitCode = 1;
+		}
 	}
-	else if (specialType == SPEC_SECT_INDEX_SPGIST)
+
+	/* Emit all tags for each anomalous page, then its anomalies' tags */
+	EmitXmlDocHeader(numOptions, options);
+	if (!buffer)
+		buffer = (char *) pg_malloc(blockSize);
+	for (i = 0; i < total.nanomalies; i++)
 	{
-		if (SpGistPageIsLeaf(page))
-			return true;
+		CheckAnomaly *anomaly = &total.anomalies[i];
+		char		name[128];
+
+		if (anomaly->blkno != lastTagged)
+		{
+			lastTagged = anomaly->blkno;
+			npages++;
+
+			ThrottleIo(blockSize);
+			if (pg_pread(fileno(fp), buffer, blockSize,
+						 (off_t) anomaly->blkno * blockSize) != blockSize)
+			{
+				fprintf(stderr, "pg_hexedit error: could not read block %u\n",
+						anomaly->blkno);
+				exitCode = 1;
+				continue;
+			}
+			bytesToFormat = blockSize;
+			currentBlock = anomaly->blkno;
+
+			/* Type changes are already reported */
+			firstType = SPEC_SECT_ERROR_UNKNOWN;
+			EmitXmlPage(anomaly->blkno);
+		}
+
+		if (anomaly->offset == InvalidOffsetNumber)
+			snprintf(name, sizeof(name), "%s: %s",
+					 checkAnomalyNames[anomaly->code], anomaly->detail);
+		else
+			snprintf(name, sizeof(name), "(%u,%u) %s: %s",
+					 anomaly->blkno + segmentBlockDelta, anomaly->offset,
+					 checkAnomalyNames[anomaly->code], anomaly->detail);
+		EmitXmlTag(InvalidBlockNumber, UINT_MAX, name, COLOR_RED_DARK,
+				   anomaly->blkno * blockSize + anomaly->start,
+				   anomaly->blkno * blockSize + anomaly->end);
 	}
+	EmitXmlFooter();
 
-	return false;
+	if (total.nanomalies > 0)
+		exitCode = 1;
+
+	fprintf(stderr, "pg_hexedit notice: --check scanned " UINT64_FORMAT " blocks, found %d anomalies on %d pages\n",
+			total.npages, total.nanomalies, npages);
+
+	pg_free(total.anomalies);
+	pg_free(states);
+	pg_free(stateptrs);
+	pg_free(checkPageTypes);
+	checkPageTypes = NULL;
 }
 
 /*
- * For each block, dump out formatted header and content information
+ * onPage callback for --fix-checksums, which never needs a page's items.
+ * When a --baseline snapshot is available, only pages that differ from it are
+ * verified.
  */
-static void
-EmitXmlPage(BlockNumber blkno)
+static bool
+FixPageChecksum(Page page, BlockNumber blkno, bool sane, void *arg)
 {
-	Page		page = (Page) buffer;
-	uint32		level = UINT_MAX;
-	int			rc;
-
-	/*
-	 * Maintain max block number for blocks that have some kind of content
-	 * (could just be zero block, could be block that we'd skip due to current
-	 * -x option)
-	 */
-	maxBlockNumber = Max(maxBlockNumber, blkno);
+	FixChecksumsState *state = (FixChecksumsState *) arg;
+	PageHeader	pageHeader = (PageHeader) page;
+	off_t		checksumOff;
+	pageChecksumResults result;
+	uint16		calculated;
+	FixedChecksum *fixed;
 
+	/* New pages never have a checksum */
 	if (PageIsNew(page))
+		return false;
+
+	if (baselineFd >= 0)
 	{
-		/*
-		 * Assume new/zeroed block has LSN 0 for -x option (but don't update
-		 * minPageLSN because it's not useful to consider that 0)
-		 */
-		if ((blockOptions & BLOCK_SKIP_LSN))
+		if (!state->baselinePage)
+			state->baselinePage = (char *) pg_malloc(blockSize);
+
+		ThrottleIo(blockSize);
+		if (pg_pread(baselineFd, state->baselinePage, blockSize,
+					 (off_t) blkno * blockSize) == blockSize &&
+			memcmp(state->baselinePage, page, blockSize) == 0)
 		{
-			nblocksskipped++;
+			state->nunchanged++;
+			return false;
 		}
-
-		return;
 	}
 
-	/* Get details of page first */
-	pageOffset = blockSize * currentBlock;
-	specialType = GetSpecialSectionType(page);
+	result = VerifyPageChecksum(page, blkno, &calculated);
+	if (result == PAGE_CHECKSUM_SKIPPED)
+		return false;
 
-	/*
-	 * A Postgres segment file should consists of blocks that are all of the
-	 * same special section reported type (excluding those blocks that have
-	 * yet to be initialized by PageInit()).  Raise error when this
-	 * expectation is not met.
-	 */
-	if (firstType == SPEC_SECT_ERROR_UNKNOWN)
-		firstType = specialType;
+	state->nverified++;
+	if (result == PAGE_CHECKSUM_VALID)
+		return false;
 
-	if (firstType != specialType)
+	checksumOff = (off_t) blkno * blockSize +
+		offsetof(PageHeaderData, pd_checksum);
+	if (pg_pwrite(fixFd, &calculated, sizeof(calculated),
+				  checksumOff) != sizeof(calculated) ||
+		(fixFsyncPolicy == FIX_FSYNC_EACH && fdatasync(fixFd) != 0))
 	{
-		fprintf(stderr, "pg_hexedit error: special section indicated type unexpectedly changed from \"%s\" to \"%s\" at file block %u\n",
-				GetSpecialSectionString(firstType),
-				GetSpecialSectionString(specialType), blkno);
+		fprintf(stderr, "pg_hexedit error: could not write checksum of block %u: %s\n",
+				blkno, strerror(errno));
 		exitCode = 1;
+		state->nfailed++;
+		return false;
 	}
 
-	/*
-	 * Check to see if we must skip this block due to it falling behind LSN
-	 * threshold
-	 */
-	if ((blockOptions & BLOCK_SKIP_LSN))
+	if (state->nfixed == state->maxfixed)
 	{
-		XLogRecPtr	pageLSN = GetPageLsn(page);
+		state->maxfixed = Max(state->maxfixed * 2, 64);
+		state->fixed = (FixedChecksum *)
+			pg_realloc(state->fixed, sizeof(FixedChecksum) * state->maxfixed);
+	}
+	fixed = &state->fixed[state->nfixed++];
+	fixed->blkno = blkno;
+	fixed->stored = pageHeader->pd_checksum;
+	fixed->calculated = calculated;
 
-		if (pageLSN < afterThreshold)
-		{
-			rc = 0;
-			nblocksskipped++;
-			return;
-		}
-		else
-		{
-			nblockstagged++;
+	return false;
+}
 
-			/* Maintain Min and Max LSNs for annotated pages */
-			if (pageLSN < minPageLSN)
-			{
-				minPageLSN = pageLSN;
-				minPageLSNBlock = blkno;
-			}
-			if (pageLSN > maxPageLSN)
-			{
-				maxPageLSN = pageLSN;
-				maxPageLSNBlock = blkno;
-			}
-		}
-	}
+/*
+ * qsort comparator that sorts --fix-checksums pages by block
+ */
+static int
+FixedChecksumCmp(const void *a, const void *b)
+{
+	const FixedChecksum *fixeda = (const FixedChecksum *) a;
+	const FixedChecksum *fixedb = (const FixedChecksum *) b;
+
+	if (fixeda->blkno != fixedb->blkno)
+		return fixeda->blkno < fixedb->blkno ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * Rewrite pd_checksum of each page in file (or -R range) whose stored
+ * checksum is incorrect, in place, instead of emitting tags.  Each page that
+ * was fixed is printed to stdout, in the same unaligned format as "psql -A".
+ * Block numbers are file-relative, so that they can be used with -R.
+ *
+ * Only pd_checksum is ever written, so that the rest of each page (including
+ * any edits made in wxHexEditor) is left as it is.  Pages whose checksum is 0
+ * are left alone unless -k is given, since that's how pages look when data
+ * checksums are disabled.  When a --baseline snapshot of the file from
+ * before it was edited is given, pages that are the same as in the snapshot
+ * are skipped, which leaves any other checksum failures for the server to
+ * find.
+ */
+static void
+EmitFixChecksums(void)
+{
+	FixChecksumsState *states;
+	FixChecksumsState total;
+	void	  **stateptrs;
+	int			w;
+	int			i;
 
-	/* Get "level" for page.  Only B-Tree tags get a "level" */
-	if (specialType == SPEC_SECT_INDEX_BTREE)
+	fixFd = open(fileName, O_RDWR);
+	if (fixFd < 0)
 	{
-		BTPageOpaque btreeSection = (BTPageOpaque) PageGetSpecialPointer(page);
-
-#if PG_VERSION_NUM < 140000
-		level = btreeSection->btpo.level;
-#else
-		level = btreeSection->btpo_level;
-#endif
+		fprintf(stderr, "pg_hexedit error: could not open file \"%s\" for writing: %s\n",
+				fileName, strerror(errno));
+		exitCode = 1;
+		return;
 	}
 
-	/*
-	 * We optionally itemize leaf blocks as whole tags, in order to limit the
-	 * size of tag files sharply.  Internal pages can be more interesting when
-	 * debugging certain types of problems, such as problems with the balance
-	 * of some tree structure.
-	 */
-	if ((blockOptions & BLOCK_SKIP_LEAF) && IsLeafPage(page))
+	if (baselineFileName)
 	{
-		EmitXmlTag(blkno, level, "leaf page", COLOR_GREEN_DARK,
-				   pageOffset,
-				   (pageOffset + BLCKSZ) - 1);
-		rc = 0;
-		return;
+		baselineFd = open(baselineFileName, O_RDONLY);
+		if (baselineFd < 0)
+		{
+			fprintf(stderr, "pg_hexedit error: could not open baseline file \"%s\": %s\n",
+					baselineFileName, strerror(errno));
+			exitCode = 1;
+			close(fixFd);
+			return;
+		}
 	}
 
-	/*
-	 * Every block that we aren't skipping will have header, items and
-	 * possibly special section tags created.  Beware of partial block reads,
-	 * though.
-	 */
-	rc = EmitXmlPageHeader(page, blkno, level);
+	states = (FixChecksumsState *) pg_malloc0(sizeof(FixChecksumsState) *
+											  numWorkers);
+	stateptrs = (void **) pg_malloc(sizeof(void *) * numWorkers);
+	for (w = 0; w < numWorkers; w++)
+		stateptrs[w] = &states[w];
 
-	/* If we didn't encounter a partial read in header, carry on...  */
-	if (rc != EOF_ENCOUNTERED)
+	if (ScanBlocksParallel(&fixChecksumsVisitor, stateptrs))
 	{
-		/*
-		 * All AMs have a single metapage at block zero of the first segment,
-		 * with the exception of heapam and GiST. (Sequences more or less
-		 * reuse the heap format, and so don't have a metapage.)
-		 */
-		if (blkno == 0 && segmentNumber == 0 &&
-			specialType != SPEC_SECT_NONE &&
-			specialType != SPEC_SECT_INDEX_GIST &&
-			specialType != SPEC_SECT_SEQUENCE)
-		{
-			/* If it's a meta page, the meta block will have no tuples */
-			EmitXmlPageMeta(blkno, level);
-		}
-		else if (specialType == SPEC_SECT_INDEX_BTREE &&
-				 P_ISDELETED((BTPageOpaque) PageGetSpecialPointer(page)))
-		{
-			/*
-			 * Deleted nbtree pages only contain BTDeletedPageData on Postgres
-			 * 14+ -- don't bother distinguishing deleted pages.  Cannot trust
-			 * maxoff from page.
-			 */
-		}
-		else if (specialType == SPEC_SECT_INDEX_HASH && IsHashBitmapPage(page))
-		{
-			/* Hash bitmap pages don't use IndexTuple or ItemId */
-			EmitXmlHashBitmap(page, blkno);
-		}
-		else if (specialType == SPEC_SECT_INDEX_GIST && GistPageIsDeleted(page))
-		{
-			/*
-			 * Deleted GiST pages only contain GISTDeletedPageContents on
-			 * Postgres 12+ -- don't bother distinguishing deleted pages.
-			 * Cannot trust maxoff from page.
-			 */
-		}
-		else if (specialType == SPEC_SECT_INDEX_GIN && GinPageIsDeleted(page))
-		{
-			/*
-			 * Unfortunately, GIN_DELETED pages don't have page state needed
-			 * by GinPageIsData().  Don't attempt to emit tags for tuples on
-			 * deleted GIN pages.
-			 */
-		}
-		else if (specialType == SPEC_SECT_INDEX_GIN && GinPageIsData(page))
+		/* Merge per-worker fixed pages into a single array */
+		memset(&total, 0, sizeof(total));
+		for (w = 0; w < numWorkers; w++)
 		{
-			/* GIN data/posting tree pages don't use IndexTuple or ItemId */
-			EmitXmlPostingTreeTids(page, blkno);
+			total.nverified += states[w].nverified;
+			total.nunchanged += states[w].nunchanged;
+			total.nfailed += states[w].nfailed;
+			total.nfixed += states[w].nfixed;
 		}
-		else if (specialType == SPEC_SECT_INDEX_BRIN && BRIN_IS_REVMAP_PAGE(page))
+		total.fixed = (FixedChecksum *) pg_malloc(sizeof(FixedChecksum) *
+												  Max(total.nfixed, 1));
+		for (w = 0, i = 0; w < numWorkers; w++)
 		{
-			/* BRIN revmap pages don't use IndexTuple/BrinTuple or ItemId */
-			EmitXmlRevmap(page, blkno);
+			if (states[w].nfixed > 0)
+				memcpy(&total.fixed[i], states[w].fixed,
+					   sizeof(FixedChecksum) * states[w].nfixed);
+			i += states[w].nfixed;
 		}
-		else
+		qsort(total.fixed, total.nfixed, sizeof(FixedChecksum),
+			  FixedChecksumCmp);
+
+		if (total.nfixed > 0 && fixFsyncPolicy == FIX_FSYNC_END &&
+			fsync(fixFd) != 0)
 		{
-			/* Conventional heap/index page format */
-			EmitXmlPageItemIdArray(page, blkno);
-			EmitXmlTuples(page, blkno);
+			fprintf(stderr, "pg_hexedit error: could not fsync file \"%s\": %s\n",
+					fileName, strerror(errno));
+			exitCode = 1;
 		}
 
-		/* Only heapam doesn't have a special area (even sequences have one) */
-		if (specialType != SPEC_SECT_NONE)
-			EmitXmlSpecial(blkno, level);
+		printf("block|stored_checksum|calculated_checksum\n");
+		for (i = 0; i < total.nfixed; i++)
+			printf("%u|0x%04x|0x%04x\n", total.fixed[i].blkno,
+				   total.fixed[i].stored, total.fixed[i].calculated);
+
+		if (baselineFd >= 0)
+			fprintf(stderr, "pg_hexedit notice: --fix-checksums skipped " UINT64_FORMAT " pages that are the same as in --baseline\n",
+					total.nunchanged);
+		fprintf(stderr, "pg_hexedit notice: --fix-checksums verified " UINT64_FORMAT " pages, rewrote %d checksums (" UINT64_FORMAT " could not be written)\n",
+				total.nverified, total.nfixed, total.nfailed);
+
+		pg_free(total.fixed);
+	}
+
+	for (w = 0; w < numWorkers; w++)
+	{
+		pg_free(states[w].fixed);
+		pg_free(states[w].baselinePage);
 	}
+	pg_free(states);
+	pg_free(stateptrs);
+
+	if (baselineFd >= 0)
+		close(baselineFd);
+	baselineFd = -1;
+	close(fixFd);
+	fixFd = -1;
 }
 
 /*
- * Display a header for the dump so we know the file name, the options and the
- * time the dump was taken
+ * Find special area flag (or value) with name of given length, among the
+ * names that field descriptors decode
  */
-static void
-EmitXmlDocHeader(int numOptions, char **options)
+static bool
+LookupFieldFlag(const char *name, size_t len, uint64 *value)
 {
-	unsigned int x;
-	char		optionBuffer[52] = "\0";
-	char		timeStr[1000];
+	unsigned int type;
 
-	/* Format time without newline */
-	time_t		rightNow = time(NULL);
-	struct tm  *localNow = localtime(&rightNow);
+	for (type = SPEC_SECT_NONE; type < SPEC_SECT_ERROR_UNKNOWN; type++)
+	{
+		const StructDesc *desc = GetSpecialDesc(type);
+		int			i;
+		int			j;
 
-	strftime(timeStr, sizeof(timeStr), "%H:%M:%S %A, %B %d %Y", localNow);
+		if (!desc)
+			continue;
 
-	/*
-	 * Iterate through the options and cache them. The maximum we can display
-	 * is 50 option characters + spaces.
-	 */
-	for (x = 1; x < (numOptions - 1); x++)
-	{
-		if ((strlen(optionBuffer) + strlen(options[x])) > 50)
-			break;
-		strcat(optionBuffer, options[x]);
-		strcat(optionBuffer, " ");
+		for (i = 0; i < desc->nfields; i++)
+		{
+			for (j = 0; j < desc->fields[i].nflags; j++)
+			{
+				const FieldFlag *flag = &desc->fields[i].flags[j];
+
+				if (strlen(flag->name) == len &&
+					strncmp(flag->name, name, len) == 0)
+				{
+					*value = flag->value;
+					return true;
+				}
+			}
+		}
 	}
 
-	printf("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-	printf("<!-- Dump created on: %s -->\n", timeStr);
-	printf("<!-- Options used: %s -->\n", (strlen(optionBuffer)) ? optionBuffer : "None");
-	printf("<!-- Block size: %u -->\n", blockSize);
-	printf("<!-- pg_hexedit version: %s -->\n", HEXEDIT_VERSION);
-	printf("<!-- pg_hexedit build PostgreSQL version: %s -->\n", PG_VERSION);
-	printf("<wxHexEditor_XML_TAG>\n");
-	printf("  <filename path=\"%s\">\n", fileName);
+	return false;
 }
 
-static void
-EmitXmlFooter(void)
+/*
+ * Find descriptor of field whose tag starts at page offset, among the fields
+ * of struct at page offset structOffset
+ */
+static const FieldDesc *
+FindFieldDesc(const StructDesc *desc, uint32 structOffset, uint32 offset)
 {
-	printf("  </filename>\n");
-	printf("</wxHexEditor_XML_TAG>\n");
+	int			i;
+
+	for (i = 0; i < desc->nfields; i++)
+	{
+		const FieldDesc *field = &desc->fields[i];
+		uint32		start = structOffset + field->offset;
+
+		if (field->elem)
+		{
+			if (offset >= start &&
+				offset < start + field->elem->size * field->nelems)
+				return FindFieldDesc(field->elem,
+									 start + (offset - start) /
+									 field->elem->size * field->elem->size,
+									 offset);
+		}
+		else if (offset == start)
+			return field;
+	}
+
+	return NULL;
 }
 
 /*
- * Emit a generic wxHexEditor tag for tuple data.
- *
- * Note: endOffset is an offset to the last byte whose range the tag covers, so
- * callers generally pass (relfileOff + length) - 1.  This is slightly less
- * verbose than getting callers to pass length.
+ * Find descriptor of metapage or special area field whose tag starts at page
+ * offset, for page in buffer (whose special section type must already be in
+ * specialType).  Returns NULL for all other tags.
  *
- * B-Tree index callers may optionally pass a "level".  Passing
- * InvalidBlockNumber avoids emitting any block number.
+ * The tags of these fields also cover any padding that follows them, so
+ * --apply and --inject use descriptors to find the size of the field proper.
  */
-static void
-EmitXmlTag(BlockNumber blkno, uint32 level, const char *name, const char *color,
-		   uint32 relfileOff, uint32 relfileOffEnd)
+static const FieldDesc *
+GetFieldDescAt(BlockNumber blkno, uint32 offset)
 {
-	Assert(relfileOff <= relfileOffEnd);
+	const StructDesc *desc;
+	const FieldDesc *field = NULL;
 
-	printf("    <TAG id=\"%u\">\n", tagNumber++);
-	printf("      <start_offset>%u</start_offset>\n", relfileOff);
-	printf("      <end_offset>%u</end_offset>\n", relfileOffEnd);
-	if (blkno == InvalidBlockNumber)
-		printf("      <tag_text>%s</tag_text>\n", name);
-	else if (level != UINT_MAX)
-		printf("      <tag_text>block %u (level %u) %s</tag_text>\n",
-			   blkno + segmentBlockDelta, level, name);
-	else
-		printf("      <tag_text>block %u %s</tag_text>\n",
-			   blkno + segmentBlockDelta, name);
-	printf("      <font_colour>" COLOR_FONT_STANDARD "</font_colour>\n");
-	printf("      <note_colour>%s</note_colour>\n", color);
-	printf("    </TAG>\n");
+	if (blkno == 0 && segmentNumber == 0 &&
+		(desc = GetMetapageDesc(specialType)) != NULL)
+		field = FindFieldDesc(desc, MAXALIGN(SizeOfPageHeaderData), offset);
+	if (!field && (desc = GetSpecialDesc(specialType)) != NULL)
+		field = FindFieldDesc(desc, ((PageHeader) buffer)->pd_special, offset);
+
+	return field;
 }
 
 /*
- * Emit a wxHexEditor tag for a line pointer (ItemId).
+ * Parse value of --apply patch file entry, which is either a number, a
+ * constant from patchSymbols or a special area flag (see LookupFieldFlag()),
+ * or several of them combined with "|" (each
+ * optionally negated with "~"); an LSN such as 0/16B3748; a 'quoted string'
+ * (with '' for a quote); or an x'0a0b' byte string.  Byte strings are only
+ * supported by "=".
  */
-static void
-EmitXmlItemId(BlockNumber blkno, OffsetNumber offset, ItemId itemId,
-			  uint32 relfileOff, const char *textFlags)
+static bool
+ParsePatchValue(const char *str, PatchEntry *entry)
 {
-	char	   *fontColor;
-	char	   *itemIdColor;
+	const char *p = str;
+	size_t		len = strlen(str);
+	uint32		xlogid;
+	uint32		xrecoff;
+	int			n = 0;
 
-	fontColor = COLOR_FONT_STANDARD;
-	itemIdColor = COLOR_BLUE_LIGHT;
+	if (*p == '\'')
+	{
+		StringInfoData buf;
 
-	/*
-	 * The color of the tag and tag font is chosen to give a cue about line
-	 * pointer details.  Unused line pointers (which are reusable) have a
-	 * non-contrasting font color to deemphasize their importance.  LP_DEAD
-	 * line pointers (which are dead but not necessarily reusable yet) don't
-	 * stay around for long in most real world workloads, and so it seems
-	 * useful to make them stick out.
-	 */
-	if (ItemIdIsRedirected(itemId))
-		itemIdColor = COLOR_BLUE_DARK;
-	else if (ItemIdIsDead(itemId))
-		itemIdColor = COLOR_BROWN;
-	else if (!ItemIdIsUsed(itemId))
-		fontColor = COLOR_BLUE_DARK;
+		initStringInfo(&buf);
+		for (p++; *p != '\0'; p++)
+		{
+			if (*p == '\'')
+			{
+				if (p[1] != '\'')
+					break;
+				p++;
+			}
+			appendStringInfoChar(&buf, *p);
+		}
+		if (*p != '\'' || p[1] != '\0')
+		{
+			pg_free(buf.data);
+			return false;
+		}
+		entry->bytes = buf.data;
+		entry->nbytes = buf.len;
+		return entry->op == PATCH_SET;
+	}
 
-	/* Interpret the content of each ItemId separately */
-	printf("    <TAG id=\"%u\">\n", tagNumber++);
-	printf("      <start_offset>%u</start_offset>\n", relfileOff);
-	printf("      <end_offset>%lu</end_offset>\n", (relfileOff + sizeof(ItemIdData)) - 1);
-	printf("      <tag_text>(%u,%d) lp_len: %u, lp_off: %u, lp_flags: %s</tag_text>\n",
-		   blkno + segmentBlockDelta, offset, ItemIdGetLength(itemId),
-		   ItemIdGetOffset(itemId), textFlags);
-	printf("      <font_colour>%s</font_colour>\n", fontColor);
-	printf("      <note_colour>%s</note_colour>\n", itemIdColor);
-	printf("    </TAG>\n");
+	if ((p[0] == 'x' || p[0] == 'X') && p[1] == '\'')
+	{
+		int			i;
+
+		if (len < 3 || p[len - 1] != '\'' || (len - 3) % 2 != 0)
+			return false;
+		entry->nbytes = (len - 3) / 2;
+		entry->bytes = (char *) pg_malloc(Max(entry->nbytes, 1));
+		for (i = 0; i < entry->nbytes; i++)
+		{
+			char		hex[3] = {p[2 + i * 2], p[3 + i * 2], '\0'};
+			char	   *end;
+
+			entry->bytes[i] = (char) strtoul(hex, &end, 16);
+			if (!isxdigit((unsigned char) hex[0]) || *end != '\0')
+				return false;
+		}
+		return entry->op == PATCH_SET;
+	}
+
+	if (sscanf(p, "%X/%X%n", &xlogid, &xrecoff, &n) == 2 && p[n] == '\0')
+	{
+		entry->value = ((uint64) xlogid << 32) | xrecoff;
+		return true;
+	}
+
+	entry->value = 0;
+	for (;;)
+	{
+		bool		invert = false;
+		uint64		term;
+		char	   *end;
+
+		while (isspace((unsigned char) *p))
+			p++;
+		if (*p == '~')
+		{
+			invert = true;
+			p++;
+			while (isspace((unsigned char) *p))
+				p++;
+		}
+
+		if (isdigit((unsigned char) *p) || *p == '-')
+		{
+			errno = 0;
+			if (*p == '-')
+				term = (uint64) strtoll(p, &end, 0);
+			else
+				term = strtoull(p, &end, 0);
+			if (end == p || errno != 0)
+				return false;
+		}
+		else
+		{
+			int			i;
+
+			for (end = (char *) p; isalnum((unsigned char) *end) || *end == '_';
+				 end++)
+				;
+			for (i = 0; i < lengthof(patchSymbols); i++)
+			{
+				if (strlen(patchSymbols[i].name) == end - p &&
+					strncmp(patchSymbols[i].name, p, end - p) == 0)
+					break;
+			}
+			if (end == p)
+				return false;
+			if (i < lengthof(patchSymbols))
+				term = patchSymbols[i].value;
+			else if (!LookupFieldFlag(p, end - p, &term))
+				return false;
+		}
+
+		entry->value |= invert ? ~term : term;
+		for (p = end; isspace((unsigned char) *p); p++)
+			;
+		if (*p == '\0')
+			return true;
+		if (*p != '|')
+			return false;
+		p++;
+	}
 }
 
 /*
- * Emit a wxHexEditor tag for individual tuple, whose TID is to be represented
- * in the tag annotation.  Could be an IndexTuple, heap tuple, or special
- * tuple-like structure (e.g., GIN data/posting tree page item).
+ * Parse --apply patch file line, which has had surrounding whitespace
+ * removed.  Entries assign a tuple field, as in:
  *
- * Note: relfileOffEnd is an offset to the last byte whose range the tag
- * covers, so callers generally pass (relfileOff + length) - 1.  This is
- * slightly less verbose than getting callers to pass length.
+ *		(12,5).t_infomask |= HEAP_XMIN_INVALID
+ *		(3,2).attr[email] = 'nobody@example.com'
+ *
+ * or a page field, as in:
+ *
+ *		block 40 btpo_next = 77
+ *
+ * Field names are those used by tags, and block numbers are
+ * relation-relative, just like in tags.  Entry's block is left
+ * relation-relative here.
  */
-static inline void
-EmitXmlTupleTag(BlockNumber blkno, OffsetNumber offset, const char *name,
-				const char *color, uint32 relfileOff, uint32 relfileOffEnd)
+static bool
+ParsePatchLine(char *line, PatchEntry *entry)
 {
-	EmitXmlTupleTagFont(blkno, offset, name, color, COLOR_FONT_STANDARD,
-						relfileOff, relfileOffEnd);
-}
+	char	   *p = line;
+	unsigned int blkno;
+	unsigned int offset;
+	const char *name;
+	int			namelen;
+	int			n = 0;
+
+	if (sscanf(p, "(%u,%u).%n", &blkno, &offset, &n) == 2 && n > 0)
+	{
+		if (offset == InvalidOffsetNumber || offset > MaxOffsetNumber)
+			return false;
+		p += n;
 
-/*
- * Like EmitXmlTupleTag(), but lets caller specify font color
- */
-static void
-EmitXmlTupleTagFont(BlockNumber blkno, OffsetNumber offset, const char *name,
-					const char *color, const char *fontColor,
-					uint32 relfileOff, uint32 relfileOffEnd)
-{
-	if (relfileOff > relfileOffEnd)
+		/* Attribute names may be anything, so they're bracketed */
+		if (strncmp(p, "attr[", 5) == 0)
+		{
+			name = p + 5;
+			p = strchr(name, ']');
+			if (!p)
+				return false;
+			namelen = p++ - name;
+			entry->attribute = true;
+		}
+		else
+		{
+			name = p;
+			while (isalnum((unsigned char) *p) || *p == '_' || *p == '-' ||
+				   *p == '>')
+				p++;
+			namelen = p - name;
+		}
+	}
+	else if (sscanf(p, "block %u %n", &blkno, &n) == 1 && n > 0)
 	{
-		fprintf(stderr, "pg_hexedit error: (%u,%u) tuple tag \"%s\" is malformed (%u > %u)\n",
-				blkno + segmentBlockDelta, offset, name, relfileOff,
-				relfileOffEnd);
-		exitCode = 1;
-		return;
+		offset = InvalidOffsetNumber;
+		p += n;
+		name = p;
+		while (isalnum((unsigned char) *p) || *p == '_')
+			p++;
+		namelen = p - name;
 	}
+	else
+		return false;
 
-	printf("    <TAG id=\"%u\">\n", tagNumber++);
-	printf("      <start_offset>%u</start_offset>\n", relfileOff);
-	printf("      <end_offset>%u</end_offset>\n", relfileOffEnd);
-	printf("      <tag_text>(%u,%u) %s</tag_text>\n",
-		   blkno + segmentBlockDelta, offset, name);
-	printf("      <font_colour>%s</font_colour>\n", fontColor);
-	printf("      <note_colour>%s</note_colour>\n", color);
-	printf("    </TAG>\n");
+	if (namelen == 0 || namelen >= NAMEDATALEN)
+		return false;
+	entry->blkno = blkno;
+	entry->offset = offset;
+	memcpy(entry->field, name, namelen);
+	entry->field[namelen] = '\0';
+
+	/* Page header tags don't use the names of the fields themselves */
+	if (offset == InvalidOffsetNumber && strcmp(entry->field, "pd_lsn") == 0)
+		strcpy(entry->field, "LSN");
+	else if (offset == InvalidOffsetNumber &&
+			 strcmp(entry->field, "pd_checksum") == 0)
+		strcpy(entry->field, "checksum");
+
+	while (isspace((unsigned char) *p))
+		p++;
+	if (strncmp(p, "|=", 2) == 0)
+		entry->op = PATCH_OR;
+	else if (strncmp(p, "&=", 2) == 0)
+		entry->op = PATCH_AND;
+	else if (strncmp(p, "^=", 2) == 0)
+		entry->op = PATCH_XOR;
+	else if (*p == '=')
+		entry->op = PATCH_SET;
+	else
+		return false;
+	p += entry->op == PATCH_SET ? 1 : 2;
+	while (isspace((unsigned char) *p))
+		p++;
+
+	return *p != '\0' && ParsePatchValue(p, entry);
 }
 
 /*
- * Like EmitXmlTupleTagFont(), but lets caller specify name in two parts
+ * Read and parse every entry of --apply patch file.  Blank lines, and lines
+ * that start with "#", are ignored.  Each line that can't be parsed is
+ * reported, and makes this return false.
  */
-static void
-EmitXmlTupleTagFontTwoName(BlockNumber blkno, OffsetNumber offset,
-						   const char *name1, const char *name2,
-						   const char *color, const char *fontColor,
-						   uint32 relfileOff, uint32 relfileOffEnd)
+static bool
+ReadPatchFile(PatchEntry **entries, int *nentries)
 {
-	char	   *combinednames;
-
-	if (relfileOff > relfileOffEnd)
+	FILE	   *patchFp;
+	StringInfoData contents;
+	char		chunk[8192];
+	size_t		nread;
+	char	   *line;
+	char	   *next;
+	int			lineno = 0;
+	int			maxentries = 64;
+	bool		ok = true;
+	bool		invalid = false;
+
+	patchFp = fopen(applyFileName, "r");
+	if (!patchFp)
 	{
-		fprintf(stderr, "pg_hexedit error: (%u,%u) tuple tag \"%s - %s\" is malformed (%u > %u)\n",
-				blkno + segmentBlockDelta, offset, name1, name2, relfileOff,
-				relfileOffEnd);
+		fprintf(stderr, "pg_hexedit error: could not open patch file \"%s\": %s\n",
+				applyFileName, strerror(errno));
 		exitCode = 1;
-		return;
+		return false;
+	}
+	initStringInfo(&contents);
+	while ((nread = fread(chunk, 1, sizeof(chunk), patchFp)) > 0)
+		appendBinaryStringInfo(&contents, chunk, nread);
+	if (ferror(patchFp))
+	{
+		fprintf(stderr, "pg_hexedit error: could not read patch file \"%s\"\n",
+				applyFileName);
+		exitCode = 1;
+		ok = false;
 	}
+	fclose(patchFp);
+
+	*entries = (PatchEntry *) pg_malloc(sizeof(PatchEntry) * maxentries);
+	*nentries = 0;
+	for (line = contents.data; ok && line; line = next)
+	{
+		PatchEntry *entry;
+		char	   *end;
+
+		lineno++;
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+
+		while (isspace((unsigned char) *line))
+			line++;
+		for (end = line + strlen(line);
+			 end > line && isspace((unsigned char) end[-1]); end--)
+			;
+		*end = '\0';
+		if (*line == '\0' || *line == '#')
+			continue;
 
-	combinednames = pg_malloc(strlen(name1) + strlen(name2) + 5);
-	combinednames[0] = '\0';
-	strcat(combinednames, name1);
-	strcat(combinednames, " - ");
-	strcat(combinednames, name2);
+		if (*nentries == maxentries)
+		{
+			maxentries *= 2;
+			*entries = (PatchEntry *) pg_realloc(*entries, sizeof(PatchEntry) *
+												 maxentries);
+		}
+		entry = &(*entries)[*nentries];
+		memset(entry, 0, sizeof(PatchEntry));
+		entry->line = lineno;
+
+		if (!ParsePatchLine(line, entry))
+		{
+			fprintf(stderr, "pg_hexedit error: could not parse line %d of patch file \"%s\": %s\n",
+					lineno, applyFileName, line);
+			exitCode = 1;
+			invalid = true;
+			pg_free(entry->bytes);
+			continue;
+		}
+		else if (entry->blkno < segmentBlockDelta)
+		{
+			fprintf(stderr, "pg_hexedit error: line %d of patch file \"%s\" patches block %u, which is before segment file\n",
+					lineno, applyFileName, entry->blkno);
+			exitCode = 1;
+			invalid = true;
+			pg_free(entry->bytes);
+			continue;
+		}
 
-	printf("    <TAG id=\"%u\">\n", tagNumber++);
-	printf("      <start_offset>%u</start_offset>\n", relfileOff);
-	printf("      <end_offset>%u</end_offset>\n", relfileOffEnd);
-	printf("      <tag_text>(%u,%u) %s</tag_text>\n",
-		   blkno + segmentBlockDelta, offset, combinednames);
-	printf("      <font_colour>%s</font_colour>\n", fontColor);
-	printf("      <note_colour>%s</note_colour>\n", color);
-	printf("    </TAG>\n");
+		entry->blkno -= segmentBlockDelta;
+		(*nentries)++;
+	}
+	pg_free(contents.data);
 
-	pg_free(combinednames);
+	return ok && !invalid;
 }
 
 /*
- * Emit wxHexEditor tags for individual non-NULL attributes in heap tuple
+ * qsort comparator that sorts --apply patch file entries by block, and then
+ * by line within each block
  */
-static void
-EmitXmlAttributesHeap(BlockNumber blkno, OffsetNumber offset,
-					  uint32 relfileOff, HeapTupleHeader htup, int itemSize)
+static int
+PatchEntryBlockCmp(const void *a, const void *b)
 {
-	unsigned char *tupdata = (unsigned char *) htup + htup->t_hoff;
-	bits8	   *t_bits;
-	int			nattrs = HeapTupleHeaderGetNatts(htup);
-	int			datalen = itemSize - htup->t_hoff;
+	const PatchEntry *entrya = (const PatchEntry *) a;
+	const PatchEntry *entryb = (const PatchEntry *) b;
 
-	/*
-	 * If an argument describing the relation's tuples was not provided, just
-	 * create a single tag
-	 */
-	if (nrelatts == 0)
-	{
-		EmitXmlTupleTag(blkno, offset, "contents", COLOR_WHITE, relfileOff,
-						(relfileOff + datalen) - 1);
-		return;
-	}
+	if (entrya->blkno != entryb->blkno)
+		return entrya->blkno < entryb->blkno ? -1 : 1;
 
-	if (nattrs > nrelatts)
-	{
-		fprintf(stderr, "pg_hexedit error: %d attributes found in (%u,%u) exceeds the number inferred for relation from -D argument %d\n",
-				nattrs, blkno, offset, nrelatts);
-		exitCode = 1;
-		nattrs = nrelatts;
-	}
+	return PatchEntryLineCmp(a, b);
+}
 
-	t_bits = (htup->t_infomask & HEAP_HASNULL) != 0 ? htup->t_bits : NULL;
+/*
+ * qsort comparator that sorts --apply patch file entries by line
+ */
+static int
+PatchEntryLineCmp(const void *a, const void *b)
+{
+	const PatchEntry *entrya = (const PatchEntry *) a;
+	const PatchEntry *entryb = (const PatchEntry *) b;
 
-	EmitXmlAttributesData(blkno, offset, relfileOff, tupdata, t_bits, nattrs,
-						  datalen);
+	if (entrya->line != entryb->line)
+		return entrya->line < entryb->line ? -1 : 1;
+
+	return 0;
 }
 
 /*
- * Emit wxHexEditor tags for individual non-NULL attributes in index tuple
+ * Find tag that --apply patch file entry's field resolves to, among the tags
+ * of its page.  The lp_off, lp_flags, and lp_len line pointer fields share
+ * one tag.
  */
-static void
-EmitXmlAttributesIndex(BlockNumber blkno, OffsetNumber offset,
-					   uint32 relfileOff, IndexTuple itup, uint32 tupHeaderOff,
-					   int itemSize)
+static PageTag *
+FindPatchTag(PatchEntry *entry, PageTag *tags, int ntags)
 {
-	unsigned char *tupdata;
-	bits8	   *t_bits;
-	int			datalen;
-	int			nattrs = nrelatts;
-	bool		haveargreltuple = true;
-
-	/*
-	 * If an argument describing the relation's tuples was not provided, just
-	 * create a single tag, but show pivot tuple heap TID representation, or
-	 * posting list representation, since we don't need -D metadata for that.
-	 *
-	 * Play it safe here -- don't attempt to emit attribute values when an
-	 * error was already encountered.  We may be able to limp on for much
-	 * longer this way, especially in the event of an access method that we
-	 * know nothing about but follows the familiar bufpage.c conventions, such
-	 * as zheap.
-	 *
-	 * Multi-column GIN entries have two attributes in main entry key tuples:
-	 * an implicit int16 leading attribute that indicates which pg_attribute
-	 * listing the entry relates to, as well as the actual value.  This isn't
-	 * something that we currently support, though, so just treat this case as
-	 * if we had no catalog metadata.
-	 */
-	if (nrelatts == 0 || exitCode != 0 ||
-		(specialType == SPEC_SECT_INDEX_GIN && nrelatts > 1))
-	{
-		/* Won't be able to emit tags based on tuple metadata argument */
-		haveargreltuple = false;
-	}
+	BlockNumber relblkno = entry->blkno + segmentBlockDelta;
+	const char *name = entry->field;
+	size_t		namelen;
+	PageTag    *match = NULL;
+	int			i;
 
-	/* Set up state for emitting attributes */
-	tupdata = (unsigned char *) itup + IndexInfoFindDataOffset(itup->t_info);
-	t_bits = IndexTupleHasNulls(itup) ?
-		(bits8 *) ((unsigned char *) itup + sizeof(IndexTupleData)) : NULL;
-	datalen = itemSize - IndexInfoFindDataOffset(itup->t_info) - 1;
+	if (entry->offset != InvalidOffsetNumber &&
+		(strcmp(name, "lp_off") == 0 || strcmp(name, "lp_flags") == 0))
+		name = "lp_len";
+	namelen = strlen(name);
 
-	/*
-	 * This is based on BTreeTupleGetNAtts(), which cannot be called from
-	 * frontend code.
-	 *
-	 * On Postgres v12+, account for possible heap TID tiebreaker attribute in
-	 * pivot tuples.  These TIDs are white because they are considered keys,
-	 * not pointers.  This color scheme is based on the precedent set by GIN's
-	 * internal posting tree pages.
-	 */
-	if (specialType == SPEC_SECT_INDEX_BTREE &&
-#if PG_VERSION_NUM < 130000
-		(itup->t_info & INDEX_ALT_TID_MASK) != 0)
-#else
-		 BTreeTupleIsPivot(itup)) /* This inline function is only in Postgres 13 */
-#endif /* PG_VERSION_NUM < 130000 */
+	for (i = 0; i < ntags; i++)
 	{
-		nattrs =
-			(ItemPointerGetOffsetNumberNoCheck(&(itup)->t_tid) &
-			 BT_OFFSET_MASK);
+		const char *rest = tags[i].text;
+		unsigned int tagblkno;
+		unsigned int tagoffset;
+		unsigned int level;
+		int			n = 0;
 
-		if (haveargreltuple && nattrs > nrelatts)
+		if (*rest == '(')
 		{
-			fprintf(stderr, "pg_hexedit error: %d attributes found in (%u,%u) exceeds the number inferred for relation from -D argument %d\n",
-					nattrs, blkno, offset, nrelatts);
-			exitCode = 1;
-			nattrs = nrelatts;
+			if (sscanf(rest, "(%u,%u) %n", &tagblkno, &tagoffset, &n) != 2 ||
+				n == 0 || tagblkno != relblkno || tagoffset != entry->offset)
+				continue;
+			rest += n;
 		}
-		if (BTreeTupleGetHeapTID(itup) != NULL)
+		else
+		{
+			/* Metapage tags have no "block n" prefix */
+			if (entry->offset != InvalidOffsetNumber)
+				continue;
+			if (sscanf(rest, "block %u %n", &tagblkno, &n) == 1 && n > 0)
+			{
+				if (tagblkno != relblkno)
+					continue;
+				rest += n;
+				n = 0;
+				if (sscanf(rest, "(level %u) %n", &level, &n) == 1 && n > 0)
+					rest += n;
+			}
+		}
+
+		if (strncmp(rest, name, namelen) != 0)
+			continue;
+		if (entry->attribute)
 		{
 			/*
-			 * Heap TID attribute is considered a column internally, but has
-			 * no pg_attribute entry.
-			 *
-			 * Note that this only handles the special representation of heap
-			 * TID that's used in pivot tuples (includes leaf page high key).
-			 * Non-pivot tuples represent heap TID using IndexTupleData.t_tid,
-			 * or by using a posting list.
+			 * Attribute value tag is named after attribute alone, unless it's
+			 * a -T TOAST pointer description.  This skips the tag of varlena
+			 * header, which is named "name - varattrib_1b" (or similar).
 			 */
-			uint32		htidoffset;
-
-			htidoffset = (tupHeaderOff + IndexTupleSize(itup)) -
-				sizeof(ItemPointerData);
-			datalen -= sizeof(ItemPointerData);
-
-			EmitXmlTupleTag(blkno, offset, "BTreeTupleGetHeapTID()->bi_hi", COLOR_PINK,
-							htidoffset, (htidoffset + sizeof(uint16)) - 1);
-			htidoffset += sizeof(uint16);
-			EmitXmlTupleTag(blkno, offset, "BTreeTupleGetHeapTID()->bi_lo", COLOR_PINK,
-							htidoffset, (htidoffset + sizeof(uint16)) - 1);
-			htidoffset += sizeof(uint16);
-			EmitXmlTupleTag(blkno, offset, "BTreeTupleGetHeapTID()->offsetNumber", COLOR_PINK,
-							htidoffset, (htidoffset + sizeof(uint16)) - 1);
+			if (rest[namelen] != '\0' &&
+				strncmp(rest + namelen, " - va_valueid ", 14) != 0)
+				continue;
 		}
-	}
-
-	/*
-	 * On Postgres v13+, account for nbtree posting list tuples
-	 */
-#if PG_VERSION_NUM >= 130000
-	else if (specialType == SPEC_SECT_INDEX_BTREE && BTreeTupleIsPosting(itup))
-	{
-		uint32	postoffset = tupHeaderOff + BTreeTupleGetPostingOffset(itup);
-		int		i;
-
-		datalen = postoffset - relfileOff - 1;
+		/* Tag text may describe field's value after its name */
+		else if (rest[namelen] != '\0' && rest[namelen] != ' ' &&
+				 rest[namelen] != ':')
+			continue;
 
-		/*
-		 * Annotate each posting list TID individually, while alternating the
-		 * color to increase legibility.
-		 *
-		 * This deliberately doesn't look anything like pivot tuple heap TID
-		 * annotations, and deliberately doesn't recreate the slight variation
-		 * in color within TIDs from tuple headers.  Small posting list tuples
-		 * should appear prominently among duplicates that aren't posting
-		 * lists.
-		 */
-		for (i = 0; i < BTreeTupleGetNPosting(itup); i++)
+		if (match)
 		{
-			char   *color = (i % 2 == 0 ? COLOR_RED_LIGHT : COLOR_GREEN_LIGHT);
-			char	tidstr[30];
-
-			sprintf(tidstr, "TID[%d] bi_hi", i);
-			EmitXmlTupleTag(blkno, offset, tidstr, color, postoffset,
-							(postoffset + sizeof(uint16)) - 1);
-			postoffset += sizeof(uint16);
-			sprintf(tidstr, "TID[%d] bi_lo", i);
-			EmitXmlTupleTag(blkno, offset, tidstr, color, postoffset,
-							(postoffset + sizeof(uint16)) - 1);
-			postoffset += sizeof(uint16);
-			sprintf(tidstr, "TID[%d] offsetNumber", i);
-			EmitXmlTupleTag(blkno, offset, tidstr, color, postoffset,
-							(postoffset + sizeof(uint16)) - 1);
-			postoffset += sizeof(uint16);
+			fprintf(stderr, "pg_hexedit error: line %d of patch file \"%s\" is ambiguous, since block %u has more than one \"%s\" tag\n",
+					entry->line, applyFileName, relblkno, name);
+			exitCode = 1;
+			return NULL;
 		}
+		match = &tags[i];
 	}
-#endif /* PG_VERSION_NUM >= 130000 */
 
-	/*
-	 * Finally, emit pg_attribute-wise columns, or plain gray tag that
-	 * represents where the pg_attribute-wise tuple values would go if we had
-	 * valid -D info
-	 */
-	if (haveargreltuple)
-		EmitXmlAttributesData(blkno, offset, relfileOff, tupdata, t_bits,
-							  nattrs, MAXALIGN(datalen));
-	else
-		EmitXmlTupleTag(blkno, offset, "contents", COLOR_WHITE,
-						relfileOff, relfileOff + datalen);
+	if (!match)
+	{
+		if (entry->offset != InvalidOffsetNumber)
+			fprintf(stderr, "pg_hexedit error: line %d of patch file \"%s\" patches \"%s\", but (%u,%u) has no such tag\n",
+					entry->line, applyFileName, entry->field, relblkno,
+					entry->offset);
+		else
+			fprintf(stderr, "pg_hexedit error: line %d of patch file \"%s\" patches \"%s\", but block %u has no such tag\n",
+					entry->line, applyFileName, entry->field, relblkno);
+		exitCode = 1;
+	}
 
+	return match;
 }
 
 /*
- * Emit wxHexEditor tags for individual non-NULL attributes.
- *
- * This relies on catalog metadata passed by user, since frontend code cannot
- * use tuple descriptors or access system catalog metadata itself.
- *
- * This code is loosely based on nocachegetattr(), though it works with both
- * heap and index tuple data areas.
+ * Format bytes of field as "\x0a0b" for --apply output
  */
-static void
-EmitXmlAttributesData(BlockNumber blkno, OffsetNumber offset,
-					  uint32 relfileOff, unsigned char *tupdata, bits8 *t_bits,
-					  int nattrs, int datalen)
+static char *
+FormatPatchBytes(const char *bytes, int nbytes)
 {
-	unsigned char *attptr = tupdata;
-	int			off = 0;
+	char	   *result = (char *) pg_malloc(nbytes * 2 + 3);
 	int			i;
 
-	for (i = 0; i < nattrs; i++)
+	strcpy(result, "\\x");
+	for (i = 0; i < nbytes; i++)
+		sprintf(result + 2 + i * 2, "%02x", (unsigned char) bytes[i]);
+
+	return result;
+}
+
+/*
+ * Apply --apply patch file entry to field covered by tag, within copy of its
+ * page.  Integer fields are patched in place using the machine's byte order,
+ * just like PostgreSQL writes them.  Other fields can only be patched with
+ * a byte string, which overwrites the field's leading bytes.
+ */
+static bool
+ApplyPatchEntry(PatchEntry *entry, PageTag *tag, char *page)
+{
+	off_t		pageStart = (off_t) entry->blkno * blockSize;
+	char	   *field;
+	int			width;
+	uint64		oldValue;
+	uint64		newValue;
+	uint64		mask;
+	const FieldDesc *desc;
+
+	if (tag->start < pageStart || tag->end >= pageStart + blockSize)
 	{
-		int			attlen = attlenrel[i];
-		char	   *attname = attnamerel[i];
-		char	   *attcolor = attcolorrel[i];
-		char		attalign = attalignrel[i];
-		int			truestartoff = 0;
-		int			truelen;
+		fprintf(stderr, "pg_hexedit error: line %d of patch file \"%s\" patches \"%s\" tag, which is not within block %u\n",
+				entry->line, applyFileName, tag->text,
+				entry->blkno + segmentBlockDelta);
+		exitCode = 1;
+		return false;
+	}
+	field = page + (tag->start - pageStart);
+	width = tag->end - tag->start + 1;
 
-		if (t_bits && att_isnull(i, t_bits))
-			continue;
+	/* Don't patch padding that metapage and special area tags also cover */
+	desc = GetFieldDescAt(entry->blkno, tag->start - pageStart);
+	if (desc && desc->size < width)
+		width = desc->size;
 
-		if (attlen == -1)
+	if (entry->bytes)
+	{
+		if (entry->nbytes > width)
 		{
-			char	   *hdrname = "";
-
-			/* Varlena header receives its own minimal tag */
-			off = att_align_pointer(off, attalign, -1, attptr);
-			truelen = VARSIZE_ANY(tupdata + off);
+			fprintf(stderr, "pg_hexedit error: line %d of patch file \"%s\" assigns %d bytes to \"%s\", which has room for %d\n",
+					entry->line, applyFileName, entry->nbytes, tag->text,
+					width);
+			exitCode = 1;
+			return false;
+		}
 
-			if (VARATT_IS_1B(attptr))
-			{
-				truestartoff = 1;
-				truelen -= 1;
-				if (VARATT_IS_1B_E(attptr))
-					hdrname = "varattrib_1b_e";
-				else
-					hdrname = "varattrib_1b";
+		entry->oldValue = FormatPatchBytes(field, width);
+		memcpy(field, entry->bytes, entry->nbytes);
+		entry->newValue = FormatPatchBytes(field, width);
+		return true;
+	}
 
-				EmitXmlTupleTagFontTwoName(blkno, offset, attname, hdrname,
-										   attcolor, COLOR_BROWN,
-										   relfileOff + off,
-										   relfileOff + off);
-			}
-			else if (VARATT_IS_4B(attptr))
-			{
-				truestartoff = 4;
-				truelen -= 4;
-				if (VARATT_IS_4B_U(attptr))
-					hdrname = "va_4byte";
-				else if (VARATT_IS_4B_C(attptr))
-					hdrname = "va_compressed";
+	if (entry->offset != InvalidOffsetNumber && width == sizeof(ItemIdData) &&
+		strncmp(entry->field, "lp_", 3) == 0)
+	{
+		ItemIdData	itemId;
+		unsigned	bits;
 
-				EmitXmlTupleTagFontTwoName(blkno, offset, attname, hdrname,
-										   attcolor, COLOR_BROWN,
-										   relfileOff + off,
-										   relfileOff + off + 3);
-			}
-		}
-		else if (attlen == -2)
+		memcpy(&itemId, field, sizeof(ItemIdData));
+		if (strcmp(entry->field, "lp_flags") == 0)
 		{
-			off = att_align_nominal(off, attalign);
-			truelen = strnlen((char *) attptr, datalen - off) + 1;
+			oldValue = itemId.lp_flags;
+			bits = 2;
 		}
 		else
 		{
-			off = att_align_nominal(off, attalign);
-			truelen = attlen;
+			oldValue = strcmp(entry->field, "lp_off") == 0 ?
+				itemId.lp_off : itemId.lp_len;
+			bits = 15;
 		}
 
-		if (datalen < off + attlen)
+		switch (entry->op)
 		{
-			fprintf(stderr, "pg_hexedit error: unexpected out of bounds tuple data for attnum %d in (%u,%u)\n",
-					i + 1, blkno, offset);
+			case PATCH_SET:
+				newValue = entry->value;
+				break;
+			case PATCH_OR:
+				newValue = oldValue | entry->value;
+				break;
+			case PATCH_AND:
+				newValue = oldValue & entry->value;
+				break;
+			default:
+				newValue = oldValue ^ entry->value;
+				break;
+		}
+		if (newValue >= ((uint64) 1 << bits))
+		{
+			fprintf(stderr, "pg_hexedit error: line %d of patch file \"%s\" sets %s to " UINT64_FORMAT ", which does not fit in %u bits\n",
+					entry->line, applyFileName, entry->field, newValue, bits);
 			exitCode = 1;
-			return;
+			return false;
 		}
 
-		EmitXmlTupleTag(blkno, offset, attname, attcolor,
-						relfileOff + off + truestartoff,
-						relfileOff + off + truestartoff + truelen - 1);
+		if (strcmp(entry->field, "lp_flags") == 0)
+			itemId.lp_flags = newValue;
+		else if (strcmp(entry->field, "lp_off") == 0)
+			itemId.lp_off = newValue;
+		else
+			itemId.lp_len = newValue;
+		memcpy(field, &itemId, sizeof(ItemIdData));
+
+		entry->oldValue = psprintf(UINT64_FORMAT, oldValue);
+		entry->newValue = psprintf(UINT64_FORMAT, newValue);
+		return true;
+	}
+
+	switch (width)
+	{
+		case sizeof(uint8):
+			oldValue = *(uint8 *) field;
+			break;
+		case sizeof(uint16):
+			{
+				uint16		value16;
+
+				memcpy(&value16, field, sizeof(uint16));
+				oldValue = value16;
+				break;
+			}
+		case sizeof(uint32):
+			{
+				uint32		value32;
+
+				memcpy(&value32, field, sizeof(uint32));
+				oldValue = value32;
+				break;
+			}
+		case sizeof(uint64):
+			if (entry->offset == InvalidOffsetNumber &&
+				strcmp(entry->field, "LSN") == 0)
+				oldValue = PageXLogRecPtrGet(*(PageXLogRecPtr *) field);
+			else
+				memcpy(&oldValue, field, sizeof(uint64));
+			break;
+		default:
+			fprintf(stderr, "pg_hexedit error: line %d of patch file \"%s\" assigns a number to \"%s\", which is %d bytes (use a byte string)\n",
+					entry->line, applyFileName, tag->text, width);
+			exitCode = 1;
+			return false;
+	}
+
+	/* Negative and "~" values are sign extended, so they always fit */
+	mask = width == sizeof(uint64) ? ~UINT64CONST(0) :
+		(UINT64CONST(1) << (width * BITS_PER_BYTE)) - 1;
+	if ((entry->value & ~mask) != 0 && (~entry->value & ~mask) != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: line %d of patch file \"%s\" assigns a value to \"%s\" that does not fit in %d bytes\n",
+				entry->line, applyFileName, tag->text, width);
+		exitCode = 1;
+		return false;
+	}
+
+	switch (entry->op)
+	{
+		case PATCH_SET:
+			newValue = entry->value & mask;
+			break;
+		case PATCH_OR:
+			newValue = (oldValue | entry->value) & mask;
+			break;
+		case PATCH_AND:
+			newValue = (oldValue & entry->value) & mask;
+			break;
+		default:
+			newValue = (oldValue ^ entry->value) & mask;
+			break;
+	}
+
+	switch (width)
+	{
+		case sizeof(uint8):
+			*(uint8 *) field = (uint8) newValue;
+			break;
+		case sizeof(uint16):
+			{
+				uint16		value16 = (uint16) newValue;
 
-		/* Get possible address of next attribute, handling alignment */
-		off = att_addlength_pointer(off, attlen, tupdata + off);
-		attptr = tupdata + off;
+				memcpy(field, &value16, sizeof(uint16));
+				break;
+			}
+		case sizeof(uint32):
+			{
+				uint32		value32 = (uint32) newValue;
+
+				memcpy(field, &value32, sizeof(uint32));
+				break;
+			}
+		default:
+			if (entry->offset == InvalidOffsetNumber &&
+				strcmp(entry->field, "LSN") == 0)
+			{
+				PageXLogRecPtr lsn;
+
+				PageXLogRecPtrSet(lsn, newValue);
+				memcpy(field, &lsn, sizeof(PageXLogRecPtr));
+				entry->oldValue = psprintf("%X/%08X", (uint32) (oldValue >> 32),
+										   (uint32) oldValue);
+				entry->newValue = psprintf("%X/%08X", (uint32) (newValue >> 32),
+										   (uint32) newValue);
+				return true;
+			}
+			memcpy(field, &newValue, sizeof(uint64));
+			break;
 	}
+
+	entry->oldValue = psprintf("0x%0*llx", width * 2,
+							   (unsigned long long) oldValue);
+	entry->newValue = psprintf("0x%0*llx", width * 2,
+							   (unsigned long long) newValue);
+	return true;
 }
 
 /*
- * Emit a wxHexEditor tag for entire heap tuple.
+ * Apply every field assignment in --apply patch file to relation file in
+ * place, instead of emitting tags.  Each entry's field is found using the
+ * tags of its page, so patch files can name any field that has a tag.  Each
+ * applied entry is printed to stdout, in the same unaligned format as
+ * "psql -A".  Block numbers are file-relative, so that they can be used with
+ * -R, while offsets are those of tuple fields (or 0 for page fields).
  *
- * Note: Caller passes itemSize from ItemId because that's the only place that
- * it's available from.
+ * Every entry of a page is resolved against the page as it was before any
+ * of them were applied, and entries are then applied in the order that they
+ * appear in the patch file.  Nothing is written unless every entry could be
+ * applied, and then each patched page is written once.  With
+ * --fix-checksums, patched pages are given a correct checksum unless their
+ * checksum is 0 (and -k wasn't given), or an entry assigned it.
  */
 static void
-EmitXmlHeapTuple(BlockNumber blkno, OffsetNumber offset,
-				 HeapTupleHeader htup, uint32 relfileOff,
-				 int itemSize)
+EmitApply(void)
 {
-	TransactionId rawXmin = HeapTupleHeaderGetRawXmin(htup);
-	TransactionId rawXmax = HeapTupleHeaderGetRawXmax(htup);
-	char		xmin[90];
-	char		xmax[90];
-	char	   *xminFontColor;
-	char	   *xmaxFontColor;
-	BlockNumber logBlock = blkno + segmentBlockDelta;
-	char	   *blkFontColor;
-	char	   *offsetFontColor;
-	char	   *flagString;
-	uint32		relfileOffNext = 0;
-	uint32		relfileOffOrig = relfileOff;
-
-	/*
-	 * Produce xmin and xmax tags for tuple.
-	 *
-	 * The choice of colors here is not completely arbitrary.  There is some
-	 * attempt at analogy in the choice of colors.  For example, xmin and xmax
-	 * are symmetric, and so are both COLOR_RED_LIGHT.
-	 *
-	 * Tuple freezing and MultiXacts leave us with a lot of potentially
-	 * interesting information to represent here.  We use special font colors
-	 * to represent special transaction IDs, and include certain special
-	 * status information about the TransactionId/MultiXact contained within
-	 * each field.  The extra information in the tags is redundant with the
-	 * infomask tags (tags for where the information is actually represented),
-	 * but it seems useful to add some visual cues.
-	 */
-	strcpy(xmin, "xmin");
-	strcpy(xmax, "xmax");
-	xminFontColor = COLOR_FONT_STANDARD;
-	xmaxFontColor = COLOR_FONT_STANDARD;
+	PatchEntry *entries;
+	int			nentries;
+	char	  **pages;
+	BlockNumber *pageBlocks;
+	int			npages = 0;
+	int			nchecksums = 0;
+	int			fd;
+	struct stat st;
+	BlockNumber nblocks;
+	bool		ok = true;
+	int			i;
+	int			j;
 
-	/*
-	 * HeapTupleHeaderXminFrozen() doesn't actually consider pre-9.4
-	 * pg_upgrad'ed tuples that have FrozenTransactionId as their raw xmin
-	 */
-	if (!HeapTupleHeaderXminFrozen(htup) && rawXmin != FrozenTransactionId)
-	{
-		if (rawXmin == BootstrapTransactionId)
-		{
-			strcat(xmin, " - BootstrapTransactionId");
-			xminFontColor = COLOR_WHITE;
-		}
-		else if (rawXmin == InvalidTransactionId)
-		{
-			strcat(xmin, " - InvalidTransactionId");
-			xminFontColor = COLOR_YELLOW_LIGHT;
-		}
-	}
-	else
+	fd = open(fileName, O_RDWR);
+	if (fd < 0)
 	{
-		/*
-		 * Raw xmin is frozen.  Frozen xmin XIDs are only preserved for
-		 * forensic reasons (on Postgres 9.4+), so use low-contrast font to
-		 * deemphasize the XID.  (Raw xmin could be FrozenTransactionId here
-		 * in a pg_upgrade'd database, which is just as uninteresting.)
-		 */
-		strcat(xmin, " - Frozen");
-		xminFontColor = COLOR_RED_DARK;
+		fprintf(stderr, "pg_hexedit error: could not open file \"%s\" for writing: %s\n",
+				fileName, strerror(errno));
+		exitCode = 1;
+		return;
 	}
 
-	/*
-	 * Deliberately tag InvalidTransactionId and HEAP_XMAX_INVALID separately
-	 * for xmax annotation, since they can be set separately in a way that
-	 * might be interesting.  Also indicate (redundantly) if the xmax is a
-	 * MultiXactId, or is the XID on a non-updating locker xact.
-	 *
-	 * Representing HEAP_XMAX_IS_MULTI and HEAP_XMAX_LOCK_ONLY but not
-	 * HEAP_XMAX_COMMITTED here is a bit arbitrary.  We do this because
-	 * HEAP_XMAX_IS_MULTI and HEAP_XMAX_LOCK_ONLY are basic facts about the
-	 * class of data that the xmax field contains, as opposed to status
-	 * information for the tuple as a whole.
-	 *
-	 * The general idea is to make it as easy as possible for the user to get
-	 * a sense of the structure of update chains on the page.
-	 */
-	if ((htup->t_infomask & HEAP_XMAX_IS_MULTI) != 0)
+	if (!ReadPatchFile(&entries, &nentries))
 	{
-		strcat(xmax, " - HEAP_XMAX_IS_MULTI");
-		xmaxFontColor = COLOR_GREEN_DARK;
+		fprintf(stderr, "pg_hexedit error: relation file \"%s\" was not patched\n",
+				fileName);
+		pg_free(entries);
+		close(fd);
+		return;
 	}
-	if (rawXmax == InvalidTransactionId)
+	if (fstat(fd, &st) != 0)
 	{
-		strcat(xmax, " - InvalidTransactionId");
-		xmaxFontColor = COLOR_YELLOW_LIGHT;
+		fprintf(stderr, "pg_hexedit error: could not stat file \"%s\": %s\n",
+				fileName, strerror(errno));
+		exitCode = 1;
+		pg_free(entries);
+		close(fd);
+		return;
 	}
-	if ((htup->t_infomask & HEAP_XMAX_INVALID) != 0)
+	nblocks = st.st_size / blockSize;
+	qsort(entries, nentries, sizeof(PatchEntry), PatchEntryBlockCmp);
+
+	if (!buffer)
+		buffer = (char *) pg_malloc(blockSize);
+	pages = (char **) pg_malloc(sizeof(char *) * Max(nentries, 1));
+	pageBlocks = (BlockNumber *) pg_malloc(sizeof(BlockNumber) *
+										   Max(nentries, 1));
+	for (i = 0; i < nentries; i = j)
 	{
-		strcat(xmax, " - HEAP_XMAX_INVALID");
-		/* Matches InvalidTransactionId case */
-		xmaxFontColor = COLOR_YELLOW_LIGHT;
+		BlockNumber blkno = entries[i].blkno;
+		PageHeader	pageHeader;
+		PageTag    *tags;
+		int			ntags;
+		bool		setChecksum = false;
+		uint16		calculated;
+		unsigned int savedOptions = blockOptions;
+		int			k;
+
+		for (j = i; j < nentries && entries[j].blkno == blkno; j++)
+			;
+
+		ThrottleIo(blockSize);
+		if (blkno >= nblocks ||
+			pg_pread(fd, buffer, blockSize,
+					 (off_t) blkno * blockSize) != blockSize)
+		{
+			fprintf(stderr, "pg_hexedit error: line %d of patch file \"%s\" patches block %u, which could not be read\n",
+					entries[i].line, applyFileName, blkno + segmentBlockDelta);
+			exitCode = 1;
+			ok = false;
+			continue;
+		}
+		bytesToFormat = blockSize;
+		currentBlock = blkno;
+
+		/* Checksum of page that is about to be patched isn't of interest */
+		blockOptions &= ~(BLOCK_CHECKSUMS | BLOCK_ZEROSUMS);
+		ntags = CollectPageTags(blkno, &tags);
+		blockOptions = savedOptions;
+
+		pages[npages] = (char *) pg_malloc(blockSize);
+		memcpy(pages[npages], buffer, blockSize);
+		for (k = i; k < j; k++)
+		{
+			PageTag    *tag = FindPatchTag(&entries[k], tags, ntags);
+
+			if (!tag || !ApplyPatchEntry(&entries[k], tag, pages[npages]))
+				ok = false;
+			else if (entries[k].offset == InvalidOffsetNumber &&
+					 strcmp(entries[k].field, "checksum") == 0)
+				setChecksum = true;
+		}
+		for (k = 0; k < ntags; k++)
+			pg_free(tags[k].text);
+		pg_free(tags);
+
+		pageHeader = (PageHeader) pages[npages];
+		if ((blockOptions & BLOCK_FIX_CHECKSUMS) && !setChecksum &&
+			VerifyPageChecksum(pages[npages], blkno, &calculated) ==
+			PAGE_CHECKSUM_INVALID)
+		{
+			pageHeader->pd_checksum = calculated;
+			nchecksums++;
+		}
+		pageBlocks[npages++] = blkno;
 	}
 
-	/*
-	 * Handle HEAP_XMAX_LOCK_ONLY last, since the HEAP_XMAX_INVALID hint seems
-	 * like it shouldn't affect font color.
-	 */
-	if ((htup->t_infomask & HEAP_XMAX_LOCK_ONLY) != 0)
+	if (!ok)
+		fprintf(stderr, "pg_hexedit error: relation file \"%s\" was not patched\n",
+				fileName);
+	else
 	{
-		/*
-		 * This color is deliberately chosen to be similar to the special
-		 * t_ctid font colors
-		 */
-		strcat(xmax, " - HEAP_XMAX_LOCK_ONLY");
-		xmaxFontColor = COLOR_BLUE_DARK;
-	}
+		for (i = 0; i < npages; i++)
+		{
+			if (pg_pwrite(fd, pages[i], blockSize,
+						  (off_t) pageBlocks[i] * blockSize) != blockSize ||
+				(fixFsyncPolicy == FIX_FSYNC_EACH && fdatasync(fd) != 0))
+			{
+				fprintf(stderr, "pg_hexedit error: could not write block %u: %s\n",
+						pageBlocks[i], strerror(errno));
+				exitCode = 1;
+				break;
+			}
+		}
+		if (npages > 0 && fixFsyncPolicy == FIX_FSYNC_END && fsync(fd) != 0)
+		{
+			fprintf(stderr, "pg_hexedit error: could not fsync file \"%s\": %s\n",
+					fileName, strerror(errno));
+			exitCode = 1;
+		}
 
-	relfileOffNext = relfileOff + sizeof(TransactionId);
-	EmitXmlTupleTagFont(blkno, offset, xmin, COLOR_RED_LIGHT, xminFontColor,
-						relfileOff, relfileOffNext - 1);
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(TransactionId);
-	EmitXmlTupleTagFont(blkno, offset, xmax, COLOR_RED_LIGHT, xmaxFontColor,
-						relfileOff, relfileOffNext - 1);
-	relfileOff = relfileOffNext;
+		qsort(entries, nentries, sizeof(PatchEntry), PatchEntryLineCmp);
+		printf("line|block|offset|field|old_value|new_value\n");
+		for (i = 0; i < nentries; i++)
+			printf("%d|%u|%u|%s|%s|%s\n", entries[i].line, entries[i].blkno,
+				   entries[i].offset, entries[i].field, entries[i].oldValue,
+				   entries[i].newValue);
 
-	if (!(htup->t_infomask & HEAP_MOVED))
-	{
-		/*
-		 * t_cid is COLOR_RED_DARK in order to signal that it's associated
-		 * with though somewhat different to xmin and xmax.
-		 */
-		relfileOffNext += sizeof(CommandId);
-		EmitXmlTupleTag(blkno, offset, "t_cid", COLOR_RED_DARK, relfileOff,
-						relfileOffNext - 1);
+		fprintf(stderr, "pg_hexedit notice: --apply applied %d patch file entries to %d pages (rewrote %d checksums)\n",
+				nentries, npages, nchecksums);
 	}
-	else
+
+	for (i = 0; i < nentries; i++)
 	{
-		/*
-		 * This must be a rare case where pg_upgrade has been run, and we're
-		 * left with a tuple with a t_xvac field instead of a t_cid field,
-		 * because at some point old-style VACUUM FULL was run. (This would
-		 * have had to have been on or before version 9.0, which has been out
-		 * of support for some time.)
-		 *
-		 * Make it COLOR_PINK, so that it sticks out like a sore thumb.
-		 */
-		StaticAssertStmt(sizeof(CommandId) == sizeof(TransactionId),
-						 "t_cid width must match t_xvac");
-		relfileOffNext += sizeof(TransactionId);
-		EmitXmlTupleTag(blkno, offset, "t_xvac", COLOR_PINK, relfileOff,
-						relfileOffNext - 1);
+		pg_free(entries[i].bytes);
+		pg_free(entries[i].oldValue);
+		pg_free(entries[i].newValue);
 	}
+	for (i = 0; i < npages; i++)
+		pg_free(pages[i]);
+	pg_free(pages);
+	pg_free(pageBlocks);
+	pg_free(entries);
+	close(fd);
+}
 
-	/*
-	 * Don't use ItemPointerData directly, to avoid having apparent mix in
-	 * endianness in these fields.  Delineate which subfield is which by using
-	 * multiple tags.
-	 *
-	 * The block component of each TID is COLOR_BLUE_LIGHT.  The same color is
-	 * used for ItemIds, since both are physical pointers.  offsetNumber is a
-	 * logical pointer, though, and so we make that COLOR_BLUE_DARK to
-	 * slightly distinguish it.
-	 *
-	 * It seems useful to provide a subtle cue about whether or not the tuple
-	 * is the latest version within the t_ctid subfields, since this helps the
-	 * user to notice update chains.  Check if tuple's t_ctid points to the
-	 * tuple itself; if it does, use non-contrasting font colors to
-	 * deemphasize.
-	 */
-	blkFontColor = COLOR_FONT_STANDARD;
-	offsetFontColor = COLOR_FONT_STANDARD;
-	if (ItemPointerGetBlockNumber(&htup->t_ctid) == logBlock &&
-		ItemPointerGetOffsetNumber(&htup->t_ctid) == offset)
+/*
+ * Get next number from --inject random number generator (splitmix64).  This
+ * is used instead of random() so that a seed produces the same corruptions
+ * everywhere.
+ */
+static uint64
+InjectRandom(uint64 *rng)
+{
+	uint64		z = (*rng += UINT64CONST(0x9E3779B97F4A7C15));
+
+	z = (z ^ (z >> 30)) * UINT64CONST(0xBF58476D1CE4E5B9);
+	z = (z ^ (z >> 27)) * UINT64CONST(0x94D049BB133111EB);
+	return z ^ (z >> 31);
+}
+
+/*
+ * Get --inject class of field covered by tag of page in buffer, or -1 when
+ * it isn't in any class.  Sets field to tag's name, without any description
+ * of its value, and sets *offset to tuple's offset (or InvalidOffsetNumber
+ * for page fields).
+ */
+static int
+GetInjectTagClass(PageTag *tag, BlockNumber blkno, char *field,
+				  OffsetNumber *offset)
+{
+	uint32		pageStart = blkno * blockSize;
+	const char *rest = tag->text;
+	bool		prefixed = false;
+	unsigned int tagblkno;
+	unsigned int tagoffset;
+	unsigned int level;
+	int			n = 0;
+	int			namelen;
+
+	*offset = InvalidOffsetNumber;
+	if (sscanf(rest, "(%u,%u) %n", &tagblkno, &tagoffset, &n) == 2 && n > 0)
 	{
-		blkFontColor = COLOR_BLUE_DARK;
-		offsetFontColor = COLOR_BLUE_LIGHT;
+		*offset = tagoffset;
+		rest += n;
+	}
+	else if (sscanf(rest, "block %u %n", &tagblkno, &n) == 1 && n > 0)
+	{
+		prefixed = true;
+		rest += n;
+		n = 0;
+		if (sscanf(rest, "(level %u) %n", &level, &n) == 1 && n > 0)
+			rest += n;
 	}
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(uint16);
-	EmitXmlTupleTagFont(blkno, offset, "t_ctid->bi_hi", COLOR_BLUE_LIGHT,
-						blkFontColor, relfileOff, relfileOffNext - 1);
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(uint16);
-	EmitXmlTupleTagFont(blkno, offset, "t_ctid->bi_lo", COLOR_BLUE_LIGHT,
-						blkFontColor, relfileOff, relfileOffNext - 1);
 
-	/*
-	 * Note: offsetNumber could be SpecTokenOffsetNumber, but we don't
-	 * annotate that
-	 */
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(uint16);
-	EmitXmlTupleTagFont(blkno, offset, "t_ctid->offsetNumber", COLOR_BLUE_DARK,
-						offsetFontColor, relfileOff, relfileOffNext - 1);
+	/* Descriptions of value follow ":", " -", or " (" */
+	namelen = strcspn(rest, ":");
+	if (strstr(rest, " -") && strstr(rest, " -") - rest < namelen)
+		namelen = strstr(rest, " -") - rest;
+	if (strstr(rest, " (") && strstr(rest, " (") - rest < namelen)
+		namelen = strstr(rest, " (") - rest;
+	while (namelen > 0 && rest[namelen - 1] == ' ')
+		namelen--;
+	namelen = Min(namelen, NAMEDATALEN - 1);
+	memcpy(field, rest, namelen);
+	field[namelen] = '\0';
+
+	if (*offset != InvalidOffsetNumber)
+	{
+		if (strncmp(rest, "lp_len:", 7) == 0)
+			return INJECT_LP;
+		if (strncmp(rest, "GinPostingList->", 16) == 0 ||
+			strncmp(rest, "PostingItem->", 13) == 0 ||
+			strncmp(rest, "varbyte encoded TIDs", 20) == 0)
+			return INJECT_GIN;
+		if (strncmp(rest, "TID[", 4) == 0 ||
+			strncmp(rest, "posting list", 12) == 0 ||
+			strstr(rest, "Posting") || strstr(rest, "GinItupIsCompressed"))
+			return INJECT_POSTING;
+		if (strncmp(rest, "t_", 2) == 0 || strncmp(rest, "xmin", 4) == 0 ||
+			strncmp(rest, "xmax", 4) == 0 ||
+			strncmp(rest, "BTreeTupleGetHeapTID()", 22) == 0)
+			return INJECT_TUPLE;
+		return -1;
+	}
 
-	flagString = GetHeapTupleHeaderFlags(htup, true);
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(uint16);
-	EmitXmlTupleTag(blkno, offset, flagString, COLOR_GREEN_LIGHT, relfileOff,
-					relfileOffNext - 1);
-	pg_free(flagString);
-	flagString = GetHeapTupleHeaderFlags(htup, false);
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(uint16);
-	EmitXmlTupleTag(blkno, offset, flagString, COLOR_GREEN_DARK, relfileOff,
-					relfileOffNext - 1);
-	pg_free(flagString);
+	if (prefixed && tag->end < pageStart + SizeOfPageHeaderData)
+		return INJECT_PAGE;
+	if (tag->start < pageStart + SizeOfPageHeaderData)
+		return -1;
+	if (specialType == SPEC_SECT_INDEX_BTREE)
+		return INJECT_BTREE;
+	if (specialType == SPEC_SECT_INDEX_GIN)
+		return INJECT_GIN;
 
-	/*
-	 * Metadata about the tuple shape and width is COLOR_YELLOW_DARK, in line
-	 * with general convention.  t_hoff is a fixed addressable field, so we
-	 * make it COLOR_YELLOW_LIGHT to represent that it's associated but
-	 * distinct.
-	 */
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(uint8);
-	EmitXmlTupleTag(blkno, offset, "t_hoff", COLOR_YELLOW_LIGHT, relfileOff,
-					relfileOffNext - 1);
+	return -1;
+}
 
-	/*
-	 * We consider the size of the t_bits field (if any) to be what the
-	 * att_isnull() macro requires.  There is one bit per attribute, which is
-	 * rounded up to the nearest byte boundary.
-	 *
-	 * This often leaves a conspicuous empty space between the t_bits area and
-	 * the first attribute/beginning of tuple contents.  This happens because
-	 * the first attribute of the tuple must be accessed at a MAXALIGN()'d
-	 * offset relative to the start of the tuple (often 32 bytes from the
-	 * beginning of the tuple).  The empty space for alignment doesn't seem
-	 * like it should count as t_bits overhead.
-	 *
-	 * (t_bits doesn't have any alignment requirements, which is why there can
-	 * be a one byte t_bits array when there aren't so many attributes.  That
-	 * can fit snugly before the first attribute, which will only have a 24
-	 * byte offset from the beginning of the tuple provided there is no oid
-	 * field.)
-	 */
-	relfileOff = relfileOffNext;
-	relfileOffNext = relfileOffOrig + htup->t_hoff;
-	if (htup->t_infomask & HEAP_HASOID)
-		relfileOffNext -= sizeof(Oid);
-	if (htup->t_infomask & HEAP_HASNULL)
-		EmitXmlTupleTag(blkno, offset, "t_bits", COLOR_YELLOW_DARK, relfileOff,
-						relfileOff + ((HeapTupleHeaderGetNatts(htup) + 0x07) >> 3) - 1);
+/*
+ * Make one random --inject corruption to field covered by tag, within copy of
+ * its page, and write it to manifest.  Line pointers have one of their
+ * fields set to a random value.  Other fields have a bit flipped, or are
+ * zeroed, or are set to random bytes.  Only one byte of fields wider than 8
+ * bytes (such as posting lists) is corrupted.
+ */
+static void
+InjectCorruption(uint64 *rng, PageTag *tag, char *page, BlockNumber blkno,
+				 FILE *manifest, const char *variantName, int class)
+{
+	uint32		pageStart = blkno * blockSize;
+	char		field[NAMEDATALEN];
+	OffsetNumber offset;
+	uint32		start = tag->start;
+	uint32		end = tag->end;
+	const char *mutation;
+	char	   *oldValue;
+	char	   *newValue;
+	char	   *bytes;
+	int			width;
+	const FieldDesc *desc;
+
+	GetInjectTagClass(tag, blkno, field, &offset);
+
+	/* Corrupting padding that tag also covers would go unnoticed */
+	desc = GetFieldDescAt(blkno, start - pageStart);
+	if (desc && desc->size < end - start + 1)
+		end = start + desc->size - 1;
+
+	if (class == INJECT_LP && end - start + 1 == sizeof(ItemIdData))
+	{
+		ItemIdData	itemId;
+		unsigned	old;
+		unsigned	new;
+		int			which = InjectRandom(rng) % 3;
+
+		memcpy(&itemId, page + (start - pageStart), sizeof(ItemIdData));
+		old = which == 0 ? itemId.lp_off :
+			which == 1 ? itemId.lp_flags : itemId.lp_len;
+		do
+		{
+			new = InjectRandom(rng) & (which == 1 ? 0x3 : 0x7FFF);
+		} while (new == old);
 
-	/*
-	 * Represent Oid as a distinct field with the same color as t_bits, since
-	 * it's also an optional heap tuple header.
-	 */
-	if (htup->t_infomask & HEAP_HASOID)
+		if (which == 0)
+		{
+			itemId.lp_off = new;
+			strcpy(field, "lp_off");
+		}
+		else if (which == 1)
+		{
+			itemId.lp_flags = new;
+			strcpy(field, "lp_flags");
+		}
+		else
+		{
+			itemId.lp_len = new;
+			strcpy(field, "lp_len");
+		}
+		memcpy(page + (start - pageStart), &itemId, sizeof(ItemIdData));
+
+		fprintf(manifest, "%s|%u|%u|%s|%s|set|%u|%u|%u|%u\n", variantName,
+				blkno, offset, injectClassNames[class], field, start, end,
+				old, new);
+		return;
+	}
+
+	if (end - start + 1 > sizeof(uint64))
 	{
-		relfileOff = relfileOffNext;
-		relfileOffNext += sizeof(Oid);
-		EmitXmlTupleTag(blkno, offset, "HeapTupleHeaderGetOid()",
-						COLOR_YELLOW_DARK, relfileOff, relfileOffNext - 1);
+		start += InjectRandom(rng) % (end - start + 1);
+		end = start;
 	}
+	bytes = page + (start - pageStart);
+	width = end - start + 1;
+	oldValue = FormatPatchBytes(bytes, width);
 
-	/*
-	 * Handle rare edge case where tuple has no contents because it consists
-	 * entirely of NULL attributes.  We trust lp_len to handle this, which is
-	 * what caller passed us.
-	 */
-	if (itemSize == (relfileOffNext - relfileOffOrig))
-		return;
-	else if (itemSize < (relfileOffNext - relfileOffOrig))
+	switch (InjectRandom(rng) % 3)
 	{
-		fprintf(stderr, "pg_hexedit error: lp_len %d from (%u,%u) is undersized\n",
-				itemSize, blkno + segmentBlockDelta, offset);
-		exitCode = 1;
-		return;
+		case 0:
+			mutation = "zero";
+			memset(bytes, 0, width);
+			break;
+		case 1:
+			{
+				int			i;
+
+				mutation = "random";
+				for (i = 0; i < width; i++)
+					bytes[i] = (char) InjectRandom(rng);
+				break;
+			}
+		default:
+			mutation = "bitflip";
+			break;
 	}
 
-	relfileOff = relfileOffNext;
-	EmitXmlAttributesHeap(blkno, offset, relfileOff, htup, itemSize);
+	/* Fall back on a bit flip when bytes happened to be left as they were */
+	newValue = FormatPatchBytes(bytes, width);
+	if (strcmp(mutation, "bitflip") == 0 || strcmp(oldValue, newValue) == 0)
+	{
+		int			bit = InjectRandom(rng) % (width * BITS_PER_BYTE);
+
+		mutation = "bitflip";
+		bytes[bit / BITS_PER_BYTE] ^= 1 << (bit % BITS_PER_BYTE);
+		pg_free(newValue);
+		newValue = FormatPatchBytes(bytes, width);
+	}
+
+	fprintf(manifest, "%s|%u|%u|%s|%s|%s|%u|%u|%s|%s\n", variantName, blkno,
+			offset, injectClassNames[class], field, mutation, start, end,
+			oldValue, newValue);
+	pg_free(oldValue);
+	pg_free(newValue);
 }
 
 /*
- * Emit a wxHexEditor tag for entire index tuple.
- *
- * Function deals with B-Tree, GiST, and hash tuples in a generic way, because
- * they use the IndexTuple format without adornment.  These index AMs use line
- * pointer metadata to represent that index tuples are logically dead by
- * setting the LP_DEAD bit.  Unlike the heap LP_DEAD case, there will still be
- * a tuple on the page when this is set (the tuple "has storage").  Caller
- * passes an argument that has us redundantly use color to represent that the
- * index tuple is dead, meaning that the space it occupies will soon be
- * recycled.
- *
- * This function is also used for GIN tuples in pending list and main B-Tree
- * key pages, and so must deal with the various abuses of the IndexTuple format
- * that GIN makes to store posting lists in main B-Tree key pages (pending
- * pages don't compress TIDs, and posting tree pages are dealt with in special
- * GIN-only paths).
- *
- * This function is not used for BrinTuples, because they share nothing with
- * IndexTuples in terms of layout, despite being conceptually similar (BRIN
- * tuples store blocks, not exact TIDs).
+ * Write --variants randomly corrupted copies of relation file to --inject
+ * directory, instead of emitting tags.  Each copy has --corruptions
+ * corruptions, and is named after the file and the copy's number.  Every
+ * corruption is listed in the directory's "manifest" file, in the same
+ * unaligned format as "psql -A".  Block numbers are file-relative, so that
+ * they can be used with -R, while start and end are file offsets of the
+ * bytes that were corrupted.
  *
- * Note: Caller does not need to pass itemSize from ItemId, because that's
- * redundant in the case of IndexTuples, and because SP-GiST callers will not
- * be able to pass an lp_len for an inner-node-contained IndexTuple.  However,
- * most still pass it, since it's a useful cross-check in the event of
- * corruption such as a torn page.
+ * Fields are found using tags, which are classified once, up front, so that
+ * each corruption is just as likely to affect any of the --classes that the
+ * file (or -R range) has.  Each copy has its own random number generator
+ * state, derived from --seed and the copy's number.  With --fix-checksums,
+ * corrupted pages are given a correct checksum unless their checksum is 0
+ * (and -k wasn't given), or was itself corrupted, so that the server doesn't
+ * refuse to read them before whatever is being tested gets a chance to.
  */
 static void
-EmitXmlIndexTuple(Page page, BlockNumber blkno, OffsetNumber offset,
-				  IndexTuple tuple, uint32 relfileOff, int itemSize, bool dead)
+EmitInject(void)
 {
-	uint32		relfileOffNext = 0;
-	uint32		relfileOffOrig = relfileOff;
-	char	   *tagColor;
-	char	   *fontColor;
-	char	   *flagString;
+	BlockNumber first;
+	BlockNumber last;
+	BlockNumber blkno;
+	BlockNumber *classBlocks[INJECT_NCLASSES];
+	int			nclassBlocks[INJECT_NCLASSES];
+	int			classes[INJECT_NCLASSES];
+	int			nclasses = 0;
+	char	   *pages;
+	BlockNumber *pageBlocks;
+	bool	   *pageChecksums;
+	const char *baseName;
+	char		path[MAXPGPATH];
+	FILE	   *manifest;
+	size_t		fileSize;
+	unsigned int savedOptions = blockOptions;
+	uint16		calculated;
+	bool		ok = true;
+	int			v;
+	int			i;
 
-	/* Make font color indicate if LP_DEAD bit is set */
-	fontColor = dead ? COLOR_BROWN : COLOR_FONT_STANDARD;
+	if (!GetScanRange(&first, &last) || !OpenRelationCache())
+		return;
 
-	if (itemSize < 0)
-		itemSize = IndexTupleSize(tuple);
-	else if (itemSize != IndexTupleSize(tuple))
+	/* Checksums of pages that are about to be corrupted aren't of interest */
+	blockOptions &= ~(BLOCK_CHECKSUMS | BLOCK_ZEROSUMS);
+
+	if (mkdir(injectDirName, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) != 0 &&
+		errno != EEXIST)
 	{
-		fprintf(stderr, "pg_hexedit error: (%u,%u) lp_len %u does not equal IndexTupleSize() %lu\n",
-				blkno + segmentBlockDelta, offset, itemSize,
-				IndexTupleSize(tuple));
+		fprintf(stderr, "pg_hexedit error: could not create directory \"%s\": %s\n",
+				injectDirName, strerror(errno));
 		exitCode = 1;
-		itemSize = Max(sizeof(IndexTupleData),
-					   Min(itemSize, IndexTupleSize(tuple)));
+		blockOptions = savedOptions;
+		CloseRelationCache();
+		return;
 	}
 
-	if (specialType != SPEC_SECT_INDEX_GIN || !GinPageIsLeaf(page) ||
-		GinIsPostingTree(tuple))
+	if (!injectSeedSet)
+		injectSeed = ((uint64) time(NULL) << 16) ^ getpid();
+
+	/* Find the blocks that have fields of each class */
+	for (i = 0; i < INJECT_NCLASSES; i++)
 	{
-		/*
-		 * Emit t_tid tags.  TID tag style should be kept consistent with
-		 * EmitXmlHeapTuple().
-		 */
-		relfileOffNext = relfileOff + sizeof(uint16);
-		tagColor = dead ? COLOR_BLACK : COLOR_BLUE_LIGHT;
-		EmitXmlTupleTagFont(blkno, offset, "t_tid->bi_hi",
-							tagColor, fontColor,
-							relfileOff, relfileOffNext - 1);
-		relfileOff = relfileOffNext;
-		relfileOffNext += sizeof(uint16);
-		EmitXmlTupleTagFont(blkno, offset, "t_tid->bi_lo",
-							tagColor, fontColor,
-							relfileOff, relfileOffNext - 1);
+		classBlocks[i] = (BlockNumber *) pg_malloc(sizeof(BlockNumber) *
+												   (last - first + 1));
+		nclassBlocks[i] = 0;
+	}
+	for (blkno = first; blkno <= last; blkno++)
+	{
+		PageTag    *tags;
+		int			ntags;
+		uint32		mask = 0;
+		const char *problem = ReadRelationBlock(blkno, buffer);
 
-		/*
-		 * Handle cases where item pointer offset is abused, but t_tid still
-		 * contains a valid block number.  These cases are handled here
-		 * because they involve IndexTuples that contain a t_tid that is still
-		 * essentially a conventional TID.  These cases are:
-		 *
-		 * 1. GIN posting tree pointers (within the leaf level of the main
-		 * entry tree).  The fact that it's a posting tree pointer (and not
-		 * the start of a posting list) is indicated by using the magic offset
-		 * number GIN_TREE_POSTING.  We use GinIsPostingTree() to test this.
-		 *
-		 * 2. nbtree pivot tuples, which use the item offset field to
-		 * represent how many suffix attributes remain (suffix truncation
-		 * optimization makes the number variable for pivot tuples).  This is
-		 * indicated by the INDEX_ALT_TID_MASK bit having been set.  Note that
-		 * nbtree uses BTreeTupleGetNAtts() to obtain the number of suffix
-		 * attributes.
-		 */
-		relfileOff = relfileOffNext;
-		relfileOffNext += sizeof(uint16);
-		tagColor = dead ? COLOR_BLACK : COLOR_BLUE_DARK;
-		if (specialType == SPEC_SECT_INDEX_GIN && GinIsPostingTree(tuple))
-			EmitXmlTupleTagFont(blkno, offset,
-								"t_tid->offsetNumber/GinIsPostingTree()",
-								tagColor, fontColor,
-								relfileOff, relfileOffNext - 1);
-		else if (specialType == SPEC_SECT_INDEX_BTREE &&
-#if PG_VERSION_NUM < 130000
-				 (tuple->t_info & INDEX_ALT_TID_MASK) != 0)
-#else
-				 BTreeTupleIsPivot(tuple)) /* This macro is only in Postgres 13 */
-#endif /* PG_VERSION_NUM < 130000 */
-			EmitXmlTupleTagFont(blkno, offset,
-								"t_tid->offsetNumber/BTreeTupleGetNAtts()",
-								tagColor, fontColor,
-								relfileOff, relfileOffNext - 1);
-#if PG_VERSION_NUM >= 130000
-		else if (specialType == SPEC_SECT_INDEX_BTREE &&
-				 BTreeTupleIsPosting(tuple))
-			EmitXmlTupleTagFont(blkno, offset,
-								"t_tid->offsetNumber/BTreeTupleGetNPosting()",
-								tagColor, fontColor,
-								relfileOff, relfileOffNext - 1);
-#endif /* PG_VERSION_NUM >= 130000 */
+		if (problem)
+		{
+			fprintf(stderr, "pg_hexedit error: could not read block %u of file \"%s\": %s\n",
+					blkno, fileName, problem);
+			exitCode = 1;
+			ok = false;
+			break;
+		}
+		ntags = ParsePageTags(blkno, buffer, &tags);
+
+		for (i = 0; i < ntags; i++)
+		{
+			char		field[NAMEDATALEN];
+			OffsetNumber offset;
+			int			class = GetInjectTagClass(&tags[i], blkno, field,
+												  &offset);
+
+			if (class >= 0)
+				mask |= 1 << class;
+			pg_free(tags[i].text);
+		}
+		pg_free(tags);
+
+		mask &= injectClassMask;
+		for (i = 0; i < INJECT_NCLASSES; i++)
+		{
+			if (mask & (1 << i))
+				classBlocks[i][nclassBlocks[i]++] = blkno;
+		}
+		ProgressAdvance(1, ntags, 0);
+	}
+	for (i = 0; i < INJECT_NCLASSES; i++)
+	{
+		if (nclassBlocks[i] > 0)
+			classes[nclasses++] = i;
+	}
+
+	if (!ok)
+	{
+		for (i = 0; i < INJECT_NCLASSES; i++)
+			pg_free(classBlocks[i]);
+		blockOptions = savedOptions;
+		CloseRelationCache();
+		return;
+	}
+
+	if (nclasses == 0)
+	{
+		fprintf(stderr, "pg_hexedit error: file \"%s\" has no fields of any class that --classes selects\n",
+				fileName);
+		exitCode = 1;
+		for (i = 0; i < INJECT_NCLASSES; i++)
+			pg_free(classBlocks[i]);
+		blockOptions = savedOptions;
+		CloseRelationCache();
+		return;
+	}
 
-		/*
-		 * Regular/common case, where offset number is actually intended to be
-		 * accessed as a conventional offset (i.e. accessed using macros such
-		 * as ItemPointerGetOffsetNumber())
-		 */
-		else
-			EmitXmlTupleTagFont(blkno, offset, "t_tid->offsetNumber",
-								tagColor, fontColor,
-								relfileOff, relfileOffNext - 1);
+	snprintf(path, sizeof(path), "%s/manifest", injectDirName);
+	manifest = fopen(path, "w");
+	if (!manifest)
+	{
+		fprintf(stderr, "pg_hexedit error: could not open \"%s\" for writing: %s\n",
+				path, strerror(errno));
+		exitCode = 1;
+		for (i = 0; i < INJECT_NCLASSES; i++)
+			pg_free(classBlocks[i]);
+		blockOptions = savedOptions;
+		CloseRelationCache();
+		return;
 	}
-	else
+	fprintf(manifest, "file|block|offset|class|field|mutation|start|end|old_value|new_value\n");
+
+	baseName = strrchr(fileName, '/') ? strrchr(fileName, '/') + 1 : fileName;
+	fileSize = (size_t) relationBlocks * blockSize;
+	pages = (char *) pg_malloc((size_t) injectCorruptions * blockSize);
+	pageBlocks = (BlockNumber *) pg_malloc(sizeof(BlockNumber) *
+										   injectCorruptions);
+	pageChecksums = (bool *) pg_malloc(sizeof(bool) * injectCorruptions);
+	for (v = 0; v < injectVariants && ok; v++)
 	{
-		/*
-		 * GIN posting lists (within the leaf level of the main entry tree)
-		 * abuse every item pointer field, so everything is handled here all
-		 * at once.  Naturally, there are block numbers (as well as offset
-		 * numbers) contained within posting lists, since a posting list is
-		 * literally a list of TIDs.  However, none of this information is
-		 * accessed in the conventional manner.
-		 */
-		relfileOffNext = relfileOff + sizeof(uint16);
-		tagColor = dead ? COLOR_BLACK : COLOR_BLUE_LIGHT;
-		EmitXmlTupleTagFont(blkno, offset, "t_tid->bi_hi/GinItupIsCompressed()",
-							tagColor, fontColor,
-							relfileOff, relfileOffNext - 1);
-		relfileOff = relfileOffNext;
-		relfileOffNext += sizeof(uint16);
-		EmitXmlTupleTagFont(blkno, offset,
-							"t_tid->bi_lo/GinGetPostingOffset()",
-							tagColor, fontColor,
-							relfileOff, relfileOffNext - 1);
-		relfileOff = relfileOffNext;
-		relfileOffNext += sizeof(uint16);
-		tagColor = dead ? COLOR_BLACK : COLOR_BLUE_DARK;
-		EmitXmlTupleTagFont(blkno, offset,
-							"t_tid->offsetNumber/GinGetNPosting()",
-							tagColor, fontColor,
-							relfileOff, relfileOffNext - 1);
+		uint64		rng = injectSeed ^ ((uint64) v * UINT64CONST(0xD1B54A32D192ED03));
+		char		variantName[MAXPGPATH];
+		int			npages = 0;
+		int			c;
+		int			fd;
+		size_t		written;
+
+		snprintf(variantName, sizeof(variantName), "%s.v%d", baseName, v);
+		for (c = 0; c < injectCorruptions; c++)
+		{
+			int			class = classes[InjectRandom(&rng) % nclasses];
+			PageTag    *tags;
+			int			ntags;
+			int			ncandidates = 0;
+			int			chosen;
+			char	   *page;
+			const char *problem;
+
+			blkno = classBlocks[class][InjectRandom(&rng) % nclassBlocks[class]];
+			problem = ReadRelationBlock(blkno, buffer);
+			if (problem)
+			{
+				fprintf(stderr, "pg_hexedit error: could not read block %u of file \"%s\": %s\n",
+						blkno, fileName, problem);
+				exitCode = 1;
+				ok = false;
+				break;
+			}
+			for (i = 0; i < npages; i++)
+			{
+				if (pageBlocks[i] == blkno)
+					break;
+			}
+			page = pages + (size_t) i * blockSize;
+			if (i == npages)
+			{
+				memcpy(page, buffer, blockSize);
+				pageBlocks[npages] = blkno;
+				pageChecksums[npages++] = false;
+			}
+
+			/* Fields are always found using the original page's tags */
+			ntags = ParsePageTags(blkno, buffer, &tags);
+			for (i = 0; i < ntags; i++)
+			{
+				char		field[NAMEDATALEN];
+				OffsetNumber offset;
+
+				if (GetInjectTagClass(&tags[i], blkno, field, &offset) == class)
+					ncandidates++;
+			}
+			chosen = InjectRandom(&rng) % ncandidates;
+			for (i = 0; i < ntags; i++)
+			{
+				char		field[NAMEDATALEN];
+				OffsetNumber offset;
+
+				if (GetInjectTagClass(&tags[i], blkno, field, &offset) != class)
+					continue;
+				if (chosen-- == 0)
+				{
+					InjectCorruption(&rng, &tags[i], page, blkno, manifest,
+									 variantName, class);
+					if (class == INJECT_PAGE && strcmp(field, "checksum") == 0)
+						pageChecksums[(page - pages) / blockSize] = true;
+					break;
+				}
+			}
+			for (i = 0; i < ntags; i++)
+				pg_free(tags[i].text);
+			pg_free(tags);
+		}
+		if (!ok)
+			break;
+
+		snprintf(path, sizeof(path), "%s/%s", injectDirName, variantName);
+		fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+		if (fd < 0)
+		{
+			fprintf(stderr, "pg_hexedit error: could not open \"%s\" for writing: %s\n",
+					path, strerror(errno));
+			exitCode = 1;
+			ok = false;
+			break;
+		}
+		for (blkno = 0, written = 0; blkno < relationBlocks; blkno++)
+		{
+			const char *problem = ReadRelationBlock(blkno, buffer);
+			size_t		done = 0;
+
+			if (problem)
+			{
+				fprintf(stderr, "pg_hexedit error: could not read block %u of file \"%s\": %s\n",
+						blkno, fileName, problem);
+				exitCode = 1;
+				ok = false;
+				break;
+			}
+			while (done < blockSize)
+			{
+				ssize_t		nwritten = write(fd, buffer + done,
+											 blockSize - done);
+
+				if (nwritten <= 0)
+					break;
+				done += nwritten;
+			}
+			written += done;
+			if (done != blockSize)
+				break;
+		}
+		/* Corrupted pages' checksums follow the -k given by user, if any */
+		blockOptions = savedOptions;
+		for (i = 0; i < npages && written == fileSize; i++)
+		{
+			char	   *page = pages + (size_t) i * blockSize;
+			PageHeader	pageHeader = (PageHeader) page;
+
+			if ((blockOptions & BLOCK_FIX_CHECKSUMS) && !pageChecksums[i] &&
+				VerifyPageChecksum(page, pageBlocks[i], &calculated) ==
+				PAGE_CHECKSUM_INVALID)
+				pageHeader->pd_checksum = calculated;
+			if (pg_pwrite(fd, page, blockSize,
+						  (off_t) pageBlocks[i] * blockSize) != blockSize)
+				written = 0;
+		}
+		blockOptions &= ~(BLOCK_CHECKSUMS | BLOCK_ZEROSUMS);
+		if (written != fileSize || close(fd) != 0)
+		{
+			fprintf(stderr, "pg_hexedit error: could not write \"%s\"\n", path);
+			exitCode = 1;
+			ok = false;
+		}
 	}
 
-	/*
-	 * Metadata about the tuple shape and width is COLOR_YELLOW_DARK, which
-	 * also matches EmitXmlHeapTuple()
-	 */
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(unsigned short);
-	flagString = GetIndexTupleFlags(tuple);
-	tagColor = dead ? COLOR_BLACK : COLOR_YELLOW_DARK;
-	EmitXmlTupleTagFont(blkno, offset, flagString,
-						tagColor, fontColor,
-						relfileOff, relfileOffNext - 1);
-	pg_free(flagString);
-	relfileOff = relfileOffNext;
+	if (fclose(manifest) != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: could not write \"%s/manifest\"\n",
+				injectDirName);
+		exitCode = 1;
+	}
+	else if (ok)
+		fprintf(stderr, "pg_hexedit notice: --inject wrote %d variants of file \"%s\" with %d corruptions each to \"%s\" (seed " UINT64_FORMAT ")\n",
+				injectVariants, fileName, injectCorruptions, injectDirName,
+				injectSeed);
+
+	pg_free(pages);
+	pg_free(pageBlocks);
+	pg_free(pageChecksums);
+	for (i = 0; i < INJECT_NCLASSES; i++)
+		pg_free(classBlocks[i]);
+	blockOptions = savedOptions;
+	CloseRelationCache();
+}
 
-	/*
-	 * NULL bitmap, if any, is counted as a separate tag, and not an extension
-	 * of t_info.  This is a little arbitrary, but makes more sense overall.
-	 * This matches heap tuple header tags.
-	 *
-	 * GIN has special rules for multicolumn indexes.  We don't break down the
-	 * structure of GIN's special representation of NULLness because doing so
-	 * requires access to catalog metadata.  See the GIN README for details.
-	 *
-	 * SP-GiST node tuples (from internal SP-GiST pages) do not have a NULL
-	 * bitmap, since there is implicitly only ever one attribute that could be
-	 * NULL, so the bit alone suffices.  See comments above
-	 * SpGistNodeTupleData.
-	 */
-	Assert(specialType != SPEC_SECT_INDEX_SPGIST || !SpGistPageIsLeaf(page));
-	if (IndexTupleHasNulls(tuple) && specialType != SPEC_SECT_INDEX_SPGIST)
+/*
+ * Emit one --shard-blocks shard's tags as a standalone XML document, in the
+ * calling thread.  The state of the document being emitted is thread-local,
+ * and is set up from scratch here.
+ */
+static void
+EmitXmlShard(TagShard *shard)
+{
+	FILE	   *savedFp = fp;
+	FILE	   *savedXmlOut = xmlOut;
+
+	fp = fopen(fileName, "rb");
+	if (!fp)
 	{
-		relfileOffNext +=
-			(IndexInfoFindDataOffset(tuple->t_info) - (relfileOff - relfileOffOrig));
+		fprintf(stderr, "pg_hexedit error: could not open file \"%s\" for shard of blocks %u - %u\n",
+				fileName, shard->start, shard->end);
+		exitCode = 1;
+		fp = savedFp;
+		return;
+	}
 
-		tagColor = dead ? COLOR_BLACK : COLOR_YELLOW_DARK;
-		EmitXmlTupleTagFont(blkno, offset, "IndexAttributeBitMapData array",
-							tagColor, fontColor,
-							relfileOff, relfileOffNext - 1);
-		relfileOff = relfileOffNext;
+	xmlOut = fopen(shard->fileName, "w");
+	if (!xmlOut)
+	{
+		fprintf(stderr, "pg_hexedit error: could not open shard file \"%s\" for writing\n",
+				shard->fileName);
+		exitCode = 1;
+		fclose(fp);
+		fp = savedFp;
+		xmlOut = savedXmlOut;
+		return;
 	}
 
-	/*
-	 * Tuple contents, plus possible posting list for GIN leaf pages.
-	 *
-	 * All-attributes-NULL IndexTuples will not have any contents here, so we
-	 * avoid creating a tuple content tag entirely.  The same applies to
-	 * "minus infinity" items from nbtree internal pages (though they don't
-	 * have a NULL bitmap).
-	 *
-	 * Tuple contents is represented in the same way in the event of a dead
-	 * tuple.
-	 */
-	relfileOffNext = relfileOffOrig + itemSize;
-	if (relfileOff < relfileOffNext)
+	blockStart = shard->start;
+	blockEnd = shard->end;
+	currentBlock = 0;
+	tagNumber = 0;
+	firstType = SPEC_SECT_ERROR_UNKNOWN;
+	minPageLSN = (XLogRecPtr) PG_UINT64_MAX;
+	maxPageLSN = InvalidXLogRecPtr;
+	nblockstagged = 0;
+	nblocksskipped = 0;
+	if (!buffer)
+		buffer = (char *) pg_malloc(blockSize);
+
+	EmitXmlDocHeader(shardNumOptions, shardOptions);
+	EmitXmlBody();
+	EmitXmlFooter();
+
+	shard->npages = nblockstagged;
+	shard->minLsn = nblockstagged > 0 ? minPageLSN : InvalidXLogRecPtr;
+	shard->maxLsn = maxPageLSN;
+	shard->ntags = tagNumber;
+	shard->written = true;
+
+	if (fclose(xmlOut) != 0)
 	{
-		/*
-		 * If this is a GIN page, we've already determined that this tuple is
-		 * from the main key B-Tree (posting trees don't use IndexTuples at
-		 * all).  We should only treat it as containing a posting list (in
-		 * addition to tuple contents) if:
-		 *
-		 * 1. It does not point to a posting tree.  Pointers to posting trees
-		 * are always simple block numbers (the posting tree root page block)
-		 * with magic offset number GIN_TREE_POSTING.
-		 *
-		 * 2. The posting list consists of one or more items.  See
-		 * ginReadTuple().
-		 *
-		 * 3. This isn't an internal page IndexTuple.  These use the item
-		 * pointer representation in the conventional way.
-		 *
-		 * 4. This isn't a pending list page.  These also don't abuse the item
-		 * pointer representation.
-		 *
-		 * The !GinPageIsLeaf() part of the test handles points 3 and 4.
-		 */
-		if (specialType != SPEC_SECT_INDEX_GIN || !GinPageIsLeaf(page) ||
-			GinIsPostingTree(tuple) || GinGetNPosting(tuple) == 0)
-			EmitXmlAttributesIndex(blkno, offset, relfileOff, tuple,
-								   relfileOffOrig, itemSize);
-		else
-		{
-			Size		postoffset = itemSize - GinGetPostingOffset(tuple);
-			const char *color;
+		fprintf(stderr, "pg_hexedit error: could not write shard file \"%s\"\n",
+				shard->fileName);
+		exitCode = 1;
+		shard->written = false;
+	}
+	fclose(fp);
+	fp = savedFp;
+	xmlOut = savedXmlOut;
+}
 
-			EmitXmlAttributesIndex(blkno, offset, relfileOff, tuple, relfileOffOrig,
-								   GinGetPostingOffset(tuple));
-			relfileOff = relfileOffNext - postoffset;
+/*
+ * --shard-blocks worker thread.  Claims shards until none remain.
+ */
+static void *
+ShardWorkerMain(void *arg)
+{
+	char	   *savedBuffer = buffer;
 
-			/*
-			 * Compressed TIDs are orange.  Old Postgres versions have
-			 * old-style uncompressed lists of TIDs in leaf pages, so their
-			 * posting lists should be blue instead of orange, like regular
-			 * block number item pointer fields.  See ginPostingListDecode()
-			 * for details on how this representation is decompressed.
-			 */
-			color =
-			GinItupIsCompressed(tuple) ? COLOR_ORANGE : COLOR_BLUE_LIGHT;
+	buffer = NULL;
+	for (;;)
+	{
+		int			shard;
 
-			EmitXmlTupleTag(blkno, offset, "posting list", color, relfileOff,
-							relfileOffNext - 1);
-		}
+		pthread_mutex_lock(&scanLock);
+		shard = nextTagShard++;
+		pthread_mutex_unlock(&scanLock);
+
+		if (shard >= ntagShards)
+			break;
+
+		EmitXmlShard(&tagShards[shard]);
 	}
+
+	if (buffer)
+		pg_free(buffer);
+	buffer = savedBuffer;
+	if (tagText.data)
+		pg_free(tagText.data);
+
+	return NULL;
 }
 
 /*
- * Emit a wxHexEditor tag for internal SP-GiST page tuple.
- *
- * This is similar to EmitXmlIndexTuple(), but SP-GiST never directly uses
- * IndexTuple representation, so requires this custom tuple formatting
- * function.  (Actually, SP-GiST internal/inner tuples end up reusing the
- * IndexTuple representation internally, which we must deal with here.)
- *
- * We are prepared for the possibility that tuple is actually SpGistDeadTuple.
- *
- * Note that lp_len isn't needed here, since it's redundant, just as it is with
- * the IndexTuple representation.
+ * Write tags for each --shard-blocks block range of file (or -R range) to a
+ * separate file, named after the file and the range.  Each is a complete
+ * wxHexEditor XML document that can be imported on its own.  Shards are
+ * written by -j worker threads, and a manifest of the shards is printed to
+ * stdout in the same unaligned format as "psql -A".
  */
 static void
-EmitXmlSpGistInnerTuple(Page page, BlockNumber blkno, OffsetNumber offset,
-						SpGistInnerTuple tuple, uint32 relfileOff)
+EmitXmlShards(int numOptions, char **options)
 {
-	SpGistNodeTuple node;
-	uint32		relfileOffNext = 0;
-	uint32		relfileOffOrig = relfileOff;
-	char	   *flagString;
-	bool		dead = (tuple->tupstate != SPGIST_LIVE);
+	pthread_t  *threads;
+	BlockNumber first;
+	BlockNumber last;
 	int			i;
 
-	Assert(!SpGistPageIsLeaf(page));
-	Assert(!SpGistPageIsMeta(page));
+	if (!GetScanRange(&first, &last))
+		return;
 
-	/*
-	 * Reuse dead tuple handling within leaf tuple routine.  This correctly
-	 * indicates "inner page leaf tuple" size by interpreting the leaf tuple
-	 * "size" field, and there are no other fields that could be interpreted
-	 * incorrectly, so this seems to be the right approach.
-	 */
-	if (dead)
+	shardNumOptions = numOptions;
+	shardOptions = options;
+	blockOptions |= BLOCK_RANGE;
+
+	ntagShards = ((last - first + 1) + shardBlocks - 1) / shardBlocks;
+	tagShards = (TagShard *) pg_malloc0(sizeof(TagShard) * ntagShards);
+	for (i = 0; i < ntagShards; i++)
+	{
+		TagShard   *shard = &tagShards[i];
+		size_t		len = strlen(fileName) + 32;
+
+		shard->start = first + i * shardBlocks;
+		shard->end = Min(shard->start + shardBlocks - 1, last);
+		shard->fileName = (char *) pg_malloc(len);
+		snprintf(shard->fileName, len, "%s.%u-%u.tags", fileName,
+				 shard->start, shard->end);
+	}
+
+	/* The main thread is always a worker */
+	threads = (pthread_t *) pg_malloc0(sizeof(pthread_t) * numWorkers);
+	for (i = 1; i < numWorkers; i++)
+	{
+		if (pthread_create(&threads[i], NULL, ShardWorkerMain, NULL) != 0)
+		{
+			fprintf(stderr, "pg_hexedit error: could not create worker thread %d\n",
+					i);
+			exitCode = 1;
+			break;
+		}
+	}
+	ShardWorkerMain(NULL);
+	while (--i > 0)
+		pthread_join(threads[i], NULL);
+
+	printf("shard|start_block|end_block|pages|min_lsn|max_lsn|tags|file\n");
+	for (i = 0; i < ntagShards; i++)
+	{
+		TagShard   *shard = &tagShards[i];
+
+		if (shard->written)
+			printf("%d|%u|%u|%u|%X/%08X|%X/%08X|%u|%s\n",
+				   i + 1, shard->start, shard->end, shard->npages,
+				   (uint32) (shard->minLsn >> 32), (uint32) shard->minLsn,
+				   (uint32) (shard->maxLsn >> 32), (uint32) shard->maxLsn,
+				   shard->ntags, shard->fileName);
+		pg_free(shard->fileName);
+	}
+
+	pg_free(threads);
+	pg_free(tagShards);
+	tagShards = NULL;
+}
+
+/*
+ * Set up an empty tags cache for relation file, for --serve, --view, --html,
+ * and --inject.  The file's size is only determined here.  Returns false on
+ * error.
+ */
+static bool
+OpenRelationCache(void)
+{
+	struct stat st;
+	BlockNumber blkno;
+	int			i;
+
+	if (fstat(fileno(fp), &st) != 0 || st.st_size < blockSize)
 	{
-		EmitXmlSpGistLeafTuple(page, blkno, offset, (SpGistLeafTuple) tuple,
-							   relfileOff);
-		return;
+		fprintf(stderr, "pg_hexedit error: premature end of file encountered\n");
+		exitCode = 1;
+		return false;
 	}
+	relationBlocks = st.st_size / blockSize;
+
+	buffer = (char *) pg_malloc(blockSize);
+	tagCache = (TagCacheEntry *) pg_malloc0(sizeof(TagCacheEntry) *
+											TAG_CACHE_PAGES);
+	for (i = 0; i < TAG_CACHE_PAGES; i++)
+		tagCache[i].prev = tagCache[i].next = -1;
+	tagCacheSlots = (int *) pg_malloc(sizeof(int) * relationBlocks);
+	for (blkno = 0; blkno < relationBlocks; blkno++)
+		tagCacheSlots[blkno] = -1;
+
+	return true;
+}
 
-	/*
-	 * Metadata about the tuple shape and width is COLOR_YELLOW_LIGHT, to
-	 * indicate that the field is metadata, but to create a contrast with
-	 * IndexTuple metadata fields (which are COLOR_YELLOW_DARK).
-	 */
-	flagString = GetSpGistInnerTupleState(tuple);
-	relfileOffNext = relfileOff + sizeof(unsigned int);
-	EmitXmlTupleTag(blkno, offset, flagString, COLOR_YELLOW_LIGHT, relfileOff,
-					relfileOffNext - 1);
-	pg_free(flagString);
+/*
+ * Release tags cache
+ */
+static void
+CloseRelationCache(void)
+{
+	int			i;
 
-	relfileOff = relfileOffNext;
-	relfileOffNext = relfileOff + sizeof(uint16);
-	EmitXmlTupleTag(blkno, offset, "SpGistInnerTuple size", COLOR_YELLOW_LIGHT,
-					relfileOff, relfileOffNext - 1);
+	for (i = 0; i < ntagCache; i++)
+		free(tagCache[i].xml);
+	pg_free(tagCache);
+	pg_free(tagCacheSlots);
+	tagCache = NULL;
+	tagCacheSlots = NULL;
+	ntagCache = 0;
+	tagCacheLruHead = tagCacheLruTail = -1;
+}
 
-	/*
-	 * Emit node tuple's contents (prefix).  The prefix value is optional.
-	 * Some SP-GiST operator classes never use them.  See spgist/README.
-	 */
-	relfileOff = relfileOffOrig + SGNTHDRSZ;
-	relfileOffNext = relfileOffOrig + SGNTHDRSZ + tuple->prefixSize;
-	if (relfileOff < relfileOffNext)
-		EmitXmlTupleTag(blkno, offset, "contents (prefix)", COLOR_WHITE,
-						relfileOff, relfileOffNext - 1);
+/*
+ * Read block of relation file into dest, for modes that read blocks on
+ * demand.  The file isn't memory-mapped, because a long-running --serve or
+ * --view can't rule out that the file is truncated under it, and accessing
+ * a truncated mapping raises SIGBUS.  Returns NULL on success, or describes
+ * why the block couldn't be read in full.
+ */
+static const char *
+ReadRelationBlock(BlockNumber blkno, char *dest)
+{
+	size_t		done = 0;
 
-	/*
-	 * Print all SpGistNodeTuple entries, which actually share IndexTuple
-	 * representation
-	 */
-	SGITITERATE(tuple, i, node)
+	ThrottleIo(blockSize);
+	while (done < blockSize)
 	{
-		EmitXmlIndexTuple(page, blkno, offset, node,
-						  relfileOffOrig + ((char *) node - (char *) tuple),
-						  -1, false);
+		ssize_t		bytesRead = pg_pread(fileno(fp), dest + done,
+										 blockSize - done,
+										 (off_t) blkno * blockSize + done);
+
+		if (bytesRead < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return strerror(errno);
+		}
+		if (bytesRead == 0)
+			return "file was truncated";
+		done += bytesRead;
 	}
+
+	return NULL;
 }
 
 /*
- * Emit a wxHexEditor tag for leaf SP-GiST page tuple.
- *
- * We are prepared for the possibility that tuple is actually SpGistDeadTuple.
+ * Get tags for block of relation file, reading and decoding the block with
+ * EmitXmlPage() when it isn't already in the LRU cache.  Tag ids are unique
+ * across all pages decoded by the server, so that any set of pages' tags can
+ * be combined into one document.  Returns NULL, and sets *problem, when the
+ * block can't be read or decoded.  The cache is left as it was.
  */
-static void
-EmitXmlSpGistLeafTuple(Page page, BlockNumber blkno, OffsetNumber offset,
-					   SpGistLeafTuple tuple, uint32 relfileOff)
+static const char *
+GetCachedPageTags(BlockNumber blkno, size_t *len, const char **problem)
 {
-	uint32		relfileOffNext = 0;
-	uint32		relfileOffOrig = relfileOff;
-	char	   *flagString;
-	bool		dead = (tuple->tupstate != SPGIST_LIVE);
+	TagCacheEntry *entry;
+	int			slot = tagCacheSlots[blkno];
+	FILE	   *savedXmlOut = xmlOut;
 
-	Assert(!SpGistPageIsMeta(page));
+	if (slot != -1)
+	{
+		tagCacheHits++;
+		entry = &tagCache[slot];
+	}
+	else
+	{
+		char	   *xml = NULL;
+		size_t		xmllen = 0;
 
-	/*
-	 * Metadata about the tuple shape and width is COLOR_YELLOW_LIGHT, to
-	 * indicate that the field is metadata, but to create a contrast with
-	 * IndexTuple metadata fields (which are COLOR_YELLOW_DARK).
-	 */
-	flagString = GetSpGistLeafTupleState(tuple);
-	relfileOffNext = relfileOff + sizeof(unsigned int);
-	EmitXmlTupleTag(blkno, offset, flagString, COLOR_YELLOW_LIGHT, relfileOff,
-					relfileOffNext - 1);
-	pg_free(flagString);
+		*problem = ReadRelationBlock(blkno, buffer);
+		if (*problem)
+			return NULL;
+		bytesToFormat = blockSize;
+		currentBlock = blkno;
 
-	relfileOff = relfileOffNext;
-	relfileOffNext = relfileOff + sizeof(OffsetNumber);
-	EmitXmlTupleTag(blkno, offset, "nextOffset", COLOR_YELLOW_DARK,
-					relfileOff, relfileOffNext - 1);
+		xmlOut = open_memstream(&xml, &xmllen);
+		if (!xmlOut)
+		{
+			xmlOut = savedXmlOut;
+			*problem = "could not create memory stream";
+			return NULL;
+		}
+		EmitXmlPage(blkno);
+		fclose(xmlOut);
+		xmlOut = savedXmlOut;
+		tagCacheMisses++;
 
-	/* Heap pointer */
-	relfileOff = relfileOffNext;
-	relfileOffNext = relfileOff + sizeof(uint16);
-	EmitXmlTupleTag(blkno, offset, dead ? "pointer->bi_hi" : "heapPtr->bi_hi",
-					COLOR_BLUE_LIGHT, relfileOff, relfileOffNext - 1);
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(uint16);
-	EmitXmlTupleTag(blkno, offset, dead ? "pointer->bi_lo" : "heapPtr->bi_lo",
-					COLOR_BLUE_LIGHT, relfileOff, relfileOffNext - 1);
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(uint16);
-	EmitXmlTupleTag(blkno, offset, dead ? "pointer->offsetNumber" : "heapPtr->offsetNumber",
-					COLOR_BLUE_DARK, relfileOff, relfileOffNext - 1);
+		/* Take an unused entry, or evict least recently used entry */
+		if (ntagCache < TAG_CACHE_PAGES)
+		{
+			slot = ntagCache++;
+			entry = &tagCache[slot];
+		}
+		else
+		{
+			slot = tagCacheLruTail;
+			entry = &tagCache[slot];
+			tagCacheSlots[entry->blkno] = -1;
+			free(entry->xml);
+		}
 
-	if (!dead)
-	{
-		/* Must not be inner tuple if not dead */
-		Assert(SpGistPageIsLeaf(page));
+		/* Unlink from LRU list, if entry is on it */
+		if (entry->prev != -1 || tagCacheLruHead == slot)
+		{
+			if (entry->prev != -1)
+				tagCache[entry->prev].next = entry->next;
+			else
+				tagCacheLruHead = entry->next;
+			if (entry->next != -1)
+				tagCache[entry->next].prev = entry->prev;
+			else
+				tagCacheLruTail = entry->prev;
+		}
+		entry->prev = entry->next = -1;
 
-		/* Emit tuple contents */
-#if PG_VERSION_NUM >= 140000
-		relfileOff = relfileOffOrig + SGLTHDRSZ(SGLT_GET_HASNULLMASK(tuple));
-#else
-		relfileOff = relfileOffOrig + SGLTHDRSZ;
-#endif
-		relfileOffNext = relfileOffOrig + tuple->size;
-		if (relfileOff < relfileOffNext)
-			EmitXmlTupleTag(blkno, offset, "contents", COLOR_WHITE,
-							relfileOff, relfileOffNext - 1);
+		entry->xml = xml;
+		entry->len = xmllen;
+		entry->blkno = blkno;
+		tagCacheSlots[blkno] = slot;
 	}
-	else
+
+	/* Move to head of LRU list */
+	if (tagCacheLruHead != slot)
 	{
-		/* XID */
-		relfileOff = relfileOffNext;
-		relfileOffNext = relfileOff + sizeof(TransactionId);
-		EmitXmlTupleTag(blkno, offset, "xid", COLOR_RED_LIGHT,
-						relfileOff, relfileOffNext - 1);
+		if (entry->prev != -1)
+			tagCache[entry->prev].next = entry->next;
+		if (entry->next != -1)
+			tagCache[entry->next].prev = entry->prev;
+		else if (tagCacheLruTail == slot)
+			tagCacheLruTail = entry->prev;
+
+		entry->prev = -1;
+		entry->next = tagCacheLruHead;
+		if (tagCacheLruHead != -1)
+			tagCache[tagCacheLruHead].prev = slot;
+		tagCacheLruHead = slot;
+		if (tagCacheLruTail == -1)
+			tagCacheLruTail = slot;
 	}
+
+	*len = entry->len;
+	return entry->xml;
 }
 
 /*
- * Emit a wxHexEditor tag for entire BRIN regular page tuple.
+ * Answer one --serve request line.  Requests are:
  *
- * This is similar to EmitXmlIndexTuple(), but BRIN never uses IndexTuple
- * representation, so requires this custom tuple formatting function.
+ * "block n":   Tags for file-relative block n
+ * "range a b": Tags for every block that overlaps byte range [a, b) of file
+ * "stats":     Cache statistics
+ *
+ * Tags are returned as a complete wxHexEditor XML document.  A response is
+ * "OK <length>\n" followed by that many bytes, or "ERROR <message>\n".
+ * Returns false when the request is invalid, or can't be answered (such as
+ * when the file was truncated after the server started).
  */
-static void
-EmitXmlBrinTuple(Page page, BlockNumber blkno, OffsetNumber offset,
-				 BrinTuple *tuple, uint32 relfileOff, int itemSize)
+static bool
+ServeRequest(const char *request, StringInfo response, int numOptions,
+			 char **options)
 {
-	uint32		relfileOffNext = 0;
-	uint32		relfileOffOrig = relfileOff;
-	char	   *flagString;
+	unsigned long long a;
+	unsigned long long b;
+	BlockNumber first;
+	BlockNumber last;
+	BlockNumber blkno;
+	char	   *doc = NULL;
+	size_t		doclen = 0;
+	FILE	   *savedXmlOut = xmlOut;
+	char		junk;
+
+	if (sscanf(request, "block %llu %c", &a, &junk) == 1)
+	{
+		if (a >= relationBlocks)
+		{
+			appendStringInfo(response, "ERROR block %llu is beyond end of file (%u blocks)\n",
+							 a, relationBlocks);
+			return false;
+		}
+		first = last = a;
+	}
+	else if (sscanf(request, "range %llu %llu %c", &a, &b, &junk) == 2)
+	{
+		if (a >= b || a >= (unsigned long long) relationBlocks * blockSize)
+		{
+			appendStringInfo(response, "ERROR invalid byte range [%llu,%llu)\n",
+							 a, b);
+			return false;
+		}
+		first = a / blockSize;
+		last = Min((b - 1) / blockSize, relationBlocks - 1);
+		if (last - first + 1 > SERVE_MAX_BLOCKS)
+		{
+			appendStringInfo(response, "ERROR byte range [%llu,%llu) spans more than %d blocks\n",
+							 a, b, SERVE_MAX_BLOCKS);
+			return false;
+		}
+	}
+	else if (strcmp(request, "stats") == 0)
+	{
+		char		stats[128];
 
-	if (!BRIN_IS_REGULAR_PAGE(page))
+		snprintf(stats, sizeof(stats),
+				 "blocks=%u cached=%d hits=" UINT64_FORMAT " misses=" UINT64_FORMAT "\n",
+				 relationBlocks, ntagCache, tagCacheHits, tagCacheMisses);
+		appendStringInfo(response, "OK %zu\n%s", strlen(stats), stats);
+		return true;
+	}
+	else
 	{
-		fprintf(stderr, "pg_hexedit error: non-regular BRIN page formatted as regular");
-		exitCode = 1;
+		appendStringInfoString(response, "ERROR unrecognized request\n");
+		return false;
 	}
 
-	/*
-	 * Emit bt_info tags.  A straight block number is used here, in contrast
-	 * to the legacy bi_hi/bi_lo representation used everywhere else.  We
-	 * still match color/style, though.
-	 */
-	relfileOffNext = relfileOff + sizeof(BlockNumber);
-	EmitXmlTupleTag(blkno, offset, "bt_blkno", COLOR_BLUE_LIGHT, relfileOff,
-					relfileOffNext - 1);
+	xmlOut = open_memstream(&doc, &doclen);
+	if (!xmlOut)
+	{
+		xmlOut = savedXmlOut;
+		appendStringInfoString(response, "ERROR could not create memory stream\n");
+		return false;
+	}
+	EmitXmlDocHeader(numOptions, options);
+	for (blkno = first; blkno <= last; blkno++)
+	{
+		size_t		len;
+		const char *problem = NULL;
+		const char *tags = GetCachedPageTags(blkno, &len, &problem);
 
-	/*
-	 * Metadata about the tuple shape and width is COLOR_YELLOW_DARK, which
-	 * also matches EmitXmlHeapTuple()
-	 */
-	relfileOff = relfileOffNext;
-	relfileOffNext += sizeof(unsigned short);
-	flagString = GetBrinTupleFlags(tuple);
-	EmitXmlTupleTag(blkno, offset, flagString, COLOR_YELLOW_DARK, relfileOff,
-					relfileOffNext - 1);
-	pg_free(flagString);
-	relfileOff = relfileOffNext;
+		if (!tags)
+		{
+			fclose(xmlOut);
+			xmlOut = savedXmlOut;
+			free(doc);
+			appendStringInfo(response, "ERROR could not read block %u: %s\n",
+							 blkno, problem);
+			return false;
+		}
+		fwrite(tags, 1, len, xmlOut);
+	}
+	EmitXmlFooter();
+	fclose(xmlOut);
+	xmlOut = savedXmlOut;
 
-	/*
-	 * NULL bitmap, if any, is counted as a separate tag, and not an extension
-	 * of bt_info.  This matches index tuples.
-	 */
-	if (BrinTupleHasNulls(tuple))
+	appendStringInfo(response, "OK %zu\n", doclen);
+	appendBinaryStringInfo(response, doc, doclen);
+	free(doc);
+
+	return true;
+}
+
+/*
+ * Write as much of client's queued output to its non-blocking socket as it
+ * will take right now.  Returns false on error.
+ */
+static bool
+FlushServeOutput(int fd, ServeClient *client)
+{
+	while (client->outputDone < client->output.len)
 	{
-		relfileOffNext +=
-			(BrinTupleDataOffset(tuple) - (relfileOff - relfileOffOrig));
+		ssize_t		written = write(fd, client->output.data + client->outputDone,
+									client->output.len - client->outputDone);
 
-		EmitXmlTupleTag(blkno, offset, "IndexAttributeBitMapData array",
-						COLOR_YELLOW_DARK, relfileOff, relfileOffNext - 1);
-		relfileOff = relfileOffNext;
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+		client->outputDone += written;
 	}
 
-	/*
-	 * Tuple contents.
-	 *
-	 * All-attributes-NULL BrinTuples will not have any contents here, so we
-	 * avoid creating a tuple content tag entirely.
-	 *
-	 * We use the lp_len value here, since there is no IndexTupleSize()
-	 * equivalent -- lp_len is really all we have to go on in the case of BRIN
-	 * tuples.
-	 *
-	 * Tagging individual attributes is hard for BRIN indexes, so we don't do
-	 * that here.  We'd need to know how many columns are stored for each
-	 * attribute, which isn't stored in the system catalogs or in the on-disk
-	 * representation.  BrinOpcInfo.oi_nstored stores this information, which
-	 * is returned by one of the opclass methods, so full backend access is
-	 * truly necessary (in practice it's 2 for minmax operator classes, and 3
-	 * for inclusion operator classes).
-	 */
-	relfileOffNext = relfileOffOrig + itemSize;
-	if (relfileOff < relfileOffNext)
-		EmitXmlTupleTag(blkno, offset, "contents", COLOR_WHITE, relfileOff,
-						relfileOffNext - 1);
+	resetStringInfo(&client->output);
+	client->outputDone = 0;
+	return true;
 }
 
 /*
- * Dump out a formatted block header for the requested block.
+ * Signal handler that makes --serve shut down
  */
-static int
-EmitXmlPageHeader(Page page, BlockNumber blkno, uint32 level)
+static void
+ServeSignalHandler(int signum)
 {
-	int			rc = 0;
-	unsigned int headerBytes;
+	serveShutdown = 1;
+}
+
+/*
+ * Answer tag requests for relation file from clients of Unix socket until
+ * SIGINT or SIGTERM is received.  Each client sends one request
+ * per line, and receives one response per request (see ServeRequest()).
+ * Nothing is decoded up front: pages are decoded the first time their tags
+ * are requested, and kept in an LRU cache of TAG_CACHE_PAGES pages.
+ */
+static void
+ServeTags(int numOptions, char **options)
+{
+	struct pollfd fds[SERVE_MAX_CLIENTS + 1];
+	ServeClient clients[SERVE_MAX_CLIENTS + 1];
+	struct sockaddr_un addr;
+	struct sigaction act;
+	struct stat st;
+	int			listenFd;
+	int			nfds = 1;
+	int			i;
+
+	if (!OpenRelationCache())
+		return;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strlcpy(addr.sun_path, serveSocketPath, sizeof(addr.sun_path));
 
 	/*
-	 * Only attempt to format the header if the entire header (minus the item
-	 * array) is available
+	 * Remove stale socket left behind by an earlier server, but only once a
+	 * connection to it has been refused.  A socket that accepts connections
+	 * belongs to a server that is still running.  Any other failure leaves
+	 * the socket alone, and bind() reports it below.
 	 */
-	if (bytesToFormat < offsetof(PageHeaderData, pd_linp[0]))
-	{
-		headerBytes = bytesToFormat;
-		rc = EOF_ENCOUNTERED;
-	}
-	else
-	{
-		/* Interpret the contents of the header */
-		PageHeader	pageHeader = (PageHeader) page;
-		XLogRecPtr	pageLSN = GetPageLsn(page);
-		int			maxOffset = PageGetMaxOffsetNumber(page);
-		char	   *flagString;
-
-		headerBytes = offsetof(PageHeaderData, pd_linp[0]);
-		blockVersion = (unsigned int) PageGetPageLayoutVersion(page);
+	if (lstat(serveSocketPath, &st) == 0 && S_ISSOCK(st.st_mode))
+	{
+		int			probeFd = socket(AF_UNIX, SOCK_STREAM, 0);
+		int			rc = -1;
+		int			probeErrno = 0;
 
-		/* We don't count itemidarray as header */
-		if (maxOffset > 0)
+		if (probeFd >= 0)
 		{
-			unsigned int itemsLength = maxOffset * sizeof(ItemIdData);
+			/* Don't wait on a live server whose listen queue is full */
+			(void) fcntl(probeFd, F_SETFL, O_NONBLOCK);
+			rc = connect(probeFd, (struct sockaddr *) &addr, sizeof(addr));
+			probeErrno = errno;
+			close(probeFd);
+		}
 
-			if (bytesToFormat < (headerBytes + itemsLength))
-			{
-				headerBytes = bytesToFormat;
-				rc = EOF_ENCOUNTERED;
-			}
+		if (rc == 0)
+		{
+			fprintf(stderr, "pg_hexedit error: socket \"%s\" is in use by another server\n",
+					serveSocketPath);
+			exitCode = 1;
+			CloseRelationCache();
+			return;
 		}
+		if (probeErrno == ECONNREFUSED)
+			unlink(serveSocketPath);
+	}
 
-		/*
-		 * For historical reasons, the 64-bit page header LSN value is stored
-		 * as two 32-bit values.  This makes interpreting what is really just
-		 * a 64-bit unsigned int confusing on little-endian systems, because
-		 * the bytes are "in big endian order" across its two 32-bit halves,
-		 * but are in the expected little-endian order *within* each half.
-		 *
-		 * This is rather similar to the situation with t_ctid.  Unlike in
-		 * that case, we choose to make LSN a single field here, because we
-		 * don't want to have two tooltips with the format value for each
-		 * field.
-		 */
-		flagString = pg_malloc(128);
-		sprintf(flagString, "LSN: %X/%08X", (uint32) (pageLSN >> 32), (uint32) pageLSN);
-		EmitXmlTag(blkno, level, flagString, COLOR_YELLOW_LIGHT, pageOffset,
-				   (pageOffset + sizeof(PageXLogRecPtr)) - 1);
-		EmitXmlTag(blkno, level, "checksum", COLOR_GREEN_DARK,
-				   pageOffset + offsetof(PageHeaderData, pd_checksum),
-				   (pageOffset + offsetof(PageHeaderData, pd_flags)) - 1);
+	listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd < 0 ||
+		bind(listenFd, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+		listen(listenFd, SERVE_MAX_CLIENTS) != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: could not listen on socket \"%s\": %s\n",
+				serveSocketPath, strerror(errno));
+		exitCode = 1;
+		CloseRelationCache();
+		return;
+	}
 
-		/* Generate generic page header flags (reuse buffer) */
-		flagString[0] = '\0';
-		strcat(flagString, "pd_flags - ");
-		if (pageHeader->pd_flags & PD_HAS_FREE_LINES)
-			strcat(flagString, "PD_HAS_FREE_LINES|");
-		if (pageHeader->pd_flags & PD_PAGE_FULL)
-			strcat(flagString, "PD_PAGE_FULL|");
-		if (pageHeader->pd_flags & PD_ALL_VISIBLE)
-			strcat(flagString, "PD_ALL_VISIBLE|");
-		if (strlen(flagString))
-			flagString[strlen(flagString) - 1] = '\0';
+	/* No SA_RESTART, so that poll() is interrupted */
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = ServeSignalHandler;
+	sigemptyset(&act.sa_mask);
+	sigaction(SIGINT, &act, NULL);
+	sigaction(SIGTERM, &act, NULL);
+	signal(SIGPIPE, SIG_IGN);
 
-		EmitXmlTag(blkno, level, flagString, COLOR_YELLOW_DARK,
-				   pageOffset + offsetof(PageHeaderData, pd_flags),
-				   (pageOffset + offsetof(PageHeaderData, pd_lower)) - 1);
-		pg_free(flagString);
-		EmitXmlTag(blkno, level, "pd_lower", COLOR_MAROON,
-				   pageOffset + offsetof(PageHeaderData, pd_lower),
-				   (pageOffset + offsetof(PageHeaderData, pd_upper)) - 1);
-		EmitXmlTag(blkno, level, "pd_upper", COLOR_MAROON,
-				   pageOffset + offsetof(PageHeaderData, pd_upper),
-				   (pageOffset + offsetof(PageHeaderData, pd_special)) - 1);
-		EmitXmlTag(blkno, level, "pd_special", COLOR_GREEN_BRIGHT,
-				   pageOffset + offsetof(PageHeaderData, pd_special),
-				   (pageOffset + offsetof(PageHeaderData, pd_pagesize_version)) - 1);
-		EmitXmlTag(blkno, level, "pd_pagesize_version", COLOR_BROWN,
-				   pageOffset + offsetof(PageHeaderData, pd_pagesize_version),
-				   (pageOffset + offsetof(PageHeaderData, pd_prune_xid)) - 1);
-		EmitXmlTag(blkno, level, "pd_prune_xid", COLOR_RED_LIGHT,
-				   pageOffset + offsetof(PageHeaderData, pd_prune_xid),
-				   (pageOffset + offsetof(PageHeaderData, pd_linp[0])) - 1);
+	fds[0].fd = listenFd;
+	fds[0].events = POLLIN;
+
+	fprintf(stderr, "pg_hexedit notice: serving tags for %u blocks of \"%s\" on socket \"%s\"\n",
+			relationBlocks, fileName, serveSocketPath);
 
+	while (!serveShutdown)
+	{
 		/*
-		 * Eye the contents of the header and alert the user to possible
-		 * problems
+		 * Stop reading requests from a client while it has responses queued,
+		 * so that a client that never reads can't make us queue unbounded
+		 * output
 		 */
-		if ((maxOffset < 0) ||
-			(maxOffset > blockSize) ||
-			(blockVersion != PG_PAGE_LAYOUT_VERSION) || /* only one we support */
-			(pageHeader->pd_upper > blockSize) ||
-			(pageHeader->pd_upper > pageHeader->pd_special) ||
-			(pageHeader->pd_lower <
-			 (sizeof(PageHeaderData) - sizeof(ItemIdData)))
-			|| (pageHeader->pd_lower > blockSize)
-			|| (pageHeader->pd_upper < pageHeader->pd_lower)
-			|| (pageHeader->pd_special > blockSize))
-		{
-			fprintf(stderr, "pg_hexedit error: invalid header information\n");
+		for (i = 1; i < nfds; i++)
+			fds[i].events = clients[i].output.len > 0 ? POLLOUT : POLLIN;
+
+		if (poll(fds, nfds, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "pg_hexedit error: poll failed: %s\n",
+					strerror(errno));
 			exitCode = 1;
+			break;
 		}
 
-		/*
-		 * Verify checksums as valid if requested.
-		 *
-		 * Caller may want us to skip zero checksums.
-		 */
-		if (blockOptions & BLOCK_CHECKSUMS ||
-			((blockOptions & BLOCK_ZEROSUMS) && pageHeader->pd_checksum != 0))
+		/* Accept new client, if there is room for it */
+		if (fds[0].revents & POLLIN)
 		{
-			uint16		calc_checksum;
+			int			clientFd = accept(listenFd, NULL, NULL);
 
-			calc_checksum = pg_checksum_page(page, blkno + segmentBlockDelta);
-			if (calc_checksum != pageHeader->pd_checksum)
+			if (clientFd >= 0 && nfds > SERVE_MAX_CLIENTS)
 			{
-				fprintf(stderr, "pg_hexedit error: checksum failure in block %u (calculated 0x%04x)\n",
-						blkno, calc_checksum);
-				exitCode = 1;
+				/* Best effort, since we won't wait for client */
+				(void) send(clientFd, "ERROR too many clients\n", 23,
+							MSG_DONTWAIT);
+				close(clientFd);
+			}
+			else if (clientFd >= 0 &&
+					 fcntl(clientFd, F_SETFL, O_NONBLOCK) != 0)
+				close(clientFd);
+			else if (clientFd >= 0)
+			{
+				fds[nfds].fd = clientFd;
+				fds[nfds].events = POLLIN;
+				fds[nfds].revents = 0;
+				initStringInfo(&clients[nfds].request);
+				initStringInfo(&clients[nfds].output);
+				clients[nfds].outputDone = 0;
+				nfds++;
 			}
 		}
-	}
 
-	/*
-	 * If we have reached the end of file while interpreting the header, give
-	 * up
-	 */
-	if (rc == EOF_ENCOUNTERED)
-	{
-		fprintf(stderr, "pg_hexedit error: end of block encountered within page header with bytes read: %4u\n",
-				bytesToFormat);
-		exitCode = 1;
-	}
+		for (i = 1; i < nfds; i++)
+		{
+			ServeClient *client = &clients[i];
+			char		readBuf[4096];
+			ssize_t		nread;
+			char	   *newline;
+			bool		disconnect = false;
 
-	return rc;
-}
+			if (client->output.len > 0)
+			{
+				if (fds[i].revents & (POLLOUT | POLLHUP | POLLERR))
+					disconnect = !FlushServeOutput(fds[i].fd, client);
+			}
+			else if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+			{
+				nread = read(fds[i].fd, readBuf, sizeof(readBuf));
+				if (nread < 0)
+					disconnect = !(errno == EINTR || errno == EAGAIN ||
+								   errno == EWOULDBLOCK);
+				else if (nread == 0)
+					disconnect = true;
+				else
+					appendBinaryStringInfo(&client->request, readBuf, nread);
+			}
 
-/*
- * Dump out a formatted metapage tags for metapage block.
- */
-static void
-EmitXmlPageMeta(BlockNumber blkno, uint32 level)
-{
-	uint32		metaStartOffset = pageOffset + MAXALIGN(SizeOfPageHeaderData);
-
-	if (specialType == SPEC_SECT_INDEX_BTREE && blkno == BTREE_METAPAGE)
-	{
-		EmitXmlTag(InvalidBlockNumber, level, "btm_magic", COLOR_PINK,
-				   metaStartOffset + offsetof(BTMetaPageData, btm_magic),
-				   (metaStartOffset + offsetof(BTMetaPageData, btm_version) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "btm_version", COLOR_PINK,
-				   metaStartOffset + offsetof(BTMetaPageData, btm_version),
-				   (metaStartOffset + offsetof(BTMetaPageData, btm_root) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "btm_root", COLOR_PINK,
-				   metaStartOffset + offsetof(BTMetaPageData, btm_root),
-				   (metaStartOffset + offsetof(BTMetaPageData, btm_level) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "btm_level", COLOR_PINK,
-				   metaStartOffset + offsetof(BTMetaPageData, btm_level),
-				   (metaStartOffset + offsetof(BTMetaPageData, btm_fastroot) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "btm_fastroot", COLOR_PINK,
-				   metaStartOffset + offsetof(BTMetaPageData, btm_fastroot),
-				   (metaStartOffset + offsetof(BTMetaPageData, btm_fastlevel) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "btm_fastlevel", COLOR_PINK,
-				   metaStartOffset + offsetof(BTMetaPageData, btm_fastlevel),
-#if PG_VERSION_NUM < 140000
-				   (metaStartOffset + offsetof(BTMetaPageData, btm_oldest_btpo_xact) - 1));
+			/*
+			 * Answer complete request lines one at a time, and only while no
+			 * earlier response is still queued.  Lines left over are answered
+			 * once the client has read the queued response.
+			 */
+			while (!disconnect && client->output.len == 0 &&
+				   (newline = memchr(client->request.data, '\n',
+									 client->request.len)) != NULL)
+			{
+				int			linelen = newline - client->request.data;
 
-		/*
-		 * These fields are only actually active when btm_version >= 3 (which
-		 * is v11's standard BTREE_VERSION)
-		 */
-		EmitXmlTag(InvalidBlockNumber, level, "btm_oldest_btpo_xact", COLOR_PINK,
-				   metaStartOffset + offsetof(BTMetaPageData, btm_oldest_btpo_xact),
-				   (metaStartOffset + offsetof(BTMetaPageData, btm_last_cleanup_num_heap_tuples) - 1));
-#else
-				   (metaStartOffset + offsetof(BTMetaPageData, btm_last_cleanup_num_delpages) - 1));
+				if (linelen > SERVE_MAX_REQUEST)
+					break;
 
-		/*
-		 * These fields are only actually active when btm_version >= 3 (which
-		 * is v11's standard BTREE_VERSION)
-		 */
-		EmitXmlTag(InvalidBlockNumber, level, "btm_last_cleanup_num_delpages", COLOR_PINK,
-				   metaStartOffset + offsetof(BTMetaPageData, btm_last_cleanup_num_delpages),
-				   (metaStartOffset + offsetof(BTMetaPageData, btm_last_cleanup_num_heap_tuples) - 1));
-#endif /* PG_VERSION_NUM < 140000 */
+				*newline = '\0';
+				if (linelen > 0 && client->request.data[linelen - 1] == '\r')
+					client->request.data[linelen - 1] = '\0';
 
-		EmitXmlTag(InvalidBlockNumber, level, "btm_last_cleanup_num_heap_tuples", COLOR_PINK,
-				   metaStartOffset + offsetof(BTMetaPageData, btm_last_cleanup_num_heap_tuples),
-#if PG_VERSION_NUM < 130000
-				   (metaStartOffset + sizeof(BTMetaPageData) - 1));
-#else
-				   (metaStartOffset + offsetof(BTMetaPageData, btm_allequalimage) - 1));
+				(void) ServeRequest(client->request.data, &client->output,
+									numOptions, options);
 
-		/* New metapage field added in Postgres 13: */
-		EmitXmlTag(InvalidBlockNumber, level, "btm_allequalimage", COLOR_PINK,
-				   metaStartOffset + offsetof(BTMetaPageData, btm_allequalimage),
-				   (metaStartOffset + sizeof(BTMetaPageData) - 1));
-#endif /* PG_VERSION_NUM < 130000 */
-	}
-	else if (specialType == SPEC_SECT_INDEX_HASH && blkno == HASH_METAPAGE)
-	{
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_magic", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_magic),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_version) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_version", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_version),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_ntuples) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_ntuples", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_ntuples),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_ffactor) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_ffactor", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_ffactor),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_bsize) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_bsize", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_bsize),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_bmsize) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_bmsize", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_bmsize),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_bmshift) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_bmshift", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_bmshift),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_maxbucket) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_maxbucket", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_maxbucket),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_highmask) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_highmask", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_highmask),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_lowmask) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_lowmask", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_lowmask),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_ovflpoint) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_ovflpoint", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_ovflpoint),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_firstfree) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_firstfree", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_firstfree),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_nmaps) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_nmaps", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_nmaps),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_procid) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_procid", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_procid),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_spares) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_spares", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_spares),
-				   (metaStartOffset + offsetof(HashMetaPageData, hashm_mapp) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "hashm_mapp", COLOR_PINK,
-				   metaStartOffset + offsetof(HashMetaPageData, hashm_mapp),
-				   (metaStartOffset + sizeof(HashMetaPageData)) - 1);
-	}
-	else if (specialType == SPEC_SECT_INDEX_GIN && blkno == GIN_METAPAGE_BLKNO)
-	{
-		EmitXmlTag(InvalidBlockNumber, level, "head", COLOR_PINK,
-				   metaStartOffset + offsetof(GinMetaPageData, head),
-				   (metaStartOffset + offsetof(GinMetaPageData, tail) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "tail", COLOR_PINK,
-				   metaStartOffset + offsetof(GinMetaPageData, tail),
-				   (metaStartOffset + offsetof(GinMetaPageData, tailFreeSize) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "tailFreeSize", COLOR_PINK,
-				   metaStartOffset + offsetof(GinMetaPageData, tailFreeSize),
-				   (metaStartOffset + offsetof(GinMetaPageData, nPendingPages) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "nPendingPages", COLOR_PINK,
-				   metaStartOffset + offsetof(GinMetaPageData, nPendingPages),
-				   (metaStartOffset + offsetof(GinMetaPageData, nPendingHeapTuples) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "nPendingHeapTuples", COLOR_PINK,
-				   metaStartOffset + offsetof(GinMetaPageData, nPendingHeapTuples),
-				   (metaStartOffset + offsetof(GinMetaPageData, nTotalPages) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "nTotalPages", COLOR_PINK,
-				   metaStartOffset + offsetof(GinMetaPageData, nTotalPages),
-				   (metaStartOffset + offsetof(GinMetaPageData, nEntryPages) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "nEntryPages", COLOR_PINK,
-				   metaStartOffset + offsetof(GinMetaPageData, nEntryPages),
-				   (metaStartOffset + offsetof(GinMetaPageData, nDataPages) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "nDataPages", COLOR_PINK,
-				   metaStartOffset + offsetof(GinMetaPageData, nDataPages),
-				   (metaStartOffset + offsetof(GinMetaPageData, nEntries) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "nEntries", COLOR_PINK,
-				   metaStartOffset + offsetof(GinMetaPageData, nEntries),
-				   (metaStartOffset + offsetof(GinMetaPageData, ginVersion) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "ginVersion", COLOR_PINK,
-				   metaStartOffset + offsetof(GinMetaPageData, ginVersion),
-				   (metaStartOffset + sizeof(GinMetaPageData)) - 1);
-	}
-	else if (specialType == SPEC_SECT_INDEX_SPGIST && blkno == SPGIST_METAPAGE_BLKNO)
-	{
-		uint32		cachedOffset = metaStartOffset;
-		int			i;
+				memmove(client->request.data, newline + 1,
+						client->request.len - linelen - 1);
+				client->request.len -= linelen + 1;
+				client->request.data[client->request.len] = '\0';
 
-		EmitXmlTag(InvalidBlockNumber, level, "magicNumber", COLOR_PINK,
-				   metaStartOffset + offsetof(SpGistMetaPageData, magicNumber),
-				   (metaStartOffset + offsetof(SpGistMetaPageData, lastUsedPages) - 1));
+				disconnect = !FlushServeOutput(fds[i].fd, client);
+			}
 
-		cachedOffset += offsetof(SpGistMetaPageData, lastUsedPages);
+			/*
+			 * Drop client whose next request line is too long, whether or not
+			 * its end has been received.  Its error response is only written
+			 * if the client will take it right away.
+			 */
+			if (!disconnect && client->output.len == 0 &&
+				client->request.len > 0)
+			{
+				newline = memchr(client->request.data, '\n',
+								 client->request.len);
+				if ((newline ? newline - client->request.data :
+					 client->request.len) > SERVE_MAX_REQUEST)
+				{
+					appendStringInfoString(&client->output,
+										   "ERROR request too long\n");
+					(void) FlushServeOutput(fds[i].fd, client);
+					disconnect = true;
+				}
+			}
 
-		for (i = 0; i < SPGIST_CACHED_PAGES; i++)
-		{
-			EmitXmlTag(InvalidBlockNumber, level, "lastUsedPages.blkno", COLOR_PINK,
-					   cachedOffset,
-					   (cachedOffset + offsetof(SpGistLastUsedPage, freeSpace)) - 1);
-			cachedOffset += offsetof(SpGistLastUsedPage, freeSpace);
-			EmitXmlTag(InvalidBlockNumber, level, "lastUsedPages.freeSpace", COLOR_PINK,
-					   cachedOffset,
-					   (cachedOffset + sizeof(int) - 1));
-			cachedOffset += sizeof(int);
+			if (disconnect)
+			{
+				close(fds[i].fd);
+				pg_free(client->request.data);
+				pg_free(client->output.data);
+				fds[i] = fds[nfds - 1];
+				clients[i] = clients[nfds - 1];
+				nfds--;
+				i--;
+			}
 		}
 	}
-	else if (specialType == SPEC_SECT_INDEX_BRIN && blkno == BRIN_METAPAGE_BLKNO)
-	{
-		EmitXmlTag(InvalidBlockNumber, level, "brinMagic", COLOR_PINK,
-				   metaStartOffset + offsetof(BrinMetaPageData, brinMagic),
-				   (metaStartOffset + offsetof(BrinMetaPageData, brinVersion) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "brinVersion", COLOR_PINK,
-				   metaStartOffset + offsetof(BrinMetaPageData, brinVersion),
-				   (metaStartOffset + offsetof(BrinMetaPageData, pagesPerRange) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "pagesPerRange", COLOR_PINK,
-				   metaStartOffset + offsetof(BrinMetaPageData, pagesPerRange),
-				   (metaStartOffset + offsetof(BrinMetaPageData, lastRevmapPage) - 1));
-		EmitXmlTag(InvalidBlockNumber, level, "lastRevmapPage", COLOR_PINK,
-				   metaStartOffset + offsetof(BrinMetaPageData, lastRevmapPage),
-				   (metaStartOffset + sizeof(BrinMetaPageData)) - 1);
-	}
-	else
+
+	for (i = 1; i < nfds; i++)
 	{
-		fprintf(stderr, "pg_hexedit error: unsupported metapage special section type \"%s\"\n",
-				GetSpecialSectionString(specialType));
-		exitCode = 1;
+		close(fds[i].fd);
+		pg_free(clients[i].request.data);
+		pg_free(clients[i].output.data);
 	}
+	close(listenFd);
+	unlink(serveSocketPath);
+
+	fprintf(stderr, "pg_hexedit notice: --serve answered requests for " UINT64_FORMAT " pages (" UINT64_FORMAT " from cache)\n",
+			tagCacheHits + tagCacheMisses, tagCacheHits);
+
+	CloseRelationCache();
 }
 
+#endif							/* PG_HEXEDIT_EXTENSION */
+
 /*
- * Emit formatted ItemId tags for tuples that reside on this block.
+ * qsort comparator that sorts tags widest first
  */
-static void
-EmitXmlPageItemIdArray(Page page, BlockNumber blkno)
+static int
+PageTagCmp(const void *a, const void *b)
 {
-	int			maxOffset = PageGetMaxOffsetNumber(page);
-	OffsetNumber offset;
-	unsigned int headerBytes;
+	const PageTag *taga = (const PageTag *) a;
+	const PageTag *tagb = (const PageTag *) b;
+	uint32		spana = taga->end - taga->start;
+	uint32		spanb = tagb->end - tagb->start;
 
-	headerBytes = offsetof(PageHeaderData, pd_linp[0]);
+	if (spana != spanb)
+		return spana > spanb ? -1 : 1;
+	if (taga->start != tagb->start)
+		return taga->start < tagb->start ? -1 : 1;
 
-	/*
-	 * It's either a non-meta index page, or a heap page.  Create tags for all
-	 * ItemId entries/line pointers on page.
-	 */
-	for (offset = FirstOffsetNumber;
-		 offset <= maxOffset;
-		 offset = OffsetNumberNext(offset))
-	{
-		ItemId		itemId;
-		unsigned int itemFlags;
-		char		textFlags[16];
+	return 0;
+}
 
-		itemId = PageGetItemId(page, offset);
+/*
+ * Collect tag for CollectPageTags().  This is the tag visitor used by --view,
+ * --html, and the server extension, which never need any XML.
+ */
+static void
+PageTagsVisitTag(uint32 start, uint32 end, const char *text,
+				 const char *fontColor, const char *noteColor)
+{
+	PageTag    *tag;
+
+	if (!visitedTags)
+		visitedTags = (PageTag *) pg_malloc(sizeof(PageTag) * 64);
+	else if (nvisitedTags % 64 == 0)
+		visitedTags = (PageTag *) pg_realloc(visitedTags, sizeof(PageTag) *
+											 (nvisitedTags + 64));
+	tag = &visitedTags[nvisitedTags++];
+	tag->start = start;
+	tag->end = end;
+	tag->text = pg_strdup(text);
+	strlcpy(tag->fontColor, fontColor, sizeof(tag->fontColor));
+	strlcpy(tag->noteColor, noteColor, sizeof(tag->noteColor));
+	tag->pair = 0;
+}
 
-		itemFlags = (unsigned int) ItemIdGetFlags(itemId);
+/*
+ * Decode page in buffer, collecting its tags rather than writing them as XML.
+ * Returns number of tags, and sets *tags to an allocated array of them,
+ * sorted widest first.
+ */
+static int
+CollectPageTags(BlockNumber blkno, PageTag **tags)
+{
+	const TagVisitor *savedVisitor = tagVisitor;
+	int			ntags;
+
+	visitedTags = NULL;
+	nvisitedTags = 0;
+	tagVisitor = &pageTagsVisitor;
+	EmitXmlPage(blkno);
+	tagVisitor = savedVisitor;
+
+	/* Always return an array, even for pages without tags */
+	if (!visitedTags)
+		visitedTags = (PageTag *) pg_malloc(sizeof(PageTag));
+	qsort(visitedTags, nvisitedTags, sizeof(PageTag), PageTagCmp);
+
+	*tags = visitedTags;
+	ntags = nvisitedTags;
+	visitedTags = NULL;
+	nvisitedTags = 0;
+
+	return ntags;
+}
 
-		switch (itemFlags)
-		{
-			case LP_UNUSED:
-				strcpy(textFlags, "LP_UNUSED");
-				break;
-			case LP_NORMAL:
-				strcpy(textFlags, "LP_NORMAL");
-				break;
-			case LP_REDIRECT:
-				strcpy(textFlags, "LP_REDIRECT");
-				break;
-			case LP_DEAD:
-				strcpy(textFlags, "LP_DEAD");
-				break;
-			default:
-				sprintf(textFlags, "0x%02x", itemFlags);
-				fprintf(stderr, "pg_hexedit error: invalid line pointer flags for (%u,%u): %s\n",
-						blkno + segmentBlockDelta, offset, textFlags);
-				exitCode = 1;
-				break;
-		}
+#ifndef PG_HEXEDIT_EXTENSION
 
-		EmitXmlItemId(blkno, offset, itemId,
-					  pageOffset + headerBytes + (sizeof(ItemIdData) * (offset - 1)),
-					  textFlags);
-	}
+/*
+ * Collect tags of block of relation file, for --view, --html, and --inject.
+ * page holds the block, as read by ReadRelationBlock().
+ */
+static int
+ParsePageTags(BlockNumber blkno, const char *page, PageTag **tags)
+{
+	if (page != buffer)
+		memcpy(buffer, page, blockSize);
+	bytesToFormat = blockSize;
+	currentBlock = blkno;
+
+	return CollectPageTags(blkno, tags);
 }
 
 /*
- * Emit formatted tuples that reside on this block.
- *
- * This is responsible for emitting tuples from all pages that use an ItemId
- * array.  This includes heapam, sequences, B-Tree, GiST, hash, regular BRIN
- * pages, and GIN pages for the main B-Tree over key values (not data/posting
- * tree pages).  It's also responsible for pending list GIN pages, which are
- * similar to GIN pages for the main B-Tree.
+ * Get curses color for "#RRGGBB" color string.  Uses the nearest color of
+ * the xterm 256 color cube when the terminal has one, and the nearest of the
+ * 8 standard colors otherwise.
  */
-static void
-EmitXmlTuples(Page page, BlockNumber blkno)
+static short
+GetViewerColor(const char *color)
 {
-	OffsetNumber offset;
-	int			itemSize;
-	int			itemOffset;
-	unsigned int itemFlags;
-	ItemId		itemId;
-	int			formatAs;
-	int			maxOffset = PageGetMaxOffsetNumber(page);
+	unsigned int red;
+	unsigned int green;
+	unsigned int blue;
 
-	/* Loop through the items on the block */
-	if (maxOffset == 0)
-		return;
-	else if ((maxOffset < 0) || (maxOffset > blockSize))
-	{
-		fprintf(stderr, "pg_hexedit error: corrupt PageGetMaxOffsetNumber() offset %d found on file block %u\n",
-				maxOffset, blkno);
-		exitCode = 1;
-		return;
-	}
+	if (sscanf(color, "#%2x%2x%2x", &red, &green, &blue) != 3)
+		return 0;				/* curses black */
 
-	/* Use the special section to determine the format style */
-	switch (specialType)
-	{
-		case SPEC_SECT_NONE:
-		case SPEC_SECT_SEQUENCE:
-			formatAs = ITEM_HEAP;
-			break;
-		case SPEC_SECT_INDEX_BTREE:
-		case SPEC_SECT_INDEX_HASH:
-		case SPEC_SECT_INDEX_GIST:
-		case SPEC_SECT_INDEX_GIN:
-			formatAs = ITEM_INDEX;
-			break;
-		case SPEC_SECT_INDEX_SPGIST:
-			if (!SpGistPageIsLeaf(page))
-				formatAs = ITEM_SPG_INN;
-			else
-				formatAs = ITEM_SPG_LEAF;
-			break;
-		case SPEC_SECT_INDEX_BRIN:
-			formatAs = ITEM_BRIN;
-			break;
-		default:
-			/* Only complain the first time an error like this is seen */
-			if (exitCode == 0)
-				fprintf(stderr, "pg_hexedit error: unsupported special section type \"%s\"\n",
-						GetSpecialSectionString(specialType));
-			formatAs = ITEM_INDEX;
-			exitCode = 1;
+	if (COLORS >= 256)
+		return 16 + 36 * ((red * 5 + 127) / 255) +
+			6 * ((green * 5 + 127) / 255) + ((blue * 5 + 127) / 255);
+
+	return (red > 127 ? COLOR_RED : 0) | (green > 127 ? COLOR_GREEN : 0) |
+		(blue > 127 ? COLOR_BLUE : 0);
+}
+
+/*
+ * Get curses color pair for tag's font and note colors, allocating a new
+ * pair when needed.  Returns 0 (the terminal's default colors) once no more
+ * pairs can be allocated.
+ */
+static short
+GetViewerPair(const char *fontColor, const char *noteColor)
+{
+	short		fg = GetViewerColor(fontColor);
+	short		bg = GetViewerColor(noteColor);
+	int			i;
+
+	if (!has_colors())
+		return 0;
+
+	for (i = 0; i < nviewerPairs; i++)
+	{
+		if (viewerPairColors[i][0] == fg && viewerPairColors[i][1] == bg)
+			return i + 1;
 	}
 
-	for (offset = FirstOffsetNumber;
-		 offset <= maxOffset;
-		 offset = OffsetNumberNext(offset))
+	if (nviewerPairs >= VIEWER_MAX_PAIRS || nviewerPairs + 1 >= COLOR_PAIRS)
+		return 0;
+
+	viewerPairColors[nviewerPairs][0] = fg;
+	viewerPairColors[nviewerPairs][1] = bg;
+	nviewerPairs++;
+	init_pair(nviewerPairs, fg, bg);
+
+	return nviewerPairs;
+}
+
+/*
+ * Get contents and parsed tags of block for --view.  Each byte of the page is
+ * mapped to its innermost (narrowest) tag, so that it can be drawn in that
+ * tag's colors.  A block that can't be read has no tags.
+ */
+static ViewerPage *
+GetViewerPage(BlockNumber blkno)
+{
+	ViewerPage *vpage = &viewerPages[blkno % VIEWER_PAGES];
+	uint32		pageStart = blkno * blockSize;
+	int			i;
+
+	if (vpage->blkno == blkno && vpage->tags)
+		return vpage;
+
+	for (i = 0; i < vpage->ntags; i++)
+		pg_free(vpage->tags[i].text);
+	if (vpage->tags)
+		pg_free(vpage->tags);
+	vpage->ntags = 0;
+	vpage->blkno = blkno;
+	if (!vpage->owner)
+		vpage->owner = (int *) pg_malloc(sizeof(int) * blockSize);
+	if (!vpage->data)
+		vpage->data = (char *) pg_malloc(blockSize);
+
+	vpage->unreadable = ReadRelationBlock(blkno, vpage->data) != NULL;
+	if (vpage->unreadable)
 	{
-		itemId = PageGetItemId(page, offset);
-		itemSize = (int) ItemIdGetLength(itemId);
-		itemOffset = (int) ItemIdGetOffset(itemId);
-		itemFlags = (unsigned int) ItemIdGetFlags(itemId);
+		memset(vpage->data, 0, blockSize);
+		vpage->tags = (PageTag *) pg_malloc(sizeof(PageTag));
+	}
+	else
+		vpage->ntags = ParsePageTags(blkno, vpage->data, &vpage->tags);
+	for (i = 0; i < vpage->ntags; i++)
+		vpage->tags[i].pair = GetViewerPair(vpage->tags[i].fontColor,
+											vpage->tags[i].noteColor);
+
+	/* Paint widest tags first, so that narrower tags inside them win */
+	for (i = 0; i < blockSize; i++)
+		vpage->owner[i] = -1;
+	for (i = 0; i < vpage->ntags; i++)
+	{
+		uint32		off;
 
-		/* LD_DEAD items may have storage, so we go by lp_len alone */
-		if (itemSize == 0)
-		{
-			if (itemFlags == LP_NORMAL)
-			{
-				fprintf(stderr, "pg_hexedit error: (%u,%u) LP_NORMAL item has lp_len 0\n",
-						blkno + segmentBlockDelta, offset);
-				exitCode = 1;
-			}
-			continue;
-		}
-		/* Sanitize */
-		if (itemFlags == LP_REDIRECT || itemFlags == LP_UNUSED)
-		{
-			fprintf(stderr, "pg_hexedit error: (%u,%u) LP_REDIRECT or LP_UNUSED item has lp_len %u\n",
-					blkno + segmentBlockDelta, offset, itemSize);
-			exitCode = 1;
-			continue;
-		}
+		for (off = Max(vpage->tags[i].start, pageStart);
+			 off <= vpage->tags[i].end && off < pageStart + blockSize;
+			 off++)
+			vpage->owner[off - pageStart] = i;
+	}
 
-		/*
-		 * Make sure the item can physically fit on this block before
-		 * formatting
-		 */
-		if (itemOffset + itemSize > blockSize ||
-			itemOffset + itemSize > bytesToFormat)
-		{
-			fprintf(stderr, "pg_hexedit error: (%u,%u) item contents extend beyond block.\n"
-					"blocksize %d bytes, read %d bytes, item start offset %d.\n",
-					blkno + segmentBlockDelta, offset, blockSize,
-					bytesToFormat, itemOffset + itemSize);
-			exitCode = 1;
-			continue;
-		}
+	return vpage;
+}
 
-		if (formatAs == ITEM_HEAP)
-		{
-			HeapTupleHeader htup;
+/*
+ * Draw --view screen: hex dump of the bytes around the cursor, in the colors
+ * of their innermost tags, and a status area describing the cursor's page and
+ * every tag that covers the cursor.
+ */
+static void
+DrawViewer(uint64 top, uint64 cursor, int bytesPerLine, const char *message)
+{
+	uint64		fileSize = (uint64) relationBlocks * blockSize;
+	int			rows = LINES - VIEWER_STATUS_LINES;
+	BlockNumber cursorBlock = cursor / blockSize;
+	ViewerPage *vpage;
+	XLogRecPtr	lsn;
+	int			row;
+	int			col;
+	int			line;
+	int			i;
 
-			htup = (HeapTupleHeader) PageGetItem(page, itemId);
+	erase();
+	for (row = 0; row < rows; row++)
+	{
+		uint64		lineOff = top + (uint64) row * bytesPerLine;
 
-			EmitXmlHeapTuple(blkno, offset, htup,
-							 pageOffset + itemOffset, itemSize);
-		}
-		else if (formatAs == ITEM_INDEX)
+		if (lineOff >= fileSize)
+			break;
+
+		mvprintw(row, 0, "%08llX ", (unsigned long long) lineOff);
+		for (col = 0; col < bytesPerLine; col++)
 		{
-			IndexTuple	tuple;
-			bool		dead;
+			uint64		off = lineOff + col;
+			int			owner;
+			attr_t		attr = A_NORMAL;
+			unsigned char c;
+
+			vpage = GetViewerPage(off / blockSize);
+			c = (unsigned char) vpage->data[off % blockSize];
+			owner = vpage->owner[off % blockSize];
+			if (owner != -1)
+				attr = COLOR_PAIR(vpage->tags[owner].pair);
+			if (off == cursor)
+				attr |= A_REVERSE;
+
+			attron(attr);
+			mvprintw(row, 9 + col * 3, "%02X", c);
+			mvaddch(row, 10 + bytesPerLine * 3 + col, isprint(c) ? c : '.');
+			attroff(attr);
+		}
+	}
 
-			tuple = (IndexTuple) PageGetItem(page, itemId);
-			dead = ItemIdIsDead(itemId);
+	/* Status area: cursor's page, then its tags, innermost first */
+	vpage = GetViewerPage(cursorBlock);
+	lsn = PageGetLSN((Page) vpage->data);
+	line = rows;
+	attron(A_BOLD);
+	mvprintw(line++, 0, "file offset %llu  block %u (relation block %u)  page offset %u  LSN %X/%08X",
+			 (unsigned long long) cursor, cursorBlock,
+			 cursorBlock + segmentBlockDelta, (uint32) (cursor % blockSize),
+			 (uint32) (lsn >> 32), (uint32) lsn);
+	if (vpage->unreadable)
+		mvprintw(line++, 0, "block could not be read");
+	attroff(A_BOLD);
+	for (i = vpage->ntags - 1; i >= 0 && line < LINES - 1; i--)
+	{
+		PageTag    *tag = &vpage->tags[i];
 
-			EmitXmlIndexTuple(page, blkno, offset, tuple,
-							  pageOffset + itemOffset, itemSize, dead);
-		}
-		else if (formatAs == ITEM_SPG_INN)
-		{
-			SpGistInnerTuple tuple;
+		if (cursor < tag->start || cursor > tag->end)
+			continue;
 
-			tuple = (SpGistInnerTuple) PageGetItem(page, itemId);
+		attron(COLOR_PAIR(tag->pair));
+		mvprintw(line++, 0, "%.*s", COLS - 1, tag->text);
+		attroff(COLOR_PAIR(tag->pair));
+	}
 
-			EmitXmlSpGistInnerTuple(page, blkno, offset, tuple,
-									pageOffset + itemOffset);
-		}
-		else if (formatAs == ITEM_SPG_LEAF)
-		{
-			SpGistLeafTuple tuple;
+	mvprintw(LINES - 1, 0, "%.*s", COLS - 1,
+			 message ? message :
+			 "arrows/PgUp/PgDn/Home/End: move  [ ]: block  g: block  t: TID  x: LSN  n: next LSN  q: quit");
+	refresh();
+}
 
-			tuple = (SpGistLeafTuple) PageGetItem(page, itemId);
+/*
+ * Prompt for a line of input on --view's last line
+ */
+static void
+ViewerPrompt(const char *prompt, char *buf, int buflen)
+{
+	move(LINES - 1, 0);
+	clrtoeol();
+	printw("%s", prompt);
+	echo();
+	curs_set(1);
+	getnstr(buf, buflen - 1);
+	curs_set(0);
+	noecho();
+}
 
-			EmitXmlSpGistLeafTuple(page, blkno, offset, tuple,
-								   pageOffset + itemOffset);
-		}
-		else if (formatAs == ITEM_BRIN)
-		{
-			BrinTuple  *tuple;
+/*
+ * Find first page after block (wrapping around) whose LSN is at or after lsn.
+ * Only page headers are read.  Returns InvalidBlockNumber when there is none.
+ */
+static BlockNumber
+FindViewerLsn(BlockNumber blkno, XLogRecPtr lsn)
+{
+	BlockNumber i;
 
-			tuple = (BrinTuple *) PageGetItem(page, itemId);
+	for (i = 1; i <= relationBlocks; i++)
+	{
+		BlockNumber candidate = (blkno + i) % relationBlocks;
+		PageHeaderData header;
 
-			EmitXmlBrinTuple(page, blkno, offset, tuple,
-							 pageOffset + itemOffset, itemSize);
-		}
+		if (pg_pread(fileno(fp), &header, SizeOfPageHeaderData,
+					 (off_t) candidate * blockSize) != SizeOfPageHeaderData)
+			continue;
+		if (!PageIsNew((Page) &header) && PageGetLSN((Page) &header) >= lsn)
+			return candidate;
 	}
+
+	return InvalidBlockNumber;
 }
 
 /*
- * Emit posting tree page pseudo-tuples.
- *
- * Posting tree pages don't store regular tuples. Non-leaf pages contain
- * PostingItems, which are pairs of ItemPointers and child block numbers.  Leaf
- * pages contain GinPostingLists and an uncompressed array of item pointers.
+ * Interactive curses viewer for relation file, for hosts where wxHexEditor
+ * can't be used.  Bytes are drawn in the colors that their tags would have in
+ * wxHexEditor, and the tags that cover the byte under the cursor are listed.
  *
- * In a leaf page, the compressed posting lists are stored after the regular
- * page header, one after each other.  Although GIN does not store regular
- * tuples, pd_lower is used to indicate the end of the posting lists. After
- * that, free space follows.
+ * Like --serve, only pages that are drawn are read and decoded.  Messages that decoding writes to stderr are held back until the
+ * viewer exits, so that they don't garble the screen.
  */
 static void
-EmitXmlPostingTreeTids(Page page, BlockNumber blkno)
+ViewRelation(void)
 {
-	OffsetNumber offsetnum;
-	OffsetNumber maxoff = GinPageGetOpaque(page)->maxoff;
-	unsigned int itemOffset;
-	unsigned int itemOffsetNext;
+	uint64		fileSize;
+	uint64		top = 0;
+	uint64		cursor = 0;
+	XLogRecPtr	searchLsn = InvalidXLogRecPtr;
+	char		message[256];
+	bool		haveMessage = false;
+	FILE	   *heldStderr;
+	int			savedStderr;
+	int			i;
 
-	Assert(GinPageIsData(page));
+	if (!isatty(fileno(stdin)) || !isatty(fileno(stdout)))
+	{
+		fprintf(stderr, "pg_hexedit error: --view requires a terminal\n");
+		exitCode = 1;
+		return;
+	}
 
-	if (!GinPageIsLeaf(page))
+	if (!OpenRelationCache())
+		return;
+	fileSize = (uint64) relationBlocks * blockSize;
+	for (i = 0; i < VIEWER_PAGES; i++)
+		viewerPages[i].blkno = InvalidBlockNumber;
+
+	fflush(stderr);
+	heldStderr = tmpfile();
+	savedStderr = dup(fileno(stderr));
+	if (heldStderr)
+		dup2(fileno(heldStderr), fileno(stderr));
+
+	initscr();
+	cbreak();
+	noecho();
+	keypad(stdscr, TRUE);
+	curs_set(0);
+	if (has_colors())
 	{
-		itemOffset = GinDataPageGetData(page) - page;
+		start_color();
+		use_default_colors();
+	}
 
-		for (offsetnum = FirstOffsetNumber;
-			 offsetnum <= maxoff;
-			 offsetnum = OffsetNumberNext(offsetnum))
+	for (;;)
+	{
+		int			bytesPerLine = COLS >= 10 + 16 * 4 ? 16 : 8;
+		int			rows = Max(LINES - VIEWER_STATUS_LINES, 1);
+		uint64		page = (uint64) rows * bytesPerLine;
+		char		input[64];
+		int			key;
+
+		/* Keep cursor on screen */
+		if (cursor < top)
+			top = cursor - cursor % bytesPerLine;
+		else if (cursor >= top + page)
+			top = cursor - cursor % bytesPerLine - (rows - 1) * bytesPerLine;
+
+		DrawViewer(top, cursor, bytesPerLine, haveMessage ? message : NULL);
+		haveMessage = false;
+
+		key = getch();
+		if (key == 'q' || key == 'Q')
+			break;
+
+		switch (key)
 		{
-			EmitXmlTupleTag(blkno, offsetnum, "PostingItem->child_blkno->bi_hi", COLOR_BLUE_LIGHT,
-							pageOffset + itemOffset,
-							(pageOffset + itemOffset + sizeof(uint16)) - 1);
-			itemOffset += sizeof(uint16);
-			EmitXmlTupleTag(blkno, offsetnum, "PostingItem->child_blkno->bi_lo", COLOR_BLUE_LIGHT,
-							pageOffset + itemOffset,
-							(pageOffset + itemOffset + sizeof(uint16)) - 1);
-			itemOffset += sizeof(uint16);
+			case KEY_LEFT:
+				if (cursor > 0)
+					cursor--;
+				break;
+			case KEY_RIGHT:
+				if (cursor + 1 < fileSize)
+					cursor++;
+				break;
+			case KEY_UP:
+				if (cursor >= bytesPerLine)
+					cursor -= bytesPerLine;
+				break;
+			case KEY_DOWN:
+				if (cursor + bytesPerLine < fileSize)
+					cursor += bytesPerLine;
+				break;
+			case KEY_PPAGE:
+				cursor = cursor >= page ? cursor - page : 0;
+				break;
+			case KEY_NPAGE:
+				cursor = Min(cursor + page, fileSize - 1);
+				break;
+			case KEY_HOME:
+				cursor = 0;
+				break;
+			case KEY_END:
+				cursor = fileSize - 1;
+				break;
+			case '[':
+				if (cursor >= blockSize)
+					cursor = (cursor / blockSize - 1) * blockSize;
+				else
+					cursor = 0;
+				break;
+			case ']':
+				if (cursor / blockSize + 1 < relationBlocks)
+					cursor = (cursor / blockSize + 1) * blockSize;
+				break;
+			case 'g':
+				{
+					unsigned long blkno;
 
-			/*
-			 * These TIDs are white because within this page (an internal
-			 * posting tree page) they are keys, not pointers.  This is
-			 * similar to nbtree internal pages (pivot tuples).
-			 */
-			EmitXmlTupleTag(blkno, offsetnum, "PostingItem->key->bi_hi", COLOR_WHITE,
-							pageOffset + itemOffset,
-							(pageOffset + itemOffset + sizeof(uint16)) - 1);
-			itemOffset += sizeof(uint16);
-			EmitXmlTupleTag(blkno, offsetnum, "PostingItem->key->bi_lo", COLOR_WHITE,
-							pageOffset + itemOffset,
-							(pageOffset + itemOffset + sizeof(uint16)) - 1);
-			itemOffset += sizeof(uint16);
-			EmitXmlTupleTag(blkno, offsetnum, "PostingItem->key->offsetNumber", COLOR_WHITE,
-							pageOffset + itemOffset,
-							(pageOffset + itemOffset + sizeof(uint16)) - 1);
-			itemOffset += sizeof(uint16);
-		}
-	}
-	else
-	{
-		GinPostingList *seg,
-				   *nextseg;
-		Pointer		endptr;
+					ViewerPrompt("file-relative block: ", input, sizeof(input));
+					if (sscanf(input, "%lu", &blkno) == 1 &&
+						blkno < relationBlocks)
+						cursor = (uint64) blkno * blockSize;
+					else
+					{
+						snprintf(message, sizeof(message),
+								 "invalid block \"%s\" (file has %u blocks)",
+								 input, relationBlocks);
+						haveMessage = true;
+					}
+					break;
+				}
+			case 't':
+				{
+					unsigned long blkno;
+					unsigned int offset;
+					Page		tidPage;
+
+					ViewerPrompt("TID (block,offset): ", input, sizeof(input));
+					if ((sscanf(input, "(%lu,%u)", &blkno, &offset) != 2 &&
+						 sscanf(input, "%lu,%u", &blkno, &offset) != 2) ||
+						blkno < segmentBlockDelta ||
+						blkno - segmentBlockDelta >= relationBlocks)
+					{
+						snprintf(message, sizeof(message),
+								 "invalid TID \"%s\" (file has relation blocks %u - %u)",
+								 input, segmentBlockDelta,
+								 segmentBlockDelta + relationBlocks - 1);
+						haveMessage = true;
+						break;
+					}
 
-		/*
-		 * See description of posting page/data page format at top of
-		 * ginpostlinglist.c for more information.
-		 *
-		 * We don't emit anything for pre-9.4 uncompressed data pages
-		 * versions, since those versions are unsupported by pg_hexedit.  They
-		 * could still be encountered if the database underwent pg_upgrade,
-		 * but that should be rare.
-		 */
-		if (!GinPageIsCompressed(page))
-			return;
+					blkno -= segmentBlockDelta;
+					tidPage = (Page) GetViewerPage(blkno)->data;
+					if (PageIsNew(tidPage) || offset < FirstOffsetNumber ||
+						offset > PageGetMaxOffsetNumber(tidPage))
+					{
+						snprintf(message, sizeof(message),
+								 "no item %u on block %lu", offset,
+								 blkno + segmentBlockDelta);
+						haveMessage = true;
+						cursor = (uint64) blkno * blockSize;
+						break;
+					}
 
-		itemOffset = GinDataPageGetData(page) - page;
-		offsetnum = FirstOffsetNumber;
-		seg = GinDataLeafPageGetPostingList(page);
-		nextseg = GinNextPostingListSegment(seg);
-		itemOffsetNext = itemOffset + ((Pointer) nextseg - (Pointer) seg);
+					/* Go to tuple, or to line pointer when it has no storage */
+					if (ItemIdHasStorage(PageGetItemId(tidPage, offset)) &&
+						ItemIdGetOffset(PageGetItemId(tidPage, offset)) < blockSize)
+						cursor = (uint64) blkno * blockSize +
+							ItemIdGetOffset(PageGetItemId(tidPage, offset));
+					else
+						cursor = (uint64) blkno * blockSize +
+							((char *) PageGetItemId(tidPage, offset) - (char *) tidPage);
+					break;
+				}
+			case 'x':
+			case 'n':
+				{
+					BlockNumber found;
 
-		endptr = ((Pointer) seg) + GinDataLeafPageGetPostingListSize(page);
-		do
-		{
-			EmitXmlTupleTag(blkno, offsetnum, "GinPostingList->first->bi_hi", COLOR_BLUE_LIGHT,
-							pageOffset + itemOffset,
-							(pageOffset + itemOffset + sizeof(uint16)) - 1);
-			itemOffset += sizeof(uint16);
-			EmitXmlTupleTag(blkno, offsetnum, "GinPostingList->first->bi_lo", COLOR_BLUE_LIGHT,
-							pageOffset + itemOffset,
-							(pageOffset + itemOffset + sizeof(uint16)) - 1);
-			itemOffset += sizeof(uint16);
-			EmitXmlTupleTag(blkno, offsetnum, "GinPostingList->first->offsetNumber", COLOR_BLUE_DARK,
-							pageOffset + itemOffset,
-							(pageOffset + itemOffset + sizeof(uint16)) - 1);
-			itemOffset += sizeof(uint16);
+					if (key == 'x')
+					{
+						ViewerPrompt("LSN: ", input, sizeof(input));
+						searchLsn = GetOptionXlogRecPtr(input);
+					}
+					if (searchLsn == InvalidXLogRecPtr)
+					{
+						snprintf(message, sizeof(message), "no valid LSN to search for");
+						haveMessage = true;
+						break;
+					}
 
-			/* Make nbytes dark yellow, to match similar IndexTuple metadata */
-			EmitXmlTupleTag(blkno, offsetnum, "GinPostingList->nbytes", COLOR_YELLOW_DARK,
-							pageOffset + itemOffset,
-							(pageOffset + itemOffset + sizeof(uint16)) - 1);
-			itemOffset += sizeof(uint16);
-			/* Compressed TIDs are orange */
-			EmitXmlTupleTag(blkno, offsetnum, "varbyte encoded TIDs", COLOR_ORANGE,
-							pageOffset + itemOffset,
-							(pageOffset + itemOffset + seg->nbytes) - 1);
-			itemOffset = itemOffsetNext;
-			seg = nextseg;
-			nextseg = GinNextPostingListSegment(seg);
-			itemOffsetNext = itemOffset + ((Pointer) nextseg - (Pointer) seg);
-			offsetnum = OffsetNumberNext(offsetnum);
+					found = FindViewerLsn(cursor / blockSize, searchLsn);
+					if (found == InvalidBlockNumber)
+					{
+						snprintf(message, sizeof(message),
+								 "no page has LSN at or after %X/%08X",
+								 (uint32) (searchLsn >> 32), (uint32) searchLsn);
+						haveMessage = true;
+					}
+					else
+						cursor = (uint64) found * blockSize;
+					break;
+				}
+			default:
+				break;
 		}
-		while ((Pointer) nextseg <= endptr);
 	}
+
+	endwin();
+
+	/* Release stderr output held back while viewer was running */
+	fflush(stderr);
+	dup2(savedStderr, fileno(stderr));
+	close(savedStderr);
+	if (heldStderr)
+	{
+		char		copyBuf[4096];
+		size_t		nread;
+
+		rewind(heldStderr);
+		while ((nread = fread(copyBuf, 1, sizeof(copyBuf), heldStderr)) > 0)
+			fwrite(copyBuf, 1, nread, stderr);
+		fclose(heldStderr);
+	}
+
+	for (i = 0; i < VIEWER_PAGES; i++)
+	{
+		int			j;
+
+		for (j = 0; j < viewerPages[i].ntags; j++)
+			pg_free(viewerPages[i].tags[j].text);
+		if (viewerPages[i].tags)
+			pg_free(viewerPages[i].tags);
+		if (viewerPages[i].owner)
+			pg_free(viewerPages[i].owner);
+		if (viewerPages[i].data)
+			pg_free(viewerPages[i].data);
+	}
+	CloseRelationCache();
 }
 
 /*
- * Emit hash bitmap page.
- *
- * This is just a matter of emitting a single tag for everything after the page
- * header, but before pd_lower.
+ * Write string to out as a JSON string literal
  */
 static void
-EmitXmlHashBitmap(Page page, BlockNumber blkno)
+EmitJsonString(FILE *out, const char *str)
 {
-	uint32		relfileOff = pageOffset + (PageGetContents(page) - page);
-	uint32		relfileOffNext = pageOffset + ((PageHeader) (page))->pd_lower;
+	const unsigned char *c;
 
-	EmitXmlTag(blkno, UINT_MAX, "hash bitmap", COLOR_YELLOW_DARK, relfileOff,
-			   relfileOffNext - 1);
+	fputc('"', out);
+	for (c = (const unsigned char *) str; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			fprintf(out, "\\%c", *c);
+		else if (*c < 0x20)
+			fprintf(out, "\\u%04x", *c);
+		else
+			fputc(*c, out);
+	}
+	fputc('"', out);
 }
 
 /*
- * Emit BRIN revmap TIDs as pseudo-tuples.
- *
- * BRIN revmap pages don't store an ItemId array, or regular tuples.  Instead,
- * the page contains an array of straight TIDs.
- *
- * We don't look at pd_upper, in keeping with pageinspect's brin_revmap_data(),
- * which also always emits REVMAP_PAGE_MAXITEMS entries.
+ * Write data to out in base64, so that it can be passed to JavaScript's
+ * atob()
  */
 static void
-EmitXmlRevmap(Page page, BlockNumber blkno)
+EmitBase64(FILE *out, const unsigned char *data, size_t len)
 {
-	OffsetNumber offsetnum;
-	uint32		relfileOff = pageOffset + (PageGetContents(page) - page);
-	uint32		relfileOffNext;
+	static const char digits[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	size_t		i;
 
-	for (offsetnum = FirstOffsetNumber;
-		 offsetnum <= REVMAP_PAGE_MAXITEMS;
-		 offsetnum = OffsetNumberNext(offsetnum))
+	for (i = 0; i < len; i += 3)
 	{
-		/*
-		 * Emit t_tid tags.  TID tag style should be kept consistent with
-		 * EmitXmlHeapTuple().
-		 *
-		 * Note: We use pseudo offset numbers here.  This is a somewhat
-		 * subjective interpretation of revmap page contents.  We want to
-		 * impose some conventions, even if they aren't particularly well
-		 * justified by struct definitions.
-		 */
-		relfileOffNext = relfileOff + sizeof(uint16);
-		EmitXmlTupleTag(blkno, offsetnum, "rm_tids[i]->bi_hi", COLOR_BLUE_LIGHT, relfileOff,
-						relfileOffNext - 1);
-		relfileOff = relfileOffNext;
-		relfileOffNext += sizeof(uint16);
-		EmitXmlTupleTag(blkno, offsetnum, "rm_tids[i]->bi_lo", COLOR_BLUE_LIGHT, relfileOff,
-						relfileOffNext - 1);
-		relfileOff = relfileOffNext;
-		relfileOffNext += sizeof(uint16);
-		EmitXmlTupleTag(blkno, offsetnum, "rm_tids[i]->offsetNumber", COLOR_BLUE_DARK,
-						relfileOff, relfileOffNext - 1);
-		relfileOff = relfileOffNext;
+		uint32		group = (uint32) data[i] << 16;
+
+		if (i + 1 < len)
+			group |= (uint32) data[i + 1] << 8;
+		if (i + 2 < len)
+			group |= data[i + 2];
+
+		fputc(digits[(group >> 18) & 0x3F], out);
+		fputc(digits[(group >> 12) & 0x3F], out);
+		fputc(i + 1 < len ? digits[(group >> 6) & 0x3F] : '=', out);
+		fputc(i + 2 < len ? digits[group & 0x3F] : '=', out);
 	}
 }
 
 /*
- * On blocks that have special sections, print the contents according to
- * previously determined special section type.
- *
- * Color of special section fields should be COLOR_GREEN_BRIGHT, to match
- * pd_special field in page header.
+ * Write --html chunk file for blocks start through end.  The chunk is a
+ * script that passes the chunk's raw bytes and tags to the viewer, so that
+ * the viewer can load it with a script element, even from a file:// URL.
+ * Returns false on error.
  */
-static void
-EmitXmlSpecial(BlockNumber blkno, uint32 level)
+static bool
+WriteHtmlChunk(int chunk, BlockNumber start, BlockNumber end)
 {
-	PageHeader	pageHeader = (PageHeader) buffer;
-	unsigned int specialOffset = pageHeader->pd_special;
-	char	   *flagString;
-
-	flagString = pg_malloc(256);
-	flagString[0] = '\0';
-
-	switch (specialType)
+	char		path[MAXPGPATH];
+	FILE	   *out;
+	BlockNumber blkno;
+	bool		firstTag = true;
+	off_t		written;
+	char	   *bytes;
+
+	/* Bytes are encoded as one base64 string, so read them all up front */
+	bytes = (char *) pg_malloc((size_t) (end - start + 1) * blockSize);
+	for (blkno = start; blkno <= end; blkno++)
 	{
-		case SPEC_SECT_NONE:
-		case SPEC_SECT_ERROR_UNKNOWN:
-		case SPEC_SECT_ERROR_BOUNDARY:
-			fprintf(stderr, "pg_hexedit error: invalid special section type \"%s\"\n",
-					GetSpecialSectionString(specialType));
-			exitCode = 1;
-			break;
-
-		case SPEC_SECT_SEQUENCE:
-			{
-				/* Special area consists of a single uint32, "magic" */
-				EmitXmlTag(blkno, level, "magic", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset,
-						   (pageOffset + specialOffset + sizeof(uint32) - 1));
-			}
-			break;
-
-		case SPEC_SECT_INDEX_BTREE:
-			{
-				BTPageOpaque btreeSection = (BTPageOpaque) (buffer + specialOffset);
-
-				EmitXmlTag(blkno, level, "btpo_prev", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo_prev),
-						   (pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo_next)) - 1);
-				EmitXmlTag(blkno, level, "btpo_next", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo_next),
-				/* btpo union simply became btpo_level on Postgres 14 */
-#if PG_VERSION_NUM >= 140000
-						   (pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo_level)) - 1);
-				EmitXmlTag(blkno, level, "btpo_level", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo_level),
-						   (pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo_flags)) - 1);
-#else
-						   (pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo)) - 1);
-				/*
-				 * XXX: Call btpo.level btpo_level on older versions, just to
-				 * keep test results consistent across Postgres versions
-				 */
-				EmitXmlTag(blkno, level, "btpo_level", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo),
-						   (pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo_flags)) - 1);
-#endif
-
-				/* Generate B-Tree special area flags */
-				strcat(flagString, "btpo_flags - ");
-				if (btreeSection->btpo_flags & BTP_LEAF)
-					strcat(flagString, "BTP_LEAF|");
-				if (btreeSection->btpo_flags & BTP_ROOT)
-					strcat(flagString, "BTP_ROOT|");
-				if (btreeSection->btpo_flags & BTP_DELETED)
-					strcat(flagString, "BTP_DELETED|");
-				if (btreeSection->btpo_flags & BTP_META)
-					strcat(flagString, "BTP_META|");
-				if (btreeSection->btpo_flags & BTP_HALF_DEAD)
-					strcat(flagString, "BTP_HALF_DEAD|");
-				if (btreeSection->btpo_flags & BTP_SPLIT_END)
-					strcat(flagString, "BTP_SPLIT_END|");
-				if (btreeSection->btpo_flags & BTP_HAS_GARBAGE)
-					strcat(flagString, "BTP_HAS_GARBAGE|");
-				if (btreeSection->btpo_flags & BTP_INCOMPLETE_SPLIT)
-					strcat(flagString, "BTP_INCOMPLETE_SPLIT|");
-				if (strlen(flagString))
-					flagString[strlen(flagString) - 1] = '\0';
-
-				EmitXmlTag(blkno, level, flagString, COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo_flags),
-						   (pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo_cycleid)) - 1);
-				EmitXmlTag(blkno, level, "btpo_cycleid", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(BTPageOpaqueData, btpo_cycleid),
-						   (pageOffset + specialOffset + sizeof(BTPageOpaqueData) - 1));
-			}
-			break;
-
-		case SPEC_SECT_INDEX_HASH:
-			{
-				HashPageOpaque hashSection = (HashPageOpaque) (buffer + specialOffset);
-
-				EmitXmlTag(blkno, level, "hasho_prevblkno", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(HashPageOpaqueData, hasho_prevblkno),
-						   (pageOffset + specialOffset + offsetof(HashPageOpaqueData, hasho_nextblkno)) - 1);
-				EmitXmlTag(blkno, level, "hasho_nextblkno", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(HashPageOpaqueData, hasho_nextblkno),
-						   (pageOffset + specialOffset + offsetof(HashPageOpaqueData, hasho_bucket)) - 1);
-				EmitXmlTag(blkno, level, "hasho_bucket", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(HashPageOpaqueData, hasho_bucket),
-						   (pageOffset + specialOffset + offsetof(HashPageOpaqueData, hasho_flag)) - 1);
-
-				/* Generate hash special area flags */
-				strcat(flagString, "hasho_flag - ");
-				if (hashSection->hasho_flag & LH_OVERFLOW_PAGE)
-					strcat(flagString, "LH_OVERFLOW_PAGE|");
-				if (hashSection->hasho_flag & LH_BUCKET_PAGE)
-					strcat(flagString, "LH_BUCKET_PAGE|");
-				if (hashSection->hasho_flag & LH_BITMAP_PAGE)
-					strcat(flagString, "LH_BITMAP_PAGE|");
-				if (hashSection->hasho_flag & LH_META_PAGE)
-					strcat(flagString, "LH_META_PAGE|");
-				if (hashSection->hasho_flag & LH_BUCKET_BEING_POPULATED)
-					strcat(flagString, "LH_BUCKET_BEING_POPULATED|");
-				if (hashSection->hasho_flag & LH_BUCKET_BEING_SPLIT)
-					strcat(flagString, "LH_BUCKET_BEING_SPLIT|");
-				if (hashSection->hasho_flag & LH_BUCKET_NEEDS_SPLIT_CLEANUP)
-					strcat(flagString, "LH_BUCKET_NEEDS_SPLIT_CLEANUP|");
-				if (hashSection->hasho_flag & LH_PAGE_HAS_DEAD_TUPLES)
-					strcat(flagString, "LH_PAGE_HAS_DEAD_TUPLES|");
-				if (strlen(flagString))
-					flagString[strlen(flagString) - 1] = '\0';
-
-				EmitXmlTag(blkno, level, flagString, COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(HashPageOpaqueData, hasho_flag),
-						   (pageOffset + specialOffset + offsetof(HashPageOpaqueData, hasho_page_id)) - 1);
-				EmitXmlTag(blkno, level, "hasho_page_id", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(HashPageOpaqueData, hasho_page_id),
-						   (pageOffset + specialOffset + sizeof(HashPageOpaqueData) - 1));
-			}
-			break;
+		const char *problem = ReadRelationBlock(blkno,
+												bytes + (size_t) (blkno - start) * blockSize);
 
-		case SPEC_SECT_INDEX_GIST:
-			{
-				GISTPageOpaque gistSection = (GISTPageOpaque) (buffer + specialOffset);
-
-				EmitXmlTag(blkno, level, "nsn", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(GISTPageOpaqueData, nsn),
-						   (pageOffset + specialOffset + offsetof(GISTPageOpaqueData, rightlink)) - 1);
-				EmitXmlTag(blkno, level, "rightlink", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(GISTPageOpaqueData, rightlink),
-						   (pageOffset + specialOffset + offsetof(GISTPageOpaqueData, flags)) - 1);
-
-				/* Generate GiST special area flags */
-				strcat(flagString, "flags - ");
-				if (gistSection->flags & F_LEAF)
-					strcat(flagString, "F_LEAF|");
-				if (gistSection->flags & F_DELETED)
-					strcat(flagString, "F_DELETED|");
-				if (gistSection->flags & F_TUPLES_DELETED)
-					strcat(flagString, "F_TUPLES_DELETED|");
-				if (gistSection->flags & F_FOLLOW_RIGHT)
-					strcat(flagString, "F_FOLLOW_RIGHT|");
-				if (gistSection->flags & F_HAS_GARBAGE)
-					strcat(flagString, "F_HAS_GARBAGE|");
-				if (strlen(flagString))
-					flagString[strlen(flagString) - 1] = '\0';
-
-				EmitXmlTag(blkno, level, flagString, COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(GISTPageOpaqueData, flags),
-						   (pageOffset + specialOffset + offsetof(GISTPageOpaqueData, gist_page_id)) - 1);
-				EmitXmlTag(blkno, level, "gist_page_id", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(GISTPageOpaqueData, gist_page_id),
-						   (pageOffset + specialOffset + sizeof(GISTPageOpaqueData) - 1));
-			}
-			break;
+		if (problem)
+		{
+			fprintf(stderr, "pg_hexedit error: could not read block %u of file \"%s\": %s\n",
+					blkno, fileName, problem);
+			exitCode = 1;
+			pg_free(bytes);
+			return false;
+		}
+	}
 
-		case SPEC_SECT_INDEX_GIN:
-			{
-				GinPageOpaque ginSection = (GinPageOpaque) (buffer + specialOffset);
-
-				EmitXmlTag(blkno, level, "rightlink", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(GinPageOpaqueData, rightlink),
-						   (pageOffset + specialOffset + offsetof(GinPageOpaqueData, maxoff)) - 1);
-				EmitXmlTag(blkno, level, "maxoff", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(GinPageOpaqueData, maxoff),
-						   (pageOffset + specialOffset + offsetof(GinPageOpaqueData, flags)) - 1);
-
-				/* Generate GIN special area flags */
-				strcat(flagString, "flags - ");
-				if (ginSection->flags & GIN_DATA)
-					strcat(flagString, "GIN_DATA|");
-				if (ginSection->flags & GIN_LEAF)
-					strcat(flagString, "GIN_LEAF|");
-				if (ginSection->flags & GIN_DELETED)
-					strcat(flagString, "GIN_DELETED|");
-				if (ginSection->flags & GIN_META)
-					strcat(flagString, "GIN_META|");
-				if (ginSection->flags & GIN_LIST)
-					strcat(flagString, "GIN_LIST|");
-				if (ginSection->flags & GIN_LIST_FULLROW)
-					strcat(flagString, "GIN_LIST_FULLROW|");
-				if (ginSection->flags & GIN_INCOMPLETE_SPLIT)
-					strcat(flagString, "GIN_INCOMPLETE_SPLIT|");
-				if (ginSection->flags & GIN_COMPRESSED)
-					strcat(flagString, "GIN_COMPRESSED|");
-				if (strlen(flagString))
-					flagString[strlen(flagString) - 1] = '\0';
-
-				EmitXmlTag(blkno, level, flagString, COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(GinPageOpaqueData, flags),
-						   (pageOffset + specialOffset + sizeof(GinPageOpaqueData) - 1));
-			}
-			break;
+	snprintf(path, sizeof(path), "%s/chunk-%d.js", htmlDirName, chunk);
+	out = fopen(path, "w");
+	if (!out)
+	{
+		fprintf(stderr, "pg_hexedit error: could not open chunk file \"%s\" for writing: %s\n",
+				path, strerror(errno));
+		exitCode = 1;
+		pg_free(bytes);
+		return false;
+	}
 
-		case SPEC_SECT_INDEX_SPGIST:
-			{
-				SpGistPageOpaque spGistSection = (SpGistPageOpaque) (buffer + specialOffset);
-
-				/* Generate SP-GiST special area flags */
-				strcat(flagString, "flags - ");
-				if (spGistSection->flags & SPGIST_META)
-					strcat(flagString, "SPGIST_META|");
-				if (spGistSection->flags & SPGIST_DELETED)
-					strcat(flagString, "SPGIST_DELETED|");
-				if (spGistSection->flags & SPGIST_LEAF)
-					strcat(flagString, "SPGIST_LEAF|");
-				if (spGistSection->flags & SPGIST_NULLS)
-					strcat(flagString, "SPGIST_NULLS|");
-				if (strlen(flagString))
-					flagString[strlen(flagString) - 1] = '\0';
-
-				EmitXmlTag(blkno, level, flagString, COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(SpGistPageOpaqueData, flags),
-						   (pageOffset + specialOffset + offsetof(SpGistPageOpaqueData, nRedirection)) - 1);
-
-				EmitXmlTag(blkno, level, "nRedirection", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(SpGistPageOpaqueData, nRedirection),
-						   (pageOffset + specialOffset + offsetof(SpGistPageOpaqueData, nPlaceholder)) - 1);
-				EmitXmlTag(blkno, level, "nPlaceholder", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(SpGistPageOpaqueData, nPlaceholder),
-						   (pageOffset + specialOffset + offsetof(SpGistPageOpaqueData, spgist_page_id)) - 1);
-				EmitXmlTag(blkno, level, "spgist_page_id", COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(SpGistPageOpaqueData, spgist_page_id),
-						   (pageOffset + specialOffset + sizeof(SpGistPageOpaqueData) - 1));
-			}
-			break;
+	fprintf(out, "pgHexeditChunk({\"chunk\":%d,\"offset\":%u,\"bytes\":\"",
+			chunk, start * blockSize);
+	EmitBase64(out, (unsigned char *) bytes,
+			   (size_t) (end - start + 1) * blockSize);
+	fprintf(out, "\",\"tags\":[");
+	for (blkno = start; blkno <= end; blkno++)
+	{
+		PageTag    *tags;
+		int			ntags = ParsePageTags(blkno,
+										  bytes + (size_t) (blkno - start) * blockSize,
+										  &tags);
+		int			i;
 
-		case SPEC_SECT_INDEX_BRIN:
-			{
-				/*
-				 * Details of array subscription are taken from
-				 * BrinPageFlags() and BringPageTupe() macros
-				 */
-				BrinSpecialSpace *brinSection = (BrinSpecialSpace *) (buffer + specialOffset);
-
-				/* Flags, of which there is currently only one, come first. */
-				strcat(flagString, "BrinPageFlags() - ");
-				if (brinSection->vector[MAXALIGN(1) / sizeof(uint16) - 2] & BRIN_EVACUATE_PAGE)
-					strcat(flagString, "BRIN_EVACUATE_PAGE|");
-				if (strlen(flagString))
-					flagString[strlen(flagString) - 1] = '\0';
-				EmitXmlTag(blkno, level, flagString, COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(BrinSpecialSpace, vector[MAXALIGN(1) / sizeof(uint16) - 2]),
-						   (pageOffset + specialOffset + offsetof(BrinSpecialSpace, vector[MAXALIGN(1) / sizeof(uint16) - 1])) - 1);
-
-				/* Generate BRIN special page type */
-				flagString[0] = '\0';
-				strcat(flagString, "BrinPageType() - ");
-				if (brinSection->vector[MAXALIGN(1) / sizeof(uint16) - 1] == BRIN_PAGETYPE_META)
-					strcat(flagString, "BRIN_PAGETYPE_META|");
-				else if (brinSection->vector[MAXALIGN(1) / sizeof(uint16) - 1] == BRIN_PAGETYPE_REVMAP)
-					strcat(flagString, "BRIN_PAGETYPE_REVMAP|");
-				else if (brinSection->vector[MAXALIGN(1) / sizeof(uint16) - 1] == BRIN_PAGETYPE_REGULAR)
-					strcat(flagString, "BRIN_PAGETYPE_REGULAR|");
-				if (strlen(flagString))
-					flagString[strlen(flagString) - 1] = '\0';
-
-				EmitXmlTag(blkno, level, flagString, COLOR_GREEN_BRIGHT,
-						   pageOffset + specialOffset + offsetof(BrinSpecialSpace, vector[MAXALIGN(1) / sizeof(uint16) - 1]),
-						   (pageOffset + specialOffset + sizeof(BrinSpecialSpace) - 1));
-			}
-			break;
+		for (i = 0; i < ntags; i++)
+		{
+			fprintf(out, "%s[%u,%u,", firstTag ? "" : ",\n", tags[i].start,
+					tags[i].end);
+			EmitJsonString(out, tags[i].text);
+			fprintf(out, ",\"%s\",\"%s\"]", tags[i].fontColor,
+					tags[i].noteColor);
+			firstTag = false;
+			pg_free(tags[i].text);
+		}
+		pg_free(tags);
+		ProgressAdvance(1, ntags, 0);
+	}
+	fprintf(out, "]});\n");
+	pg_free(bytes);
+	written = ftello(out);
+	if (written > 0)
+		ProgressAdvance(0, 0, written);
 
-		default:
-			/* Only complain the first time an error like this is seen */
-			if (exitCode == 0)
-				fprintf(stderr, "pg_hexedit error: unsupported special section type \"%s\"\n",
-						GetSpecialSectionString(specialType));
-			exitCode = 1;
+	if (fclose(out) != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: could not write chunk file \"%s\"\n",
+				path);
+		exitCode = 1;
+		return false;
 	}
 
-	pg_free(flagString);
+	return true;
 }
 
 /*
- * Dump the main body of XML tags (does not include header, header comments, or
- * footer.)
+ * Write self-contained HTML report for file (or -R range) to --html
+ * directory.  index.html is a hex viewer that only ever renders the lines
+ * that are visible, and only loads the chunk files that those lines fall in.
+ * Each chunk file has the raw bytes and tags of HTML_CHUNK_BLOCKS blocks, so
+ * the report opens instantly no matter how large the file is.
+ *
+ * Blocks are read the same way as they are for --serve.
  */
 static void
-EmitXmlBody(void)
+EmitHtmlReport(void)
 {
-	unsigned int initialRead = 1;
-	unsigned int contentsToDump = 1;
+	char		path[MAXPGPATH];
+	FILE	   *out;
+	BlockNumber first;
+	BlockNumber last;
+	int			nchunks;
+	int			i;
 
-	/*
-	 * Calculate an offset in blocks to the segment file, from the start of
-	 * the logical relation (or from the start of segment 0, if you prefer).
-	 * This is needed so that annotations and error messages do not emit
-	 * file-relative block numbers within TIDs.
-	 *
-	 * Relation-relative block numbers should always be used in annotations,
-	 * including when a raw block number is required, but should only be used
-	 * for TIDs in error messages.  If an error message references a block
-	 * number, then it is naturally file-relative; otherwise, a TID would have
-	 * been used.  The distinction between relation-relative and file-relative
-	 * block numbers is not just an implementation detail, since input options
-	 * like BLOCK_RANGE are always in terms of file-relative block numbers.
-	 */
-	segmentBlockDelta = (segmentSize / blockSize) * segmentNumber;
+	if (!GetScanRange(&first, &last) || !OpenRelationCache())
+		return;
 
-	/*
-	 * If the user requested a block range, seek to the correct position
-	 * within the file for the start block.
-	 */
-	if (blockOptions & BLOCK_RANGE)
+	if (mkdir(htmlDirName, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) != 0 &&
+		errno != EEXIST)
 	{
-		unsigned int position = blockSize * blockStart;
-
-		if (fseek(fp, position, SEEK_SET) != 0)
-		{
-			fprintf(stderr, "pg_hexedit error: seek error encountered before requested start block %d\n",
-					blockStart);
-			contentsToDump = 0;
-			exitCode = 1;
-		}
-		else
-			currentBlock = blockStart;
+		fprintf(stderr, "pg_hexedit error: could not create directory \"%s\": %s\n",
+				htmlDirName, strerror(errno));
+		exitCode = 1;
+		CloseRelationCache();
+		return;
 	}
 
-	/*
-	 * Iterate through the blocks in the file until you reach the end or the
-	 * requested range end
-	 */
-	while (contentsToDump)
+	nchunks = ((last - first + 1) + HTML_CHUNK_BLOCKS - 1) / HTML_CHUNK_BLOCKS;
+	for (i = 0; i < nchunks; i++)
 	{
-		bytesToFormat = fread(buffer, 1, blockSize, fp);
+		BlockNumber start = first + i * HTML_CHUNK_BLOCKS;
 
-		if (bytesToFormat == 0)
+		if (!WriteHtmlChunk(i, start,
+							Min(start + HTML_CHUNK_BLOCKS - 1, last)))
 		{
-			/*
-			 * fseek() won't pop an error if you seek passed eof.  The next
-			 * subsequent read gets the error.
-			 */
-			if (initialRead)
-			{
-				fprintf(stderr, "pg_hexedit error: premature end of file encountered\n");
-				exitCode = 1;
-			}
-			contentsToDump = 0;
+			CloseRelationCache();
+			return;
 		}
-		else
-			EmitXmlPage(currentBlock);
+	}
 
-		/* Check to see if we are at the end of the requested range. */
-		if ((blockOptions & BLOCK_RANGE) &&
-			(currentBlock >= blockEnd) && (contentsToDump))
-		{
-			contentsToDump = 0;
-		}
-		else
-			currentBlock++;
+	snprintf(path, sizeof(path), "%s/index.html", htmlDirName);
+	out = fopen(path, "w");
+	if (!out)
+	{
+		fprintf(stderr, "pg_hexedit error: could not open \"%s\" for writing: %s\n",
+				path, strerror(errno));
+		exitCode = 1;
+		CloseRelationCache();
+		return;
+	}
 
-		initialRead = 0;
+	fputs(htmlReportHead, out);
+	fprintf(out, "{\"file\":");
+	EmitJsonString(out, fileName);
+	fprintf(out, ",\"blockSize\":%u,\"firstBlock\":%u,\"lastBlock\":%u,\"chunkBlocks\":%d,\"segmentBlockDelta\":%u,\"itemIdStart\":%u}",
+			blockSize, first, last, HTML_CHUNK_BLOCKS, segmentBlockDelta,
+			(uint32) SizeOfPageHeaderData);
+	fputs(htmlReportTail, out);
+	if (fclose(out) != 0)
+	{
+		fprintf(stderr, "pg_hexedit error: could not write \"%s\"\n", path);
+		exitCode = 1;
 	}
+	else
+		fprintf(stderr, "pg_hexedit notice: wrote %d chunk files for blocks %u - %u to \"%s\", open \"%s\" in a web browser\n",
+				nchunks, first, last, htmlDirName, path);
+
+	CloseRelationCache();
 }
 
 /*
@@ -3994,6 +15517,7 @@ main(int argv, char **argc)
 	/* If there is a parameter list, validate the options */
 	unsigned int validOptions;
 
+	xmlOut = stdout;
 	validOptions = (argv < 2) ? OPT_RC_COPYRIGHT : ConsumeOptions(argv, argc);
 
 	/*
@@ -4004,27 +15528,144 @@ main(int argv, char **argc)
 		DisplayOptions(validOptions);
 	else
 	{
-		blockSize = GetBlockSize();
+		/* Each file in a --metrics data directory has its block size read */
+		blockSize = metricsDataDir ? BLCKSZ : GetBlockSize();
 
 		/*
-		 * On a positive block size, allocate a local buffer to store the
-		 * subsequent blocks, and generate main body of XML tags.
+		 * Calculate an offset in blocks to the segment file, from the start
+		 * of the logical relation (or from the start of segment 0, if you
+		 * prefer).  This is needed so that annotations and error messages do
+		 * not emit file-relative block numbers within TIDs.
+		 *
+		 * Relation-relative block numbers should always be used in
+		 * annotations, including when a raw block number is required, but
+		 * should only be used for TIDs in error messages.  If an error message
+		 * references a block number, then it is naturally file-relative;
+		 * otherwise, a TID would have been used.  The distinction between
+		 * relation-relative and file-relative block numbers is not just an
+		 * implementation detail, since input options like BLOCK_RANGE are
+		 * always in terms of file-relative block numbers.
 		 */
-		EmitXmlDocHeader(argv, argc);
 		if (blockSize > 0)
 		{
-			buffer = (char *) pg_malloc(blockSize);
-			EmitXmlBody();
+			segmentBlockDelta = (segmentSize / blockSize) * segmentNumber;
+			ProgressStart();
+		}
+
+		/*
+		 * With -T, index TOAST file's chunks up front, so that external TOAST
+		 * pointers can be resolved as main file's tuples are decoded
+		 */
+		if (toastFp && blockSize > 0)
+			BuildToastChunkIndex();
+
+		if (blockOptions & BLOCK_COLUMN_STATS)
+		{
+			if (blockSize > 0)
+				EmitColumnStats();
+		}
+		else if (blockOptions & BLOCK_SALVAGE)
+		{
+			if (blockSize > 0)
+				SalvageTuples();
+		}
+		else if (blockOptions & BLOCK_CHECK_UTF8)
+		{
+			if (blockSize > 0)
+				EmitXmlUtf8Problems(argv, argc);
+		}
+		else if (blockOptions & BLOCK_LSN_HEATMAP)
+		{
+			if (blockSize > 0)
+				EmitLsnHeatmap();
+		}
+		else if (blockOptions & BLOCK_FPW_ESTIMATE)
+		{
+			if (blockSize > 0)
+				EmitFpwEstimate();
+		}
+		else if (blockOptions & BLOCK_METRICS)
+		{
+			if (blockSize > 0)
+				EmitMetrics();
 		}
-		EmitXmlFooter();
+		else if (blockOptions & BLOCK_CHECK)
+		{
+			if (blockSize > 0)
+				EmitCheck(argv, argc);
+		}
+		else if (blockOptions & BLOCK_APPLY)
+		{
+			if (blockSize > 0)
+				EmitApply();
+		}
+		else if (blockOptions & BLOCK_INJECT)
+		{
+			if (blockSize > 0)
+				EmitInject();
+		}
+		else if (blockOptions & BLOCK_FIX_CHECKSUMS)
+		{
+			if (blockSize > 0)
+				EmitFixChecksums();
+		}
+		else if (blockOptions & BLOCK_SHARD)
+		{
+			if (blockSize > 0)
+				EmitXmlShards(argv, argc);
+		}
+		else if (blockOptions & BLOCK_SERVE)
+		{
+			if (blockSize > 0)
+				ServeTags(argv, argc);
+		}
+		else if (blockOptions & BLOCK_VIEW)
+		{
+			if (blockSize > 0)
+				ViewRelation();
+		}
+		else if (blockOptions & BLOCK_HTML)
+		{
+			if (blockSize > 0)
+				EmitHtmlReport();
+		}
+		else
+		{
+			/*
+			 * On a positive block size, allocate a local buffer to store the
+			 * subsequent blocks, and generate main body of XML tags.
+			 */
+			EmitXmlDocHeader(argv, argc);
+			if (blockSize > 0)
+			{
+				buffer = (char *) pg_malloc(blockSize);
+				EmitXmlBody();
+				if (sessionFileName)
+					WriteSessionFile();
+			}
+			EmitXmlFooter();
+
+			if (toastChunks)
+			{
+				EmitToastSummary();
+				EmitXmlToastDocument(argv, argc);
+			}
+		}
+
+		if (blockSize > 0)
+			ProgressReport(true);
 	}
 
+	EmitThrottleSummary();
+
 	/*
 	 * Finally, print debug output to stderr.  This is a convenient way of
 	 * informing user that options such as -x flag are working more or less as
 	 * expected.
 	 */
-	if ((blockOptions & BLOCK_SKIP_LSN))
+	if ((blockOptions & BLOCK_SKIP_LSN) &&
+		!(blockOptions & (BLOCK_SCAN_MODES | BLOCK_SHARD | BLOCK_SERVE |
+						  BLOCK_VIEW | BLOCK_HTML)))
 	{
 		if (nblockstagged == 0)
 		{
@@ -4064,8 +15705,16 @@ main(int argv, char **argc)
 	if (fp)
 		fclose(fp);
 
+	if (toastFp)
+		fclose(toastFp);
+
+	if (salvageFp && salvageFp != stdout)
+		fclose(salvageFp);
+
 	if (buffer)
 		pg_free(buffer);
 
 	exit(exitCode);
 }
+
+#endif							/* PG_HEXEDIT_EXTENSION */
@@ -0,0 +1,123 @@
+/*
+ * pg_hexedit_plugin.h - Decoder plugin interface for pg_hexedit.
+ *
+ * Copyright (c) 2018-2021, Crunchy Data Solutions, Inc.
+ *
+ * Plugins teach pg_hexedit to tag the pages of index access methods that it
+ * doesn't know about, such as contrib/bloom and pgvector.  A plugin is a
+ * shared library that is loaded with --plugin, and that exports a
+ * HEXEDIT_PLUGIN_INIT_FUNCTION function (see HexeditPluginInit).  It returns
+ * one HexeditPluginAm for each access method that the plugin decodes.
+ *
+ * Plugins are given a chance to recognize every page whose pd_special is
+ * sane, before pg_hexedit's own guesses about core access methods are made.
+ * This is necessary because GIN pages are recognized by the size of their
+ * special area alone, which other access methods may share.  Once a page is
+ * recognized, the plugin's callbacks emit its tags using the same tag
+ * primitives that pg_hexedit uses itself, so its tags work everywhere that
+ * pg_hexedit's own tags do (including --serve, --view, --html, --check, and
+ * --apply).
+ *
+ * Callers include postgres.h before including this file.
+ */
+#ifndef PG_HEXEDIT_PLUGIN_H
+#define PG_HEXEDIT_PLUGIN_H
+
+#include "storage/bufpage.h"
+
+/*
+ * Version of this interface.  Bumped whenever either struct changes
+ * incompatibly.
+ */
+#define HEXEDIT_PLUGIN_API_VERSION		1
+
+/* Name of function that every plugin exports */
+#define HEXEDIT_PLUGIN_INIT_FUNCTION	"pg_hexedit_plugin_init"
+
+/*
+ * Services that pg_hexedit provides to plugins.  Offsets passed to tag
+ * functions are file offsets, and refer to the first and last bytes that tag
+ * covers.  Block numbers passed to tag functions are file-relative; they're
+ * printed relation-relative, just like pg_hexedit's own tags.  Colors are
+ * "#RRGGBB" strings.  Callbacks may be called from several threads at once,
+ * so any state that plugins keep must be thread-safe.
+ */
+typedef struct HexeditPluginHost
+{
+	int			apiVersion;		/* HEXEDIT_PLUGIN_API_VERSION */
+
+	/* Tag page field, as "block n name" (or just "name", for metapages) */
+	void		(*emitTag) (BlockNumber blkno, bool metapage, const char *name,
+							const char *color, uint32 relfileOff,
+							uint32 relfileOffEnd);
+
+	/* Tag tuple field, as "(n,offset) name" */
+	void		(*emitTupleTag) (BlockNumber blkno, OffsetNumber offset,
+								 const char *name, const char *color,
+								 uint32 relfileOff, uint32 relfileOffEnd);
+
+	/* Report problem with page, making pg_hexedit's exit status nonzero */
+	void		(*reportError) (const char *fmt,...) pg_attribute_printf(1, 2);
+} HexeditPluginHost;
+
+/*
+ * Access method that a plugin decodes.  Only name and recognize are
+ * required.  page is always a complete page, and pageOffset is its file
+ * offset.
+ */
+typedef struct HexeditPluginAm
+{
+	/* Short name of access method, such as "bloom" */
+	const char *name;
+
+	/*
+	 * Does page belong to access method?  specialSize is the size of page's
+	 * special area, which is always within the page.
+	 */
+	bool		(*recognize) (Page page, uint32 specialSize);
+
+	/*
+	 * Emit tags for metapage, which is block 0 of segment 0.  Metapages
+	 * never have their line pointers or tuples tagged.  When NULL, access
+	 * method has no metapage.
+	 */
+	void		(*emitMetapage) (Page page, BlockNumber blkno, uint32 pageOffset);
+
+	/*
+	 * Does non-metapage have line pointers and tuples?  When NULL, every
+	 * non-metapage does.
+	 */
+	bool		(*hasTuples) (Page page, BlockNumber blkno);
+
+	/*
+	 * Emit tags for contents of tuple, whose line pointer has already been
+	 * tagged.  When NULL, each tuple gets a single tag.
+	 */
+	void		(*emitTuple) (Page page, BlockNumber blkno, OffsetNumber offset,
+							  const char *tuple, uint32 relfileOff,
+							  uint32 len);
+
+	/*
+	 * Emit tags for page's special area, along with anything else on page
+	 * that isn't a tuple or metapage field.  Called for every page, after
+	 * its other tags.  When NULL, the special area gets a single tag.
+	 */
+	void		(*emitPage) (Page page, BlockNumber blkno, uint32 pageOffset);
+
+	/* Is page a leaf page (see -l)?  When NULL, no page is. */
+	bool		(*isLeaf) (Page page);
+} HexeditPluginAm;
+
+/*
+ * Type of HEXEDIT_PLUGIN_INIT_FUNCTION.  Returns an array of *nams access
+ * methods, or NULL (after reporting why) if plugin can't be used with host,
+ * such as when host's apiVersion isn't the one that it was built for.  The
+ * host struct stays valid for as long as the plugin is loaded.
+ */
+typedef const HexeditPluginAm *(*HexeditPluginInit) (const HexeditPluginHost *host,
+													 int *nams);
+
+extern PGDLLEXPORT const HexeditPluginAm *pg_hexedit_plugin_init(const HexeditPluginHost *host,
+																 int *nams);
+
+#endif							/* PG_HEXEDIT_PLUGIN_H */
@@ -0,0 +1,243 @@
+/*
+ * bloom.c - pg_hexedit plugin for contrib/bloom indexes.
+ *
+ * Copyright (c) 2018-2021, Crunchy Data Solutions, Inc.
+ *
+ * Usage: pg_hexedit --plugin plugins/bloom.so file
+ *
+ * Bloom pages don't have line pointers.  Each non-metapage stores maxoff
+ * fixed size BloomTuples one after another, directly after the page header,
+ * and pd_lower points just past the last of them.  The size of each tuple
+ * depends on the index's signature length, which is stored in the metapage;
+ * we infer it from pd_lower instead, so that segments other than the first
+ * can be decoded too.
+ */
+#include "postgres.h"
+
+#include "pg_hexedit_plugin.h"
+
+/*
+ * On-disk structs, as in contrib/bloom/bloom.h (which isn't installed)
+ */
+typedef struct BloomPageOpaqueData
+{
+	OffsetNumber maxoff;		/* number of index tuples on page */
+	uint16		flags;			/* see bit definitions below */
+	uint16		unused;			/* placeholder to force maxaligning of size of
+								 * BloomPageOpaqueData and to place
+								 * bloom_page_id exactly at the end of page */
+	uint16		bloom_page_id;	/* for identification of BLOOM indexes */
+} BloomPageOpaqueData;
+
+typedef BloomPageOpaqueData *BloomPageOpaque;
+
+#define BLOOM_META		(1<<0)
+#define BLOOM_DELETED	(2<<0)
+
+#define BLOOM_PAGE_ID		0xFF83
+#define BLOOM_MAGICK_NUMBER (0xDBAC0DED)
+
+typedef uint16 BloomSignatureWord;
+
+typedef struct BloomOptions
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	int			bloomLength;	/* length of signature in words (not bits!) */
+	int			bitSize[INDEX_MAX_KEYS];	/* # of bits generated for each
+											 * index key */
+} BloomOptions;
+
+typedef struct BloomMetaPageData
+{
+	uint32		magickNumber;
+	uint16		nStart;
+	uint16		nEnd;
+	BloomOptions opts;
+	BlockNumber notFullPage[FLEXIBLE_ARRAY_MEMBER];
+} BloomMetaPageData;
+
+typedef struct BloomTuple
+{
+	ItemPointerData heapPtr;
+	BloomSignatureWord sign[FLEXIBLE_ARRAY_MEMBER];
+} BloomTuple;
+
+#define BLOOMTUPLEHDRSZ offsetof(BloomTuple, sign)
+
+#define BloomPageGetOpaque(page) ((BloomPageOpaque) PageGetSpecialPointer(page))
+
+/* Same colors as pg_hexedit's */
+#define COLOR_BLUE_LIGHT		"#3498DB"
+#define COLOR_GREEN_BRIGHT		"#50E964"
+#define COLOR_PINK				"#E949D1"
+#define COLOR_WHITE				"#CCD1D1"
+
+static const HexeditPluginHost *host;
+
+static bool
+BloomRecognize(Page page, uint32 specialSize)
+{
+	return specialSize == MAXALIGN(sizeof(BloomPageOpaqueData)) &&
+		BloomPageGetOpaque(page)->bloom_page_id == BLOOM_PAGE_ID;
+}
+
+static void
+BloomEmitMetapage(Page page, BlockNumber blkno, uint32 pageOffset)
+{
+	uint32		metaStartOffset = pageOffset + MAXALIGN(SizeOfPageHeaderData);
+	BloomMetaPageData *meta = (BloomMetaPageData *) PageGetContents(page);
+	uint32		arrayOffset;
+	uint32		arrayEnd;
+
+	if (!(BloomPageGetOpaque(page)->flags & BLOOM_META))
+	{
+		host->reportError("bloom block %u is not a metapage", blkno);
+		return;
+	}
+	if (meta->magickNumber != BLOOM_MAGICK_NUMBER)
+		host->reportError("bloom metapage has invalid magickNumber 0x%08X",
+						  meta->magickNumber);
+
+	host->emitTag(blkno, true, "magickNumber", COLOR_PINK,
+				  metaStartOffset + offsetof(BloomMetaPageData, magickNumber),
+				  (metaStartOffset + offsetof(BloomMetaPageData, nStart)) - 1);
+	host->emitTag(blkno, true, "nStart", COLOR_PINK,
+				  metaStartOffset + offsetof(BloomMetaPageData, nStart),
+				  (metaStartOffset + offsetof(BloomMetaPageData, nEnd)) - 1);
+	host->emitTag(blkno, true, "nEnd", COLOR_PINK,
+				  metaStartOffset + offsetof(BloomMetaPageData, nEnd),
+				  (metaStartOffset + offsetof(BloomMetaPageData, opts)) - 1);
+	host->emitTag(blkno, true, "opts.vl_len_", COLOR_PINK,
+				  metaStartOffset + offsetof(BloomMetaPageData, opts.vl_len_),
+				  (metaStartOffset + offsetof(BloomMetaPageData, opts.bloomLength)) - 1);
+	host->emitTag(blkno, true, "opts.bloomLength", COLOR_PINK,
+				  metaStartOffset + offsetof(BloomMetaPageData, opts.bloomLength),
+				  (metaStartOffset + offsetof(BloomMetaPageData, opts.bitSize)) - 1);
+	host->emitTag(blkno, true, "opts.bitSize", COLOR_PINK,
+				  metaStartOffset + offsetof(BloomMetaPageData, opts.bitSize),
+				  (metaStartOffset + offsetof(BloomMetaPageData, notFullPage)) - 1);
+
+	/* Only tag the part of notFullPage that's in use */
+	if (meta->nEnd > meta->nStart)
+	{
+		arrayOffset = metaStartOffset + offsetof(BloomMetaPageData, notFullPage) +
+			meta->nStart * sizeof(BlockNumber);
+		arrayEnd = metaStartOffset + offsetof(BloomMetaPageData, notFullPage) +
+			meta->nEnd * sizeof(BlockNumber);
+		if (arrayEnd > pageOffset + ((PageHeader) page)->pd_special)
+			host->reportError("bloom metapage nEnd %u extends beyond special area",
+							  meta->nEnd);
+		else
+			host->emitTag(blkno, true, "notFullPage", COLOR_BLUE_LIGHT,
+						  arrayOffset, arrayEnd - 1);
+	}
+}
+
+static bool
+BloomHasTuples(Page page, BlockNumber blkno)
+{
+	/* Tuples are tagged by BloomEmitPage(), since there are no ItemIds */
+	return false;
+}
+
+static void
+BloomEmitPage(Page page, BlockNumber blkno, uint32 pageOffset)
+{
+	PageHeader	pageHeader = (PageHeader) page;
+	BloomPageOpaque opaque = BloomPageGetOpaque(page);
+	uint32		specialOffset = pageOffset + pageHeader->pd_special;
+	uint32		contents = MAXALIGN(SizeOfPageHeaderData);
+	char		flagString[64];
+
+	/* Tuples of non-metapages */
+	if (!(opaque->flags & (BLOOM_META | BLOOM_DELETED)) && opaque->maxoff > 0)
+	{
+		uint32		tupleSize;
+		OffsetNumber offset;
+
+		if (pageHeader->pd_lower < contents ||
+			pageHeader->pd_lower > pageHeader->pd_special ||
+			(pageHeader->pd_lower - contents) % opaque->maxoff != 0 ||
+			(pageHeader->pd_lower - contents) / opaque->maxoff <= BLOOMTUPLEHDRSZ)
+			host->reportError("bloom block %u has maxoff %u that doesn't match pd_lower %u",
+							  blkno, opaque->maxoff, pageHeader->pd_lower);
+		else
+		{
+			tupleSize = (pageHeader->pd_lower - contents) / opaque->maxoff;
+
+			for (offset = FirstOffsetNumber; offset <= opaque->maxoff; offset++)
+			{
+				uint32		tupleOffset = pageOffset + contents +
+				(offset - 1) * tupleSize;
+
+				host->emitTupleTag(blkno, offset, "heapPtr->bi_hi", COLOR_BLUE_LIGHT,
+								   tupleOffset + offsetof(BloomTuple, heapPtr.ip_blkid.bi_hi),
+								   (tupleOffset + offsetof(BloomTuple, heapPtr.ip_blkid.bi_lo)) - 1);
+				host->emitTupleTag(blkno, offset, "heapPtr->bi_lo", COLOR_BLUE_LIGHT,
+								   tupleOffset + offsetof(BloomTuple, heapPtr.ip_blkid.bi_lo),
+								   (tupleOffset + offsetof(BloomTuple, heapPtr.ip_posid)) - 1);
+				host->emitTupleTag(blkno, offset, "heapPtr->offsetNumber", COLOR_BLUE_LIGHT,
+								   tupleOffset + offsetof(BloomTuple, heapPtr.ip_posid),
+								   (tupleOffset + BLOOMTUPLEHDRSZ) - 1);
+				host->emitTupleTag(blkno, offset, "sign", COLOR_WHITE,
+								   tupleOffset + BLOOMTUPLEHDRSZ,
+								   (tupleOffset + tupleSize) - 1);
+			}
+		}
+	}
+
+	/* Special area */
+	host->emitTag(blkno, false, "maxoff", COLOR_GREEN_BRIGHT,
+				  specialOffset + offsetof(BloomPageOpaqueData, maxoff),
+				  (specialOffset + offsetof(BloomPageOpaqueData, flags)) - 1);
+
+	strcpy(flagString, "flags - ");
+	if (opaque->flags & BLOOM_META)
+		strcat(flagString, "BLOOM_META|");
+	if (opaque->flags & BLOOM_DELETED)
+		strcat(flagString, "BLOOM_DELETED|");
+	flagString[strlen(flagString) - 1] = '\0';
+	host->emitTag(blkno, false, flagString, COLOR_GREEN_BRIGHT,
+				  specialOffset + offsetof(BloomPageOpaqueData, flags),
+				  (specialOffset + offsetof(BloomPageOpaqueData, unused)) - 1);
+	host->emitTag(blkno, false, "unused", COLOR_GREEN_BRIGHT,
+				  specialOffset + offsetof(BloomPageOpaqueData, unused),
+				  (specialOffset + offsetof(BloomPageOpaqueData, bloom_page_id)) - 1);
+	host->emitTag(blkno, false, "bloom_page_id", COLOR_GREEN_BRIGHT,
+				  specialOffset + offsetof(BloomPageOpaqueData, bloom_page_id),
+				  (specialOffset + sizeof(BloomPageOpaqueData)) - 1);
+}
+
+static bool
+BloomIsLeaf(Page page)
+{
+	/* Every non-metapage is a leaf page, since bloom indexes are flat */
+	return !(BloomPageGetOpaque(page)->flags & BLOOM_META);
+}
+
+static const HexeditPluginAm bloomAms[] = {
+	{
+		"bloom",
+		BloomRecognize,
+		BloomEmitMetapage,
+		BloomHasTuples,
+		NULL,
+		BloomEmitPage,
+		BloomIsLeaf
+	}
+};
+
+const HexeditPluginAm *
+pg_hexedit_plugin_init(const HexeditPluginHost *h, int *nams)
+{
+	if (h->apiVersion != HEXEDIT_PLUGIN_API_VERSION)
+	{
+		h->reportError("bloom plugin requires plugin API version %d, not %d",
+					   HEXEDIT_PLUGIN_API_VERSION, h->apiVersion);
+		return NULL;
+	}
+
+	host = h;
+	*nams = lengthof(bloomAms);
+	return bloomAms;
+}